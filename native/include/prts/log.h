@@ -27,7 +27,7 @@ typedef enum {
     PRTS_LOG_FORMAT_JSON,
     PRTS_LOG_FORMAT_TEXT,
     PRTS_LOG_FORMAT_SYSLOG,
-    PRTS_LOG_FORMAT_AUTO,
+    PRTS_LOG_FORMAT_AUTO,           /* Per line; once per stream/source when streaming */
 } prts_log_format_t;
 
 /* Parsed log entry */
@@ -133,6 +133,190 @@ PRTS_API prts_result_t prts_parser_parse_batch(
     size_t* count_out
 );
 
+/**
+ * Set a field-extraction template for fixed-layout lines.
+ * The pattern is literal text with %{name} captures, for example
+ * "%{timestamp} [%{level}] (%{source}) %{file}:%{line}: %{message}".
+ * It is compiled once and matched in a single forward pass: each capture
+ * extends to the first occurrence of the literal that follows it. Captures
+ * named level, source and message fill the entry directly, %{} discards
+ * text, and any other name becomes a field_names/field_values pair.
+ * Lines that do not match fall back to the generic parser for the format.
+ * Field values are valid until the next parse, batch, feed or parallel call.
+ * @param parser The log parser
+ * @param pattern Template pattern ("%%" for a literal percent), NULL to clear
+ * @return PRTS_OK on success, PRTS_ERROR_INVALID for a malformed pattern
+ */
+PRTS_API prts_result_t prts_parser_set_template(
+    prts_log_parser_t* parser,
+    const char* pattern
+);
+
+/**
+ * Parse a large buffer in parallel on a thread pool.
+ * The input is split into chunks at newline boundaries, each chunk is parsed
+ * by a worker with its own parser state, and entries are returned in input
+ * order. Small inputs are parsed on the calling thread.
+ * @param parser The log parser (provides the configuration for all chunks)
+ * @param pool Thread pool to run chunk parsers on
+ * @param data Log data to parse
+ * @param data_len Length of the log data
+ * @param entries_out Output entries array
+ * @param max_entries Maximum entries to parse
+ * @param count_out Actual number of entries parsed
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_parser_parse_parallel(
+    prts_log_parser_t* parser,
+    prts_thread_pool_t* pool,
+    const char* data,
+    size_t data_len,
+    prts_log_entry_t* entries_out,
+    size_t max_entries,
+    size_t* count_out
+);
+
+/**
+ * Feed a chunk of streamed log data (socket reads, pipe buffers, ...).
+ * Complete lines are parsed in place from the chunk; a trailing partial
+ * line is copied into the parser and completed by the next chunk.
+ * All entries of the previous chunk must be polled before feeding again.
+ * @param parser The log parser
+ * @param data Chunk data (must stay valid until its entries are polled)
+ * @param data_len Length of the chunk
+ * @return PRTS_OK on success, PRTS_ERROR_FULL if unpolled entries remain,
+ *         PRTS_ERROR_NOMEM with the carried partial line kept
+ */
+PRTS_API prts_result_t prts_parser_feed(
+    prts_log_parser_t* parser,
+    const char* data,
+    size_t data_len
+);
+
+/**
+ * Poll entries parsed from fed chunks.
+ * @param parser The log parser
+ * @param entries_out Output entries array (valid until the next feed call)
+ * @param max_entries Maximum entries to return
+ * @param count_out Actual number of entries returned (0 when drained)
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_parser_poll(
+    prts_log_parser_t* parser,
+    prts_log_entry_t* entries_out,
+    size_t max_entries,
+    size_t* count_out
+);
+
+/**
+ * Mark the end of the stream.
+ * A pending partial line is treated as complete and returned by the next poll.
+ * @param parser The log parser
+ * @return PRTS_OK on success, PRTS_ERROR_FULL if unpolled entries remain
+ */
+PRTS_API prts_result_t prts_parser_finish(prts_log_parser_t* parser);
+
+/**
+ * Reset streaming state, discarding pending partial lines and entries.
+ * AUTO format detection restarts with the next line.
+ * @param parser The log parser
+ */
+PRTS_API void prts_parser_reset(prts_log_parser_t* parser);
+
+/* === Memory-Mapped Ingestion === */
+
+/**
+ * Memory-map a set of log files for zero-copy parsing.
+ * Files are mapped read-only with sequential access advice.
+ * @param paths File paths
+ * @param num_paths Number of files
+ * @param mapping_out Output pointer for mapping handle
+ * @return PRTS_OK on success, PRTS_ERROR if a file cannot be mapped
+ */
+PRTS_API prts_result_t prts_log_mapping_open(
+    const char* const* paths,
+    size_t num_paths,
+    prts_log_mapping_t** mapping_out
+);
+
+/**
+ * Unmap all files. Entries parsed from the mapping become invalid.
+ * @param mapping The mapping handle
+ */
+PRTS_API void prts_log_mapping_close(prts_log_mapping_t* mapping);
+
+/**
+ * Get the number of mapped files.
+ * @param mapping The mapping handle
+ * @return Number of files
+ */
+PRTS_API size_t prts_log_mapping_count(const prts_log_mapping_t* mapping);
+
+/**
+ * Get the mapped contents of one file.
+ * @param mapping The mapping handle
+ * @param index File index
+ * @param data_out Output pointer to mapped data (NULL for empty files)
+ * @param len_out Output data length
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_log_mapping_data(
+    const prts_log_mapping_t* mapping,
+    size_t index,
+    const char** data_out,
+    size_t* len_out
+);
+
+/**
+ * Rewind the mapping's parse cursor to the start of the first file.
+ * @param mapping The mapping handle
+ */
+PRTS_API void prts_log_mapping_rewind(prts_log_mapping_t* mapping);
+
+/**
+ * Get the mapping's parse cursor, e.g. to checkpoint a backfill.
+ * @param mapping The mapping handle
+ * @param file_out Output file index (may be NULL)
+ * @param offset_out Output byte offset within the file (may be NULL)
+ */
+PRTS_API void prts_log_mapping_tell(
+    const prts_log_mapping_t* mapping,
+    size_t* file_out,
+    size_t* offset_out
+);
+
+/**
+ * Move the mapping's parse cursor.
+ * @param mapping The mapping handle
+ * @param file File index (equal to the file count to mark the end)
+ * @param offset Byte offset within the file, should be at a line start
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_log_mapping_seek(
+    prts_log_mapping_t* mapping,
+    size_t file,
+    size_t offset
+);
+
+/**
+ * Parse the next batch of lines from a mapping, continuing where the
+ * previous call stopped. Entry raw/message pointers reference the mapping
+ * directly and stay valid until the mapping is closed.
+ * @param parser The log parser
+ * @param mapping The mapping handle
+ * @param entries_out Output entries array
+ * @param max_entries Maximum entries to parse
+ * @param count_out Actual number of entries parsed (0 when all files are consumed)
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_parser_parse_mapping(
+    prts_log_parser_t* parser,
+    prts_log_mapping_t* mapping,
+    prts_log_entry_t* entries_out,
+    size_t max_entries,
+    size_t* count_out
+);
+
 /* === Log Indexer === */
 
 /**
@@ -17,8 +17,16 @@ typedef enum {
     PRTS_METRIC_COUNTER,    /* Monotonically increasing counter */
     PRTS_METRIC_GAUGE,      /* Point-in-time value */
     PRTS_METRIC_HISTOGRAM,  /* Distribution of values */
+    PRTS_METRIC_SKETCH,     /* Distribution with relative-error quantiles */
 } prts_metric_type_t;
 
+/* Pre-resolved handles for hot-path updates */
+typedef struct prts_metric prts_metric_t;                /* A registered metric */
+typedef struct prts_metric_series prts_metric_series_t;  /* A metric bound to a label set */
+
+/* Mergeable relative-error quantile sketch (DDSketch) */
+typedef struct prts_sketch prts_sketch_t;
+
 /* Metric configuration */
 typedef struct {
     const char* name;
@@ -28,7 +36,7 @@ typedef struct {
     size_t num_labels;
 } prts_metric_config_t;
 
-/* Histogram buckets */
+/* Histogram buckets: strictly increasing upper bounds, +Inf is implicit */
 typedef struct {
     double* boundaries;
     size_t num_boundaries;
@@ -44,12 +52,59 @@ typedef struct {
         struct {
             uint64_t count;
             double sum;
-            uint64_t* bucket_counts;
-            size_t num_buckets;
+            uint64_t* bucket_counts;    /* Per-bucket (not cumulative); samples only */
+            size_t num_buckets;         /* Boundaries + 1 (+Inf) */
         } histogram;
+        struct {
+            uint64_t count;
+            double sum;
+            double p50;
+            double p90;
+            double p99;
+            double p999;
+        } sketch;
     } value;
 } prts_metric_value_t;
 
+/* One series as seen by prts_metrics_visit */
+typedef struct {
+    const char* name;
+    prts_metric_type_t type;
+    const char* const* label_names;
+    const char* const* label_values;
+    size_t num_labels;
+    uint64_t series_key;            /* Stable across calls, see prts_metrics_series_key */
+    const double* boundaries;       /* Histograms: num_buckets - 1 upper bounds */
+    prts_metric_value_t value;      /* bucket_counts is valid during the callback only */
+    const prts_sketch_t* sketch;    /* Sketches: a copy, valid during the callback only */
+} prts_metric_sample_t;
+
+/* Series visitor; must not call back into the collector */
+typedef void (*prts_metrics_visit_fn)(const prts_metric_sample_t* sample, void* ctx);
+
+/* Exposition formats */
+typedef enum {
+    PRTS_EXPORT_PROMETHEUS,     /* Prometheus text format 0.0.4 */
+    PRTS_EXPORT_OPENMETRICS,    /* OpenMetrics 1.0 text format */
+} prts_export_format_t;
+
+/* Export sink; receives consecutive pieces of the output */
+typedef prts_result_t (*prts_export_write_fn)(const char* data, size_t len, void* ctx);
+
+/* Cardinality limits; 0 means unlimited */
+typedef struct {
+    size_t max_series_per_metric;
+    size_t max_series;              /* Across all metrics */
+} prts_metrics_limits_t;
+
+/* Collector statistics */
+typedef struct {
+    size_t num_metrics;
+    size_t num_series;
+    uint64_t series_dropped;        /* Series refused by a limit */
+    uint64_t series_evicted;        /* Series removed by prts_metrics_evict_stale */
+} prts_metrics_stats_t;
+
 /**
  * Create a metrics collector.
  * @param collector_out Output pointer for collector
@@ -76,11 +131,256 @@ PRTS_API prts_result_t prts_metrics_register(
     const prts_metric_config_t* config
 );
 
+/**
+ * Register a histogram metric with explicit bucket boundaries.
+ * Histograms registered through other calls use the Prometheus defaults
+ * (0.005 .. 10).
+ * @param collector The metrics collector
+ * @param config Metric configuration (type must be PRTS_METRIC_HISTOGRAM)
+ * @param buckets Bucket boundaries (NULL for defaults)
+ * @param metric_out Output metric handle (may be NULL)
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_metrics_register_histogram(
+    prts_metrics_collector_t* collector,
+    const prts_metric_config_t* config,
+    const prts_histogram_config_t* buckets,
+    prts_metric_t** metric_out
+);
+
+/**
+ * Register a sketch metric. Sketches record observations through the
+ * histogram calls and report quantiles within relative_accuracy of the
+ * true value, e.g. 0.01 gives p99 within 1%.
+ * @param collector The metrics collector
+ * @param config Metric configuration (type must be PRTS_METRIC_SKETCH)
+ * @param relative_accuracy Relative error bound in (0, 1) (0 for 1%)
+ * @param metric_out Output metric handle (may be NULL)
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_metrics_register_sketch(
+    prts_metrics_collector_t* collector,
+    const prts_metric_config_t* config,
+    double relative_accuracy,
+    prts_metric_t** metric_out
+);
+
+/**
+ * Merge the sketches of a sketch metric into sketch_out.
+ * sketch_out must have the same relative accuracy as the metric.
+ * @param collector The metrics collector
+ * @param name Metric name
+ * @param label_values One value per registered label (NULL to merge every series)
+ * @param sketch_out Sketch to merge into
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_metrics_sketch_merge(
+    prts_metrics_collector_t* collector,
+    const char* name,
+    const char** label_values,
+    prts_sketch_t* sketch_out
+);
+
+/**
+ * Create a standalone quantile sketch.
+ * @param relative_accuracy Relative error bound in (0, 1) (0 for 1%)
+ * @param max_bins Bin limit bounding memory (0 for 2048); the lowest
+ *        bins are collapsed when exceeded
+ * @param sketch_out Output pointer for sketch
+ * @return PRTS_OK on success, PRTS_ERROR_INVALID for an accuracy too fine
+ *         to index every double (below about 2e-7)
+ */
+PRTS_API prts_result_t prts_sketch_create(
+    double relative_accuracy,
+    size_t max_bins,
+    prts_sketch_t** sketch_out
+);
+
+/**
+ * Destroy a sketch.
+ * @param sketch The sketch to destroy
+ */
+PRTS_API void prts_sketch_destroy(prts_sketch_t* sketch);
+
+/**
+ * Remove all observations from a sketch.
+ * @param sketch The sketch
+ */
+PRTS_API void prts_sketch_clear(prts_sketch_t* sketch);
+
+/**
+ * Add an observation. Values at or below zero share the zero bin.
+ * @param sketch The sketch
+ * @param value Observed value
+ * @return PRTS_OK on success, PRTS_ERROR_INVALID for NaN or an infinity
+ */
+PRTS_API prts_result_t prts_sketch_add(prts_sketch_t* sketch, double value);
+
+/**
+ * Merge other into sketch. Both must have the same relative accuracy.
+ * @param sketch Destination sketch
+ * @param other Source sketch
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_sketch_merge(prts_sketch_t* sketch, const prts_sketch_t* other);
+
+/**
+ * Remove the observations of an earlier snapshot of the same sketch,
+ * leaving those added since. min and max keep bounding the remaining
+ * observations but are no longer exact.
+ * @param sketch Later snapshot, updated in place
+ * @param earlier Earlier snapshot
+ * @return PRTS_OK on success, PRTS_ERROR_INVALID if earlier is not an
+ *         earlier state of sketch (sketch is left unchanged)
+ */
+PRTS_API prts_result_t prts_sketch_subtract(prts_sketch_t* sketch, const prts_sketch_t* earlier);
+
+/**
+ * Estimate a quantile.
+ * @param sketch The sketch
+ * @param q Quantile in [0, 1]
+ * @param value_out Output value
+ * @return PRTS_OK on success, PRTS_ERROR_EMPTY if the sketch is empty
+ */
+PRTS_API prts_result_t prts_sketch_quantile(
+    const prts_sketch_t* sketch,
+    double q,
+    double* value_out
+);
+
+/**
+ * Get the number of observations in a sketch.
+ * @param sketch The sketch
+ * @return Observation count
+ */
+PRTS_API uint64_t prts_sketch_count(const prts_sketch_t* sketch);
+
+/**
+ * Get the sum of observations in a sketch.
+ * @param sketch The sketch
+ * @return Observation sum
+ */
+PRTS_API double prts_sketch_sum(const prts_sketch_t* sketch);
+
+/**
+ * Get the relative accuracy of a sketch.
+ * @param sketch The sketch
+ * @return Relative accuracy
+ */
+PRTS_API double prts_sketch_relative_accuracy(const prts_sketch_t* sketch);
+
+/**
+ * Generate linear bucket boundaries: start, start + width, ...
+ * @param start First boundary
+ * @param width Distance between boundaries (> 0)
+ * @param count Number of boundaries
+ * @param boundaries_out Output array of count boundaries
+ * @return PRTS_OK on success, PRTS_ERROR_INVALID for arguments outside
+ *         these ranges or boundaries that would not be finite and strictly
+ *         increasing
+ */
+PRTS_API prts_result_t prts_histogram_linear_buckets(
+    double start,
+    double width,
+    size_t count,
+    double* boundaries_out
+);
+
+/**
+ * Generate exponential bucket boundaries: start, start * factor, ...
+ * @param start First boundary (> 0)
+ * @param factor Growth factor (> 1)
+ * @param count Number of boundaries
+ * @param boundaries_out Output array of count boundaries
+ * @return PRTS_OK on success, PRTS_ERROR_INVALID for arguments outside
+ *         these ranges or boundaries that would not be finite and strictly
+ *         increasing
+ */
+PRTS_API prts_result_t prts_histogram_exponential_buckets(
+    double start,
+    double factor,
+    size_t count,
+    double* boundaries_out
+);
+
+/**
+ * Register a new metric and return a handle to it.
+ * @param collector The metrics collector
+ * @param config Metric configuration
+ * @param metric_out Output metric handle (valid until the collector is destroyed)
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_metrics_register_handle(
+    prts_metrics_collector_t* collector,
+    const prts_metric_config_t* config,
+    prts_metric_t** metric_out
+);
+
+/**
+ * Look up a registered metric by name.
+ * @param collector The metrics collector
+ * @param name Metric name
+ * @param metric_out Output metric handle
+ * @return PRTS_OK on success, PRTS_ERROR_INVALID if not registered
+ */
+PRTS_API prts_result_t prts_metrics_lookup(
+    prts_metrics_collector_t* collector,
+    const char* name,
+    prts_metric_t** metric_out
+);
+
+/**
+ * Bind a metric to a label set, creating the series if needed.
+ * Updates through the series handle skip name and label hashing.
+ * A bound series is never evicted until released with prts_metrics_unbind.
+ * @param metric The metric handle
+ * @param label_values One value per registered label, in order (NULL for no labels)
+ * @param series_out Output series handle
+ * @return PRTS_OK on success, PRTS_ERROR_FULL if a cardinality limit is reached
+ */
+PRTS_API prts_result_t prts_metrics_bind(
+    prts_metric_t* metric,
+    const char** label_values,
+    prts_metric_series_t** series_out
+);
+
+/**
+ * Release a series handle obtained from prts_metrics_bind.
+ * The series stays registered but becomes eligible for eviction.
+ * @param series The series handle
+ */
+PRTS_API void prts_metrics_unbind(prts_metric_series_t* series);
+
+/**
+ * Increment a bound counter series.
+ * @param series The series handle
+ * @param delta Increment amount
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_series_counter_inc(prts_metric_series_t* series, uint64_t delta);
+
+/**
+ * Set a bound gauge series.
+ * @param series The series handle
+ * @param value Gauge value
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_series_gauge_set(prts_metric_series_t* series, double value);
+
+/**
+ * Observe a value on a bound histogram or sketch series.
+ * @param series The series handle
+ * @param value Observed value
+ * @return PRTS_OK on success, PRTS_ERROR_INVALID for a non-finite value
+ *         on a sketch
+ */
+PRTS_API prts_result_t prts_series_histogram_observe(prts_metric_series_t* series, double value);
+
 /**
  * Increment a counter metric.
  * @param collector The metrics collector
  * @param name Metric name
- * @param label_values Label values (NULL for no labels)
+ * @param label_values One value per registered label, in order (NULL for no labels)
  * @param delta Increment amount
  * @return PRTS_OK on success
  */
@@ -95,7 +395,7 @@ PRTS_API prts_result_t prts_metrics_counter_inc(
  * Set a gauge metric.
  * @param collector The metrics collector
  * @param name Metric name
- * @param label_values Label values (NULL for no labels)
+ * @param label_values One value per registered label, in order (NULL for no labels)
  * @param value Gauge value
  * @return PRTS_OK on success
  */
@@ -107,12 +407,13 @@ PRTS_API prts_result_t prts_metrics_gauge_set(
 );
 
 /**
- * Observe a histogram value.
+ * Observe a histogram or sketch value.
  * @param collector The metrics collector
  * @param name Metric name
- * @param label_values Label values (NULL for no labels)
+ * @param label_values One value per registered label, in order (NULL for no labels)
  * @param value Observed value
- * @return PRTS_OK on success
+ * @return PRTS_OK on success, PRTS_ERROR_INVALID for a non-finite value
+ *         on a sketch
  */
 PRTS_API prts_result_t prts_metrics_histogram_observe(
     prts_metrics_collector_t* collector,
@@ -123,9 +424,13 @@ PRTS_API prts_result_t prts_metrics_histogram_observe(
 
 /**
  * Get metric value.
+ * A label set that has never been updated reads as zero. Histograms
+ * report count, sum and num_buckets; read the per-bucket counts with
+ * prts_metrics_get_buckets. Sketches report count, sum and
+ * p50/p90/p99/p999 in value_out->value.sketch.
  * @param collector The metrics collector
  * @param name Metric name
- * @param label_values Label values (NULL for no labels)
+ * @param label_values One value per registered label, in order (NULL for no labels)
  * @param value_out Output value
  * @return PRTS_OK on success
  */
@@ -136,13 +441,125 @@ PRTS_API prts_result_t prts_metrics_get(
     prts_metric_value_t* value_out
 );
 
+/**
+ * Get the per-bucket counts of a histogram series.
+ * Counts are per bucket, not cumulative, with +Inf last. A label set that
+ * has never been updated reads as zero.
+ * @param collector The metrics collector
+ * @param name Histogram metric name
+ * @param label_values One value per registered label, in order (NULL for no labels)
+ * @param counts_out Output counts (receives at most capacity buckets)
+ * @param capacity Size of counts_out
+ * @param num_buckets_out Output total number of buckets (may be NULL)
+ * @return PRTS_OK on success, PRTS_ERROR_INVALID if the metric is not a histogram
+ */
+PRTS_API prts_result_t prts_metrics_get_buckets(
+    prts_metrics_collector_t* collector,
+    const char* name,
+    const char** label_values,
+    uint64_t* counts_out,
+    size_t capacity,
+    size_t* num_buckets_out
+);
+
+/**
+ * Set cardinality limits for new series.
+ * Existing series are kept; updates that would create a series beyond a
+ * limit fail with PRTS_ERROR_FULL and are counted as dropped.
+ * @param collector The metrics collector
+ * @param limits Limits to apply
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_metrics_set_limits(
+    prts_metrics_collector_t* collector,
+    const prts_metrics_limits_t* limits
+);
+
+/**
+ * Advance the eviction epoch and remove stale series.
+ * A series is stale once idle_epochs calls have passed without an update;
+ * call this at a fixed period, e.g. every scrape. Bound series are kept.
+ * @param collector The metrics collector
+ * @param idle_epochs Number of epochs a series may stay idle (at least 1)
+ * @param evicted_out Output number of series removed (may be NULL)
+ * @return PRTS_OK on success, PRTS_ERROR_NOMEM if a series table could not
+ *         be rebuilt; the remaining stale series stay until the next call
+ */
+PRTS_API prts_result_t prts_metrics_evict_stale(
+    prts_metrics_collector_t* collector,
+    uint32_t idle_epochs,
+    size_t* evicted_out
+);
+
+/**
+ * Get collector statistics.
+ * @param collector The metrics collector
+ * @param stats_out Output statistics
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_metrics_stats(
+    prts_metrics_collector_t* collector,
+    prts_metrics_stats_t* stats_out
+);
+
+/**
+ * Compute the key identifying a series, as reported by prts_metrics_visit.
+ * @param collector The metrics collector
+ * @param name Metric name
+ * @param label_values One value per registered label, in order (NULL for no labels)
+ * @param key_out Output series key
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_metrics_series_key(
+    prts_metrics_collector_t* collector,
+    const char* name,
+    const char** label_values,
+    uint64_t* key_out
+);
+
+/**
+ * Read every series of every metric in one pass.
+ * All samples share one timestamp. The collector is read-locked for the
+ * duration, so updates proceed but new series wait until visit returns.
+ * @param collector The metrics collector
+ * @param visit Callback invoked once per series
+ * @param ctx Callback context
+ * @return PRTS_OK on success, PRTS_ERROR_NOMEM if a histogram or sketch
+ *         could not be copied (series visited so far stay visited)
+ */
+PRTS_API prts_result_t prts_metrics_visit(
+    prts_metrics_collector_t* collector,
+    prts_metrics_visit_fn visit,
+    void* ctx
+);
+
+/**
+ * Export metrics through a write callback.
+ * Output is produced in 16KB chunks, the last one shorter. Each metric's series are
+ * snapshotted under the collector lock and formatted after it is
+ * released, so a slow writer never blocks metric updates.
+ * @param collector The metrics collector
+ * @param format Exposition format
+ * @param write Called with each chunk; a non-OK result aborts the export
+ * @param ctx Callback context
+ * @return PRTS_OK on success, or the first error returned by write
+ */
+PRTS_API prts_result_t prts_metrics_export(
+    prts_metrics_collector_t* collector,
+    prts_export_format_t format,
+    prts_export_write_fn write,
+    void* ctx
+);
+
 /**
  * Export metrics in Prometheus format.
+ * The output is NUL-terminated; when it does not fit, the buffer holds
+ * as much as fits and PRTS_ERROR_FULL is returned.
  * @param collector The metrics collector
  * @param buffer Output buffer
  * @param buffer_size Buffer size
- * @param written_out Bytes written
- * @return PRTS_OK on success
+ * @param written_out Bytes written, excluding the NUL
+ * @return PRTS_OK on success, PRTS_ERROR_FULL if the buffer is too small
  */
 PRTS_API prts_result_t prts_metrics_export_prometheus(
     prts_metrics_collector_t* collector,
@@ -151,6 +568,268 @@ PRTS_API prts_result_t prts_metrics_export_prometheus(
     size_t* written_out
 );
 
+/* Common aggregation windows, in nanoseconds */
+#define PRTS_WINDOW_1M (60ULL * 1000000000ULL)
+#define PRTS_WINDOW_5M (300ULL * 1000000000ULL)
+#define PRTS_WINDOW_1H (3600ULL * 1000000000ULL)
+
+/* Aggregator configuration */
+typedef struct {
+    prts_timestamp_t interval;      /* Expected tick spacing in ns (0 for 10s) */
+    prts_timestamp_t retention;     /* Longest queryable window in ns (0 for 1h) */
+} prts_aggregator_config_t;
+
+/*
+ * Statistics of one series over a window. rate and irate are per second
+ * and treat a decrease of a counter as a reset. For histograms and
+ * sketches they count observations, avg is the mean observed value and
+ * min/max/last refer to the observation count.
+ */
+typedef struct {
+    double rate;                    /* Increase over the window */
+    double irate;                   /* Increase between the last two samples */
+    double min;
+    double max;
+    double avg;
+    double last;
+    size_t samples;                 /* Snapshots inside the window */
+} prts_window_stats_t;
+
+/**
+ * Create a time-window aggregator over a collector.
+ * The aggregator keeps a ring of per-interval snapshots for each series;
+ * call prts_metrics_aggregator_tick once per interval to take one.
+ * Sketch snapshots hold the bins their interval added, so sketch series
+ * cost memory in proportion to the spread of values in each interval.
+ * @param collector The metrics collector (must outlive the aggregator)
+ * @param config Aggregator configuration (NULL for defaults)
+ * @param aggregator_out Output pointer for aggregator
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_metrics_aggregator_create(
+    prts_metrics_collector_t* collector,
+    const prts_aggregator_config_t* config,
+    prts_metrics_aggregator_t** aggregator_out
+);
+
+/**
+ * Destroy an aggregator.
+ * @param aggregator The aggregator to destroy
+ */
+PRTS_API void prts_metrics_aggregator_destroy(prts_metrics_aggregator_t* aggregator);
+
+/**
+ * Snapshot every series of the collector.
+ * Series without a snapshot for a whole retention period are dropped.
+ * @param aggregator The aggregator
+ * @param now Snapshot timestamp (0 for the current time)
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_metrics_aggregator_tick(
+    prts_metrics_aggregator_t* aggregator,
+    prts_timestamp_t now
+);
+
+/**
+ * Compute window statistics for a series.
+ * The window ends at the newest snapshot of the series.
+ * @param aggregator The aggregator
+ * @param name Metric name
+ * @param label_values One value per registered label, in order (NULL for no labels)
+ * @param window Window length in ns (at most the retention)
+ * @param stats_out Output statistics
+ * @return PRTS_OK on success, PRTS_ERROR_EMPTY if the series has no snapshots
+ */
+PRTS_API prts_result_t prts_metrics_aggregator_query(
+    prts_metrics_aggregator_t* aggregator,
+    const char* name,
+    const char** label_values,
+    prts_timestamp_t window,
+    prts_window_stats_t* stats_out
+);
+
+/**
+ * Estimate a quantile of the observations a histogram or sketch received
+ * in a window. Histograms interpolate linearly within buckets; sketches
+ * merge the observations of each interval in the window and keep their
+ * relative accuracy.
+ * @param aggregator The aggregator
+ * @param name Histogram or sketch metric name
+ * @param label_values One value per registered label, in order (NULL for no labels)
+ * @param window Window length in ns (at most the retention)
+ * @param q Quantile in [0, 1]
+ * @param value_out Output value
+ * @return PRTS_OK on success, PRTS_ERROR_EMPTY if nothing was observed in the window,
+ *         PRTS_ERROR_INVALID for counters and gauges
+ */
+PRTS_API prts_result_t prts_metrics_aggregator_quantile(
+    prts_metrics_aggregator_t* aggregator,
+    const char* name,
+    const char** label_values,
+    prts_timestamp_t window,
+    double q,
+    double* value_out
+);
+
+#define PRTS_STORE_MAX_TIERS 4
+
+/* Rollup tier: bucket width and how long its buckets are kept */
+typedef struct {
+    prts_timestamp_t width;         /* Bucket width in ns, a whole number of ms */
+    prts_timestamp_t retention;     /* Kept in ns (0 disables the tier) */
+} prts_rollup_tier_t;
+
+/* Series store configuration */
+typedef struct {
+    prts_timestamp_t interval;      /* Sampling interval in ns (0 for 10s) */
+    prts_timestamp_t retention;     /* History kept in ns (0 for 24h) */
+    size_t chunk_bytes;             /* Compressed chunk size (0 for 512) */
+    const prts_rollup_tier_t* rollup_tiers; /* Finest first (NULL for 1m/7d and 1h/90d) */
+    size_t num_rollup_tiers;        /* 0 with non-NULL rollup_tiers disables rollups */
+} prts_store_config_t;
+
+/* One stored sample; timestamps are kept at millisecond resolution */
+typedef struct {
+    prts_timestamp_t timestamp;
+    double value;
+} prts_sample_t;
+
+/* Aggregate of the samples in one time bucket */
+typedef struct {
+    prts_timestamp_t timestamp;     /* Bucket start */
+    double min;
+    double max;
+    double sum;
+    uint64_t count;
+} prts_rollup_point_t;
+
+/* Series store memory usage */
+typedef struct {
+    size_t num_series;
+    size_t num_chunks;
+    uint64_t num_samples;
+    size_t bytes;                   /* Compressed sample data */
+    size_t rollup_points;           /* Points across all rollup tiers */
+    size_t rollup_bytes;            /* Compressed rollup data */
+} prts_store_stats_t;
+
+/**
+ * Create an in-memory series store over a collector.
+ * Samples are compressed Gorilla-style: delta-of-delta timestamps and
+ * XOR-encoded values, in fixed-size chunks. Histograms and sketches
+ * are stored as their observation count.
+ *
+ * As chunks seal, their samples are rolled up into each configured tier
+ * (by default 1m buckets kept for 7 days and 1h buckets kept for 90
+ * days), independent of the raw retention. Rollup points are compressed
+ * the same way as samples.
+ * @param collector The metrics collector (must outlive the store)
+ * @param config Store configuration (NULL for defaults)
+ * @param store_out Output pointer for store
+ * @return PRTS_OK on success, PRTS_ERROR_INVALID for more than
+ *         PRTS_STORE_MAX_TIERS tiers, or tiers not whole milliseconds wide
+ *         or not ordered finest first
+ */
+PRTS_API prts_result_t prts_series_store_create(
+    prts_metrics_collector_t* collector,
+    const prts_store_config_t* config,
+    prts_series_store_t** store_out
+);
+
+/**
+ * Destroy a series store.
+ * @param store The store to destroy
+ */
+PRTS_API void prts_series_store_destroy(prts_series_store_t* store);
+
+/**
+ * Append one sample of every collector series, and drop chunks older
+ * than the retention. Calls less than half an interval after the
+ * previous sample are ignored, so the store may be ticked more often
+ * than its interval.
+ * @param store The series store
+ * @param now Sample timestamp (0 for the current time)
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_series_store_sample(
+    prts_series_store_t* store,
+    prts_timestamp_t now
+);
+
+/**
+ * Append a sample to a series directly.
+ * @param store The series store
+ * @param series_key Series key (see prts_metrics_series_key)
+ * @param timestamp Sample timestamp, later than the series' previous one
+ * @param value Sample value
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_series_store_append(
+    prts_series_store_t* store,
+    uint64_t series_key,
+    prts_timestamp_t timestamp,
+    double value
+);
+
+/**
+ * Read the samples of a series in [from, to], oldest first.
+ * Only chunks overlapping the range are decoded.
+ * @param store The series store
+ * @param series_key Series key (see prts_metrics_series_key)
+ * @param from Range start (inclusive)
+ * @param to Range end (inclusive)
+ * @param samples_out Output samples array
+ * @param max_samples Maximum samples to return
+ * @param count_out Actual number of samples returned
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_series_store_query(
+    prts_series_store_t* store,
+    uint64_t series_key,
+    prts_timestamp_t from,
+    prts_timestamp_t to,
+    prts_sample_t* samples_out,
+    size_t max_samples,
+    size_t* count_out
+);
+
+/**
+ * Read a series in [from, to] aggregated into step-sized buckets.
+ * The coarsest rollup tier no wider than step is used, with raw samples
+ * filling in the span not rolled up yet; steps finer than every tier read
+ * raw samples only. Buckets without samples are omitted.
+ * @param store The series store
+ * @param series_key Series key (see prts_metrics_series_key)
+ * @param from Range start (inclusive)
+ * @param to Range end (inclusive)
+ * @param step Bucket width in ns
+ * @param points_out Output points array, oldest first
+ * @param max_points Maximum points to return
+ * @param count_out Actual number of points returned
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_series_store_query_rollup(
+    prts_series_store_t* store,
+    uint64_t series_key,
+    prts_timestamp_t from,
+    prts_timestamp_t to,
+    prts_timestamp_t step,
+    prts_rollup_point_t* points_out,
+    size_t max_points,
+    size_t* count_out
+);
+
+/**
+ * Get the memory usage of a series store.
+ * @param store The series store
+ * @param stats_out Output statistics
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_series_store_stats(
+    prts_series_store_t* store,
+    prts_store_stats_t* stats_out
+);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,105 @@
+/**
+ * PRTS Native - Platform Topology
+ * CPU sets, thread affinity and NUMA-local memory.
+ */
+
+#ifndef PRTS_PLATFORM_H
+#define PRTS_PLATFORM_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PRTS_MAX_CPUS 1024
+#define PRTS_MAX_NUMA_NODES 64
+
+/* Set of logical CPUs, by index */
+typedef struct {
+    uint64_t bits[PRTS_MAX_CPUS / 64];
+} prts_cpu_set_t;
+
+static inline void prts_cpu_set_zero(prts_cpu_set_t* set) {
+    for (size_t i = 0; i < PRTS_MAX_CPUS / 64; i++) set->bits[i] = 0;
+}
+
+static inline void prts_cpu_set_add(prts_cpu_set_t* set, size_t cpu) {
+    if (cpu < PRTS_MAX_CPUS) set->bits[cpu / 64] |= 1ULL << (cpu % 64);
+}
+
+static inline bool prts_cpu_set_has(const prts_cpu_set_t* set, size_t cpu) {
+    return cpu < PRTS_MAX_CPUS && (set->bits[cpu / 64] >> (cpu % 64)) & 1;
+}
+
+static inline bool prts_cpu_set_empty(const prts_cpu_set_t* set) {
+    for (size_t i = 0; i < PRTS_MAX_CPUS / 64; i++) {
+        if (set->bits[i]) return false;
+    }
+    return true;
+}
+
+/**
+ * Get the number of online CPUs.
+ * @return CPU count (at least 1)
+ */
+PRTS_API size_t prts_cpu_count(void);
+
+/**
+ * Get the number of NUMA nodes.
+ * Node ids run from 0 to the count minus one; a machine without NUMA
+ * reports a single node holding every CPU.
+ * @return Node count (at least 1)
+ */
+PRTS_API size_t prts_numa_node_count(void);
+
+/**
+ * Get the CPUs of a NUMA node.
+ * @param node Node id
+ * @param cpus Output CPU set
+ * @return PRTS_OK on success, PRTS_ERROR_INVALID for an unknown or CPU-less node
+ */
+PRTS_API prts_result_t prts_numa_node_cpus(size_t node, prts_cpu_set_t* cpus);
+
+/**
+ * Get the NUMA node of the CPU the calling thread is running on.
+ * @return Node id, 0 where unknown
+ */
+PRTS_API size_t prts_numa_current_node(void);
+
+/**
+ * Restrict the calling thread to a set of CPUs.
+ * @param cpus CPU set
+ * @return PRTS_OK on success, PRTS_ERROR where affinity is unsupported
+ */
+PRTS_API prts_result_t prts_thread_set_affinity(const prts_cpu_set_t* cpus);
+
+/**
+ * Prefer a NUMA node for the calling thread's future allocations.
+ * @param node Node id
+ * @return PRTS_OK on success, PRTS_ERROR where unsupported
+ */
+PRTS_API prts_result_t prts_thread_bind_memory(size_t node);
+
+/**
+ * Allocate page-aligned memory placed on a NUMA node.
+ * Placement is a preference: the kernel falls back to other nodes when
+ * the node is out of memory. Release with prts_numa_free.
+ * @param size Size in bytes
+ * @param node Node id
+ * @return Zeroed memory, or NULL on failure
+ */
+PRTS_API void* prts_numa_alloc(size_t size, size_t node);
+
+/**
+ * Free memory from prts_numa_alloc.
+ * @param ptr Memory, may be NULL
+ * @param size Size passed to prts_numa_alloc
+ */
+PRTS_API void prts_numa_free(void* ptr, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PRTS_PLATFORM_H */
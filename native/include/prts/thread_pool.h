@@ -7,6 +7,7 @@
 #define PRTS_THREAD_POOL_H
 
 #include "types.h"
+#include "platform.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,21 +19,75 @@ typedef struct {
     size_t queue_size;      /* Task queue size */
     bool allow_grow;        /* Allow dynamic thread growth */
     size_t max_threads;     /* Maximum threads if allow_grow is true */
+    bool work_stealing;     /* Queue tasks submitted by workers on per-worker deques */
+    uint32_t grow_wait_us;  /* Queue wait that adds a worker when all are busy (0 = 1ms) */
+    uint32_t idle_timeout_ms; /* Idle time before workers above num_threads retire (0 = 5s) */
+    uint32_t aging_ms;      /* Queue wait that raises a task one priority level (0 = 100ms) */
+    prts_cpu_set_t cpus;    /* Pin workers to these CPUs (empty = no pinning) */
+    bool bind_memory;       /* Workers prefer memory on the NUMA node they run on */
 } prts_threadpool_config_t;
 
+/* Task priority; each level has its own queue lane */
+typedef enum {
+    PRTS_PRIORITY_HIGH = 0,     /* Latency-sensitive work such as interactive queries */
+    PRTS_PRIORITY_NORMAL = 1,
+    PRTS_PRIORITY_LOW = 2,      /* Background work such as compaction */
+} prts_task_priority_t;
+
+/* Per-task submission options */
+typedef struct {
+    prts_task_priority_t priority;
+    uint32_t deadline_ms;   /* Drop the task if it has not started by then (0 = none) */
+} prts_task_options_t;
+
 /* Thread pool statistics */
 typedef struct {
     size_t active_threads;
     size_t idle_threads;
     size_t pending_tasks;
     size_t completed_tasks;
-    uint64_t total_wait_ns;
-    uint64_t total_exec_ns;
+    size_t expired_tasks;   /* Dropped because their deadline passed */
+    uint64_t total_wait_ns; /* Time tasks spent queued before starting */
+    uint64_t total_exec_ns; /* Time tasks spent running */
+    uint64_t wait_p50_ns;   /* Queue wait quantiles, within about 25% */
+    uint64_t wait_p99_ns;
+    uint64_t exec_p50_ns;   /* Run time quantiles, within about 25% */
+    uint64_t exec_p99_ns;
 } prts_threadpool_stats_t;
 
 /* Task handle */
 typedef struct prts_task prts_task_t;
 
+/* Delayed or periodic task */
+typedef struct prts_timer prts_timer_t;
+
+/* Result of asynchronous work: a result code and a value */
+typedef struct prts_future prts_future_t;
+
+/* Asynchronous task; sets *value_out and returns its result code */
+typedef prts_result_t (*prts_future_fn)(void* arg, void** value_out);
+
+/* Continuation; receives the antecedent's value */
+typedef prts_result_t (*prts_then_fn)(void* value, void* arg, void** value_out);
+
+/* One thread pool per NUMA node */
+typedef struct prts_numa_pool prts_numa_pool_t;
+
+/* Loop body over the index range [begin, end) */
+typedef void (*prts_range_fn)(size_t begin, size_t end, void* arg);
+
+/* Reduction body: fold [begin, end) into acc */
+typedef void (*prts_reduce_fn)(size_t begin, size_t end, void* acc, void* arg);
+
+/* Merge accumulator other into acc */
+typedef void (*prts_combine_fn)(void* acc, const void* other, void* arg);
+
+/* Task graph (DAG of tasks) */
+typedef struct prts_task_graph prts_task_graph_t;
+
+/* Graph task; a non-OK result cancels every task downstream of it */
+typedef prts_result_t (*prts_graph_task_fn)(void* arg);
+
 /**
  * Create a new thread pool.
  * @param config Pool configuration
@@ -46,13 +101,17 @@ PRTS_API prts_result_t prts_threadpool_create(
 
 /**
  * Destroy a thread pool.
- * Waits for all pending tasks to complete.
+ * Waits for all pending tasks to complete. Task handles belong to the
+ * pool and must be freed before it is destroyed.
  * @param pool The thread pool
  */
 PRTS_API void prts_threadpool_destroy(prts_thread_pool_t* pool);
 
 /**
  * Submit a task to the thread pool.
+ * Tasks from other threads go through a shared queue bounded by queue_size.
+ * Tasks submitted from a worker are never blocked by the bound; with
+ * work_stealing they go to the worker's own deque.
  * @param pool The thread pool
  * @param fn Task function
  * @param arg Task argument
@@ -66,6 +125,8 @@ PRTS_API prts_result_t prts_threadpool_submit(
 
 /**
  * Submit a task and get a handle for waiting.
+ * Task nodes and handles are recycled by the pool, so steady-state
+ * submission does not allocate.
  * @param pool The thread pool
  * @param fn Task function
  * @param arg Task argument
@@ -79,20 +140,317 @@ PRTS_API prts_result_t prts_threadpool_submit_wait(
     prts_task_t** task_out
 );
 
+/**
+ * Submit a task with a priority and an optional deadline.
+ * Higher priorities are dispatched first; a queued task is raised one
+ * level for every aging_ms it waits, so lower priorities still progress.
+ * A task still queued when its deadline passes is dropped and its
+ * handle's wait returns PRTS_ERROR_CANCELLED.
+ * @param pool The thread pool
+ * @param fn Task function
+ * @param arg Task argument
+ * @param options Priority and deadline (NULL = normal priority, no deadline)
+ * @param task_out Optional output pointer for task handle
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_threadpool_submit_ex(
+    prts_thread_pool_t* pool,
+    prts_task_fn fn,
+    void* arg,
+    const prts_task_options_t* options,
+    prts_task_t** task_out
+);
+
+/**
+ * Submit several tasks at once.
+ * All tasks are queued with a single lock acquisition and wakeup, or none
+ * are. A batch larger than queue_size is admitted once the queue is empty.
+ * @param pool The thread pool
+ * @param fn Task function
+ * @param args One argument per task
+ * @param count Number of tasks
+ * @param tasks_out Optional array of count task handles
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_threadpool_submit_batch(
+    prts_thread_pool_t* pool,
+    prts_task_fn fn,
+    void* const* args,
+    size_t count,
+    prts_task_t** tasks_out
+);
+
+/**
+ * Run fn over [begin, end) in parallel and wait for it to finish.
+ * The range is split into chunks of grain items that the calling thread
+ * and up to one helper per worker claim dynamically. Called from a
+ * worker, it runs other queued tasks while waiting, so loops may nest.
+ * @param pool The thread pool
+ * @param begin First index
+ * @param end One past the last index
+ * @param grain Items per chunk (0 = automatic)
+ * @param fn Loop body, called once per chunk
+ * @param arg Loop body argument
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_threadpool_parallel_for(
+    prts_thread_pool_t* pool,
+    size_t begin,
+    size_t end,
+    size_t grain,
+    prts_range_fn fn,
+    void* arg
+);
+
+/**
+ * Reduce [begin, end) in parallel.
+ * Each participating thread folds its chunks into a private accumulator
+ * initialized from identity; the accumulators are then combined into
+ * result_out on the calling thread. combine must be associative and
+ * commutative.
+ * @param pool The thread pool
+ * @param begin First index
+ * @param end One past the last index
+ * @param grain Items per chunk (0 = automatic)
+ * @param acc_size Accumulator size in bytes
+ * @param identity Initial accumulator value
+ * @param reduce Reduction body, called once per chunk
+ * @param combine Accumulator merge
+ * @param arg Argument for reduce and combine
+ * @param result_out Output accumulator (acc_size bytes)
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_threadpool_parallel_reduce(
+    prts_thread_pool_t* pool,
+    size_t begin,
+    size_t end,
+    size_t grain,
+    size_t acc_size,
+    const void* identity,
+    prts_reduce_fn reduce,
+    prts_combine_fn combine,
+    void* arg,
+    void* result_out
+);
+
+/**
+ * Create an empty task graph.
+ * Graphs are built, submitted and waited for from one thread at a time.
+ * @param pool The thread pool that runs the graph
+ * @param graph_out Output pointer for the graph
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_task_graph_create(
+    prts_thread_pool_t* pool,
+    prts_task_graph_t** graph_out
+);
+
+/**
+ * Destroy a task graph, waiting for it first if it is running.
+ * @param graph The task graph
+ */
+PRTS_API void prts_task_graph_destroy(prts_task_graph_t* graph);
+
+/**
+ * Add a task to a graph.
+ * @param graph The task graph (not running)
+ * @param fn Task function
+ * @param arg Task argument
+ * @param node_out Output node id (may be NULL)
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_task_graph_add(
+    prts_task_graph_t* graph,
+    prts_graph_task_fn fn,
+    void* arg,
+    size_t* node_out
+);
+
+/**
+ * Make one task run only after another has finished.
+ * @param graph The task graph (not running)
+ * @param from Node that must finish first
+ * @param to Node that depends on it
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_task_graph_add_edge(
+    prts_task_graph_t* graph,
+    size_t from,
+    size_t to
+);
+
+/**
+ * Start running a graph.
+ * Tasks without predecessors are queued at once; every other task is
+ * queued by whichever worker finishes its last predecessor. A graph may
+ * be submitted again after it has been waited for.
+ * @param graph The task graph
+ * @return PRTS_OK on success, PRTS_ERROR_INVALID if the graph has a cycle
+ */
+PRTS_API prts_result_t prts_task_graph_submit(prts_task_graph_t* graph);
+
+/**
+ * Cancel a running graph. Tasks that have not started are skipped.
+ * @param graph The task graph
+ */
+PRTS_API void prts_task_graph_cancel(prts_task_graph_t* graph);
+
+/**
+ * Wait for every task of a graph to finish or be skipped.
+ * @param graph The task graph
+ * @param timeout_ms Timeout in milliseconds (0 = no wait, -1 = infinite)
+ * @return PRTS_OK if every task succeeded, the first task failure,
+ *         PRTS_ERROR_CANCELLED if tasks were cancelled, or PRTS_ERROR_TIMEOUT
+ */
+PRTS_API prts_result_t prts_task_graph_wait(prts_task_graph_t* graph, int timeout_ms);
+
+/**
+ * Get the result of one task after the graph has been waited for.
+ * Skipped tasks report PRTS_ERROR_CANCELLED.
+ * @param graph The task graph
+ * @param node Node id
+ * @param result_out Output task result
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_task_graph_node_result(
+    prts_task_graph_t* graph,
+    size_t node,
+    prts_result_t* result_out
+);
+
 /**
  * Wait for a task to complete.
  * @param task The task handle
  * @param timeout_ms Timeout in milliseconds (0 = no wait, -1 = infinite)
- * @return PRTS_OK on success, PRTS_ERROR_TIMEOUT on timeout
+ * @return PRTS_OK on success, PRTS_ERROR_TIMEOUT on timeout,
+ *         PRTS_ERROR_CANCELLED if the task was dropped at its deadline
  */
 PRTS_API prts_result_t prts_task_wait(prts_task_t* task, int timeout_ms);
 
 /**
  * Free a task handle.
+ * May be called before the task has run; the handle is recycled once it has.
  * @param task The task handle
  */
 PRTS_API void prts_task_free(prts_task_t* task);
 
+/**
+ * Create a pending future to be completed with prts_future_set (a promise).
+ * @param pool Pool that runs the future's continuations
+ * @param future_out Output pointer for the future
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_future_create(prts_thread_pool_t* pool, prts_future_t** future_out);
+
+/**
+ * Complete a future created with prts_future_create.
+ * Continuations are dispatched from the calling thread.
+ * @param future The future
+ * @param result Result code; anything but PRTS_OK fails dependent continuations
+ * @param value Value passed to continuations
+ * @return PRTS_OK on success, PRTS_ERROR_INVALID if already completed
+ */
+PRTS_API prts_result_t prts_future_set(prts_future_t* future, prts_result_t result, void* value);
+
+/**
+ * Run fn on the pool and get a future for its result.
+ * @param pool The thread pool
+ * @param fn Task function
+ * @param arg Task argument
+ * @param future_out Output pointer for the future
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_threadpool_async(
+    prts_thread_pool_t* pool,
+    prts_future_fn fn,
+    void* arg,
+    prts_future_t** future_out
+);
+
+/**
+ * Chain a continuation onto a future.
+ * Once future succeeds, fn runs on the pool with its value, and next
+ * completes with fn's result and value. If future fails, fn is skipped
+ * and next fails with the same result, so errors flow down a chain.
+ * @param future The antecedent
+ * @param fn Continuation
+ * @param arg Continuation argument
+ * @param next_out Output pointer for the continuation's future
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_future_then(
+    prts_future_t* future,
+    prts_then_fn fn,
+    void* arg,
+    prts_future_t** next_out
+);
+
+/**
+ * Get a future that completes when all futures have succeeded, or as
+ * soon as one fails, with that failure's result. Its value is NULL; read
+ * each input's value from the input. An empty set completes at once.
+ * @param pool Pool for the combined future
+ * @param futures Input futures
+ * @param count Number of futures
+ * @param future_out Output pointer for the combined future
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_future_when_all(
+    prts_thread_pool_t* pool,
+    prts_future_t* const* futures,
+    size_t count,
+    prts_future_t** future_out
+);
+
+/**
+ * Get a future that completes with the value of the first future to
+ * succeed, or with the last failure if every one fails.
+ * @param pool Pool for the combined future
+ * @param futures Input futures
+ * @param count Number of futures (must be > 0)
+ * @param future_out Output pointer for the combined future
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_future_when_any(
+    prts_thread_pool_t* pool,
+    prts_future_t* const* futures,
+    size_t count,
+    prts_future_t** future_out
+);
+
+/**
+ * Check whether a future has completed.
+ * @param future The future
+ * @return true once completed
+ */
+PRTS_API bool prts_future_ready(const prts_future_t* future);
+
+/**
+ * Wait for a future to complete.
+ * Called from a worker without a timeout, it runs other tasks meanwhile.
+ * @param future The future
+ * @param timeout_ms Timeout in milliseconds (0 = no wait, -1 = infinite)
+ * @return PRTS_OK once completed, PRTS_ERROR_TIMEOUT on timeout
+ */
+PRTS_API prts_result_t prts_future_wait(prts_future_t* future, int timeout_ms);
+
+/**
+ * Wait for a future and get its outcome.
+ * @param future The future
+ * @param value_out Optional output for the value
+ * @return The future's result code
+ */
+PRTS_API prts_result_t prts_future_get(prts_future_t* future, void** value_out);
+
+/**
+ * Release a future handle.
+ * Pending work still completes; the future is freed once nothing refers
+ * to it. Futures must be released, and complete, before the pool is
+ * destroyed.
+ * @param future The future
+ */
+PRTS_API void prts_future_release(prts_future_t* future);
+
 /**
  * Get thread pool statistics.
  * @param pool The thread pool
@@ -104,6 +462,121 @@ PRTS_API prts_result_t prts_threadpool_stats(
     prts_threadpool_stats_t* stats
 );
 
+/**
+ * Get the number of core workers, without the cost of a stats snapshot.
+ * Workers added by allow_grow are not counted.
+ * @param pool The thread pool
+ * @return Core worker count (0 for a NULL pool)
+ */
+PRTS_API size_t prts_threadpool_num_threads(const prts_thread_pool_t* pool);
+
+/**
+ * Run a task once after a delay.
+ * Timers live in a hierarchical wheel with 1ms ticks advanced by the
+ * pool's own workers, so they need no extra threads and cost O(1) to arm,
+ * cancel and expire. Expired tasks run on a worker like any other task.
+ * @param pool The thread pool
+ * @param delay_ms Delay in milliseconds
+ * @param fn Task function
+ * @param arg Task argument
+ * @param timer_out Optional handle, to be released with prts_timer_cancel
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_threadpool_submit_after(
+    prts_thread_pool_t* pool,
+    uint32_t delay_ms,
+    prts_task_fn fn,
+    void* arg,
+    prts_timer_t** timer_out
+);
+
+/**
+ * Run a task every period, first after one period.
+ * A run is skipped while the previous one is still in progress, and a
+ * timer that falls behind keeps its cadence from the current time rather
+ * than catching up in a burst.
+ * @param pool The thread pool
+ * @param period_ms Period in milliseconds (must be > 0)
+ * @param fn Task function
+ * @param arg Task argument
+ * @param timer_out Optional handle, to be released with prts_timer_cancel
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_threadpool_submit_every(
+    prts_thread_pool_t* pool,
+    uint32_t period_ms,
+    prts_task_fn fn,
+    void* arg,
+    prts_timer_t** timer_out
+);
+
+/**
+ * Cancel a timer and release its handle.
+ * A run already handed to a worker still completes. Handles must be
+ * released before the pool is destroyed; destroying the pool drops
+ * timers that have not fired.
+ * @param timer Timer handle
+ * @return PRTS_OK if the timer was stopped, PRTS_ERROR_EMPTY if a
+ *         one-shot timer had already fired
+ */
+PRTS_API prts_result_t prts_timer_cancel(prts_timer_t* timer);
+
+/**
+ * Create one thread pool per NUMA node.
+ * Each pool is created from config with its workers pinned to the node's
+ * CPUs (config->cpus is ignored), so its queues and the tasks' working
+ * memory stay node-local. num_threads is per node; 0 means one per CPU
+ * of the node. Set bind_memory to have workers allocate from their node.
+ * @param config Configuration applied to every node's pool
+ * @param pool_out Output pointer for the NUMA pool
+ * @return PRTS_OK on success
+ */
+PRTS_API prts_result_t prts_numa_pool_create(
+    const prts_threadpool_config_t* config,
+    prts_numa_pool_t** pool_out
+);
+
+/**
+ * Destroy a NUMA pool and every node's thread pool.
+ * @param pool The NUMA pool
+ */
+PRTS_API void prts_numa_pool_destroy(prts_numa_pool_t* pool);
+
+/**
+ * Get the thread pool of a NUMA node.
+ * @param pool The NUMA pool
+ * @param node Node id
+ * @return The node's pool, or NULL if the node has no CPUs
+ */
+PRTS_API prts_thread_pool_t* prts_numa_pool_node(prts_numa_pool_t* pool, size_t node);
+
+/**
+ * Get the thread pool local to the calling thread.
+ * Workers get their own pool; other threads get the pool of the node
+ * they are running on, or the first pool if that node has none. Submit
+ * here to keep a task on the submitter's node; pair with
+ * prts_numa_alloc(size, prts_numa_current_node()) for its buffers.
+ * @param pool The NUMA pool
+ * @return The local node's pool
+ */
+PRTS_API prts_thread_pool_t* prts_numa_pool_local(prts_numa_pool_t* pool);
+
+/**
+ * Mark the calling task as about to block (I/O, locks, sleeps).
+ * In a growable pool this starts an extra worker, up to max_threads, so
+ * that num_threads workers stay available for other tasks. Has no effect
+ * outside a pool worker or when allow_grow is false.
+ * @param pool The thread pool
+ */
+PRTS_API void prts_threadpool_block_begin(prts_thread_pool_t* pool);
+
+/**
+ * End a blocking section started with prts_threadpool_block_begin.
+ * Surplus workers retire after idle_timeout_ms without work.
+ * @param pool The thread pool
+ */
+PRTS_API void prts_threadpool_block_end(prts_thread_pool_t* pool);
+
 /**
  * Wait for all pending tasks to complete.
  * @param pool The thread pool
@@ -29,6 +29,7 @@ typedef enum {
     PRTS_ERROR_TIMEOUT = -4,
     PRTS_ERROR_FULL = -5,
     PRTS_ERROR_EMPTY = -6,
+    PRTS_ERROR_CANCELLED = -7,
 } prts_result_t;
 
 /* Timestamp in nanoseconds */
@@ -39,8 +40,11 @@ typedef struct prts_memory_pool prts_memory_pool_t;
 typedef struct prts_thread_pool prts_thread_pool_t;
 typedef struct prts_ring_buffer prts_ring_buffer_t;
 typedef struct prts_metrics_collector prts_metrics_collector_t;
+typedef struct prts_metrics_aggregator prts_metrics_aggregator_t;
+typedef struct prts_series_store prts_series_store_t;
 typedef struct prts_log_parser prts_log_parser_t;
 typedef struct prts_log_indexer prts_log_indexer_t;
+typedef struct prts_log_mapping prts_log_mapping_t;
 
 /* Callback types */
 typedef void (*prts_task_fn)(void* arg);
@@ -1,10 +1,32 @@
 /**
  * PRTS Native - Thread Pool Implementation
+ *
+ * Tasks submitted from outside the pool go through a shared injection
+ * queue. In work-stealing mode each worker also owns a Chase-Lev deque:
+ * tasks submitted from a worker are pushed to its own deque, popped LIFO
+ * by the owner and stolen FIFO by idle workers.
+ *
+ * The injection queue has one FIFO lane per priority. Lanes are served
+ * highest first, but a lane's head gains one level for every aging
+ * interval it has waited, so background work keeps making progress.
+ *
+ * Futures complete with a result code and a value. Continuations are
+ * queued on the future and dispatched by whichever thread completes it,
+ * so chains run without parking a thread per stage.
+ *
+ * Delayed and periodic tasks sit in a hierarchical timer wheel. There
+ * is no timer thread: one sleeping worker waits for the next wheel event,
+ * and workers looking for tasks advance the wheel once it is due.
+ *
+ * A NUMA pool is one such pool per node, each pinned to its node's CPUs.
  */
 
 #include "prts/thread_pool.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include <time.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -13,456 +35,2852 @@
 #include <unistd.h>
 #endif
 
-/* Task structure */
-typedef struct task_node {
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#define CACHE_LINE_SIZE 64
+
+/* Initial per-worker deque capacity (power of two); deques grow on demand */
+#define INITIAL_DEQUE_CAPACITY 256
+
+/* Passes over the other workers' deques before going to sleep */
+#define STEAL_ROUNDS 2
+
+/* Task nodes are carved from slabs and recycled, never returned to the system */
+#define TASK_SLAB_SIZE 64
+#define TASK_CACHE_MAX 256  /* Per-worker free nodes; half go back to the pool beyond this */
+
+/* Elastic pools: defaults for the growth trigger and surplus retirement */
+#define DEFAULT_GROW_WAIT_US 1000
+#define DEFAULT_IDLE_TIMEOUT_MS 5000
+
+/* Injection queue lanes, one per prts_task_priority_t */
+#define NUM_LANES 3
+#define DEFAULT_AGING_MS 100
+
+/*
+ * Latency histograms: four linear sub-buckets per power of two of
+ * nanoseconds (about 25% resolution), exact below 4ns, clamped at 2^40ns.
+ */
+#define LATENCY_SUB_BITS 2
+#define LATENCY_MAX_OCTAVE 39
+#define LATENCY_BUCKETS ((LATENCY_MAX_OCTAVE << LATENCY_SUB_BITS) + (1 << LATENCY_SUB_BITS))
+
+/*
+ * Timer wheel: four levels of 64 slots over 1ms ticks, covering about
+ * 4.6 hours; later expiries wait in the last level and are re-cascaded.
+ */
+#define TIMER_LEVEL_BITS 6
+#define TIMER_SLOTS (1 << TIMER_LEVEL_BITS)
+#define TIMER_LEVELS 4
+#define TIMER_TICK_NS 1000000ULL
+#define TIMER_FIRE_BATCH 32
+#define TIMER_NONE UINT64_MAX
+
+/* Timer states, guarded by the wheel lock */
+#define TIMER_ARMED 0
+#define TIMER_FIRED 1       /* One-shot, handed to a worker */
+#define TIMER_CANCELLED 2
+
+/* Worker slot states, guarded by the pool lock */
+#define SLOT_EMPTY 0        /* No thread */
+#define SLOT_RUNNING 1
+#define SLOT_EXITED 2       /* Thread retired, not yet joined */
+
+/* Task completion states */
+#define TASK_PENDING 0
+#define TASK_WAITED 1       /* Pending, with a thread blocked in prts_task_wait */
+#define TASK_DONE 2
+
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+#ifdef _WIN32
+typedef CONDITION_VARIABLE pool_cond_t;
+#else
+typedef pthread_cond_t pool_cond_t;
+#endif
+
+/*
+ * Task node. It doubles as the wait handle returned by
+ * prts_threadpool_submit_wait, and is recycled once the task has run and
+ * the handle, if any, has been freed.
+ */
+struct prts_task {
     prts_task_fn fn;
     void* arg;
-    struct task_node* next;
-    prts_task_t* wait_handle;
-} task_node_t;
+    struct prts_task* next;         /* Injection queue or free list */
+    prts_thread_pool_t* pool;
+    prts_timestamp_t queued_at;
+    prts_timestamp_t deadline;      /* Latest start time, 0 = none */
+    uint8_t priority;
+    bool expired;                   /* Dropped at its deadline; read after completion */
+    _Atomic uint32_t refs;          /* One for the queue, one for a handle */
+    _Atomic uint32_t state;         /* Futex word: TASK_PENDING, TASK_WAITED or TASK_DONE */
+};
 
-/* Task wait handle */
-struct prts_task {
-    bool completed;
+typedef struct prts_task task_node_t;
+
+/* Per-worker latency totals and distribution; written by the owner only */
+typedef struct {
+    _Atomic uint64_t total_ns;
+    _Atomic uint64_t buckets[LATENCY_BUCKETS];
+} latency_hist_t;
+
+/* Delayed or periodic task; doubles as the handle from submit_after/every */
+struct prts_timer {
+    prts_task_fn fn;
+    void* arg;
+    prts_thread_pool_t* pool;
+    uint64_t expires;               /* Wheel tick */
+    uint64_t period;                /* Ticks between runs, 0 = one-shot */
+    struct prts_timer* next;        /* Slot list */
+    struct prts_timer** pprev;
+    struct prts_timer* fired_next;  /* Runs collected by timer_advance */
+    uint8_t level;
+    uint8_t slot;
+    int state;                      /* TIMER_*, guarded by the wheel lock */
+    _Atomic bool running;           /* A periodic run is in flight */
+    _Atomic uint32_t refs;          /* Wheel or in-flight run, plus the handle */
+};
+
+typedef struct {
 #ifdef _WIN32
-    HANDLE event;
+    CRITICAL_SECTION lock;
 #else
-    pthread_mutex_t mutex;
-    pthread_cond_t cond;
+    pthread_mutex_t lock;
 #endif
-};
+    prts_timestamp_t base;          /* Time of tick 0 */
+    uint64_t current;               /* Last processed tick */
+    uint64_t occupied[TIMER_LEVELS]; /* Non-empty slot bitmaps */
+    struct prts_timer* slots[TIMER_LEVELS][TIMER_SLOTS];
+} timer_wheel_t;
+
+typedef struct task_slab {
+    struct task_slab* next;
+    task_node_t tasks[TASK_SLAB_SIZE];
+} task_slab_t;
+
+/* Deque storage; replaced by a copy twice the size when full */
+typedef struct deque_array {
+    int64_t capacity;               /* Power of two */
+    struct deque_array* retired;    /* Previous array, freed with the deque */
+    _Atomic(task_node_t*) slots[];
+} deque_array_t;
+
+/* Worker state. The thief end (top) gets its own cache line. */
+typedef struct {
+    _Atomic int64_t top;
+    char top_padding[CACHE_LINE_SIZE - sizeof(int64_t)];
+
+    /* Written by the owning worker only */
+    _Atomic int64_t bottom;
+    _Atomic(deque_array_t*) array;
+    _Atomic uint64_t submitted;     /* Tasks pushed to this deque */
+    _Atomic uint64_t completed;     /* Tasks run by this worker */
+    _Atomic uint64_t expired;       /* Tasks dropped at their deadline */
+    _Atomic bool busy;
+    latency_hist_t wait;            /* Queued until started */
+    latency_hist_t exec;            /* Started until finished */
+    uint64_t rng;                   /* Victim selection */
+    task_node_t* free_tasks;        /* Node cache */
+    size_t num_free_tasks;
+
+    prts_thread_pool_t* pool;
+    int status;                     /* SLOT_*, guarded by the pool lock */
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+    char padding[CACHE_LINE_SIZE];
+} worker_t;
 
 /* Thread pool structure */
 struct prts_thread_pool {
-    size_t num_threads;
+    size_t num_threads;             /* Core workers, always kept */
     size_t queue_size;
     size_t max_threads;
     bool allow_grow;
+    bool work_stealing;
     bool shutdown;
 
+    /* Worker placement, applied by each worker as it starts */
+    prts_cpu_set_t cpus;
+    bool pinned;
+    bool bind_memory;
+
+    /* One slot per potential worker; slots outlive retired threads */
+    worker_t* workers;
+    size_t num_slots;
+    size_t num_live;                /* Running workers, guarded by lock */
+    size_t num_blocked;             /* Workers inside block_begin/end, guarded by lock */
+    uint64_t grow_wait_ns;
+    uint32_t idle_timeout_ms;
+
 #ifdef _WIN32
-    HANDLE* threads;
     CRITICAL_SECTION lock;
-    CONDITION_VARIABLE not_empty;
-    CONDITION_VARIABLE not_full;
 #else
-    pthread_t* threads;
     pthread_mutex_t lock;
-    pthread_cond_t not_empty;
-    pthread_cond_t not_full;
 #endif
-
-    task_node_t* head;
-    task_node_t* tail;
-    size_t task_count;
-
-    size_t active_count;
-    size_t completed_count;
-    uint64_t total_wait_ns;
-    uint64_t total_exec_ns;
+    pool_cond_t not_empty;
+    pool_cond_t not_full;
+    pool_cond_t quiescent;
+    pool_cond_t task_done;          /* prts_task_wait where there is no futex */
+
+    /* Shared node free list and slab list, guarded by lock */
+    task_node_t* free_tasks;
+    task_slab_t* slabs;
+
+    /* Injection queue for tasks submitted from outside the pool, guarded by lock */
+    struct {
+        task_node_t* head;
+        task_node_t* tail;
+        size_t count;
+    } lanes[NUM_LANES];
+    size_t task_count;              /* Across all lanes */
+    uint64_t aging_ns;
+    _Atomic size_t inject_count;    /* task_count, readable without the lock */
+    _Atomic size_t urgent_count;    /* High-priority lane count, readable without the lock */
+    _Atomic uint64_t injected;      /* Tasks ever added to the injection queue */
+
+    /* Timers; timer_next is the time of the next wheel event, TIMER_NONE when empty */
+    timer_wheel_t wheel;
+    _Atomic uint64_t timer_next;
+    bool timer_keeper;              /* A sleeping worker waits for timer_next; guarded by lock */
+
+    _Atomic size_t num_sleeping;    /* Workers waiting on not_empty; changed under lock */
+    size_t num_waiters;             /* Threads in prts_threadpool_wait_all */
 };
 
-/* Worker thread function */
+/* The worker running on this thread, if any */
+static THREAD_LOCAL worker_t* current_worker;
+
+static void pool_lock(prts_thread_pool_t* pool) {
 #ifdef _WIN32
-static DWORD WINAPI worker_thread(LPVOID arg)
+    EnterCriticalSection(&pool->lock);
 #else
-static void* worker_thread(void* arg)
+    pthread_mutex_lock(&pool->lock);
 #endif
-{
-    prts_thread_pool_t* pool = (prts_thread_pool_t*)arg;
+}
 
-    while (1) {
+static void pool_unlock(prts_thread_pool_t* pool) {
 #ifdef _WIN32
-        EnterCriticalSection(&pool->lock);
-
-        while (pool->task_count == 0 && !pool->shutdown) {
-            SleepConditionVariableCS(&pool->not_empty, &pool->lock, INFINITE);
-        }
-
-        if (pool->shutdown && pool->task_count == 0) {
-            LeaveCriticalSection(&pool->lock);
-            return 0;
-        }
+    LeaveCriticalSection(&pool->lock);
 #else
-        pthread_mutex_lock(&pool->lock);
-
-        while (pool->task_count == 0 && !pool->shutdown) {
-            pthread_cond_wait(&pool->not_empty, &pool->lock);
-        }
-
-        if (pool->shutdown && pool->task_count == 0) {
-            pthread_mutex_unlock(&pool->lock);
-            return NULL;
-        }
+    pthread_mutex_unlock(&pool->lock);
 #endif
+}
 
-        /* Dequeue task */
-        task_node_t* task = pool->head;
-        pool->head = task->next;
-        if (!pool->head) {
-            pool->tail = NULL;
-        }
-        pool->task_count--;
-        pool->active_count++;
-
+static void pool_wait(prts_thread_pool_t* pool, pool_cond_t* cond) {
 #ifdef _WIN32
-        WakeConditionVariable(&pool->not_full);
-        LeaveCriticalSection(&pool->lock);
+    SleepConditionVariableCS(cond, &pool->lock, INFINITE);
 #else
-        pthread_cond_signal(&pool->not_full);
-        pthread_mutex_unlock(&pool->lock);
+    pthread_cond_wait(cond, &pool->lock);
 #endif
+}
 
-        /* Execute task */
-        task->fn(task->arg);
-
-        /* Signal completion */
-        if (task->wait_handle) {
-            prts_task_t* handle = task->wait_handle;
+/* Returns false on timeout */
+static bool pool_timed_wait(prts_thread_pool_t* pool, pool_cond_t* cond, uint32_t timeout_ms) {
 #ifdef _WIN32
-            handle->completed = true;
-            SetEvent(handle->event);
+    return SleepConditionVariableCS(cond, &pool->lock, timeout_ms) != 0;
 #else
-            pthread_mutex_lock(&handle->mutex);
-            handle->completed = true;
-            pthread_cond_signal(&handle->cond);
-            pthread_mutex_unlock(&handle->mutex);
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return pthread_cond_timedwait(cond, &pool->lock, &ts) == 0;
 #endif
-        }
-
-        free(task);
+}
 
+static void pool_signal(pool_cond_t* cond) {
 #ifdef _WIN32
-        EnterCriticalSection(&pool->lock);
-        pool->active_count--;
-        pool->completed_count++;
-        LeaveCriticalSection(&pool->lock);
+    WakeConditionVariable(cond);
 #else
-        pthread_mutex_lock(&pool->lock);
-        pool->active_count--;
-        pool->completed_count++;
-        pthread_mutex_unlock(&pool->lock);
+    pthread_cond_signal(cond);
 #endif
-    }
+}
 
+static void pool_broadcast(pool_cond_t* cond) {
 #ifdef _WIN32
-    return 0;
+    WakeAllConditionVariable(cond);
 #else
-    return NULL;
+    pthread_cond_broadcast(cond);
 #endif
 }
 
-prts_result_t prts_threadpool_create(
-    const prts_threadpool_config_t* config,
-    prts_thread_pool_t** pool_out
-) {
-    if (!config || !pool_out) {
-        return PRTS_ERROR_INVALID;
-    }
+/* Bump a counter that only one thread writes */
+static void counter_inc(_Atomic uint64_t* counter) {
+    uint64_t value = atomic_load_explicit(counter, memory_order_relaxed);
+    atomic_store_explicit(counter, value + 1, memory_order_release);
+}
 
-    prts_thread_pool_t* pool = calloc(1, sizeof(prts_thread_pool_t));
-    if (!pool) {
-        return PRTS_ERROR_NOMEM;
-    }
+static void counter_add(_Atomic uint64_t* counter, uint64_t n) {
+    uint64_t value = atomic_load_explicit(counter, memory_order_relaxed);
+    atomic_store_explicit(counter, value + n, memory_order_relaxed);
+}
 
-    /* Determine thread count */
-    size_t num_threads = config->num_threads;
-    if (num_threads == 0) {
-#ifdef _WIN32
-        SYSTEM_INFO sysinfo;
-        GetSystemInfo(&sysinfo);
-        num_threads = sysinfo.dwNumberOfProcessors;
+/* ============================================================================
+ * Latency histograms
+ * ============================================================================ */
+
+static unsigned leading_zeros(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return x ? (unsigned)__builtin_clzll(x) : 64;
 #else
-        num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned n = 0;
+    for (uint64_t bit = 1ULL << 63; bit && !(x & bit); bit >>= 1) n++;
+    return n;
 #endif
-    }
-
-    pool->num_threads = num_threads;
-    pool->queue_size = config->queue_size > 0 ? config->queue_size : 1024;
-    pool->max_threads = config->max_threads;
-    pool->allow_grow = config->allow_grow;
+}
 
-    /* Initialize synchronization */
-#ifdef _WIN32
-    InitializeCriticalSection(&pool->lock);
-    InitializeConditionVariable(&pool->not_empty);
-    InitializeConditionVariable(&pool->not_full);
+static size_t latency_bucket(uint64_t ns) {
+    if (ns < (1u << LATENCY_SUB_BITS)) {
+        return (size_t)ns;
+    }
+    unsigned octave = 63 - leading_zeros(ns);
+    if (octave > LATENCY_MAX_OCTAVE) {
+        return LATENCY_BUCKETS - 1;
+    }
+    size_t sub = (size_t)(ns >> (octave - LATENCY_SUB_BITS)) & ((1u << LATENCY_SUB_BITS) - 1);
+    return ((size_t)(octave - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) + sub;
+}
 
-    pool->threads = calloc(num_threads, sizeof(HANDLE));
-#else
-    pthread_mutex_init(&pool->lock, NULL);
-    pthread_cond_init(&pool->not_empty, NULL);
-    pthread_cond_init(&pool->not_full, NULL);
+/* Midpoint of a bucket's range */
+static uint64_t latency_bucket_value(size_t bucket) {
+    if (bucket < (1u << LATENCY_SUB_BITS)) {
+        return bucket;
+    }
+    unsigned octave = (unsigned)(bucket >> LATENCY_SUB_BITS) + LATENCY_SUB_BITS - 1;
+    uint64_t sub = bucket & ((1u << LATENCY_SUB_BITS) - 1);
+    uint64_t width = 1ULL << (octave - LATENCY_SUB_BITS);
+    return ((1ULL << LATENCY_SUB_BITS) + sub) * width + width / 2;
+}
 
-    pool->threads = calloc(num_threads, sizeof(pthread_t));
-#endif
+static void latency_record(latency_hist_t* hist, uint64_t ns) {
+    counter_add(&hist->total_ns, ns);
+    counter_add(&hist->buckets[latency_bucket(ns)], 1);
+}
 
-    if (!pool->threads) {
-        free(pool);
-        return PRTS_ERROR_NOMEM;
+/* Estimate quantile q of merged bucket counts */
+static uint64_t latency_quantile(const uint64_t* buckets, uint64_t count, double q) {
+    if (count == 0) {
+        return 0;
     }
-
-    /* Create worker threads */
-    for (size_t i = 0; i < num_threads; i++) {
-#ifdef _WIN32
-        pool->threads[i] = CreateThread(NULL, 0, worker_thread, pool, 0, NULL);
-        if (!pool->threads[i]) {
-            pool->shutdown = true;
-            for (size_t j = 0; j < i; j++) {
-                WaitForSingleObject(pool->threads[j], INFINITE);
-                CloseHandle(pool->threads[j]);
-            }
-            free(pool->threads);
-            free(pool);
-            return PRTS_ERROR;
-        }
-#else
-        if (pthread_create(&pool->threads[i], NULL, worker_thread, pool) != 0) {
-            pool->shutdown = true;
-            pthread_cond_broadcast(&pool->not_empty);
-            for (size_t j = 0; j < i; j++) {
-                pthread_join(pool->threads[j], NULL);
-            }
-            free(pool->threads);
-            free(pool);
-            return PRTS_ERROR;
+    uint64_t rank = (uint64_t)(q * (double)(count - 1));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen > rank) {
+            return latency_bucket_value(i);
         }
-#endif
     }
-
-    *pool_out = pool;
-    return PRTS_OK;
+    return latency_bucket_value(LATENCY_BUCKETS - 1);
 }
 
-void prts_threadpool_destroy(prts_thread_pool_t* pool) {
-    if (!pool) return;
+/* ============================================================================
+ * Task nodes
+ * ============================================================================ */
 
-#ifdef _WIN32
-    EnterCriticalSection(&pool->lock);
-    pool->shutdown = true;
-    WakeAllConditionVariable(&pool->not_empty);
-    LeaveCriticalSection(&pool->lock);
+/* Carve a slab into a linked list of nodes; caller holds the lock */
+static task_node_t* slab_alloc(prts_thread_pool_t* pool) {
+    task_slab_t* slab = malloc(sizeof(task_slab_t));
+    if (!slab) {
+        return NULL;
+    }
+    slab->next = pool->slabs;
+    pool->slabs = slab;
 
-    for (size_t i = 0; i < pool->num_threads; i++) {
-        WaitForSingleObject(pool->threads[i], INFINITE);
-        CloseHandle(pool->threads[i]);
+    for (size_t i = 0; i + 1 < TASK_SLAB_SIZE; i++) {
+        slab->tasks[i].next = &slab->tasks[i + 1];
     }
+    slab->tasks[TASK_SLAB_SIZE - 1].next = NULL;
+    return &slab->tasks[0];
+}
 
-    DeleteCriticalSection(&pool->lock);
-#else
-    pthread_mutex_lock(&pool->lock);
-    pool->shutdown = true;
-    pthread_cond_broadcast(&pool->not_empty);
-    pthread_mutex_unlock(&pool->lock);
+/* Caller holds the lock */
+static task_node_t* pool_alloc_task(prts_thread_pool_t* pool) {
+    if (!pool->free_tasks) {
+        pool->free_tasks = slab_alloc(pool);
+        if (!pool->free_tasks) {
+            return NULL;
+        }
+    }
+    task_node_t* task = pool->free_tasks;
+    pool->free_tasks = task->next;
+    return task;
+}
+
+/* Pop the worker's cache, refilling it a slab's worth at a time */
+static task_node_t* worker_alloc_task(worker_t* w) {
+    if (!w->free_tasks) {
+        prts_thread_pool_t* pool = w->pool;
+        size_t count = 0;
+
+        pool_lock(pool);
+        task_node_t* list = pool->free_tasks;
+        if (list) {
+            task_node_t* last = list;
+            for (count = 1; count < TASK_SLAB_SIZE && last->next; count++) {
+                last = last->next;
+            }
+            pool->free_tasks = last->next;
+            last->next = NULL;
+        } else {
+            list = slab_alloc(pool);
+            count = TASK_SLAB_SIZE;
+        }
+        pool_unlock(pool);
 
-    for (size_t i = 0; i < pool->num_threads; i++) {
-        pthread_join(pool->threads[i], NULL);
+        if (!list) {
+            return NULL;
+        }
+        w->free_tasks = list;
+        w->num_free_tasks = count;
     }
 
-    pthread_mutex_destroy(&pool->lock);
-    pthread_cond_destroy(&pool->not_empty);
-    pthread_cond_destroy(&pool->not_full);
-#endif
+    task_node_t* task = w->free_tasks;
+    w->free_tasks = task->next;
+    w->num_free_tasks--;
+    return task;
+}
+
+static void worker_free_task(worker_t* w, task_node_t* task) {
+    task->next = w->free_tasks;
+    w->free_tasks = task;
+    w->num_free_tasks++;
+
+    if (w->num_free_tasks > TASK_CACHE_MAX) {
+        /* Hand half back for submitters outside the pool */
+        task_node_t* first = w->free_tasks;
+        task_node_t* last = first;
+        for (size_t i = 1; i < TASK_CACHE_MAX / 2; i++) {
+            last = last->next;
+        }
+        w->free_tasks = last->next;
+        w->num_free_tasks -= TASK_CACHE_MAX / 2;
 
-    /* Free remaining tasks */
-    while (pool->head) {
-        task_node_t* task = pool->head;
-        pool->head = task->next;
-        free(task);
+        pool_lock(w->pool);
+        last->next = w->pool->free_tasks;
+        w->pool->free_tasks = first;
+        pool_unlock(w->pool);
     }
+}
 
-    free(pool->threads);
-    free(pool);
+/* Return a chain of nodes to the worker cache, or to the shared list (locked) */
+static void free_task_chain(prts_thread_pool_t* pool, worker_t* self, task_node_t* first) {
+    while (first) {
+        task_node_t* task = first;
+        first = first->next;
+        if (self) {
+            worker_free_task(self, task);
+        } else {
+            task->next = pool->free_tasks;
+            pool->free_tasks = task;
+        }
+    }
 }
 
-prts_result_t prts_threadpool_submit(
-    prts_thread_pool_t* pool,
-    prts_task_fn fn,
-    void* arg
-) {
-    return prts_threadpool_submit_wait(pool, fn, arg, NULL);
+/*
+ * Take count nodes as a NULL-terminated chain, from the worker's cache
+ * or, for other threads, from the shared list (caller holds the lock).
+ */
+static task_node_t* alloc_task_chain(prts_thread_pool_t* pool, worker_t* self, size_t count) {
+    task_node_t* first = NULL;
+    task_node_t** link = &first;
+    for (size_t i = 0; i < count; i++) {
+        task_node_t* task = self ? worker_alloc_task(self) : pool_alloc_task(pool);
+        if (!task) {
+            *link = NULL;
+            free_task_chain(pool, self, first);
+            return NULL;
+        }
+        *link = task;
+        link = &task->next;
+    }
+    *link = NULL;
+    return first;
 }
 
-prts_result_t prts_threadpool_submit_wait(
+static void task_init(
+    task_node_t* task,
     prts_thread_pool_t* pool,
     prts_task_fn fn,
     void* arg,
-    prts_task_t** task_out
+    bool with_handle
 ) {
-    if (!pool || !fn) {
-        return PRTS_ERROR_INVALID;
-    }
-
-    task_node_t* task = malloc(sizeof(task_node_t));
-    if (!task) {
-        return PRTS_ERROR_NOMEM;
-    }
-
     task->fn = fn;
     task->arg = arg;
-    task->next = NULL;
-    task->wait_handle = NULL;
-
-    /* Create wait handle if requested */
-    if (task_out) {
-        prts_task_t* handle = malloc(sizeof(prts_task_t));
-        if (!handle) {
-            free(task);
-            return PRTS_ERROR_NOMEM;
-        }
-        handle->completed = false;
-#ifdef _WIN32
-        handle->event = CreateEvent(NULL, TRUE, FALSE, NULL);
-#else
-        pthread_mutex_init(&handle->mutex, NULL);
-        pthread_cond_init(&handle->cond, NULL);
-#endif
-        task->wait_handle = handle;
-        *task_out = handle;
-    }
-
-#ifdef _WIN32
-    EnterCriticalSection(&pool->lock);
+    task->pool = pool;
+    task->expired = false;
+    atomic_store_explicit(&task->refs, with_handle ? 2 : 1, memory_order_relaxed);
+    atomic_store_explicit(&task->state, TASK_PENDING, memory_order_relaxed);
+}
 
-    while (pool->task_count >= pool->queue_size && !pool->shutdown) {
-        SleepConditionVariableCS(&pool->not_full, &pool->lock, INFINITE);
+/* Drop a reference; the last one recycles the node */
+static void task_release(task_node_t* task) {
+    /* A task nobody waits on holds a single reference; skip the RMW */
+    if (atomic_load_explicit(&task->refs, memory_order_acquire) != 1 &&
+        atomic_fetch_sub_explicit(&task->refs, 1, memory_order_acq_rel) != 1) {
+        return;
     }
-#else
-    pthread_mutex_lock(&pool->lock);
 
-    while (pool->task_count >= pool->queue_size && !pool->shutdown) {
-        pthread_cond_wait(&pool->not_full, &pool->lock);
+    prts_thread_pool_t* pool = task->pool;
+    worker_t* self = current_worker;
+    if (self && self->pool == pool) {
+        worker_free_task(self, task);
+        return;
     }
-#endif
 
-    if (pool->shutdown) {
-#ifdef _WIN32
-        LeaveCriticalSection(&pool->lock);
-#else
-        pthread_mutex_unlock(&pool->lock);
-#endif
-        free(task);
-        return PRTS_ERROR;
-    }
+    pool_lock(pool);
+    task->next = pool->free_tasks;
+    pool->free_tasks = task;
+    pool_unlock(pool);
+}
 
-    /* Enqueue task */
-    if (pool->tail) {
-        pool->tail->next = task;
-    } else {
-        pool->head = task;
+/*
+ * Completion words: TASK_PENDING until signalled, TASK_WAITED once a
+ * waiter has gone to sleep on them, TASK_DONE when complete. Used by
+ * task handles and by parallel_for callers.
+ */
+static void completion_signal(prts_thread_pool_t* pool, _Atomic uint32_t* state) {
+    if (atomic_exchange_explicit(state, TASK_DONE, memory_order_acq_rel) != TASK_WAITED) {
+        return;
     }
-    pool->tail = task;
-    pool->task_count++;
 
-#ifdef _WIN32
-    WakeConditionVariable(&pool->not_empty);
-    LeaveCriticalSection(&pool->lock);
+    /* The word may already be gone; waking a stale address is harmless */
+#if defined(__linux__)
+    (void)pool;
+    syscall(SYS_futex, state, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#elif defined(_WIN32)
+    (void)pool;
+    WakeByAddressAll((PVOID)state);
 #else
-    pthread_cond_signal(&pool->not_empty);
-    pthread_mutex_unlock(&pool->lock);
+    pool_lock(pool);
+    pool_broadcast(&pool->task_done);
+    pool_unlock(pool);
 #endif
-
-    return PRTS_OK;
 }
 
-prts_result_t prts_task_wait(prts_task_t* task, int timeout_ms) {
-    if (!task) {
-        return PRTS_ERROR_INVALID;
+/* Block while the word is TASK_WAITED, for up to timeout_ns (negative = no limit) */
+static void completion_block(prts_thread_pool_t* pool, _Atomic uint32_t* state, int64_t timeout_ns) {
+#if defined(__linux__)
+    (void)pool;
+    struct timespec ts;
+    struct timespec* tsp = NULL;
+    if (timeout_ns >= 0) {
+        ts.tv_sec = timeout_ns / 1000000000;
+        ts.tv_nsec = timeout_ns % 1000000000;
+        tsp = &ts;
     }
-
-#ifdef _WIN32
-    DWORD result = WaitForSingleObject(task->event,
-        timeout_ms < 0 ? INFINITE : (DWORD)timeout_ms);
-    return result == WAIT_OBJECT_0 ? PRTS_OK : PRTS_ERROR_TIMEOUT;
+    syscall(SYS_futex, state, FUTEX_WAIT_PRIVATE, TASK_WAITED, tsp, NULL, 0);
+#elif defined(_WIN32)
+    (void)pool;
+    uint32_t waited = TASK_WAITED;
+    WaitOnAddress((volatile VOID*)state, &waited, sizeof(waited),
+                  timeout_ns < 0 ? INFINITE : (DWORD)((timeout_ns + 999999) / 1000000));
 #else
-    pthread_mutex_lock(&task->mutex);
-
-    if (timeout_ms < 0) {
-        while (!task->completed) {
-            pthread_cond_wait(&task->cond, &task->mutex);
-        }
-    } else if (timeout_ms > 0) {
-        struct timespec ts;
-        clock_gettime(CLOCK_REALTIME, &ts);
-        ts.tv_sec += timeout_ms / 1000;
-        ts.tv_nsec += (timeout_ms % 1000) * 1000000;
-        if (ts.tv_nsec >= 1000000000) {
-            ts.tv_sec++;
-            ts.tv_nsec -= 1000000000;
-        }
-
-        while (!task->completed) {
-            if (pthread_cond_timedwait(&task->cond, &task->mutex, &ts) != 0) {
-                pthread_mutex_unlock(&task->mutex);
-                return PRTS_ERROR_TIMEOUT;
+    pool_lock(pool);
+    if (atomic_load_explicit(state, memory_order_acquire) == TASK_WAITED) {
+        if (timeout_ns < 0) {
+            pool_wait(pool, &pool->task_done);
+        } else {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_sec += timeout_ns / 1000000000;
+            ts.tv_nsec += timeout_ns % 1000000000;
+            if (ts.tv_nsec >= 1000000000) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000;
             }
+            pthread_cond_timedwait(&pool->task_done, &pool->lock, &ts);
         }
     }
-
-    bool completed = task->completed;
-    pthread_mutex_unlock(&task->mutex);
-
-    return completed ? PRTS_OK : PRTS_ERROR_TIMEOUT;
-#endif
-}
-
-void prts_task_free(prts_task_t* task) {
-    if (!task) return;
-
-#ifdef _WIN32
-    CloseHandle(task->event);
-#else
-    pthread_mutex_destroy(&task->mutex);
-    pthread_cond_destroy(&task->cond);
+    pool_unlock(pool);
 #endif
-
-    free(task);
 }
 
-prts_result_t prts_threadpool_stats(
+static prts_result_t completion_wait(
     prts_thread_pool_t* pool,
-    prts_threadpool_stats_t* stats
+    _Atomic uint32_t* state_word,
+    int timeout_ms
 ) {
-    if (!pool || !stats) {
-        return PRTS_ERROR_INVALID;
+    uint32_t state = atomic_load_explicit(state_word, memory_order_acquire);
+    if (state == TASK_DONE) {
+        return PRTS_OK;
+    }
+    if (timeout_ms == 0) {
+        return PRTS_ERROR_TIMEOUT;
     }
 
-#ifdef _WIN32
-    EnterCriticalSection(&pool->lock);
-#else
-    pthread_mutex_lock(&pool->lock);
-#endif
+    prts_timestamp_t deadline = 0;
+    if (timeout_ms > 0) {
+        deadline = prts_timestamp_now() + (prts_timestamp_t)timeout_ms * 1000000;
+    }
 
-    stats->active_threads = pool->active_count;
-    stats->idle_threads = pool->num_threads - pool->active_count;
-    stats->pending_tasks = pool->task_count;
-    stats->completed_tasks = pool->completed_count;
-    stats->total_wait_ns = pool->total_wait_ns;
-    stats->total_exec_ns = pool->total_exec_ns;
+    while (state != TASK_DONE) {
+        /* Flag the waiter so the signalling thread knows to wake it */
+        if (state == TASK_PENDING &&
+            !atomic_compare_exchange_weak_explicit(state_word, &state, TASK_WAITED,
+                                                   memory_order_acquire,
+                                                   memory_order_acquire)) {
+            continue;
+        }
 
-#ifdef _WIN32
-    LeaveCriticalSection(&pool->lock);
-#else
-    pthread_mutex_unlock(&pool->lock);
-#endif
+        int64_t timeout_ns = -1;
+        if (timeout_ms > 0) {
+            prts_timestamp_t now = prts_timestamp_now();
+            if (now >= deadline) {
+                return PRTS_ERROR_TIMEOUT;
+            }
+            timeout_ns = (int64_t)(deadline - now);
+        }
+
+        completion_block(pool, state_word, timeout_ns);
+        state = atomic_load_explicit(state_word, memory_order_acquire);
+    }
 
     return PRTS_OK;
 }
 
-void prts_threadpool_wait_all(prts_thread_pool_t* pool) {
-    if (!pool) return;
+/* ============================================================================
+ * Chase-Lev deque
+ * (Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models")
+ * ============================================================================ */
 
-#ifdef _WIN32
-    EnterCriticalSection(&pool->lock);
-    while (pool->task_count > 0 || pool->active_count > 0) {
-        SleepConditionVariableCS(&pool->not_full, &pool->lock, INFINITE);
-    }
-    LeaveCriticalSection(&pool->lock);
-#else
-    pthread_mutex_lock(&pool->lock);
-    while (pool->task_count > 0 || pool->active_count > 0) {
-        pthread_cond_wait(&pool->not_full, &pool->lock);
+static deque_array_t* deque_array_create(int64_t capacity) {
+    deque_array_t* a = malloc(sizeof(deque_array_t) + capacity * sizeof(task_node_t*));
+    if (!a) {
+        return NULL;
     }
-    pthread_mutex_unlock(&pool->lock);
+    a->capacity = capacity;
+    a->retired = NULL;
+    return a;
+}
+
+static prts_result_t deque_init(worker_t* w) {
+    deque_array_t* a = deque_array_create(INITIAL_DEQUE_CAPACITY);
+    if (!a) {
+        return PRTS_ERROR_NOMEM;
+    }
+    atomic_init(&w->top, 0);
+    atomic_init(&w->bottom, 0);
+    atomic_init(&w->array, a);
+    return PRTS_OK;
+}
+
+static void deque_free(worker_t* w) {
+    deque_array_t* a = atomic_load_explicit(&w->array, memory_order_relaxed);
+    while (a) {
+        deque_array_t* retired = a->retired;
+        free(a);
+        a = retired;
+    }
+}
+
+/*
+ * Copy live slots into a larger array. Thieves may still be reading the
+ * old one, so it is kept until the pool is destroyed.
+ */
+static deque_array_t* deque_grow(worker_t* w, deque_array_t* a, int64_t top, int64_t bottom) {
+    deque_array_t* grown = deque_array_create(a->capacity * 2);
+    if (!grown) {
+        return NULL;
+    }
+    for (int64_t i = top; i < bottom; i++) {
+        task_node_t* task = atomic_load_explicit(&a->slots[i & (a->capacity - 1)],
+                                                 memory_order_relaxed);
+        atomic_store_explicit(&grown->slots[i & (grown->capacity - 1)], task,
+                              memory_order_relaxed);
+    }
+    grown->retired = a;
+    atomic_store_explicit(&w->array, grown, memory_order_release);
+    return grown;
+}
+
+/* Owner only; make room for count more pushes */
+static prts_result_t deque_reserve(worker_t* w, size_t count) {
+    int64_t bottom = atomic_load_explicit(&w->bottom, memory_order_relaxed);
+    int64_t top = atomic_load_explicit(&w->top, memory_order_acquire);
+    deque_array_t* a = atomic_load_explicit(&w->array, memory_order_relaxed);
+
+    while (bottom - top + (int64_t)count > a->capacity) {
+        a = deque_grow(w, a, top, bottom);
+        if (!a) {
+            return PRTS_ERROR_NOMEM;
+        }
+    }
+    return PRTS_OK;
+}
+
+/* Owner only, after deque_reserve */
+static void deque_push(worker_t* w, task_node_t* task) {
+    int64_t bottom = atomic_load_explicit(&w->bottom, memory_order_relaxed);
+    deque_array_t* a = atomic_load_explicit(&w->array, memory_order_relaxed);
+
+    atomic_store_explicit(&a->slots[bottom & (a->capacity - 1)], task, memory_order_relaxed);
+    atomic_store_explicit(&w->bottom, bottom + 1, memory_order_release);
+}
+
+/* Owner only; takes the most recently pushed task */
+static task_node_t* deque_pop(worker_t* w) {
+    int64_t bottom = atomic_load_explicit(&w->bottom, memory_order_relaxed) - 1;
+    deque_array_t* a = atomic_load_explicit(&w->array, memory_order_relaxed);
+    atomic_store_explicit(&w->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t top = atomic_load_explicit(&w->top, memory_order_relaxed);
+
+    if (top > bottom) {
+        atomic_store_explicit(&w->bottom, bottom + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    task_node_t* task = atomic_load_explicit(&a->slots[bottom & (a->capacity - 1)],
+                                             memory_order_relaxed);
+    if (top == bottom) {
+        /* Last task: race thieves for it */
+        if (!atomic_compare_exchange_strong_explicit(&w->top, &top, top + 1,
+                                                     memory_order_seq_cst,
+                                                     memory_order_relaxed)) {
+            task = NULL;
+        }
+        atomic_store_explicit(&w->bottom, bottom + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+/* Any thread; takes the oldest task, or NULL if empty or the race was lost */
+static task_node_t* deque_steal(worker_t* w) {
+    int64_t top = atomic_load_explicit(&w->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t bottom = atomic_load_explicit(&w->bottom, memory_order_acquire);
+
+    if (top >= bottom) {
+        return NULL;
+    }
+
+    deque_array_t* a = atomic_load_explicit(&w->array, memory_order_acquire);
+    task_node_t* task = atomic_load_explicit(&a->slots[top & (a->capacity - 1)],
+                                             memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&w->top, &top, top + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        return NULL;
+    }
+    return task;
+}
+
+static size_t deque_size(worker_t* w) {
+    int64_t bottom = atomic_load_explicit(&w->bottom, memory_order_acquire);
+    int64_t top = atomic_load_explicit(&w->top, memory_order_acquire);
+    return bottom > top ? (size_t)(bottom - top) : 0;
+}
+
+/* ============================================================================
+ * Scheduling
+ * ============================================================================ */
+
+static bool any_deque_nonempty(prts_thread_pool_t* pool) {
+    for (size_t i = 0; i < pool->num_slots; i++) {
+        if (deque_size(&pool->workers[i]) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Wake sleeping workers after making count tasks visible */
+static void wake_workers(prts_thread_pool_t* pool, size_t count) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&pool->num_sleeping, memory_order_relaxed) > 0) {
+        pool_lock(pool);
+        if (count > 1) {
+            pool_broadcast(&pool->not_empty);
+        } else {
+            pool_signal(&pool->not_empty);
+        }
+        pool_unlock(pool);
+    }
+}
+
+static bool spawn_worker(prts_thread_pool_t* pool);
+
+/*
+ * Elastic pools add a worker when every worker is busy and queued work
+ * has waited longer than grow_wait_ns. Caller holds the lock.
+ */
+static void maybe_grow(prts_thread_pool_t* pool) {
+    if (!pool->allow_grow || pool->num_live >= pool->num_slots || pool->task_count == 0 ||
+        atomic_load_explicit(&pool->num_sleeping, memory_order_relaxed) > 0) {
+        return;
+    }
+
+    prts_timestamp_t now = prts_timestamp_now();
+    for (int lane = 0; lane < NUM_LANES; lane++) {
+        task_node_t* head = pool->lanes[lane].head;
+        if (head && now - head->queued_at >= pool->grow_wait_ns) {
+            spawn_worker(pool);
+            return;
+        }
+    }
+}
+
+/*
+ * Pick the lane to serve next; caller holds the lock and the queue is
+ * not empty. A head's rank is its lane minus one per aging interval
+ * waited; a head whose deadline falls within one interval ranks as high
+ * priority. Ties go to the higher-priority lane.
+ */
+static int inject_pick_lane(prts_thread_pool_t* pool) {
+    int first = 0;
+    while (!pool->lanes[first].head) {
+        first++;
+    }
+    if (pool->lanes[first].count == pool->task_count) {
+        return first;
+    }
+
+    prts_timestamp_t now = prts_timestamp_now();
+    int best = -1;
+    int64_t best_rank = 0;
+    for (int lane = first; lane < NUM_LANES; lane++) {
+        task_node_t* head = pool->lanes[lane].head;
+        if (!head) continue;
+
+        int64_t waited = now > head->queued_at ? (int64_t)(now - head->queued_at) : 0;
+        int64_t rank = lane - waited / (int64_t)pool->aging_ns;
+        if (head->deadline && head->deadline <= now + pool->aging_ns && rank > 0) {
+            rank = 0;
+        }
+        if (best < 0 || rank < best_rank) {
+            best = lane;
+            best_rank = rank;
+        }
+    }
+    return best;
+}
+
+/* Caller holds the lock */
+static void inject_push(prts_thread_pool_t* pool, int lane, task_node_t* first, size_t count) {
+    task_node_t* last = first;
+    while (last->next) {
+        last = last->next;
+    }
+    if (pool->lanes[lane].tail) {
+        pool->lanes[lane].tail->next = first;
+    } else {
+        pool->lanes[lane].head = first;
+    }
+    pool->lanes[lane].tail = last;
+    pool->lanes[lane].count += count;
+    pool->task_count += count;
+    atomic_store_explicit(&pool->inject_count, pool->task_count, memory_order_relaxed);
+    atomic_store_explicit(&pool->urgent_count, pool->lanes[PRTS_PRIORITY_HIGH].count,
+                          memory_order_relaxed);
+}
+
+static task_node_t* inject_pop(prts_thread_pool_t* pool) {
+    if (atomic_load_explicit(&pool->inject_count, memory_order_relaxed) == 0) {
+        return NULL;
+    }
+
+    pool_lock(pool);
+    task_node_t* task = NULL;
+    if (pool->task_count > 0) {
+        int lane = inject_pick_lane(pool);
+        task = pool->lanes[lane].head;
+        pool->lanes[lane].head = task->next;
+        if (!task->next) {
+            pool->lanes[lane].tail = NULL;
+        }
+        pool->lanes[lane].count--;
+        pool->task_count--;
+        atomic_store_explicit(&pool->inject_count, pool->task_count, memory_order_relaxed);
+        atomic_store_explicit(&pool->urgent_count, pool->lanes[PRTS_PRIORITY_HIGH].count,
+                              memory_order_relaxed);
+        pool_signal(&pool->not_full);
+        maybe_grow(pool);
+    }
+    pool_unlock(pool);
+
+    return task;
+}
+
+static uint64_t next_random(worker_t* w) {
+    /* xorshift64 */
+    uint64_t x = w->rng;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    w->rng = x;
+    return x;
+}
+
+static void timer_advance(prts_thread_pool_t* pool);
+
+/* Advance the wheel if an event is due; cheap when no timer is armed */
+static void timer_poll(prts_thread_pool_t* pool) {
+    uint64_t next = atomic_load_explicit(&pool->timer_next, memory_order_relaxed);
+    if (next != TIMER_NONE && prts_timestamp_now() >= next) {
+        timer_advance(pool);
+    }
+}
+
+/*
+ * High-priority injected work first, then the own deque, then the rest
+ * of the injection queue, then steal from random victims.
+ */
+static task_node_t* find_task(prts_thread_pool_t* pool, worker_t* self) {
+    timer_poll(pool);
+
+    task_node_t* task = NULL;
+    if (atomic_load_explicit(&pool->urgent_count, memory_order_relaxed) > 0) {
+        task = inject_pop(pool);
+        if (task) {
+            return task;
+        }
+    }
+
+    task = deque_pop(self);
+    if (task) {
+        return task;
+    }
+
+    task = inject_pop(pool);
+    if (task || !pool->work_stealing || pool->num_slots < 2) {
+        return task;
+    }
+
+    for (int round = 0; round < STEAL_ROUNDS; round++) {
+        size_t start = (size_t)(next_random(self) % pool->num_slots);
+        for (size_t i = 0; i < pool->num_slots; i++) {
+            worker_t* victim = &pool->workers[(start + i) % pool->num_slots];
+            if (victim == self) continue;
+
+            task = deque_steal(victim);
+            if (task) {
+                return task;
+            }
+        }
+    }
+    return NULL;
+}
+
+/* Every submitted task has completed; counters only grow, completions read first */
+static bool pool_quiescent(prts_thread_pool_t* pool) {
+    uint64_t completed = 0;
+    for (size_t i = 0; i < pool->num_slots; i++) {
+        completed += atomic_load_explicit(&pool->workers[i].completed, memory_order_acquire);
+    }
+
+    uint64_t submitted = atomic_load_explicit(&pool->injected, memory_order_acquire);
+    for (size_t i = 0; i < pool->num_slots; i++) {
+        submitted += atomic_load_explicit(&pool->workers[i].submitted, memory_order_acquire);
+    }
+    return submitted == completed;
+}
+
+/*
+ * Sleep until work may be available. Returns false when the worker
+ * should exit: the pool is shutting down and every queue is empty, or
+ * the worker is surplus to the core count and stayed idle too long.
+ */
+static bool worker_idle(prts_thread_pool_t* pool, worker_t* self) {
+    bool keep_running = true;
+
+    pool_lock(pool);
+
+    if (pool->task_count == 0) {
+        /* Announce the sleep before the final check so pushers see it */
+        atomic_fetch_add(&pool->num_sleeping, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        if (!any_deque_nonempty(pool)) {
+            if (pool->shutdown) {
+                keep_running = false;
+            } else {
+                if (pool->num_waiters > 0) {
+                    pool_broadcast(&pool->quiescent);
+                }
+                uint64_t next = atomic_load_explicit(&pool->timer_next, memory_order_relaxed);
+                if (next != TIMER_NONE && !pool->timer_keeper) {
+                    /* Keep time for the wheel; never retires */
+                    prts_timestamp_t now = prts_timestamp_now();
+                    uint64_t wait_ms = next > now ? (next - now + 999999) / 1000000 : 0;
+                    pool->timer_keeper = true;
+                    if (wait_ms > 0 &&
+                        pool_timed_wait(pool, &pool->not_empty,
+                                        wait_ms < UINT32_MAX ? (uint32_t)wait_ms : UINT32_MAX) &&
+                        atomic_load_explicit(&pool->num_sleeping, memory_order_relaxed) > 1) {
+                        /* Woken for work; hand the watch to another sleeper */
+                        pool_signal(&pool->not_empty);
+                    }
+                    pool->timer_keeper = false;
+                } else if (pool->num_live - pool->num_blocked <= pool->num_threads) {
+                    /* Blocked workers keep their slots; spares only stand in for them */
+                    pool_wait(pool, &pool->not_empty);
+                } else if (!pool_timed_wait(pool, &pool->not_empty, pool->idle_timeout_ms) &&
+                           pool->num_live - pool->num_blocked > pool->num_threads &&
+                           pool->task_count == 0 &&
+                           !any_deque_nonempty(pool) && !pool->shutdown) {
+                    /* Retire; the slot is joined when reused or at destroy */
+                    pool->num_live--;
+                    self->status = SLOT_EXITED;
+                    keep_running = false;
+                }
+            }
+        }
+        atomic_fetch_sub(&pool->num_sleeping, 1);
+    }
+
+    if (!keep_running && self->free_tasks) {
+        /* Hand the node cache back before the thread goes away */
+        task_node_t* last = self->free_tasks;
+        while (last->next) {
+            last = last->next;
+        }
+        last->next = pool->free_tasks;
+        pool->free_tasks = self->free_tasks;
+        self->free_tasks = NULL;
+        self->num_free_tasks = 0;
+    }
+
+    pool_unlock(pool);
+    return keep_running;
+}
+
+static void run_task(worker_t* self, task_node_t* task) {
+    prts_timestamp_t start = prts_timestamp_now();
+    if (task->deadline && start > task->deadline) {
+        /* Too late to be useful; published to waiters by the completion signal */
+        task->expired = true;
+        counter_inc(&self->expired);
+    } else {
+        prts_timestamp_t queued_at = task->queued_at;
+        task->fn(task->arg);
+        latency_record(&self->wait, start > queued_at ? start - queued_at : 0);
+        latency_record(&self->exec, prts_timestamp_now() - start);
+    }
+
+    /* Only a live handle can have a waiter */
+    if (atomic_load_explicit(&task->refs, memory_order_relaxed) > 1) {
+        completion_signal(task->pool, &task->state);
+    }
+    task_release(task);
+    counter_inc(&self->completed);
+}
+
+/* Worker thread function */
+#ifdef _WIN32
+static DWORD WINAPI worker_thread(LPVOID arg)
+#else
+static void* worker_thread(void* arg)
+#endif
+{
+    worker_t* self = (worker_t*)arg;
+    prts_thread_pool_t* pool = self->pool;
+    current_worker = self;
+
+    /* Placement is best effort; a failure leaves the worker unpinned */
+    if (pool->pinned) {
+        prts_thread_set_affinity(&pool->cpus);
+    }
+    if (pool->bind_memory) {
+        prts_thread_bind_memory(prts_numa_current_node());
+    }
+
+    while (1) {
+        task_node_t* task = find_task(pool, self);
+        if (task) {
+            atomic_store_explicit(&self->busy, true, memory_order_relaxed);
+            run_task(self, task);
+            atomic_store_explicit(&self->busy, false, memory_order_relaxed);
+            continue;
+        }
+
+        if (!worker_idle(pool, self)) {
+            break;
+        }
+    }
+
+    current_worker = NULL;
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static size_t cpu_set_count(const prts_cpu_set_t* set) {
+    size_t count = 0;
+    for (size_t i = 0; i < PRTS_MAX_CPUS; i++) {
+        if (prts_cpu_set_has(set, i)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static void join_worker(worker_t* w) {
+#ifdef _WIN32
+    WaitForSingleObject(w->thread, INFINITE);
+    CloseHandle(w->thread);
+#else
+    pthread_join(w->thread, NULL);
+#endif
+    w->status = SLOT_EMPTY;
+}
+
+/* Start a worker in a free slot; caller holds the lock */
+static bool spawn_worker(prts_thread_pool_t* pool) {
+    if (pool->shutdown || pool->num_live >= pool->num_slots) {
+        return false;
+    }
+
+    worker_t* w = NULL;
+    for (size_t i = 0; i < pool->num_slots; i++) {
+        if (pool->workers[i].status != SLOT_RUNNING) {
+            w = &pool->workers[i];
+            break;
+        }
+    }
+    if (!w) {
+        return false;
+    }
+
+    /* A retired thread released the lock before exiting, so this is brief */
+    if (w->status == SLOT_EXITED) {
+        join_worker(w);
+    }
+
+#ifdef _WIN32
+    w->thread = CreateThread(NULL, 0, worker_thread, w, 0, NULL);
+    if (!w->thread) {
+        return false;
+    }
+#else
+    if (pthread_create(&w->thread, NULL, worker_thread, w) != 0) {
+        return false;
+    }
+#endif
+
+    w->status = SLOT_RUNNING;
+    pool->num_live++;
+    return true;
+}
+
+/* Stop and join every worker, then free the pool */
+static void pool_teardown(prts_thread_pool_t* pool) {
+    pool_lock(pool);
+    pool->shutdown = true;
+    pool_broadcast(&pool->not_empty);
+    pool_broadcast(&pool->not_full);
+    pool_unlock(pool);
+
+    /* Workers no longer spawn or retire once shutdown is set */
+    for (size_t i = 0; i < pool->num_slots; i++) {
+        if (pool->workers[i].status != SLOT_EMPTY) {
+            join_worker(&pool->workers[i]);
+        }
+    }
+
+#ifdef _WIN32
+    DeleteCriticalSection(&pool->lock);
+#else
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->not_empty);
+    pthread_cond_destroy(&pool->not_full);
+    pthread_cond_destroy(&pool->quiescent);
+    pthread_cond_destroy(&pool->task_done);
+#endif
+
+    /* Timers still armed; their handles must already be gone */
+#ifdef _WIN32
+    DeleteCriticalSection(&pool->wheel.lock);
+#else
+    pthread_mutex_destroy(&pool->wheel.lock);
+#endif
+    for (int level = 0; level < TIMER_LEVELS; level++) {
+        for (int slot = 0; slot < TIMER_SLOTS; slot++) {
+            while (pool->wheel.slots[level][slot]) {
+                struct prts_timer* timer = pool->wheel.slots[level][slot];
+                pool->wheel.slots[level][slot] = timer->next;
+                free(timer);
+            }
+        }
+    }
+
+    /* Every task node, queued, cached or held as a handle, lives in a slab */
+    while (pool->slabs) {
+        task_slab_t* slab = pool->slabs;
+        pool->slabs = slab->next;
+        free(slab);
+    }
+
+    for (size_t i = 0; i < pool->num_slots; i++) {
+        deque_free(&pool->workers[i]);
+    }
+    free(pool->workers);
+    free(pool);
+}
+
+prts_result_t prts_threadpool_create(
+    const prts_threadpool_config_t* config,
+    prts_thread_pool_t** pool_out
+) {
+    if (!config || !pool_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    prts_thread_pool_t* pool = calloc(1, sizeof(prts_thread_pool_t));
+    if (!pool) {
+        return PRTS_ERROR_NOMEM;
+    }
+
+    pool->cpus = config->cpus;
+    pool->pinned = !prts_cpu_set_empty(&config->cpus);
+    pool->bind_memory = config->bind_memory;
+
+    /* Determine thread count: one per CPU, or per pinned CPU */
+    size_t num_threads = config->num_threads;
+    if (num_threads == 0) {
+        num_threads = pool->pinned ? cpu_set_count(&pool->cpus) : prts_cpu_count();
+    }
+
+    pool->num_threads = num_threads;
+    pool->queue_size = config->queue_size > 0 ? config->queue_size : 1024;
+    pool->max_threads = config->max_threads;
+    pool->allow_grow = config->allow_grow && config->max_threads > num_threads;
+    pool->work_stealing = config->work_stealing;
+    pool->grow_wait_ns = (uint64_t)(config->grow_wait_us > 0 ? config->grow_wait_us
+                                                             : DEFAULT_GROW_WAIT_US) * 1000;
+    pool->idle_timeout_ms = config->idle_timeout_ms > 0 ? config->idle_timeout_ms
+                                                        : DEFAULT_IDLE_TIMEOUT_MS;
+    pool->num_slots = pool->allow_grow ? config->max_threads : num_threads;
+    pool->aging_ns = (uint64_t)(config->aging_ms > 0 ? config->aging_ms : DEFAULT_AGING_MS) *
+                     1000000;
+
+    pool->workers = calloc(pool->num_slots, sizeof(worker_t));
+    if (!pool->workers) {
+        free(pool);
+        return PRTS_ERROR_NOMEM;
+    }
+    for (size_t i = 0; i < pool->num_slots; i++) {
+        worker_t* w = &pool->workers[i];
+        if (deque_init(w) != PRTS_OK) {
+            for (size_t j = 0; j < i; j++) {
+                deque_free(&pool->workers[j]);
+            }
+            free(pool->workers);
+            free(pool);
+            return PRTS_ERROR_NOMEM;
+        }
+        w->pool = pool;
+        w->rng = (i + 1) * 0x9E3779B97F4A7C15ULL;
+    }
+
+    /* Initialize synchronization */
+#ifdef _WIN32
+    InitializeCriticalSection(&pool->lock);
+    InitializeConditionVariable(&pool->not_empty);
+    InitializeConditionVariable(&pool->not_full);
+    InitializeConditionVariable(&pool->quiescent);
+    InitializeConditionVariable(&pool->task_done);
+#else
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->not_empty, NULL);
+    pthread_cond_init(&pool->not_full, NULL);
+    pthread_cond_init(&pool->quiescent, NULL);
+    pthread_cond_init(&pool->task_done, NULL);
+#endif
+#ifdef _WIN32
+    InitializeCriticalSection(&pool->wheel.lock);
+#else
+    pthread_mutex_init(&pool->wheel.lock, NULL);
+#endif
+    pool->wheel.base = prts_timestamp_now();
+    atomic_init(&pool->timer_next, TIMER_NONE);
+
+    /* Create the core worker threads */
+    pool_lock(pool);
+    bool started = true;
+    for (size_t i = 0; i < num_threads && started; i++) {
+        started = spawn_worker(pool);
+    }
+    pool_unlock(pool);
+
+    if (!started) {
+        pool_teardown(pool);
+        return PRTS_ERROR;
+    }
+
+    *pool_out = pool;
+    return PRTS_OK;
+}
+
+void prts_threadpool_destroy(prts_thread_pool_t* pool) {
+    if (!pool) return;
+    pool_teardown(pool);
+}
+
+/* The calling thread's worker, if it belongs to this pool */
+static worker_t* pool_worker(prts_thread_pool_t* pool) {
+    worker_t* self = current_worker;
+    return self && self->pool == pool ? self : NULL;
+}
+
+static void init_task_chain(
+    task_node_t* first,
+    prts_thread_pool_t* pool,
+    prts_task_fn fn,
+    void* const* args,
+    void* shared_arg,
+    const prts_task_options_t* options,
+    prts_task_t** tasks_out
+) {
+    prts_timestamp_t now = prts_timestamp_now();
+    prts_timestamp_t deadline = 0;
+    if (options && options->deadline_ms > 0) {
+        deadline = now + (prts_timestamp_t)options->deadline_ms * 1000000;
+    }
+
+    size_t i = 0;
+    for (task_node_t* task = first; task; task = task->next, i++) {
+        task_init(task, pool, fn, args ? args[i] : shared_arg, tasks_out != NULL);
+        task->queued_at = now;
+        task->deadline = deadline;
+        task->priority = options ? (uint8_t)options->priority : PRTS_PRIORITY_NORMAL;
+        if (tasks_out) {
+            tasks_out[i] = task;
+        }
+    }
+}
+
+/*
+ * Queue count tasks, all or nothing, with one lock acquisition and one
+ * wakeup. Each task gets args[i], or shared_arg when args is NULL.
+ * options may be NULL for normal priority and no deadline.
+ */
+static prts_result_t pool_submit(
+    prts_thread_pool_t* pool,
+    prts_task_fn fn,
+    void* const* args,
+    void* shared_arg,
+    size_t count,
+    const prts_task_options_t* options,
+    prts_task_t** tasks_out
+) {
+    worker_t* self = pool_worker(pool);
+    int lane = options ? (int)options->priority : PRTS_PRIORITY_NORMAL;
+
+    /* Only normal-priority work stays on a worker's deque */
+    bool local = self && pool->work_stealing && lane == PRTS_PRIORITY_NORMAL;
+
+    /* Workers take nodes from their own cache, outside the lock */
+    task_node_t* first = NULL;
+    if (self) {
+        first = alloc_task_chain(pool, self, count);
+        if (!first) {
+            return PRTS_ERROR_NOMEM;
+        }
+        init_task_chain(first, pool, fn, args, shared_arg, options, tasks_out);
+
+        /* Tasks spawned by a worker stay on its own deque */
+        if (local) {
+            if (deque_reserve(self, count) != PRTS_OK) {
+                free_task_chain(pool, self, first);
+                return PRTS_ERROR_NOMEM;
+            }
+
+            uint64_t submitted = atomic_load_explicit(&self->submitted, memory_order_relaxed);
+            atomic_store_explicit(&self->submitted, submitted + count, memory_order_release);
+            while (first) {
+                task_node_t* task = first;
+                first = first->next;
+                deque_push(self, task);
+            }
+            wake_workers(pool, count);
+            return PRTS_OK;
+        }
+    }
+
+    pool_lock(pool);
+
+    /*
+     * A batch larger than the bound is admitted into an empty queue.
+     * Workers are never blocked by the bound: a worker waiting for room
+     * that only workers can make would deadlock nested fan-out.
+     */
+    while (!self && pool->task_count > 0 &&
+           pool->task_count + count > pool->queue_size && !pool->shutdown) {
+        pool_wait(pool, &pool->not_full);
+    }
+
+    /* Once shutting down, only running tasks may add work */
+    if (pool->shutdown && !self) {
+        pool_unlock(pool);
+        return PRTS_ERROR;
+    }
+
+    if (!first) {
+        first = alloc_task_chain(pool, NULL, count);
+        if (!first) {
+            pool_unlock(pool);
+            return PRTS_ERROR_NOMEM;
+        }
+        init_task_chain(first, pool, fn, args, shared_arg, options, tasks_out);
+    }
+
+    /* Queued work is stuck behind busy workers; add one */
+    maybe_grow(pool);
+
+    inject_push(pool, lane, first, count);
+    atomic_fetch_add_explicit(&pool->injected, count, memory_order_release);
+
+    if (atomic_load_explicit(&pool->num_sleeping, memory_order_relaxed) > 0) {
+        if (count > 1) {
+            pool_broadcast(&pool->not_empty);
+        } else {
+            pool_signal(&pool->not_empty);
+        }
+    }
+    pool_unlock(pool);
+
+    return PRTS_OK;
+}
+
+prts_result_t prts_threadpool_submit(
+    prts_thread_pool_t* pool,
+    prts_task_fn fn,
+    void* arg
+) {
+    return prts_threadpool_submit_wait(pool, fn, arg, NULL);
+}
+
+prts_result_t prts_threadpool_submit_wait(
+    prts_thread_pool_t* pool,
+    prts_task_fn fn,
+    void* arg,
+    prts_task_t** task_out
+) {
+    if (!pool || !fn) {
+        return PRTS_ERROR_INVALID;
+    }
+    return pool_submit(pool, fn, NULL, arg, 1, NULL, task_out);
+}
+
+prts_result_t prts_threadpool_submit_ex(
+    prts_thread_pool_t* pool,
+    prts_task_fn fn,
+    void* arg,
+    const prts_task_options_t* options,
+    prts_task_t** task_out
+) {
+    if (!pool || !fn) {
+        return PRTS_ERROR_INVALID;
+    }
+    if (options && (options->priority < PRTS_PRIORITY_HIGH ||
+                    options->priority > PRTS_PRIORITY_LOW)) {
+        return PRTS_ERROR_INVALID;
+    }
+    return pool_submit(pool, fn, NULL, arg, 1, options, task_out);
+}
+
+prts_result_t prts_threadpool_submit_batch(
+    prts_thread_pool_t* pool,
+    prts_task_fn fn,
+    void* const* args,
+    size_t count,
+    prts_task_t** tasks_out
+) {
+    if (!pool || !fn || !args) {
+        return PRTS_ERROR_INVALID;
+    }
+    if (count == 0) {
+        return PRTS_OK;
+    }
+    return pool_submit(pool, fn, args, NULL, count, NULL, tasks_out);
+}
+
+/*
+ * Wait for a completion word. A worker keeps running other tasks
+ * meanwhile, so waits nested inside pool tasks cannot starve the pool;
+ * it only blocks once every queued task has been taken.
+ */
+static void help_until_done(prts_thread_pool_t* pool, _Atomic uint32_t* state) {
+    worker_t* self = pool_worker(pool);
+    while (atomic_load_explicit(state, memory_order_acquire) != TASK_DONE) {
+        if (self) {
+            task_node_t* task = find_task(pool, self);
+            if (task) {
+                run_task(self, task);
+                continue;
+            }
+        }
+        completion_wait(pool, state, -1);
+    }
+}
+
+/* ============================================================================
+ * Parallel loops
+ * ============================================================================ */
+
+/* Chunks per participant when the grain size is chosen automatically */
+#define AUTO_CHUNKS_PER_THREAD 8
+
+/* One parallel_for or parallel_reduce call, on the caller's stack */
+typedef struct {
+    prts_thread_pool_t* pool;
+    size_t begin;
+    size_t count;                   /* Items in the range */
+    size_t grain;
+    _Atomic size_t next;            /* Offset of the next unclaimed chunk */
+
+    prts_range_fn range_fn;
+    prts_reduce_fn reduce_fn;
+    void* arg;
+
+    /* Reduce: one accumulator per participant that claimed work */
+    char* accs;
+    size_t acc_stride;
+    size_t acc_size;
+    const void* identity;
+    _Atomic size_t num_accs;
+
+    _Atomic size_t helpers;         /* Helper tasks still to finish */
+    _Atomic uint32_t state;         /* Completion word, signalled by the last helper */
+} range_job_t;
+
+/* Claim chunks until the range is exhausted */
+static void range_run(range_job_t* job) {
+    void* acc = NULL;
+    while (1) {
+        size_t offset = atomic_fetch_add_explicit(&job->next, job->grain, memory_order_relaxed);
+        if (offset >= job->count) {
+            break;
+        }
+        size_t n = job->count - offset < job->grain ? job->count - offset : job->grain;
+        size_t begin = job->begin + offset;
+
+        if (!job->reduce_fn) {
+            job->range_fn(begin, begin + n, job->arg);
+            continue;
+        }
+        if (!acc) {
+            size_t slot = atomic_fetch_add_explicit(&job->num_accs, 1, memory_order_relaxed);
+            acc = job->accs + slot * job->acc_stride;
+            memcpy(acc, job->identity, job->acc_size);
+        }
+        job->reduce_fn(begin, begin + n, acc, job->arg);
+    }
+}
+
+static void range_task(void* arg) {
+    range_job_t* job = (range_job_t*)arg;
+    prts_thread_pool_t* pool = job->pool;
+
+    range_run(job);
+
+    /* job lives on the caller's stack; do not touch it after signalling */
+    if (atomic_fetch_sub_explicit(&job->helpers, 1, memory_order_acq_rel) == 1) {
+        completion_signal(pool, &job->state);
+    }
+}
+
+/* Helpers worth starting for a range, given its chunking */
+static size_t range_helpers(prts_thread_pool_t* pool, range_job_t* job) {
+    if (job->grain == 0) {
+        job->grain = job->count / ((pool->num_threads + 1) * AUTO_CHUNKS_PER_THREAD);
+        if (job->grain == 0) {
+            job->grain = 1;
+        }
+    }
+    size_t chunks = job->count / job->grain + (job->count % job->grain != 0);
+    return chunks - 1 < pool->num_threads ? chunks - 1 : pool->num_threads;
+}
+
+/* Fan out to helpers, take part from the calling thread, and wait */
+static void range_execute(range_job_t* job, size_t num_helpers) {
+    prts_thread_pool_t* pool = job->pool;
+
+    atomic_init(&job->next, 0);
+    atomic_init(&job->num_accs, 0);
+    atomic_init(&job->helpers, num_helpers);
+    atomic_init(&job->state, TASK_PENDING);
+
+    if (num_helpers == 0 ||
+        pool_submit(pool, range_task, NULL, job, num_helpers, NULL, NULL) != PRTS_OK) {
+        /* Run everything on the calling thread */
+        atomic_store_explicit(&job->helpers, 0, memory_order_relaxed);
+        atomic_store_explicit(&job->state, TASK_DONE, memory_order_relaxed);
+    }
+
+    range_run(job);
+
+    /* Helpers may not have started yet */
+    help_until_done(pool, &job->state);
+}
+
+prts_result_t prts_threadpool_parallel_for(
+    prts_thread_pool_t* pool,
+    size_t begin,
+    size_t end,
+    size_t grain,
+    prts_range_fn fn,
+    void* arg
+) {
+    if (!pool || !fn || end < begin) {
+        return PRTS_ERROR_INVALID;
+    }
+    if (begin == end) {
+        return PRTS_OK;
+    }
+
+    range_job_t job = {
+        .pool = pool,
+        .begin = begin,
+        .count = end - begin,
+        .grain = grain,
+        .range_fn = fn,
+        .arg = arg,
+    };
+    range_execute(&job, range_helpers(pool, &job));
+    return PRTS_OK;
+}
+
+prts_result_t prts_threadpool_parallel_reduce(
+    prts_thread_pool_t* pool,
+    size_t begin,
+    size_t end,
+    size_t grain,
+    size_t acc_size,
+    const void* identity,
+    prts_reduce_fn reduce,
+    prts_combine_fn combine,
+    void* arg,
+    void* result_out
+) {
+    if (!pool || !identity || !reduce || !combine || !result_out ||
+        acc_size == 0 || end < begin) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    memcpy(result_out, identity, acc_size);
+    if (begin == end) {
+        return PRTS_OK;
+    }
+
+    range_job_t job = {
+        .pool = pool,
+        .begin = begin,
+        .count = end - begin,
+        .grain = grain,
+        .reduce_fn = reduce,
+        .arg = arg,
+        .acc_size = acc_size,
+        .identity = identity,
+    };
+    size_t num_helpers = range_helpers(pool, &job);
+
+    /* Keep every accumulator suitably aligned */
+    size_t align = _Alignof(max_align_t);
+    job.acc_stride = (acc_size + align - 1) / align * align;
+    job.accs = malloc(job.acc_stride * (num_helpers + 1));
+    if (!job.accs) {
+        return PRTS_ERROR_NOMEM;
+    }
+
+    range_execute(&job, num_helpers);
+
+    size_t num_accs = atomic_load_explicit(&job.num_accs, memory_order_relaxed);
+    for (size_t i = 0; i < num_accs; i++) {
+        combine(result_out, job.accs + i * job.acc_stride, arg);
+    }
+
+    free(job.accs);
+    return PRTS_OK;
+}
+
+/* ============================================================================
+ * Task graphs
+ * ============================================================================ */
+
+#define INITIAL_GRAPH_CAPACITY 16
+
+/* Ready successors are submitted in batches of up to this many */
+#define GRAPH_READY_BATCH 32
+
+typedef struct {
+    prts_task_graph_t* graph;
+    prts_graph_task_fn fn;
+    void* arg;
+
+    size_t* successors;
+    size_t num_successors;
+    size_t successors_capacity;
+    size_t num_predecessors;
+
+    _Atomic size_t pending;         /* Predecessors still to finish */
+    _Atomic bool skip;              /* A predecessor failed or was cancelled */
+    prts_result_t result;
+} graph_node_t;
+
+struct prts_task_graph {
+    prts_thread_pool_t* pool;
+    graph_node_t* nodes;
+    size_t num_nodes;
+    size_t capacity;
+    bool running;                   /* Submitted and not yet waited for */
+
+    _Atomic size_t remaining;       /* Nodes still to finish */
+    _Atomic bool cancelled;
+    _Atomic int result;             /* First failure; cancellations rank last */
+    _Atomic uint32_t state;         /* Completion word */
+};
+
+static void graph_node_task(void* arg);
+
+static void graph_record(prts_task_graph_t* graph, prts_result_t result) {
+    int expected = PRTS_OK;
+    if (result == PRTS_ERROR_CANCELLED) {
+        atomic_compare_exchange_strong(&graph->result, &expected, result);
+        return;
+    }
+
+    /* A real failure replaces a cancellation */
+    while (!atomic_compare_exchange_weak(&graph->result, &expected, result)) {
+        if (expected != PRTS_OK && expected != PRTS_ERROR_CANCELLED) {
+            return;
+        }
+    }
+}
+
+static void graph_submit_ready(prts_task_graph_t* graph, void** ready, size_t count) {
+    if (pool_submit(graph->pool, graph_node_task, ready, NULL, count, NULL, NULL) == PRTS_OK) {
+        return;
+    }
+
+    /* Could not queue them; run them here rather than stall the graph */
+    for (size_t i = 0; i < count; i++) {
+        graph_node_task(ready[i]);
+    }
+}
+
+static void graph_node_task(void* arg) {
+    graph_node_t* node = (graph_node_t*)arg;
+    prts_task_graph_t* graph = node->graph;
+    prts_thread_pool_t* pool = graph->pool;
+
+    prts_result_t result = PRTS_ERROR_CANCELLED;
+    if (!atomic_load_explicit(&node->skip, memory_order_relaxed) &&
+        !atomic_load_explicit(&graph->cancelled, memory_order_relaxed)) {
+        result = node->fn(node->arg);
+    }
+    node->result = result;
+    if (result != PRTS_OK) {
+        graph_record(graph, result);
+    }
+
+    /* Release successors; a failure cancels everything downstream */
+    void* ready[GRAPH_READY_BATCH];
+    size_t num_ready = 0;
+    for (size_t i = 0; i < node->num_successors; i++) {
+        graph_node_t* next = &graph->nodes[node->successors[i]];
+        if (result != PRTS_OK) {
+            atomic_store_explicit(&next->skip, true, memory_order_relaxed);
+        }
+        if (atomic_fetch_sub_explicit(&next->pending, 1, memory_order_acq_rel) == 1) {
+            ready[num_ready++] = next;
+            if (num_ready == GRAPH_READY_BATCH) {
+                graph_submit_ready(graph, ready, num_ready);
+                num_ready = 0;
+            }
+        }
+    }
+    if (num_ready > 0) {
+        graph_submit_ready(graph, ready, num_ready);
+    }
+
+    /* graph may be destroyed as soon as the last node signals */
+    if (atomic_fetch_sub_explicit(&graph->remaining, 1, memory_order_acq_rel) == 1) {
+        completion_signal(pool, &graph->state);
+    }
+}
+
+prts_result_t prts_task_graph_create(
+    prts_thread_pool_t* pool,
+    prts_task_graph_t** graph_out
+) {
+    if (!pool || !graph_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    prts_task_graph_t* graph = calloc(1, sizeof(prts_task_graph_t));
+    if (!graph) {
+        return PRTS_ERROR_NOMEM;
+    }
+    graph->pool = pool;
+    atomic_init(&graph->state, TASK_DONE);
+
+    *graph_out = graph;
+    return PRTS_OK;
+}
+
+void prts_task_graph_destroy(prts_task_graph_t* graph) {
+    if (!graph) return;
+
+    if (graph->running) {
+        help_until_done(graph->pool, &graph->state);
+    }
+
+    for (size_t i = 0; i < graph->num_nodes; i++) {
+        free(graph->nodes[i].successors);
+    }
+    free(graph->nodes);
+    free(graph);
+}
+
+prts_result_t prts_task_graph_add(
+    prts_task_graph_t* graph,
+    prts_graph_task_fn fn,
+    void* arg,
+    size_t* node_out
+) {
+    if (!graph || !fn || graph->running) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    if (graph->num_nodes == graph->capacity) {
+        size_t new_capacity = graph->capacity ? graph->capacity * 2 : INITIAL_GRAPH_CAPACITY;
+        graph_node_t* nodes = realloc(graph->nodes, new_capacity * sizeof(graph_node_t));
+        if (!nodes) {
+            return PRTS_ERROR_NOMEM;
+        }
+        graph->nodes = nodes;
+        graph->capacity = new_capacity;
+    }
+
+    graph_node_t* node = &graph->nodes[graph->num_nodes];
+    memset(node, 0, sizeof(graph_node_t));
+    node->graph = graph;
+    node->fn = fn;
+    node->arg = arg;
+
+    if (node_out) {
+        *node_out = graph->num_nodes;
+    }
+    graph->num_nodes++;
+    return PRTS_OK;
+}
+
+prts_result_t prts_task_graph_add_edge(
+    prts_task_graph_t* graph,
+    size_t from,
+    size_t to
+) {
+    if (!graph || graph->running || from >= graph->num_nodes ||
+        to >= graph->num_nodes || from == to) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    graph_node_t* node = &graph->nodes[from];
+    if (node->num_successors == node->successors_capacity) {
+        size_t new_capacity = node->successors_capacity ? node->successors_capacity * 2 : 4;
+        size_t* successors = realloc(node->successors, new_capacity * sizeof(size_t));
+        if (!successors) {
+            return PRTS_ERROR_NOMEM;
+        }
+        node->successors = successors;
+        node->successors_capacity = new_capacity;
+    }
+
+    node->successors[node->num_successors++] = to;
+    graph->nodes[to].num_predecessors++;
+    return PRTS_OK;
+}
+
+prts_result_t prts_task_graph_submit(prts_task_graph_t* graph) {
+    if (!graph || graph->running) {
+        return PRTS_ERROR_INVALID;
+    }
+    if (graph->num_nodes == 0) {
+        return PRTS_OK;
+    }
+
+    /* Kahn's algorithm, to reject cycles and find the roots */
+    size_t n = graph->num_nodes;
+    size_t* order = malloc(n * sizeof(size_t));
+    void** roots = malloc(n * sizeof(void*));
+    if (!order || !roots) {
+        free(order);
+        free(roots);
+        return PRTS_ERROR_NOMEM;
+    }
+
+    size_t num_roots = 0;
+    size_t head = 0;
+    size_t tail = 0;
+    for (size_t i = 0; i < n; i++) {
+        graph_node_t* node = &graph->nodes[i];
+        atomic_store_explicit(&node->pending, node->num_predecessors, memory_order_relaxed);
+        if (node->num_predecessors == 0) {
+            order[tail++] = i;
+            roots[num_roots++] = node;
+        }
+    }
+    while (head < tail) {
+        graph_node_t* node = &graph->nodes[order[head++]];
+        for (size_t i = 0; i < node->num_successors; i++) {
+            graph_node_t* next = &graph->nodes[node->successors[i]];
+            size_t pending = atomic_load_explicit(&next->pending, memory_order_relaxed) - 1;
+            atomic_store_explicit(&next->pending, pending, memory_order_relaxed);
+            if (pending == 0) {
+                order[tail++] = node->successors[i];
+            }
+        }
+    }
+    free(order);
+
+    if (tail < n) {
+        free(roots);
+        return PRTS_ERROR_INVALID;
+    }
+
+    /* Reset run state */
+    for (size_t i = 0; i < n; i++) {
+        graph_node_t* node = &graph->nodes[i];
+        atomic_store_explicit(&node->pending, node->num_predecessors, memory_order_relaxed);
+        atomic_store_explicit(&node->skip, false, memory_order_relaxed);
+        node->result = PRTS_ERROR_CANCELLED;
+    }
+    atomic_store_explicit(&graph->remaining, n, memory_order_relaxed);
+    atomic_store_explicit(&graph->cancelled, false, memory_order_relaxed);
+    atomic_store_explicit(&graph->result, PRTS_OK, memory_order_relaxed);
+    atomic_store_explicit(&graph->state, TASK_PENDING, memory_order_relaxed);
+
+    prts_result_t result = pool_submit(graph->pool, graph_node_task, roots, NULL, num_roots, NULL, NULL);
+    free(roots);
+
+    if (result != PRTS_OK) {
+        atomic_store_explicit(&graph->state, TASK_DONE, memory_order_relaxed);
+        return result;
+    }
+    graph->running = true;
+    return PRTS_OK;
+}
+
+void prts_task_graph_cancel(prts_task_graph_t* graph) {
+    if (!graph) return;
+    atomic_store_explicit(&graph->cancelled, true, memory_order_relaxed);
+}
+
+prts_result_t prts_task_graph_wait(prts_task_graph_t* graph, int timeout_ms) {
+    if (!graph) {
+        return PRTS_ERROR_INVALID;
+    }
+    if (!graph->running) {
+        return PRTS_OK;
+    }
+
+    if (timeout_ms < 0) {
+        help_until_done(graph->pool, &graph->state);
+    } else if (completion_wait(graph->pool, &graph->state, timeout_ms) != PRTS_OK) {
+        return PRTS_ERROR_TIMEOUT;
+    }
+
+    graph->running = false;
+    return (prts_result_t)atomic_load_explicit(&graph->result, memory_order_relaxed);
+}
+
+prts_result_t prts_task_graph_node_result(
+    prts_task_graph_t* graph,
+    size_t node,
+    prts_result_t* result_out
+) {
+    if (!graph || graph->running || node >= graph->num_nodes || !result_out) {
+        return PRTS_ERROR_INVALID;
+    }
+    *result_out = graph->nodes[node].result;
+    return PRTS_OK;
+}
+
+prts_result_t prts_task_wait(prts_task_t* task, int timeout_ms) {
+    if (!task) {
+        return PRTS_ERROR_INVALID;
+    }
+    prts_result_t result = completion_wait(task->pool, &task->state, timeout_ms);
+    if (result == PRTS_OK && task->expired) {
+        return PRTS_ERROR_CANCELLED;
+    }
+    return result;
+}
+
+void prts_task_free(prts_task_t* task) {
+    if (!task) return;
+    task_release(task);
+}
+
+size_t prts_threadpool_num_threads(const prts_thread_pool_t* pool) {
+    return pool ? pool->num_threads : 0;
+}
+
+prts_result_t prts_threadpool_stats(
+    prts_thread_pool_t* pool,
+    prts_threadpool_stats_t* stats
+) {
+    if (!pool || !stats) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    uint64_t wait_buckets[LATENCY_BUCKETS] = {0};
+    uint64_t exec_buckets[LATENCY_BUCKETS] = {0};
+    uint64_t total_wait = 0;
+    uint64_t total_exec = 0;
+    uint64_t timed = 0;
+
+    pool_lock(pool);
+
+    size_t active = 0;
+    size_t pending = pool->task_count;
+    size_t completed = 0;
+    size_t expired = 0;
+    for (size_t i = 0; i < pool->num_slots; i++) {
+        worker_t* w = &pool->workers[i];
+        if (atomic_load_explicit(&w->busy, memory_order_relaxed)) {
+            active++;
+        }
+        pending += deque_size(w);
+        expired += atomic_load_explicit(&w->expired, memory_order_relaxed);
+        completed += atomic_load_explicit(&w->completed, memory_order_relaxed);
+
+        total_wait += atomic_load_explicit(&w->wait.total_ns, memory_order_relaxed);
+        total_exec += atomic_load_explicit(&w->exec.total_ns, memory_order_relaxed);
+        for (size_t b = 0; b < LATENCY_BUCKETS; b++) {
+            uint64_t n = atomic_load_explicit(&w->wait.buckets[b], memory_order_relaxed);
+            wait_buckets[b] += n;
+            exec_buckets[b] += atomic_load_explicit(&w->exec.buckets[b], memory_order_relaxed);
+            timed += n;
+        }
+    }
+
+    stats->active_threads = active;
+    stats->idle_threads = pool->num_live > active ? pool->num_live - active : 0;
+    stats->pending_tasks = pending;
+    stats->completed_tasks = completed - expired;
+    stats->expired_tasks = expired;
+
+    pool_unlock(pool);
+
+    /* Both histograms get one sample per task run, so they share a count */
+    stats->total_wait_ns = total_wait;
+    stats->total_exec_ns = total_exec;
+    stats->wait_p50_ns = latency_quantile(wait_buckets, timed, 0.50);
+    stats->wait_p99_ns = latency_quantile(wait_buckets, timed, 0.99);
+    stats->exec_p50_ns = latency_quantile(exec_buckets, timed, 0.50);
+    stats->exec_p99_ns = latency_quantile(exec_buckets, timed, 0.99);
+
+    return PRTS_OK;
+}
+
+/* ============================================================================
+ * Futures
+ * ============================================================================ */
+
+/* Continuation list marker once the future has completed */
+#define CONTS_CLOSED ((future_cont_t*)(uintptr_t)1)
+
+/* Entry in a future's continuation list */
+typedef struct future_cont {
+    struct future_cont* next;
+    struct prts_future* target;     /* then: the future fed by this one */
+    struct future_join* join;       /* when_all / when_any, or NULL */
+} future_cont_t;
+
+struct prts_future {
+    prts_thread_pool_t* pool;
+    _Atomic uint32_t refs;          /* Handle, plus whoever will complete it */
+    _Atomic uint32_t state;         /* Completion word */
+    _Atomic bool settled;           /* A completer has claimed it */
+    prts_result_t result;           /* Written once, before state becomes TASK_DONE */
+    void* value;
+    _Atomic(future_cont_t*) conts;  /* Pending continuations, CONTS_CLOSED once complete */
+
+    /* How the future is produced: an async task or a continuation */
+    prts_future_fn fn;
+    prts_then_fn then_fn;
+    void* arg;
+    void* input;                    /* The antecedent's value, for then_fn */
+    future_cont_t link;             /* Entry in the antecedent's list */
+};
+
+/* when_all / when_any over count inputs */
+typedef struct future_join {
+    prts_future_t* target;
+    bool any;
+    _Atomic bool done;              /* Target completed */
+    _Atomic size_t remaining;       /* Inputs yet to complete; the last frees the join */
+    future_cont_t links[];
+} future_join_t;
+
+static prts_future_t* future_alloc(prts_thread_pool_t* pool, uint32_t refs) {
+    prts_future_t* future = calloc(1, sizeof(prts_future_t));
+    if (!future) {
+        return NULL;
+    }
+    future->pool = pool;
+    atomic_init(&future->refs, refs);
+    atomic_init(&future->state, TASK_PENDING);
+    atomic_init(&future->conts, NULL);
+    return future;
+}
+
+static void future_release(prts_future_t* future) {
+    if (atomic_fetch_sub_explicit(&future->refs, 1, memory_order_acq_rel) == 1) {
+        free(future);
+    }
+}
+
+static bool future_complete(prts_future_t* future, prts_result_t result, void* value);
+
+static void future_then_task(void* arg) {
+    prts_future_t* target = (prts_future_t*)arg;
+    void* value = NULL;
+    prts_result_t result = target->then_fn(target->input, target->arg, &value);
+    future_complete(target, result, value);
+    future_release(target);
+}
+
+/* Feed the completed source's outcome to one continuation */
+static void future_dispatch(prts_future_t* source, future_cont_t* cont) {
+    prts_result_t result = source->result;
+
+    future_join_t* join = cont->join;
+    if (join) {
+        /*
+         * Once this input counts itself off, the last input may free the
+         * join, so everything needed is read or claimed first. The
+         * settling input holds its own reference to the target.
+         */
+        prts_future_t* target = join->target;
+        bool any = join->any;
+        bool settle = any ? result == PRTS_OK : result != PRTS_OK;
+        bool won = settle && !atomic_exchange_explicit(&join->done, true, memory_order_acq_rel);
+        if (won) {
+            atomic_fetch_add_explicit(&target->refs, 1, memory_order_relaxed);
+        }
+
+        if (atomic_fetch_sub_explicit(&join->remaining, 1, memory_order_acq_rel) == 1) {
+            /* Last input: the join is ours alone now */
+            if (!won && !atomic_exchange_explicit(&join->done, true, memory_order_acq_rel)) {
+                won = true;
+                atomic_fetch_add_explicit(&target->refs, 1, memory_order_relaxed);
+            }
+            future_release(target);
+            free(join);
+        }
+
+        if (won) {
+            /* when_any passes the winner's value; when_all has none */
+            future_complete(target, result, any ? source->value : NULL);
+            future_release(target);
+        }
+        return;
+    }
+
+    prts_future_t* target = cont->target;
+    if (result != PRTS_OK) {
+        /* Errors skip the continuation and flow down the chain */
+        future_complete(target, result, NULL);
+        future_release(target);
+        return;
+    }
+
+    target->input = source->value;
+    if (pool_submit(target->pool, future_then_task, NULL, target, 1, NULL, NULL) != PRTS_OK) {
+        future_complete(target, PRTS_ERROR, NULL);
+        future_release(target);
+    }
+}
+
+/* Returns false if the future had already been completed */
+static bool future_complete(prts_future_t* future, prts_result_t result, void* value) {
+    if (atomic_exchange_explicit(&future->settled, true, memory_order_acq_rel)) {
+        return false;
+    }
+    future->result = result;
+    future->value = value;
+
+    /* Close the list; later continuations see the outcome and run at once */
+    future_cont_t* list = atomic_exchange_explicit(&future->conts, CONTS_CLOSED,
+                                                   memory_order_acq_rel);
+    completion_signal(future->pool, &future->state);
+
+    /* Run continuations in the order they were added */
+    future_cont_t* ordered = NULL;
+    while (list) {
+        future_cont_t* next = list->next;
+        list->next = ordered;
+        ordered = list;
+        list = next;
+    }
+    while (ordered) {
+        future_cont_t* cont = ordered;
+        ordered = ordered->next;
+        future_dispatch(future, cont);
+    }
+    return true;
+}
+
+/* Queue a continuation, or run it now if the future has completed */
+static void future_add_cont(prts_future_t* future, future_cont_t* cont) {
+    future_cont_t* head = atomic_load_explicit(&future->conts, memory_order_acquire);
+    do {
+        if (head == CONTS_CLOSED) {
+            future_dispatch(future, cont);
+            return;
+        }
+        cont->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&future->conts, &head, cont,
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire));
+}
+
+static void future_async_task(void* arg) {
+    prts_future_t* future = (prts_future_t*)arg;
+    void* value = NULL;
+    prts_result_t result = future->fn(future->arg, &value);
+    future_complete(future, result, value);
+    future_release(future);
+}
+
+prts_result_t prts_future_create(prts_thread_pool_t* pool, prts_future_t** future_out) {
+    if (!pool || !future_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    prts_future_t* future = future_alloc(pool, 1);
+    if (!future) {
+        return PRTS_ERROR_NOMEM;
+    }
+    *future_out = future;
+    return PRTS_OK;
+}
+
+prts_result_t prts_future_set(prts_future_t* future, prts_result_t result, void* value) {
+    if (!future) {
+        return PRTS_ERROR_INVALID;
+    }
+    return future_complete(future, result, value) ? PRTS_OK : PRTS_ERROR_INVALID;
+}
+
+prts_result_t prts_threadpool_async(
+    prts_thread_pool_t* pool,
+    prts_future_fn fn,
+    void* arg,
+    prts_future_t** future_out
+) {
+    if (!pool || !fn || !future_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    /* One reference for the handle, one for the task */
+    prts_future_t* future = future_alloc(pool, 2);
+    if (!future) {
+        return PRTS_ERROR_NOMEM;
+    }
+    future->fn = fn;
+    future->arg = arg;
+
+    prts_result_t result = pool_submit(pool, future_async_task, NULL, future, 1, NULL, NULL);
+    if (result != PRTS_OK) {
+        free(future);
+        return result;
+    }
+    *future_out = future;
+    return PRTS_OK;
+}
+
+prts_result_t prts_future_then(
+    prts_future_t* future,
+    prts_then_fn fn,
+    void* arg,
+    prts_future_t** next_out
+) {
+    if (!future || !fn || !next_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    /* One reference for the handle, one for the antecedent's completion */
+    prts_future_t* next = future_alloc(future->pool, 2);
+    if (!next) {
+        return PRTS_ERROR_NOMEM;
+    }
+    next->then_fn = fn;
+    next->arg = arg;
+    next->link.target = next;
+
+    *next_out = next;
+    future_add_cont(future, &next->link);
+    return PRTS_OK;
+}
+
+static prts_result_t future_join(
+    prts_thread_pool_t* pool,
+    prts_future_t* const* futures,
+    size_t count,
+    bool any,
+    prts_future_t** future_out
+) {
+    if (!pool || !future_out || (count > 0 && !futures) || (any && count == 0)) {
+        return PRTS_ERROR_INVALID;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!futures[i]) {
+            return PRTS_ERROR_INVALID;
+        }
+    }
+
+    prts_future_t* target = future_alloc(pool, 2);
+    if (!target) {
+        return PRTS_ERROR_NOMEM;
+    }
+    if (count == 0) {
+        future_complete(target, PRTS_OK, NULL);
+        future_release(target);
+        *future_out = target;
+        return PRTS_OK;
+    }
+
+    future_join_t* join = calloc(1, sizeof(future_join_t) + count * sizeof(future_cont_t));
+    if (!join) {
+        free(target);
+        return PRTS_ERROR_NOMEM;
+    }
+    join->target = target;
+    join->any = any;
+    atomic_init(&join->done, false);
+    atomic_init(&join->remaining, count);
+
+    /* The join may complete and be freed while still being attached */
+    *future_out = target;
+    for (size_t i = 0; i < count; i++) {
+        join->links[i].join = join;
+    }
+    for (size_t i = 0; i < count; i++) {
+        future_add_cont(futures[i], &join->links[i]);
+    }
+    return PRTS_OK;
+}
+
+prts_result_t prts_future_when_all(
+    prts_thread_pool_t* pool,
+    prts_future_t* const* futures,
+    size_t count,
+    prts_future_t** future_out
+) {
+    return future_join(pool, futures, count, false, future_out);
+}
+
+prts_result_t prts_future_when_any(
+    prts_thread_pool_t* pool,
+    prts_future_t* const* futures,
+    size_t count,
+    prts_future_t** future_out
+) {
+    return future_join(pool, futures, count, true, future_out);
+}
+
+bool prts_future_ready(const prts_future_t* future) {
+    return future && atomic_load_explicit(&((prts_future_t*)future)->state,
+                                          memory_order_acquire) == TASK_DONE;
+}
+
+prts_result_t prts_future_wait(prts_future_t* future, int timeout_ms) {
+    if (!future) {
+        return PRTS_ERROR_INVALID;
+    }
+    if (timeout_ms < 0) {
+        help_until_done(future->pool, &future->state);
+        return PRTS_OK;
+    }
+    return completion_wait(future->pool, &future->state, timeout_ms);
+}
+
+prts_result_t prts_future_get(prts_future_t* future, void** value_out) {
+    if (!future) {
+        return PRTS_ERROR_INVALID;
+    }
+    help_until_done(future->pool, &future->state);
+    if (value_out) {
+        *value_out = future->value;
+    }
+    return future->result;
+}
+
+void prts_future_release(prts_future_t* future) {
+    if (!future) return;
+    future_release(future);
+}
+
+/* ============================================================================
+ * Timers
+ * ============================================================================ */
+
+static void wheel_lock(timer_wheel_t* wheel) {
+#ifdef _WIN32
+    EnterCriticalSection(&wheel->lock);
+#else
+    pthread_mutex_lock(&wheel->lock);
+#endif
+}
+
+static bool wheel_trylock(timer_wheel_t* wheel) {
+#ifdef _WIN32
+    return TryEnterCriticalSection(&wheel->lock) != 0;
+#else
+    return pthread_mutex_trylock(&wheel->lock) == 0;
+#endif
+}
+
+static void wheel_unlock(timer_wheel_t* wheel) {
+#ifdef _WIN32
+    LeaveCriticalSection(&wheel->lock);
+#else
+    pthread_mutex_unlock(&wheel->lock);
 #endif
 }
+
+static void timer_release(struct prts_timer* timer) {
+    if (atomic_fetch_sub_explicit(&timer->refs, 1, memory_order_acq_rel) == 1) {
+        free(timer);
+    }
+}
+
+/*
+ * File a timer by how far away it is, no earlier than tick earliest;
+ * caller holds the wheel lock. Cascades refile at the current tick,
+ * whose level-0 slot is processed right after.
+ */
+static void wheel_insert(timer_wheel_t* wheel, struct prts_timer* timer, uint64_t earliest) {
+    if (timer->expires < earliest) {
+        timer->expires = earliest;
+    }
+
+    uint64_t delta = timer->expires - wheel->current;
+    int level = 0;
+    while (level < TIMER_LEVELS - 1 && delta >= 1ULL << (TIMER_LEVEL_BITS * (level + 1))) {
+        level++;
+    }
+
+    /* Beyond the wheel: park in the furthest slot and re-cascade from there */
+    uint64_t tick = timer->expires;
+    uint64_t span = 1ULL << (TIMER_LEVEL_BITS * TIMER_LEVELS);
+    if (delta >= span) {
+        tick = wheel->current + span - 1;
+    }
+
+    int slot = (int)((tick >> (TIMER_LEVEL_BITS * level)) & (TIMER_SLOTS - 1));
+    struct prts_timer** head = &wheel->slots[level][slot];
+    timer->level = (uint8_t)level;
+    timer->slot = (uint8_t)slot;
+    timer->next = *head;
+    timer->pprev = head;
+    if (*head) {
+        (*head)->pprev = &timer->next;
+    }
+    *head = timer;
+    wheel->occupied[level] |= 1ULL << slot;
+}
+
+static void wheel_remove(timer_wheel_t* wheel, struct prts_timer* timer) {
+    *timer->pprev = timer->next;
+    if (timer->next) {
+        timer->next->pprev = timer->pprev;
+    }
+    if (!wheel->slots[timer->level][timer->slot]) {
+        wheel->occupied[timer->level] &= ~(1ULL << timer->slot);
+    }
+}
+
+/*
+ * Tick of the next wheel event after current: a level-0 slot expiring or
+ * a higher-level slot cascading. Caller holds the wheel lock.
+ */
+static uint64_t wheel_next_event(const timer_wheel_t* wheel) {
+    uint64_t next = TIMER_NONE;
+    for (int level = 0; level < TIMER_LEVELS; level++) {
+        uint64_t bits = wheel->occupied[level];
+        if (!bits) continue;
+
+        unsigned shift = TIMER_LEVEL_BITS * level;
+        uint64_t position = wheel->current >> shift;
+        unsigned start = (unsigned)((position + 1) & (TIMER_SLOTS - 1));
+
+        /* Rotate so bit k is the slot k + 1 positions ahead */
+        uint64_t rotated = start ? (bits >> start) | (bits << (TIMER_SLOTS - start)) : bits;
+        uint64_t ahead = 64 - leading_zeros(rotated & (~rotated + 1));
+        uint64_t tick = (position + ahead) << shift;
+        if (tick < next) {
+            next = tick;
+        }
+    }
+    return next;
+}
+
+/* Publish the time of the next event; caller holds the wheel lock */
+static uint64_t wheel_update_next(prts_thread_pool_t* pool) {
+    uint64_t tick = wheel_next_event(&pool->wheel);
+    uint64_t next = tick == TIMER_NONE ? TIMER_NONE : pool->wheel.base + tick * TIMER_TICK_NS;
+    atomic_store_explicit(&pool->timer_next, next, memory_order_relaxed);
+    return next;
+}
+
+/* Wake sleepers so the timekeeper re-reads an earlier timer_next */
+static void wake_timekeeper(prts_thread_pool_t* pool) {
+    pool_lock(pool);
+    if (atomic_load_explicit(&pool->num_sleeping, memory_order_relaxed) > 0) {
+        pool_broadcast(&pool->not_empty);
+    }
+    pool_unlock(pool);
+}
+
+static void timer_run(void* arg) {
+    struct prts_timer* timer = (struct prts_timer*)arg;
+    timer->fn(timer->arg);
+    if (timer->period) {
+        atomic_store_explicit(&timer->running, false, memory_order_release);
+    }
+    timer_release(timer);
+}
+
+static void timer_dispatch(prts_thread_pool_t* pool, void** fired, size_t count) {
+    if (pool_submit(pool, timer_run, fired, NULL, count, NULL, NULL) != PRTS_OK) {
+        /* Out of nodes: the runs are lost, the timers stay consistent */
+        for (size_t i = 0; i < count; i++) {
+            struct prts_timer* timer = fired[i];
+            if (timer->period) {
+                atomic_store_explicit(&timer->running, false, memory_order_release);
+            }
+            timer_release(timer);
+        }
+    }
+}
+
+/*
+ * Process wheel events up to now, jumping straight between occupied
+ * slots. Expired timers are collected under the wheel lock and handed to
+ * workers as ordinary tasks after it is released; only workers advance
+ * the wheel, so dispatch never waits on the queue bound. Only one thread
+ * advances at a time; the others carry on.
+ */
+static void timer_advance(prts_thread_pool_t* pool) {
+    timer_wheel_t* wheel = &pool->wheel;
+    if (!wheel_trylock(wheel)) {
+        return;
+    }
+
+    uint64_t now = (prts_timestamp_now() - wheel->base) / TIMER_TICK_NS;
+    struct prts_timer* fired = NULL;
+    struct prts_timer** fired_tail = &fired;
+
+    while (1) {
+        uint64_t tick = wheel_next_event(wheel);
+        if (tick > now) {
+            wheel->current = now;
+            break;
+        }
+        wheel->current = tick;
+
+        /* Cascade every level whose period starts at this tick */
+        for (int level = TIMER_LEVELS - 1; level > 0; level--) {
+            unsigned shift = TIMER_LEVEL_BITS * level;
+            if (tick & ((1ULL << shift) - 1)) continue;
+
+            int slot = (int)((tick >> shift) & (TIMER_SLOTS - 1));
+            struct prts_timer* list = wheel->slots[level][slot];
+            wheel->slots[level][slot] = NULL;
+            wheel->occupied[level] &= ~(1ULL << slot);
+            while (list) {
+                struct prts_timer* timer = list;
+                list = list->next;
+                wheel_insert(wheel, timer, tick);
+            }
+        }
+
+        int slot = (int)(tick & (TIMER_SLOTS - 1));
+        struct prts_timer* list = wheel->slots[0][slot];
+        wheel->slots[0][slot] = NULL;
+        wheel->occupied[0] &= ~(1ULL << slot);
+        while (list) {
+            struct prts_timer* timer = list;
+            list = list->next;
+
+            if (!timer->period) {
+                /* The wheel's reference passes to the run */
+                timer->state = TIMER_FIRED;
+                *fired_tail = timer;
+                fired_tail = &timer->fired_next;
+            } else {
+                /* Skip a run while the previous one is still going */
+                if (!atomic_exchange_explicit(&timer->running, true, memory_order_acq_rel)) {
+                    atomic_fetch_add_explicit(&timer->refs, 1, memory_order_relaxed);
+                    *fired_tail = timer;
+                    fired_tail = &timer->fired_next;
+                }
+                timer->expires += timer->period;
+                if (timer->expires <= now) {
+                    /* Fell behind; keep the cadence from now rather than bursting */
+                    timer->expires = now + timer->period;
+                }
+                wheel_insert(wheel, timer, tick + 1);
+            }
+        }
+    }
+    *fired_tail = NULL;
+
+    wheel_update_next(pool);
+    wheel_unlock(wheel);
+
+    /* A periodic timer may be re-armed already, but its run holds a reference */
+    void* batch[TIMER_FIRE_BATCH];
+    size_t num_batch = 0;
+    while (fired) {
+        batch[num_batch++] = fired;
+        fired = fired->fired_next;
+        if (num_batch == TIMER_FIRE_BATCH || !fired) {
+            timer_dispatch(pool, batch, num_batch);
+            num_batch = 0;
+        }
+    }
+}
+
+static prts_result_t timer_schedule(
+    prts_thread_pool_t* pool,
+    uint32_t delay_ms,
+    uint32_t period_ms,
+    prts_task_fn fn,
+    void* arg,
+    prts_timer_t** timer_out
+) {
+    if (!pool || !fn) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    struct prts_timer* timer = calloc(1, sizeof(struct prts_timer));
+    if (!timer) {
+        return PRTS_ERROR_NOMEM;
+    }
+    timer->fn = fn;
+    timer->arg = arg;
+    timer->pool = pool;
+    timer->period = period_ms;
+    timer->state = TIMER_ARMED;
+    atomic_init(&timer->refs, timer_out ? 2 : 1);
+
+    timer_wheel_t* wheel = &pool->wheel;
+    prts_timestamp_t due = prts_timestamp_now() + (prts_timestamp_t)delay_ms * TIMER_TICK_NS;
+
+    wheel_lock(wheel);
+    pool_lock(pool);
+    bool shutdown = pool->shutdown;
+    pool_unlock(pool);
+    if (shutdown) {
+        wheel_unlock(wheel);
+        free(timer);
+        return PRTS_ERROR;
+    }
+
+    /* Round up so a timer never fires early */
+    timer->expires = (due - wheel->base + TIMER_TICK_NS - 1) / TIMER_TICK_NS;
+    uint64_t before = atomic_load_explicit(&pool->timer_next, memory_order_relaxed);
+    wheel_insert(wheel, timer, wheel->current + 1);
+    uint64_t after = wheel_update_next(pool);
+    wheel_unlock(wheel);
+
+    if (after < before) {
+        wake_timekeeper(pool);
+    }
+
+    if (timer_out) {
+        *timer_out = timer;
+    }
+    return PRTS_OK;
+}
+
+prts_result_t prts_threadpool_submit_after(
+    prts_thread_pool_t* pool,
+    uint32_t delay_ms,
+    prts_task_fn fn,
+    void* arg,
+    prts_timer_t** timer_out
+) {
+    return timer_schedule(pool, delay_ms, 0, fn, arg, timer_out);
+}
+
+prts_result_t prts_threadpool_submit_every(
+    prts_thread_pool_t* pool,
+    uint32_t period_ms,
+    prts_task_fn fn,
+    void* arg,
+    prts_timer_t** timer_out
+) {
+    if (period_ms == 0) {
+        return PRTS_ERROR_INVALID;
+    }
+    return timer_schedule(pool, period_ms, period_ms, fn, arg, timer_out);
+}
+
+prts_result_t prts_timer_cancel(prts_timer_t* timer) {
+    if (!timer) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    timer_wheel_t* wheel = &timer->pool->wheel;
+    bool armed = false;
+
+    wheel_lock(wheel);
+    if (timer->state == TIMER_ARMED) {
+        wheel_remove(wheel, timer);
+        timer->state = TIMER_CANCELLED;
+        armed = true;
+    }
+    wheel_unlock(wheel);
+
+    /* The wheel's reference, then the handle's */
+    if (armed) {
+        timer_release(timer);
+    }
+    timer_release(timer);
+    return armed ? PRTS_OK : PRTS_ERROR_EMPTY;
+}
+
+/* ============================================================================
+ * NUMA pools
+ * ============================================================================ */
+
+struct prts_numa_pool {
+    prts_thread_pool_t* pools[PRTS_MAX_NUMA_NODES];     /* By node id; NULL for CPU-less nodes */
+    prts_thread_pool_t* fallback;                       /* First pool, for unknown nodes */
+};
+
+prts_result_t prts_numa_pool_create(
+    const prts_threadpool_config_t* config,
+    prts_numa_pool_t** pool_out
+) {
+    if (!config || !pool_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    prts_numa_pool_t* numa = calloc(1, sizeof(prts_numa_pool_t));
+    if (!numa) {
+        return PRTS_ERROR_NOMEM;
+    }
+
+    size_t num_nodes = prts_numa_node_count();
+    for (size_t node = 0; node < num_nodes; node++) {
+        prts_threadpool_config_t node_config = *config;
+        if (prts_numa_node_cpus(node, &node_config.cpus) != PRTS_OK) {
+            continue;
+        }
+
+        prts_result_t result = prts_threadpool_create(&node_config, &numa->pools[node]);
+        if (result != PRTS_OK) {
+            prts_numa_pool_destroy(numa);
+            return result;
+        }
+        if (!numa->fallback) {
+            numa->fallback = numa->pools[node];
+        }
+    }
+
+    if (!numa->fallback) {
+        free(numa);
+        return PRTS_ERROR;
+    }
+
+    *pool_out = numa;
+    return PRTS_OK;
+}
+
+void prts_numa_pool_destroy(prts_numa_pool_t* numa) {
+    if (!numa) return;
+
+    for (size_t node = 0; node < PRTS_MAX_NUMA_NODES; node++) {
+        prts_threadpool_destroy(numa->pools[node]);
+    }
+    free(numa);
+}
+
+prts_thread_pool_t* prts_numa_pool_node(prts_numa_pool_t* numa, size_t node) {
+    if (!numa || node >= PRTS_MAX_NUMA_NODES) {
+        return NULL;
+    }
+    return numa->pools[node];
+}
+
+prts_thread_pool_t* prts_numa_pool_local(prts_numa_pool_t* numa) {
+    if (!numa) {
+        return NULL;
+    }
+
+    /* A worker stays with its own pool, wherever the scheduler moved it */
+    worker_t* self = current_worker;
+    if (self) {
+        for (size_t node = 0; node < PRTS_MAX_NUMA_NODES; node++) {
+            if (numa->pools[node] == self->pool) {
+                return self->pool;
+            }
+        }
+    }
+
+    prts_thread_pool_t* pool = prts_numa_pool_node(numa, prts_numa_current_node());
+    return pool ? pool : numa->fallback;
+}
+
+void prts_threadpool_block_begin(prts_thread_pool_t* pool) {
+    if (!pool || !pool->allow_grow || !pool_worker(pool)) return;
+
+    pool_lock(pool);
+    pool->num_blocked++;
+
+    /* Keep num_threads workers able to run tasks */
+    if (pool->num_live - pool->num_blocked < pool->num_threads &&
+        atomic_load_explicit(&pool->num_sleeping, memory_order_relaxed) == 0) {
+        spawn_worker(pool);
+    }
+    pool_unlock(pool);
+}
+
+void prts_threadpool_block_end(prts_thread_pool_t* pool) {
+    if (!pool || !pool->allow_grow || !pool_worker(pool)) return;
+
+    pool_lock(pool);
+    pool->num_blocked--;
+
+    /* Spares that stood in may now retire; wake them onto the idle timeout */
+    if (pool->num_live - pool->num_blocked > pool->num_threads) {
+        pool_broadcast(&pool->not_empty);
+    }
+    pool_unlock(pool);
+}
+
+void prts_threadpool_wait_all(prts_thread_pool_t* pool) {
+    if (!pool) return;
+
+    pool_lock(pool);
+    pool->num_waiters++;
+    while (!pool_quiescent(pool)) {
+        pool_wait(pool, &pool->quiescent);
+    }
+    pool->num_waiters--;
+    pool_unlock(pool);
+}
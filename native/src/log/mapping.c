@@ -0,0 +1,206 @@
+/**
+ * PRTS Native - Memory-Mapped Log Ingestion
+ * Zero-copy parsing of archived log files.
+ */
+
+#include "prts/log.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* One mapped file */
+typedef struct {
+    const char* data;
+    size_t len;
+} mapped_file_t;
+
+struct prts_log_mapping {
+    mapped_file_t* files;
+    size_t num_files;
+
+    /* Parse cursor */
+    size_t current_file;
+    size_t offset;
+};
+
+static prts_result_t map_file(const char* path, mapped_file_t* file) {
+    file->data = NULL;
+    file->len = 0;
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return PRTS_ERROR;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size)) {
+        CloseHandle(handle);
+        return PRTS_ERROR;
+    }
+    if (size.QuadPart == 0) {
+        CloseHandle(handle);
+        return PRTS_OK;
+    }
+
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(handle);
+    if (!mapping) {
+        return PRTS_ERROR;
+    }
+
+    /* The view keeps the mapping object alive */
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data) {
+        return PRTS_ERROR;
+    }
+
+    file->data = data;
+    file->len = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return PRTS_ERROR;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return PRTS_ERROR;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return PRTS_OK;
+    }
+
+    /* The mapping stays valid after the descriptor is closed */
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return PRTS_ERROR;
+    }
+
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    file->data = data;
+    file->len = (size_t)st.st_size;
+#endif
+
+    return PRTS_OK;
+}
+
+static void unmap_file(mapped_file_t* file) {
+    if (!file->data) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(file->data);
+#else
+    munmap((void*)file->data, file->len);
+#endif
+
+    file->data = NULL;
+    file->len = 0;
+}
+
+prts_result_t prts_log_mapping_open(
+    const char* const* paths,
+    size_t num_paths,
+    prts_log_mapping_t** mapping_out
+) {
+    if (!paths || num_paths == 0 || !mapping_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    prts_log_mapping_t* mapping = calloc(1, sizeof(prts_log_mapping_t));
+    if (!mapping) {
+        return PRTS_ERROR_NOMEM;
+    }
+
+    mapping->files = calloc(num_paths, sizeof(mapped_file_t));
+    if (!mapping->files) {
+        free(mapping);
+        return PRTS_ERROR_NOMEM;
+    }
+
+    for (size_t i = 0; i < num_paths; i++) {
+        if (!paths[i] || map_file(paths[i], &mapping->files[i]) != PRTS_OK) {
+            prts_log_mapping_close(mapping);
+            return PRTS_ERROR;
+        }
+        mapping->num_files++;
+    }
+
+    *mapping_out = mapping;
+    return PRTS_OK;
+}
+
+void prts_log_mapping_close(prts_log_mapping_t* mapping) {
+    if (!mapping) return;
+
+    for (size_t i = 0; i < mapping->num_files; i++) {
+        unmap_file(&mapping->files[i]);
+    }
+
+    free(mapping->files);
+    free(mapping);
+}
+
+size_t prts_log_mapping_count(const prts_log_mapping_t* mapping) {
+    return mapping ? mapping->num_files : 0;
+}
+
+prts_result_t prts_log_mapping_data(
+    const prts_log_mapping_t* mapping,
+    size_t index,
+    const char** data_out,
+    size_t* len_out
+) {
+    if (!mapping || !data_out || !len_out || index >= mapping->num_files) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    *data_out = mapping->files[index].data;
+    *len_out = mapping->files[index].len;
+    return PRTS_OK;
+}
+
+void prts_log_mapping_rewind(prts_log_mapping_t* mapping) {
+    if (!mapping) return;
+    mapping->current_file = 0;
+    mapping->offset = 0;
+}
+
+void prts_log_mapping_tell(
+    const prts_log_mapping_t* mapping,
+    size_t* file_out,
+    size_t* offset_out
+) {
+    if (!mapping) return;
+    if (file_out) *file_out = mapping->current_file;
+    if (offset_out) *offset_out = mapping->offset;
+}
+
+prts_result_t prts_log_mapping_seek(
+    prts_log_mapping_t* mapping,
+    size_t file,
+    size_t offset
+) {
+    if (!mapping || file > mapping->num_files ||
+        (file < mapping->num_files && offset > mapping->files[file].len)) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    mapping->current_file = file;
+    mapping->offset = file < mapping->num_files ? offset : 0;
+    return PRTS_OK;
+}
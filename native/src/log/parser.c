@@ -3,18 +3,83 @@
  */
 
 #include "prts/log.h"
+#include "prts/thread_pool.h"
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
+/* Inputs smaller than this per chunk are not worth a worker */
+#define PARALLEL_MIN_CHUNK (1024 * 1024)
+#define PARALLEL_CHUNKS_PER_THREAD 4
+
+#define ARENA_BLOCK_SIZE 4096
+
+/* Lines parsed in AUTO mode before the detected format is re-validated */
+#define FORMAT_REDETECT_INTERVAL 4096
+
+/* Arena block for extracted field storage */
+typedef struct arena_block {
+    struct arena_block* next;
+    size_t size;
+    size_t used;
+    char data[];
+} arena_block_t;
+
+/* Compiled template operation */
+typedef enum {
+    TEMPLATE_LITERAL,       /* Match text exactly */
+    TEMPLATE_CAPTURE,       /* Capture up to the next literal (or end of line) */
+} template_op_kind_t;
+
+typedef enum {
+    CAPTURE_SKIP,
+    CAPTURE_LEVEL,
+    CAPTURE_SOURCE,
+    CAPTURE_MESSAGE,
+    CAPTURE_FIELD,
+} capture_target_t;
+
+typedef struct {
+    template_op_kind_t kind;
+    capture_target_t target;
+    size_t field_index;
+    const char* text;       /* Literal text */
+    size_t len;
+} template_op_t;
+
+/* Field-extraction template compiled from a pattern */
+typedef struct {
+    char* pattern;          /* Original pattern, kept for cloning */
+    char* strings;          /* Literal text and NUL-terminated field names */
+    template_op_t* ops;
+    size_t num_ops;
+    const char** field_names;
+    size_t num_fields;
+} parser_template_t;
+
 struct prts_log_parser {
     prts_log_format_t format;
     char timestamp_format[64];
     bool parse_json_fields;
+    parser_template_t* template;
+
+    /* AUTO format detection, locked in per stream/source */
+    prts_log_format_t detected_format;
+    size_t redetect_countdown;      /* 0 = detect on next line */
+
+    /* Parsing buffers: extracted field values, reset per parse call/batch */
+    arena_block_t* arena;
 
-    /* Parsing buffers */
-    char* temp_buffer;
-    size_t temp_buffer_size;
+    /* Streaming state */
+    char* carry;                /* Partial line carried across chunks */
+    size_t carry_len;
+    size_t carry_cap;
+    char* joined;               /* Line completed from carry + chunk head */
+    size_t joined_len;
+    size_t joined_cap;
+    bool joined_pending;
+    const char* cursor;         /* Unpolled complete lines of the current chunk */
+    const char* cursor_end;
 };
 
 prts_result_t prts_parser_create(
@@ -38,31 +103,339 @@ prts_result_t prts_parser_create(
                 sizeof(parser->timestamp_format) - 1);
     }
 
-    parser->temp_buffer_size = 4096;
-    parser->temp_buffer = malloc(parser->temp_buffer_size);
-    if (!parser->temp_buffer) {
+    parser->arena = malloc(sizeof(arena_block_t) + ARENA_BLOCK_SIZE);
+    if (!parser->arena) {
         free(parser);
         return PRTS_ERROR_NOMEM;
     }
+    parser->arena->next = NULL;
+    parser->arena->size = ARENA_BLOCK_SIZE;
+    parser->arena->used = 0;
 
     *parser_out = parser;
     return PRTS_OK;
 }
 
+static void template_free(parser_template_t* tmpl) {
+    if (!tmpl) return;
+    free(tmpl->pattern);
+    free(tmpl->strings);
+    free(tmpl->ops);
+    free(tmpl->field_names);
+    free(tmpl);
+}
+
 void prts_parser_destroy(prts_log_parser_t* parser) {
     if (!parser) return;
-    free(parser->temp_buffer);
+    while (parser->arena) {
+        arena_block_t* block = parser->arena;
+        parser->arena = block->next;
+        free(block);
+    }
+    template_free(parser->template);
+    free(parser->carry);
+    free(parser->joined);
     free(parser);
 }
 
+/* Level keywords, perfect-hashed by the low 5 bits of their first letter */
+typedef struct {
+    char text[8];           /* Upper-case keyword, zero padded */
+    char mask[8];           /* 0xff for each keyword byte */
+    size_t len;
+    prts_log_level_t level;
+} level_keyword_t;
+
+static const level_keyword_t level_keywords[32] = {
+    ['T' & 31] = {"TRACE", "\xff\xff\xff\xff\xff", 5, PRTS_LOG_TRACE},
+    ['D' & 31] = {"DEBUG", "\xff\xff\xff\xff\xff", 5, PRTS_LOG_DEBUG},
+    ['I' & 31] = {"INFO", "\xff\xff\xff\xff", 4, PRTS_LOG_INFO},
+    ['W' & 31] = {"WARN", "\xff\xff\xff\xff", 4, PRTS_LOG_WARN},
+    ['E' & 31] = {"ERROR", "\xff\xff\xff\xff\xff", 5, PRTS_LOG_ERROR},
+    ['F' & 31] = {"FATAL", "\xff\xff\xff\xff\xff", 5, PRTS_LOG_FATAL},
+};
+
+/* Clears bit 5 of every byte: folds ASCII letters to upper case */
+#define CASE_FOLD_MASK 0xDFDFDFDFDFDFDFDFULL
+
+/*
+ * Classify a level keyword prefix with one table lookup and one masked
+ * 64-bit compare. Returns the keyword length, or 0 if str has no keyword.
+ */
+static size_t classify_level(const char* str, size_t len, prts_log_level_t* level_out) {
+    if (len < 4) {
+        return 0;
+    }
+
+    const level_keyword_t* kw = &level_keywords[(unsigned char)str[0] & 31];
+    if (len < kw->len || kw->len == 0) {
+        return 0;
+    }
+
+    uint64_t word = 0;
+    uint64_t key;
+    uint64_t mask;
+    memcpy(&word, str, len < 8 ? len : 8);
+    memcpy(&key, kw->text, 8);
+    memcpy(&mask, kw->mask, 8);
+
+    if ((word & CASE_FOLD_MASK & mask) != key) {
+        return 0;
+    }
+
+    *level_out = kw->level;
+    return kw->len;
+}
+
 static prts_log_level_t parse_level(const char* str, size_t len) {
-    if (len >= 5 && strncasecmp(str, "TRACE", 5) == 0) return PRTS_LOG_TRACE;
-    if (len >= 5 && strncasecmp(str, "DEBUG", 5) == 0) return PRTS_LOG_DEBUG;
-    if (len >= 4 && strncasecmp(str, "INFO", 4) == 0) return PRTS_LOG_INFO;
-    if (len >= 4 && strncasecmp(str, "WARN", 4) == 0) return PRTS_LOG_WARN;
-    if (len >= 5 && strncasecmp(str, "ERROR", 5) == 0) return PRTS_LOG_ERROR;
-    if (len >= 5 && strncasecmp(str, "FATAL", 5) == 0) return PRTS_LOG_FATAL;
-    return PRTS_LOG_INFO;
+    prts_log_level_t level = PRTS_LOG_INFO;
+    classify_level(str, len, &level);
+    return level;
+}
+
+/* Bounded substring search; returns NULL if needle is not in [str, end) */
+static const char* find_str(const char* str, const char* end,
+                            const char* needle, size_t needle_len) {
+    while ((size_t)(end - str) >= needle_len) {
+        const char* p = memchr(str, needle[0], end - str - needle_len + 1);
+        if (!p) {
+            return NULL;
+        }
+        if (memcmp(p, needle, needle_len) == 0) {
+            return p;
+        }
+        str = p + 1;
+    }
+    return NULL;
+}
+
+/* Release all but the most recent arena block */
+static void arena_reset(prts_log_parser_t* parser) {
+    arena_block_t* block = parser->arena->next;
+    while (block) {
+        arena_block_t* next = block->next;
+        free(block);
+        block = next;
+    }
+    parser->arena->next = NULL;
+    parser->arena->used = 0;
+}
+
+static void* arena_alloc(prts_log_parser_t* parser, size_t size) {
+    size = (size + 7) & ~(size_t)7;
+
+    arena_block_t* block = parser->arena;
+    if (block->size - block->used < size) {
+        size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        block = malloc(sizeof(arena_block_t) + block_size);
+        if (!block) {
+            return NULL;
+        }
+        block->next = parser->arena;
+        block->size = block_size;
+        block->used = 0;
+        parser->arena = block;
+    }
+
+    void* ptr = block->data + block->used;
+    block->used += size;
+    return ptr;
+}
+
+/* Move the blocks of another parser's arena into this one */
+static void arena_adopt(prts_log_parser_t* parser, prts_log_parser_t* other) {
+    arena_block_t* first = other->arena;
+    arena_block_t* last = first;
+    while (last->next) {
+        last = last->next;
+    }
+
+    /* Keep the current block at the head so allocation continues there */
+    last->next = parser->arena->next;
+    parser->arena->next = first;
+    other->arena = NULL;
+}
+
+static prts_result_t template_compile(const char* pattern, parser_template_t** tmpl_out) {
+    size_t pattern_len = strlen(pattern);
+
+    parser_template_t* tmpl = calloc(1, sizeof(parser_template_t));
+    if (!tmpl) {
+        return PRTS_ERROR_NOMEM;
+    }
+
+    /* Every op consumes at least one pattern byte */
+    tmpl->pattern = strdup(pattern);
+    tmpl->strings = malloc(pattern_len + 1);
+    tmpl->ops = calloc(pattern_len + 1, sizeof(template_op_t));
+    tmpl->field_names = calloc(pattern_len + 1, sizeof(char*));
+    if (!tmpl->pattern || !tmpl->strings || !tmpl->ops || !tmpl->field_names) {
+        template_free(tmpl);
+        return PRTS_ERROR_NOMEM;
+    }
+
+    char* out = tmpl->strings;
+    const char* p = pattern;
+    while (*p) {
+        if (p[0] == '%' && p[1] == '{') {
+            const char* name = p + 2;
+            const char* close = strchr(name, '}');
+            if (!close) {
+                template_free(tmpl);
+                return PRTS_ERROR_INVALID;
+            }
+
+            /* Adjacent captures have no delimiter between them */
+            if (tmpl->num_ops > 0 && tmpl->ops[tmpl->num_ops - 1].kind == TEMPLATE_CAPTURE) {
+                template_free(tmpl);
+                return PRTS_ERROR_INVALID;
+            }
+
+            size_t name_len = close - name;
+            template_op_t* op = &tmpl->ops[tmpl->num_ops++];
+            op->kind = TEMPLATE_CAPTURE;
+            if (name_len == 0) {
+                op->target = CAPTURE_SKIP;
+            } else if (name_len == 5 && memcmp(name, "level", 5) == 0) {
+                op->target = CAPTURE_LEVEL;
+            } else if (name_len == 6 && memcmp(name, "source", 6) == 0) {
+                op->target = CAPTURE_SOURCE;
+            } else if (name_len == 7 && memcmp(name, "message", 7) == 0) {
+                op->target = CAPTURE_MESSAGE;
+            } else {
+                op->target = CAPTURE_FIELD;
+                op->field_index = tmpl->num_fields;
+                memcpy(out, name, name_len);
+                out[name_len] = '\0';
+                tmpl->field_names[tmpl->num_fields++] = out;
+                out += name_len + 1;
+            }
+            p = close + 1;
+            continue;
+        }
+
+        /* Literal character; "%%" is an escaped percent sign */
+        char c = *p++;
+        if (c == '%' && *p == '%') {
+            p++;
+        }
+
+        template_op_t* last = tmpl->num_ops > 0 ? &tmpl->ops[tmpl->num_ops - 1] : NULL;
+        if (last && last->kind == TEMPLATE_LITERAL && last->text + last->len == out) {
+            last->len++;
+        } else {
+            template_op_t* op = &tmpl->ops[tmpl->num_ops++];
+            op->kind = TEMPLATE_LITERAL;
+            op->text = out;
+            op->len = 1;
+        }
+        *out++ = c;
+    }
+
+    if (tmpl->num_ops == 0) {
+        template_free(tmpl);
+        return PRTS_ERROR_INVALID;
+    }
+
+    *tmpl_out = tmpl;
+    return PRTS_OK;
+}
+
+/* Run a compiled template over a line in a single forward pass */
+static bool template_match(
+    prts_log_parser_t* parser,
+    const char* line,
+    size_t line_len,
+    prts_log_entry_t* entry_out
+) {
+    const parser_template_t* tmpl = parser->template;
+    const char* p = line;
+    const char* end = line + line_len;
+
+    const char** values = NULL;
+    if (tmpl->num_fields > 0) {
+        values = arena_alloc(parser, tmpl->num_fields * sizeof(char*));
+        if (!values) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < tmpl->num_ops; i++) {
+        const template_op_t* op = &tmpl->ops[i];
+
+        if (op->kind == TEMPLATE_LITERAL) {
+            if ((size_t)(end - p) < op->len || memcmp(p, op->text, op->len) != 0) {
+                return false;
+            }
+            p += op->len;
+            continue;
+        }
+
+        /* A capture ends where the following literal starts */
+        const char* capture_end = end;
+        if (i + 1 < tmpl->num_ops) {
+            const template_op_t* next = &tmpl->ops[i + 1];
+            capture_end = find_str(p, end, next->text, next->len);
+            if (!capture_end) {
+                return false;
+            }
+        }
+
+        size_t len = capture_end - p;
+        switch (op->target) {
+            case CAPTURE_LEVEL:
+                entry_out->level = parse_level(p, len);
+                break;
+            case CAPTURE_SOURCE:
+                entry_out->source = p;
+                entry_out->source_len = len;
+                break;
+            case CAPTURE_MESSAGE:
+                entry_out->message = p;
+                entry_out->message_len = len;
+                break;
+            case CAPTURE_FIELD: {
+                char* value = arena_alloc(parser, len + 1);
+                if (!value) {
+                    return false;
+                }
+                memcpy(value, p, len);
+                value[len] = '\0';
+                values[op->field_index] = value;
+                break;
+            }
+            case CAPTURE_SKIP:
+                break;
+        }
+        p = capture_end;
+    }
+
+    if (p != end) {
+        return false;
+    }
+
+    entry_out->field_names = tmpl->field_names;
+    entry_out->field_values = values;
+    entry_out->num_fields = tmpl->num_fields;
+    return true;
+}
+
+prts_result_t prts_parser_set_template(prts_log_parser_t* parser, const char* pattern) {
+    if (!parser) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    parser_template_t* tmpl = NULL;
+    if (pattern) {
+        prts_result_t result = template_compile(pattern, &tmpl);
+        if (result != PRTS_OK) {
+            return result;
+        }
+    }
+
+    template_free(parser->template);
+    parser->template = tmpl;
+    return PRTS_OK;
 }
 
 static prts_log_format_t detect_format(const char* line, size_t len) {
@@ -75,21 +448,31 @@ static prts_log_format_t detect_format(const char* line, size_t len) {
     return PRTS_LOG_FORMAT_TEXT;
 }
 
-prts_result_t prts_parser_parse(
+/*
+ * Parse one line; extracted fields accumulate in the arena.
+ * In AUTO mode a streaming caller (feed/poll, mappings) detects the format
+ * once per stream and re-validates it periodically; stateless callers
+ * detect it per line, since their lines need not share a source.
+ */
+static prts_result_t parse_line(
     prts_log_parser_t* parser,
     const char* line,
     size_t line_len,
+    bool stream,
     prts_log_entry_t* entry_out
 ) {
-    if (!parser || !line || !entry_out) {
-        return PRTS_ERROR_INVALID;
-    }
-
     memset(entry_out, 0, sizeof(prts_log_entry_t));
 
     prts_log_format_t format = parser->format;
-    if (format == PRTS_LOG_FORMAT_AUTO) {
+    if (format == PRTS_LOG_FORMAT_AUTO && !stream) {
         format = detect_format(line, line_len);
+    } else if (format == PRTS_LOG_FORMAT_AUTO) {
+        if (parser->redetect_countdown == 0) {
+            parser->detected_format = detect_format(line, line_len);
+            parser->redetect_countdown = FORMAT_REDETECT_INTERVAL;
+        }
+        parser->redetect_countdown--;
+        format = parser->detected_format;
     }
 
     entry_out->raw = line;
@@ -97,34 +480,50 @@ prts_result_t prts_parser_parse(
     entry_out->level = PRTS_LOG_INFO;
     entry_out->timestamp = 0;
 
+    if (parser->template) {
+        if (template_match(parser, line, line_len, entry_out)) {
+            return PRTS_OK;
+        }
+
+        /* Fall back to the generic parser for lines that do not match */
+        memset(entry_out, 0, sizeof(prts_log_entry_t));
+        entry_out->raw = line;
+        entry_out->raw_len = line_len;
+        entry_out->level = PRTS_LOG_INFO;
+    }
+
     switch (format) {
         case PRTS_LOG_FORMAT_JSON: {
-            /* Simple JSON parsing */
+            /* Simple JSON parsing, bounded by line_len so lines need not be
+             * NUL-terminated (batch buffers, memory-mapped files) */
+            const char* end = line + line_len;
+
             /* Look for "level" field */
-            const char* level_key = strstr(line, "\"level\"");
+            const char* level_key = find_str(line, end, "\"level\"", 7);
             if (level_key) {
-                const char* colon = strchr(level_key, ':');
+                const char* colon = memchr(level_key, ':', end - level_key);
                 if (colon) {
-                    while (*colon && (*colon == ':' || *colon == ' ' || *colon == '"')) colon++;
-                    const char* end = colon;
-                    while (*end && *end != '"' && *end != ',' && *end != '}') end++;
-                    entry_out->level = parse_level(colon, end - colon);
+                    while (colon < end && (*colon == ':' || *colon == ' ' || *colon == '"')) colon++;
+                    const char* value_end = colon;
+                    while (value_end < end && *value_end != '"' && *value_end != ',' &&
+                           *value_end != '}') value_end++;
+                    entry_out->level = parse_level(colon, value_end - colon);
                 }
             }
 
             /* Look for "message" or "msg" field */
-            const char* msg_key = strstr(line, "\"message\"");
-            if (!msg_key) msg_key = strstr(line, "\"msg\"");
+            const char* msg_key = find_str(line, end, "\"message\"", 9);
+            if (!msg_key) msg_key = find_str(line, end, "\"msg\"", 5);
             if (msg_key) {
-                const char* colon = strchr(msg_key, ':');
+                const char* colon = memchr(msg_key, ':', end - msg_key);
                 if (colon) {
-                    while (*colon && (*colon == ':' || *colon == ' ')) colon++;
-                    if (*colon == '"') {
+                    while (colon < end && (*colon == ':' || *colon == ' ')) colon++;
+                    if (colon < end && *colon == '"') {
                         colon++;
-                        const char* end = colon;
-                        while (*end && *end != '"') end++;
+                        const char* value_end = colon;
+                        while (value_end < end && *value_end != '"') value_end++;
                         entry_out->message = colon;
-                        entry_out->message_len = end - colon;
+                        entry_out->message_len = value_end - colon;
                     }
                 }
             }
@@ -151,10 +550,10 @@ prts_result_t prts_parser_parse(
             }
 
             /* Look for level */
-            if (*p == '[') {
+            if (remaining > 0 && *p == '[') {
                 p++;
                 remaining--;
-                const char* level_end = strchr(p, ']');
+                const char* level_end = memchr(p, ']', remaining);
                 if (level_end) {
                     entry_out->level = parse_level(p, level_end - p);
                     p = level_end + 1;
@@ -162,16 +561,9 @@ prts_result_t prts_parser_parse(
                 }
             } else {
                 /* Check for level without brackets */
-                const char* levels[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
-                for (size_t i = 0; i < 6; i++) {
-                    size_t level_len = strlen(levels[i]);
-                    if (remaining >= level_len && strncasecmp(p, levels[i], level_len) == 0) {
-                        entry_out->level = (prts_log_level_t)i;
-                        p += level_len;
-                        remaining = line_len - (p - line);
-                        break;
-                    }
-                }
+                size_t level_len = classify_level(p, remaining, &entry_out->level);
+                p += level_len;
+                remaining -= level_len;
             }
 
             /* Skip whitespace */
@@ -189,6 +581,20 @@ prts_result_t prts_parser_parse(
     return PRTS_OK;
 }
 
+prts_result_t prts_parser_parse(
+    prts_log_parser_t* parser,
+    const char* line,
+    size_t line_len,
+    prts_log_entry_t* entry_out
+) {
+    if (!parser || !line || !entry_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    arena_reset(parser);
+    return parse_line(parser, line, line_len, false, entry_out);
+}
+
 prts_result_t prts_parser_parse_batch(
     prts_log_parser_t* parser,
     const char* data,
@@ -201,6 +607,8 @@ prts_result_t prts_parser_parse_batch(
         return PRTS_ERROR_INVALID;
     }
 
+    arena_reset(parser);
+
     size_t count = 0;
     const char* line_start = data;
     const char* end = data + data_len;
@@ -214,10 +622,11 @@ prts_result_t prts_parser_parse_batch(
 
         /* Skip empty lines */
         if (line_end > line_start) {
-            prts_result_t result = prts_parser_parse(
+            prts_result_t result = parse_line(
                 parser,
                 line_start,
                 line_end - line_start,
+                false,
                 &entries_out[count]
             );
             if (result == PRTS_OK) {
@@ -231,3 +640,440 @@ prts_result_t prts_parser_parse_batch(
     *count_out = count;
     return PRTS_OK;
 }
+
+/* Per-chunk state for parallel parsing */
+typedef struct {
+    prts_log_parser_t* parser;
+    const char* data;
+    size_t data_len;
+    prts_log_entry_t* entries;
+    size_t count;
+    size_t max_entries;
+    prts_result_t result;
+} parse_chunk_t;
+
+/* Create a parser with the same configuration and fresh state */
+static prts_log_parser_t* parser_clone(const prts_log_parser_t* parser) {
+    prts_parser_config_t config = {
+        .format = parser->format,
+        .timestamp_format = parser->timestamp_format[0] ? parser->timestamp_format : NULL,
+        .parse_json_fields = parser->parse_json_fields,
+    };
+
+    prts_log_parser_t* clone = NULL;
+    if (prts_parser_create(&config, &clone) != PRTS_OK) {
+        return NULL;
+    }
+
+    if (parser->template &&
+        prts_parser_set_template(clone, parser->template->pattern) != PRTS_OK) {
+        prts_parser_destroy(clone);
+        return NULL;
+    }
+    return clone;
+}
+
+static void parse_chunk_task(void* arg) {
+    parse_chunk_t* chunk = (parse_chunk_t*)arg;
+    const char* line_start = chunk->data;
+    const char* end = chunk->data + chunk->data_len;
+
+    if (chunk->max_entries == 0) {
+        chunk->result = PRTS_OK;
+        return;
+    }
+
+    /* Start from a line-length guess and grow as needed */
+    size_t capacity = chunk->data_len / 64 + 16;
+    if (capacity > chunk->max_entries) {
+        capacity = chunk->max_entries;
+    }
+    chunk->entries = malloc(capacity * sizeof(prts_log_entry_t));
+    if (!chunk->entries) {
+        chunk->result = PRTS_ERROR_NOMEM;
+        return;
+    }
+
+    while (line_start < end && chunk->count < chunk->max_entries) {
+        const char* line_end = memchr(line_start, '\n', end - line_start);
+        if (!line_end) {
+            line_end = end;
+        }
+
+        if (line_end > line_start) {
+            if (chunk->count == capacity) {
+                size_t new_capacity = capacity * 2;
+                if (new_capacity > chunk->max_entries) {
+                    new_capacity = chunk->max_entries;
+                }
+                prts_log_entry_t* new_entries = realloc(chunk->entries,
+                    new_capacity * sizeof(prts_log_entry_t));
+                if (!new_entries) {
+                    chunk->result = PRTS_ERROR_NOMEM;
+                    return;
+                }
+                chunk->entries = new_entries;
+                capacity = new_capacity;
+            }
+
+            if (parse_line(chunk->parser, line_start, line_end - line_start, false,
+                           &chunk->entries[chunk->count]) == PRTS_OK) {
+                chunk->count++;
+            }
+        }
+
+        line_start = line_end + 1;
+    }
+
+    chunk->result = PRTS_OK;
+}
+
+static void parse_chunk_range(size_t begin, size_t end, void* arg) {
+    parse_chunk_t* chunks = (parse_chunk_t*)arg;
+    for (size_t i = begin; i < end; i++) {
+        if (chunks[i].parser) {
+            parse_chunk_task(&chunks[i]);
+        }
+    }
+}
+
+prts_result_t prts_parser_parse_parallel(
+    prts_log_parser_t* parser,
+    prts_thread_pool_t* pool,
+    const char* data,
+    size_t data_len,
+    prts_log_entry_t* entries_out,
+    size_t max_entries,
+    size_t* count_out
+) {
+    if (!parser || !pool || !data || !entries_out || !count_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    size_t num_chunks = prts_threadpool_num_threads(pool) * PARALLEL_CHUNKS_PER_THREAD;
+    if (num_chunks > data_len / PARALLEL_MIN_CHUNK) {
+        num_chunks = data_len / PARALLEL_MIN_CHUNK;
+    }
+    if (num_chunks < 2 || max_entries == 0) {
+        return prts_parser_parse_batch(parser, data, data_len,
+                                       entries_out, max_entries, count_out);
+    }
+
+    parse_chunk_t* chunks = calloc(num_chunks, sizeof(parse_chunk_t));
+    if (!chunks) {
+        return PRTS_ERROR_NOMEM;
+    }
+
+    /* Split at newline boundaries near equal offsets */
+    const char* end = data + data_len;
+    const char* chunk_start = data;
+    size_t used_chunks = 0;
+    for (size_t i = 0; i < num_chunks && chunk_start < end; i++) {
+        const char* chunk_end = end;
+        if (i + 1 < num_chunks) {
+            const char* target = data + (data_len / num_chunks) * (i + 1);
+            if (target < chunk_start) {
+                target = chunk_start;
+            }
+            const char* nl = memchr(target, '\n', end - target);
+            chunk_end = nl ? nl + 1 : end;
+        }
+
+        parse_chunk_t* chunk = &chunks[used_chunks++];
+        chunk->data = chunk_start;
+        chunk->data_len = chunk_end - chunk_start;
+        chunk->max_entries = max_entries;
+        chunk->result = PRTS_ERROR;
+        chunk->parser = parser_clone(parser);
+        chunk_start = chunk_end;
+    }
+
+    for (size_t i = 0; i < used_chunks; i++) {
+        if (!chunks[i].parser) {
+            chunks[i].result = PRTS_ERROR_NOMEM;
+        }
+    }
+
+    arena_reset(parser);
+
+    /* One chunk at a time; the calling thread parses alongside the workers */
+    prts_threadpool_parallel_for(pool, 0, used_chunks, 1, parse_chunk_range, chunks);
+
+    prts_result_t result = PRTS_OK;
+    size_t count = 0;
+    for (size_t i = 0; i < used_chunks; i++) {
+        /* Stitch per-chunk outputs together in input order */
+        parse_chunk_t* chunk = &chunks[i];
+        if (chunk->result != PRTS_OK) {
+            result = chunk->result;
+        } else if (result == PRTS_OK && count < max_entries) {
+            size_t n = chunk->count;
+            if (n > max_entries - count) {
+                n = max_entries - count;
+            }
+            memcpy(&entries_out[count], chunk->entries, n * sizeof(prts_log_entry_t));
+
+            /* Template field names belong to the chunk parser; its template dies below */
+            if (parser->template) {
+                const char** chunk_names = chunk->parser->template->field_names;
+                for (size_t j = count; j < count + n; j++) {
+                    if (entries_out[j].field_names == chunk_names) {
+                        entries_out[j].field_names = parser->template->field_names;
+                    }
+                }
+            }
+            count += n;
+        }
+
+        /* Extracted fields live in the chunk parser's arena */
+        free(chunk->entries);
+        if (chunk->parser) {
+            arena_adopt(parser, chunk->parser);
+            prts_parser_destroy(chunk->parser);
+        }
+    }
+
+    free(chunks);
+
+    *count_out = result == PRTS_OK ? count : 0;
+    return result;
+}
+
+/* Ensure a streaming buffer can hold need bytes plus a terminator */
+static prts_result_t buffer_reserve(char** buf, size_t* cap, size_t need) {
+    if (need + 1 <= *cap) {
+        return PRTS_OK;
+    }
+
+    size_t new_cap = *cap > 0 ? *cap : 256;
+    while (new_cap < need + 1) {
+        new_cap *= 2;
+    }
+
+    char* new_buf = realloc(*buf, new_cap);
+    if (!new_buf) {
+        return PRTS_ERROR_NOMEM;
+    }
+
+    *buf = new_buf;
+    *cap = new_cap;
+    return PRTS_OK;
+}
+
+static bool stream_has_pending(const prts_log_parser_t* parser) {
+    return parser->joined_pending || parser->cursor < parser->cursor_end;
+}
+
+prts_result_t prts_parser_feed(
+    prts_log_parser_t* parser,
+    const char* data,
+    size_t data_len
+) {
+    if (!parser || (!data && data_len > 0)) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    if (stream_has_pending(parser)) {
+        return PRTS_ERROR_FULL;
+    }
+
+    arena_reset(parser);
+    parser->cursor = NULL;
+    parser->cursor_end = NULL;
+
+    if (data_len == 0) {
+        return PRTS_OK;
+    }
+
+    const char* end = data + data_len;
+    const char* first_nl = memchr(data, '\n', data_len);
+
+    /* No line boundary: the whole chunk extends the carried fragment */
+    if (!first_nl) {
+        if (buffer_reserve(&parser->carry, &parser->carry_cap,
+                           parser->carry_len + data_len) != PRTS_OK) {
+            return PRTS_ERROR_NOMEM;
+        }
+        memcpy(parser->carry + parser->carry_len, data, data_len);
+        parser->carry_len += data_len;
+        parser->carry[parser->carry_len] = '\0';
+        return PRTS_OK;
+    }
+
+    /* Find the last line boundary; everything after it is the new fragment */
+    const char* last_nl = end - 1;
+    while (*last_nl != '\n') {
+        last_nl--;
+    }
+    size_t tail_len = end - (last_nl + 1);
+
+    /*
+     * Reserve both buffers before touching stream state, so a failed
+     * feed keeps the carried fragment and can be retried.
+     */
+    size_t head_len = first_nl - data;
+    size_t joined_len = parser->carry_len + head_len;
+    if (parser->carry_len > 0 &&
+        buffer_reserve(&parser->joined, &parser->joined_cap, joined_len) != PRTS_OK) {
+        return PRTS_ERROR_NOMEM;
+    }
+    if (tail_len > 0 &&
+        buffer_reserve(&parser->carry, &parser->carry_cap, tail_len) != PRTS_OK) {
+        return PRTS_ERROR_NOMEM;
+    }
+
+    /* Complete the carried fragment with the head of this chunk */
+    const char* start = data;
+    if (parser->carry_len > 0) {
+        memcpy(parser->joined, parser->carry, parser->carry_len);
+        memcpy(parser->joined + parser->carry_len, data, head_len);
+        parser->joined[joined_len] = '\0';
+        parser->joined_len = joined_len;
+        parser->joined_pending = true;
+        parser->carry_len = 0;
+        start = first_nl + 1;
+    }
+
+    if (tail_len > 0) {
+        memcpy(parser->carry, last_nl + 1, tail_len);
+        parser->carry[tail_len] = '\0';
+        parser->carry_len = tail_len;
+    }
+
+    parser->cursor = start;
+    parser->cursor_end = last_nl + 1;
+    return PRTS_OK;
+}
+
+prts_result_t prts_parser_poll(
+    prts_log_parser_t* parser,
+    prts_log_entry_t* entries_out,
+    size_t max_entries,
+    size_t* count_out
+) {
+    if (!parser || !entries_out || !count_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    size_t count = 0;
+
+    if (parser->joined_pending && count < max_entries) {
+        parser->joined_pending = false;
+        if (parser->joined_len > 0 &&
+            parse_line(parser, parser->joined, parser->joined_len, true,
+                       &entries_out[count]) == PRTS_OK) {
+            count++;
+        }
+    }
+
+    while (parser->cursor < parser->cursor_end && count < max_entries) {
+        const char* line_start = parser->cursor;
+        const char* line_end = memchr(line_start, '\n', parser->cursor_end - line_start);
+        parser->cursor = line_end + 1;
+
+        /* Skip empty lines */
+        if (line_end > line_start &&
+            parse_line(parser, line_start, line_end - line_start, true,
+                       &entries_out[count]) == PRTS_OK) {
+            count++;
+        }
+    }
+
+    *count_out = count;
+    return PRTS_OK;
+}
+
+prts_result_t prts_parser_finish(prts_log_parser_t* parser) {
+    if (!parser) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    if (stream_has_pending(parser)) {
+        return PRTS_ERROR_FULL;
+    }
+
+    if (parser->carry_len > 0) {
+        /* Swap buffers so the fragment becomes the pending joined line */
+        char* buf = parser->joined;
+        size_t cap = parser->joined_cap;
+        parser->joined = parser->carry;
+        parser->joined_cap = parser->carry_cap;
+        parser->joined_len = parser->carry_len;
+        parser->joined_pending = true;
+        parser->carry = buf;
+        parser->carry_cap = cap;
+        parser->carry_len = 0;
+    }
+
+    return PRTS_OK;
+}
+
+void prts_parser_reset(prts_log_parser_t* parser) {
+    if (!parser) return;
+
+    parser->redetect_countdown = 0;
+    parser->carry_len = 0;
+    parser->joined_len = 0;
+    parser->joined_pending = false;
+    parser->cursor = NULL;
+    parser->cursor_end = NULL;
+}
+
+prts_result_t prts_parser_parse_mapping(
+    prts_log_parser_t* parser,
+    prts_log_mapping_t* mapping,
+    prts_log_entry_t* entries_out,
+    size_t max_entries,
+    size_t* count_out
+) {
+    if (!parser || !mapping || !entries_out || !count_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    arena_reset(parser);
+
+    size_t count = 0;
+    size_t file_index = 0;
+    size_t offset = 0;
+    size_t num_files = prts_log_mapping_count(mapping);
+    prts_log_mapping_tell(mapping, &file_index, &offset);
+
+    while (file_index < num_files && count < max_entries) {
+        const char* data = NULL;
+        size_t data_len = 0;
+        prts_log_mapping_data(mapping, file_index, &data, &data_len);
+
+        if (offset >= data_len) {
+            /* Lines never span files; each file is a new source */
+            file_index++;
+            offset = 0;
+            parser->redetect_countdown = 0;
+            continue;
+        }
+
+        /* The last line of a file may lack a trailing newline */
+        const char* line_start = data + offset;
+        const char* end = data + data_len;
+        const char* line_end = memchr(line_start, '\n', end - line_start);
+        if (!line_end) {
+            line_end = end;
+        }
+
+        /* Skip empty lines */
+        if (line_end > line_start &&
+            parse_line(parser, line_start, line_end - line_start, true,
+                       &entries_out[count]) == PRTS_OK) {
+            count++;
+        }
+
+        offset = (line_end - data) + 1;
+        if (offset > data_len) {
+            offset = data_len;
+        }
+    }
+
+    prts_log_mapping_seek(mapping, file_index, offset);
+
+    *count_out = count;
+    return PRTS_OK;
+}
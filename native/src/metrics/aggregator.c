@@ -5,6 +5,613 @@
 
 #include "prts/metrics.h"
 #include <stdlib.h>
+#include <string.h>
 
-/* Placeholder implementation */
-/* TODO: Implement time-window aggregation */
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define DEFAULT_INTERVAL (10ULL * 1000000000ULL)
+#define DEFAULT_RETENTION PRTS_WINDOW_1H
+
+/* Initial series table size (power of two) */
+#define INITIAL_TABLE_CAPACITY 64
+
+/* One snapshot of a series */
+typedef struct {
+    prts_timestamp_t timestamp;
+    double value;                   /* Counter, gauge, or observation count */
+    double sum;                     /* Histograms and sketches: observation sum */
+} agg_sample_t;
+
+/* Snapshot ring of one series, oldest at head - len */
+typedef struct {
+    uint64_t key;
+    prts_metric_type_t type;
+    agg_sample_t* samples;
+    uint64_t* buckets;              /* Histograms: num_buckets counts per slot */
+    double* boundaries;
+    size_t num_buckets;
+    prts_sketch_t** deltas;         /* Sketches: observations since the previous slot */
+    prts_sketch_t* last;            /* Sketches: state at the newest snapshot */
+    size_t head;
+    size_t len;
+} agg_series_t;
+
+struct prts_metrics_aggregator {
+    prts_metrics_collector_t* collector;
+    prts_timestamp_t interval;
+    prts_timestamp_t retention;
+    size_t ring_capacity;           /* Snapshots kept per series */
+
+    /* Open-addressed series table keyed by series key */
+    agg_series_t** table;
+    size_t table_capacity;
+    size_t num_series;
+
+#ifdef _WIN32
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+};
+
+static void aggregator_lock(prts_metrics_aggregator_t* agg) {
+#ifdef _WIN32
+    EnterCriticalSection(&agg->lock);
+#else
+    pthread_mutex_lock(&agg->lock);
+#endif
+}
+
+static void aggregator_unlock(prts_metrics_aggregator_t* agg) {
+#ifdef _WIN32
+    LeaveCriticalSection(&agg->lock);
+#else
+    pthread_mutex_unlock(&agg->lock);
+#endif
+}
+
+static void agg_series_free(const prts_metrics_aggregator_t* agg, agg_series_t* s) {
+    if (!s) return;
+    free(s->samples);
+    free(s->buckets);
+    free(s->boundaries);
+    if (s->deltas) {
+        for (size_t i = 0; i < agg->ring_capacity; i++) {
+            prts_sketch_destroy(s->deltas[i]);
+        }
+        free(s->deltas);
+    }
+    prts_sketch_destroy(s->last);
+    free(s);
+}
+
+static agg_series_t* agg_series_create(
+    const prts_metrics_aggregator_t* agg,
+    const prts_metric_sample_t* sample
+) {
+    agg_series_t* s = calloc(1, sizeof(agg_series_t));
+    if (!s) {
+        return NULL;
+    }
+    s->key = sample->series_key;
+    s->type = sample->type;
+
+    s->samples = calloc(agg->ring_capacity, sizeof(agg_sample_t));
+    if (!s->samples) {
+        free(s);
+        return NULL;
+    }
+
+    if (sample->type == PRTS_METRIC_HISTOGRAM) {
+        s->num_buckets = sample->value.value.histogram.num_buckets;
+        s->buckets = calloc(agg->ring_capacity * s->num_buckets, sizeof(uint64_t));
+        s->boundaries = malloc(s->num_buckets * sizeof(double));
+        if (!s->buckets || !s->boundaries) {
+            agg_series_free(agg, s);
+            return NULL;
+        }
+        if (s->num_buckets > 1) {
+            memcpy(s->boundaries, sample->boundaries, (s->num_buckets - 1) * sizeof(double));
+        }
+    } else if (sample->type == PRTS_METRIC_SKETCH) {
+        s->deltas = calloc(agg->ring_capacity, sizeof(prts_sketch_t*));
+        if (!s->deltas) {
+            agg_series_free(agg, s);
+            return NULL;
+        }
+    }
+
+    return s;
+}
+
+static size_t ring_slot(const prts_metrics_aggregator_t* agg, const agg_series_t* s, size_t i) {
+    return (s->head + agg->ring_capacity - s->len + i) % agg->ring_capacity;
+}
+
+/* The i-th snapshot, oldest first */
+static const agg_sample_t* ring_sample(
+    const prts_metrics_aggregator_t* agg,
+    const agg_series_t* s,
+    size_t i
+) {
+    return &s->samples[ring_slot(agg, s, i)];
+}
+
+static const uint64_t* ring_buckets(
+    const prts_metrics_aggregator_t* agg,
+    const agg_series_t* s,
+    size_t i
+) {
+    return s->buckets + ring_slot(agg, s, i) * s->num_buckets;
+}
+
+static agg_series_t** find_slot(const prts_metrics_aggregator_t* agg, uint64_t key) {
+    size_t mask = agg->table_capacity - 1;
+    size_t slot = key & mask;
+    while (agg->table[slot] && agg->table[slot]->key != key) {
+        slot = (slot + 1) & mask;
+    }
+    return &agg->table[slot];
+}
+
+/* Rehash the live series into a table of the given capacity */
+static prts_result_t rebuild_table(prts_metrics_aggregator_t* agg, size_t capacity) {
+    agg_series_t** old_table = agg->table;
+    size_t old_capacity = agg->table_capacity;
+
+    agg->table = calloc(capacity, sizeof(agg_series_t*));
+    if (!agg->table) {
+        agg->table = old_table;
+        return PRTS_ERROR_NOMEM;
+    }
+    agg->table_capacity = capacity;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_table[i]) {
+            *find_slot(agg, old_table[i]->key) = old_table[i];
+        }
+    }
+    free(old_table);
+
+    return PRTS_OK;
+}
+
+prts_result_t prts_metrics_aggregator_create(
+    prts_metrics_collector_t* collector,
+    const prts_aggregator_config_t* config,
+    prts_metrics_aggregator_t** aggregator_out
+) {
+    if (!collector || !aggregator_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    prts_metrics_aggregator_t* agg = calloc(1, sizeof(prts_metrics_aggregator_t));
+    if (!agg) {
+        return PRTS_ERROR_NOMEM;
+    }
+
+    agg->collector = collector;
+    agg->interval = config && config->interval > 0 ? config->interval : DEFAULT_INTERVAL;
+    agg->retention = config && config->retention > 0 ? config->retention : DEFAULT_RETENTION;
+    if (agg->retention < agg->interval) {
+        free(agg);
+        return PRTS_ERROR_INVALID;
+    }
+
+    /* One snapshot per interval, plus the baseline just before the window */
+    agg->ring_capacity = (size_t)(agg->retention / agg->interval) + 2;
+
+    agg->table_capacity = INITIAL_TABLE_CAPACITY;
+    agg->table = calloc(agg->table_capacity, sizeof(agg_series_t*));
+    if (!agg->table) {
+        free(agg);
+        return PRTS_ERROR_NOMEM;
+    }
+
+#ifdef _WIN32
+    InitializeCriticalSection(&agg->lock);
+#else
+    pthread_mutex_init(&agg->lock, NULL);
+#endif
+
+    *aggregator_out = agg;
+    return PRTS_OK;
+}
+
+void prts_metrics_aggregator_destroy(prts_metrics_aggregator_t* aggregator) {
+    if (!aggregator) return;
+
+    for (size_t i = 0; i < aggregator->table_capacity; i++) {
+        agg_series_free(aggregator, aggregator->table[i]);
+    }
+    free(aggregator->table);
+
+#ifdef _WIN32
+    DeleteCriticalSection(&aggregator->lock);
+#else
+    pthread_mutex_destroy(&aggregator->lock);
+#endif
+
+    free(aggregator);
+}
+
+typedef struct {
+    prts_metrics_aggregator_t* agg;
+    prts_timestamp_t now;
+    prts_result_t result;
+} tick_context_t;
+
+/*
+ * Keep the observations a sketch received since the previous snapshot in
+ * the head slot, so windows of any length merge their own intervals.
+ */
+static prts_result_t record_sketch(agg_series_t* s, const prts_sketch_t* sketch) {
+    double accuracy = prts_sketch_relative_accuracy(sketch);
+    prts_sketch_t** delta = &s->deltas[s->head];
+
+    prts_sketch_t* next;
+    if (prts_sketch_create(accuracy, 0, &next) != PRTS_OK) {
+        return PRTS_ERROR_NOMEM;
+    }
+    if (!*delta && prts_sketch_create(accuracy, 0, delta) != PRTS_OK) {
+        prts_sketch_destroy(next);
+        return PRTS_ERROR_NOMEM;
+    }
+
+    prts_sketch_clear(*delta);
+    if (prts_sketch_merge(next, sketch) != PRTS_OK ||
+        prts_sketch_merge(*delta, sketch) != PRTS_OK) {
+        prts_sketch_destroy(next);
+        return PRTS_ERROR_NOMEM;
+    }
+
+    /* A sketch that is not a later state of the last one was reset */
+    if (s->last) {
+        prts_sketch_subtract(*delta, s->last);
+    }
+    prts_sketch_destroy(s->last);
+    s->last = next;
+
+    return PRTS_OK;
+}
+
+static void record_sample(const prts_metric_sample_t* sample, void* ctx) {
+    tick_context_t* tick = ctx;
+    prts_metrics_aggregator_t* agg = tick->agg;
+
+    /* Keep the load factor below 3/4 */
+    if ((agg->num_series + 1) * 4 > agg->table_capacity * 3 &&
+        rebuild_table(agg, agg->table_capacity * 2) != PRTS_OK) {
+        tick->result = PRTS_ERROR_NOMEM;
+        return;
+    }
+
+    agg_series_t** slot = find_slot(agg, sample->series_key);
+    if (!*slot) {
+        *slot = agg_series_create(agg, sample);
+        if (!*slot) {
+            tick->result = PRTS_ERROR_NOMEM;
+            return;
+        }
+        agg->num_series++;
+    }
+    agg_series_t* s = *slot;
+
+    if (sample->type == PRTS_METRIC_SKETCH && record_sketch(s, sample->sketch) != PRTS_OK) {
+        tick->result = PRTS_ERROR_NOMEM;
+        return;
+    }
+
+    agg_sample_t* out = &s->samples[s->head];
+    out->timestamp = tick->now ? tick->now : sample->value.timestamp;
+    out->sum = 0;
+    switch (sample->type) {
+        case PRTS_METRIC_COUNTER:
+            out->value = (double)sample->value.value.counter;
+            break;
+        case PRTS_METRIC_GAUGE:
+            out->value = sample->value.value.gauge;
+            break;
+        case PRTS_METRIC_HISTOGRAM:
+            out->value = (double)sample->value.value.histogram.count;
+            out->sum = sample->value.value.histogram.sum;
+            memcpy(s->buckets + s->head * s->num_buckets,
+                   sample->value.value.histogram.bucket_counts,
+                   s->num_buckets * sizeof(uint64_t));
+            break;
+        case PRTS_METRIC_SKETCH:
+            out->value = (double)sample->value.value.sketch.count;
+            out->sum = sample->value.value.sketch.sum;
+            break;
+    }
+
+    s->head = (s->head + 1) % agg->ring_capacity;
+    if (s->len < agg->ring_capacity) {
+        s->len++;
+    }
+}
+
+prts_result_t prts_metrics_aggregator_tick(
+    prts_metrics_aggregator_t* aggregator,
+    prts_timestamp_t now
+) {
+    if (!aggregator) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    aggregator_lock(aggregator);
+
+    tick_context_t tick = { aggregator, now, PRTS_OK };
+    prts_result_t result = prts_metrics_visit(aggregator->collector, record_sample, &tick);
+    if (result == PRTS_OK) {
+        result = tick.result;
+    }
+
+    /* Drop series that stopped reporting a whole retention period ago */
+    if (result == PRTS_OK) {
+        prts_timestamp_t latest = now ? now : prts_timestamp_now();
+        size_t dropped = 0;
+        for (size_t i = 0; i < aggregator->table_capacity; i++) {
+            agg_series_t* s = aggregator->table[i];
+            if (s && ring_sample(aggregator, s, s->len - 1)->timestamp + aggregator->retention <
+                     latest) {
+                agg_series_free(aggregator, s);
+                aggregator->table[i] = NULL;
+                dropped++;
+            }
+        }
+        if (dropped > 0) {
+            aggregator->num_series -= dropped;
+            result = rebuild_table(aggregator, aggregator->table_capacity);
+        }
+    }
+
+    aggregator_unlock(aggregator);
+
+    return result;
+}
+
+/*
+ * Locate a window ending at the newest snapshot. first is the oldest
+ * snapshot inside the window; base is the snapshot rates and quantiles
+ * are measured from, which is the one just before the window when it is
+ * within an interval of the window start.
+ */
+static void window_bounds(
+    const prts_metrics_aggregator_t* agg,
+    const agg_series_t* s,
+    prts_timestamp_t window,
+    size_t* first_out,
+    size_t* base_out
+) {
+    prts_timestamp_t newest = ring_sample(agg, s, s->len - 1)->timestamp;
+    prts_timestamp_t start = newest > window ? newest - window : 0;
+
+    size_t first = s->len - 1;
+    while (first > 0 && ring_sample(agg, s, first - 1)->timestamp > start) {
+        first--;
+    }
+
+    size_t base = first;
+    if (first > 0 && ring_sample(agg, s, first - 1)->timestamp + agg->interval >= start) {
+        base = first - 1;
+    }
+
+    *first_out = first;
+    *base_out = base;
+}
+
+/* Increase between two snapshots; a decrease restarts from zero */
+static double increase(double from, double to, bool resets) {
+    if (resets && to < from) {
+        return to;
+    }
+    return to - from;
+}
+
+static double per_second(double delta, prts_timestamp_t from, prts_timestamp_t to) {
+    if (to <= from) {
+        return 0.0;
+    }
+    return delta * 1e9 / (double)(to - from);
+}
+
+static agg_series_t* lookup(
+    prts_metrics_aggregator_t* agg,
+    const char* name,
+    const char** label_values,
+    prts_result_t* result_out
+) {
+    uint64_t key;
+    *result_out = prts_metrics_series_key(agg->collector, name, label_values, &key);
+    if (*result_out != PRTS_OK) {
+        return NULL;
+    }
+
+    agg_series_t* s = *find_slot(agg, key);
+    if (!s || s->len == 0) {
+        *result_out = PRTS_ERROR_EMPTY;
+        return NULL;
+    }
+    return s;
+}
+
+prts_result_t prts_metrics_aggregator_query(
+    prts_metrics_aggregator_t* aggregator,
+    const char* name,
+    const char** label_values,
+    prts_timestamp_t window,
+    prts_window_stats_t* stats_out
+) {
+    if (!aggregator || !name || !stats_out || window == 0 || window > aggregator->retention) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    aggregator_lock(aggregator);
+
+    prts_result_t result;
+    agg_series_t* s = lookup(aggregator, name, label_values, &result);
+    if (!s) {
+        aggregator_unlock(aggregator);
+        return result;
+    }
+
+    size_t first, base;
+    window_bounds(aggregator, s, window, &first, &base);
+
+    bool resets = s->type != PRTS_METRIC_GAUGE;
+    const agg_sample_t* newest = ring_sample(aggregator, s, s->len - 1);
+
+    memset(stats_out, 0, sizeof(prts_window_stats_t));
+    stats_out->min = newest->value;
+    stats_out->max = newest->value;
+    stats_out->last = newest->value;
+    stats_out->samples = s->len - first;
+
+    double total = 0.0;
+    double delta = 0.0;
+    double delta_sum = 0.0;
+    for (size_t i = base; i < s->len; i++) {
+        const agg_sample_t* cur = ring_sample(aggregator, s, i);
+        if (i > base) {
+            const agg_sample_t* prev = ring_sample(aggregator, s, i - 1);
+            delta += increase(prev->value, cur->value, resets);
+            delta_sum += cur->value < prev->value ? cur->sum : cur->sum - prev->sum;
+        }
+        if (i >= first) {
+            if (cur->value < stats_out->min) stats_out->min = cur->value;
+            if (cur->value > stats_out->max) stats_out->max = cur->value;
+            total += cur->value;
+        }
+    }
+
+    const agg_sample_t* oldest = ring_sample(aggregator, s, base);
+    stats_out->rate = per_second(delta, oldest->timestamp, newest->timestamp);
+
+    if (s->len >= 2) {
+        const agg_sample_t* prev = ring_sample(aggregator, s, s->len - 2);
+        stats_out->irate = per_second(increase(prev->value, newest->value, resets),
+                                      prev->timestamp, newest->timestamp);
+    }
+
+    if (s->type == PRTS_METRIC_HISTOGRAM || s->type == PRTS_METRIC_SKETCH) {
+        stats_out->avg = delta > 0 ? delta_sum / delta : 0.0;
+    } else {
+        stats_out->avg = total / (double)stats_out->samples;
+    }
+
+    aggregator_unlock(aggregator);
+
+    return PRTS_OK;
+}
+
+/* Merge the intervals after base and estimate q over them */
+static prts_result_t sketch_quantile(
+    const prts_metrics_aggregator_t* agg,
+    const agg_series_t* s,
+    size_t base,
+    double q,
+    double* value_out
+) {
+    if (base == s->len - 1) {
+        return PRTS_ERROR_EMPTY;
+    }
+
+    prts_sketch_t* window;
+    if (prts_sketch_create(prts_sketch_relative_accuracy(s->last), 0, &window) != PRTS_OK) {
+        return PRTS_ERROR_NOMEM;
+    }
+
+    prts_result_t result = PRTS_OK;
+    for (size_t i = base + 1; i < s->len && result == PRTS_OK; i++) {
+        result = prts_sketch_merge(window, s->deltas[ring_slot(agg, s, i)]);
+    }
+    if (result == PRTS_OK) {
+        result = prts_sketch_quantile(window, q, value_out);
+    }
+
+    prts_sketch_destroy(window);
+    return result;
+}
+
+prts_result_t prts_metrics_aggregator_quantile(
+    prts_metrics_aggregator_t* aggregator,
+    const char* name,
+    const char** label_values,
+    prts_timestamp_t window,
+    double q,
+    double* value_out
+) {
+    if (!aggregator || !name || !value_out || window == 0 || window > aggregator->retention ||
+        !(q >= 0 && q <= 1)) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    aggregator_lock(aggregator);
+
+    prts_result_t result;
+    agg_series_t* s = lookup(aggregator, name, label_values, &result);
+    if (!s || (s->type != PRTS_METRIC_HISTOGRAM && s->type != PRTS_METRIC_SKETCH)) {
+        aggregator_unlock(aggregator);
+        return s ? PRTS_ERROR_INVALID : result;
+    }
+
+    size_t first, base;
+    window_bounds(aggregator, s, window, &first, &base);
+
+    if (s->type == PRTS_METRIC_SKETCH) {
+        result = sketch_quantile(aggregator, s, base, q, value_out);
+        aggregator_unlock(aggregator);
+        return result;
+    }
+
+    const uint64_t* from = ring_buckets(aggregator, s, base);
+    const uint64_t* to = ring_buckets(aggregator, s, s->len - 1);
+
+    /* A reset anywhere means the newest snapshot is the whole window */
+    bool reset = false;
+    uint64_t total = 0;
+    for (size_t b = 0; b < s->num_buckets; b++) {
+        if (to[b] < from[b]) {
+            reset = true;
+        }
+    }
+    for (size_t b = 0; b < s->num_buckets; b++) {
+        total += reset ? to[b] : to[b] - from[b];
+    }
+    if (base == s->len - 1 || total == 0) {
+        aggregator_unlock(aggregator);
+        return PRTS_ERROR_EMPTY;
+    }
+
+    /* Interpolate within the bucket holding the target rank */
+    double rank = q * (double)total;
+    uint64_t cumulative = 0;
+    size_t inf_bucket = s->num_buckets - 1;
+    for (size_t b = 0; b < s->num_buckets; b++) {
+        uint64_t count = reset ? to[b] : to[b] - from[b];
+        if ((double)(cumulative + count) >= rank && count > 0) {
+            if (b == inf_bucket) {
+                /* +Inf bucket: the highest finite bound is the best estimate */
+                *value_out = b > 0 ? s->boundaries[b - 1] : 0.0;
+            } else {
+                double lower = b > 0 ? s->boundaries[b - 1] : 0.0;
+                double upper = s->boundaries[b];
+                if (b == 0 && upper <= 0) {
+                    lower = upper;
+                }
+                *value_out = lower + (upper - lower) * (rank - (double)cumulative) / (double)count;
+            }
+            break;
+        }
+        cumulative += count;
+    }
+
+    aggregator_unlock(aggregator);
+
+    return PRTS_OK;
+}
@@ -6,6 +6,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdatomic.h>
+#include <math.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -14,346 +16,1947 @@
 #include <time.h>
 #endif
 
-/* Maximum metrics */
-#define MAX_METRICS 256
-#define MAX_LABEL_VALUES 16
 #define MAX_NAME_LEN 128
 
-/* Metric entry */
+/* Initial metric array size (power of two); the name index is twice this */
+#define INITIAL_METRICS_CAPACITY 16
+
+/* Initial series table size per metric (power of two) */
+#define INITIAL_SERIES_CAPACITY 16
+
+/* Counter and histogram updates are spread over per-thread shards */
+#define CACHE_LINE_SIZE 64
+#define METRIC_SHARDS 16    /* Power of two */
+
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+/* One cache line of series state, updated with relaxed atomics */
 typedef struct {
+    _Atomic uint64_t count;         /* Counter value or histogram count */
+    _Atomic uint64_t sum_bits;      /* Histogram sum, as double bits */
+    char padding[CACHE_LINE_SIZE - 2 * sizeof(uint64_t)];
+} metric_shard_t;
+
+/* Series: one label-value combination of a metric */
+typedef struct prts_metric_series {
+    struct prts_metric* metric;
+    uint64_t hash;
+    uint64_t key;                   /* Stable identity: name and label values */
+    char** label_values;
+    char* labels_text;              /* Rendered {label="value",...} for export */
+    size_t labels_len;
+
+    _Atomic uint64_t gauge_bits;    /* Gauge value, as double bits */
+    metric_shard_t* shards;         /* Cache-line aligned, counters/histograms only */
+    _Atomic uint64_t* buckets;      /* Histograms: per-shard bucket counts, bucket_stride apart */
+    void* shards_alloc;
+
+    prts_sketch_t* sketch;          /* Sketches only, guarded by sketch_lock */
+    atomic_flag sketch_lock;
+
+    _Atomic uint32_t epoch;         /* Eviction epoch of the last update */
+    _Atomic uint32_t pins;          /* Bound handles; pinned series are never evicted */
+} metric_series_t;
+
+/* Metric entry */
+typedef struct prts_metric {
+    prts_metrics_collector_t* collector;
+    uint64_t name_hash;
     char name[MAX_NAME_LEN];
     char description[256];
     prts_metric_type_t type;
     char** labels;
     size_t num_labels;
 
-    /* Values for different label combinations */
-    struct {
-        char** label_values;
-        union {
-            uint64_t counter;
-            double gauge;
-            struct {
-                uint64_t count;
-                double sum;
-                uint64_t* bucket_counts;
-                double* boundaries;
-                size_t num_buckets;
-            } histogram;
-        } value;
-    } entries[MAX_LABEL_VALUES];
-    size_t num_entries;
+    /* Sketch relative accuracy, 0 for the default */
+    double sketch_accuracy;
+
+    /* Histogram upper bounds; bucket num_boundaries is the +Inf bucket */
+    double* boundaries;
+    size_t num_boundaries;
+    size_t bucket_stride;           /* Buckets per shard, padded to cache lines */
+
+    /* Open-addressed series table keyed by label-value hash */
+    metric_series_t** series;
+    size_t series_capacity;
+    size_t num_series;
+
+    uint64_t series_dropped;        /* Series refused by a cardinality limit */
+    uint64_t series_evicted;        /* Series removed as stale */
 } metric_entry_t;
 
 /* Metrics collector structure */
 struct prts_metrics_collector {
-    metric_entry_t metrics[MAX_METRICS];
+    /* Registered metrics in registration order; entries never move */
+    metric_entry_t** metrics;
     size_t num_metrics;
+    size_t metrics_capacity;
 
+    /* Open-addressed name -> metric index, at most half full */
+    metric_entry_t** name_index;
+    size_t name_index_size;
+
+    /*
+     * Guards the metric and series tables. Values are updated with atomics
+     * under the shared lock, so eviction (exclusive) never frees a series
+     * mid-update; pinned series are updated without the lock.
+     */
 #ifdef _WIN32
-    CRITICAL_SECTION lock;
+    SRWLOCK lock;
 #else
-    pthread_mutex_t lock;
+    pthread_rwlock_t lock;
 #endif
-};
 
-prts_result_t prts_metrics_create(prts_metrics_collector_t** collector_out) {
-    if (!collector_out) {
-        return PRTS_ERROR_INVALID;
-    }
+    /* Cardinality limits and accounting, guarded by lock */
+    prts_metrics_limits_t limits;
+    size_t num_series;
+    uint64_t series_dropped;
+    uint64_t series_evicted;
+    _Atomic uint32_t epoch;         /* Advanced by prts_metrics_evict_stale */
 
-    prts_metrics_collector_t* collector = calloc(1, sizeof(prts_metrics_collector_t));
-    if (!collector) {
-        return PRTS_ERROR_NOMEM;
-    }
+    /* Scratch space reused by exports, guarded by export_lock */
+    struct export_state* export_state;
+#ifdef _WIN32
+    CRITICAL_SECTION export_lock;
+#else
+    pthread_mutex_t export_lock;
+#endif
+};
 
+static atomic_uint next_shard;
+static THREAD_LOCAL unsigned thread_shard = UINT32_MAX;
+
+static void collector_lock(prts_metrics_collector_t* collector) {
 #ifdef _WIN32
-    InitializeCriticalSection(&collector->lock);
+    AcquireSRWLockExclusive(&collector->lock);
 #else
-    pthread_mutex_init(&collector->lock, NULL);
+    pthread_rwlock_wrlock(&collector->lock);
 #endif
+}
 
-    *collector_out = collector;
-    return PRTS_OK;
+static void collector_unlock(prts_metrics_collector_t* collector) {
+#ifdef _WIN32
+    ReleaseSRWLockExclusive(&collector->lock);
+#else
+    pthread_rwlock_unlock(&collector->lock);
+#endif
 }
 
-void prts_metrics_destroy(prts_metrics_collector_t* collector) {
-    if (!collector) return;
+static void collector_read_lock(prts_metrics_collector_t* collector) {
+#ifdef _WIN32
+    AcquireSRWLockShared(&collector->lock);
+#else
+    pthread_rwlock_rdlock(&collector->lock);
+#endif
+}
 
+static void collector_read_unlock(prts_metrics_collector_t* collector) {
 #ifdef _WIN32
-    DeleteCriticalSection(&collector->lock);
+    ReleaseSRWLockShared(&collector->lock);
 #else
-    pthread_mutex_destroy(&collector->lock);
+    pthread_rwlock_unlock(&collector->lock);
 #endif
+}
 
-    /* Free allocated memory */
-    for (size_t i = 0; i < collector->num_metrics; i++) {
-        metric_entry_t* m = &collector->metrics[i];
-        if (m->labels) {
-            for (size_t j = 0; j < m->num_labels; j++) {
-                free(m->labels[j]);
-            }
-            free(m->labels);
-        }
+/* Threads are assigned shards round-robin on first use */
+static unsigned current_shard_index(void) {
+    if (thread_shard == UINT32_MAX) {
+        thread_shard = atomic_fetch_add_explicit(&next_shard, 1, memory_order_relaxed) &
+                       (METRIC_SHARDS - 1);
     }
+    return thread_shard;
+}
 
-    free(collector);
+static metric_shard_t* current_shard(const metric_series_t* s) {
+    return &s->shards[current_shard_index()];
 }
 
-static metric_entry_t* find_metric(prts_metrics_collector_t* collector, const char* name) {
-    for (size_t i = 0; i < collector->num_metrics; i++) {
-        if (strcmp(collector->metrics[i].name, name) == 0) {
-            return &collector->metrics[i];
+/*
+ * Branchless lower bound: index of the first boundary >= value, i.e. the
+ * Prometheus "le" bucket, or n for the +Inf bucket.
+ */
+static size_t find_bucket(const double* boundaries, size_t n, double value) {
+    if (n == 0 || value != value) {
+        return n;
+    }
+
+    const double* base = boundaries;
+    size_t len = n;
+    while (len > 1) {
+        size_t half = len / 2;
+        base = base[half - 1] < value ? base + half : base;
+        len -= half;
+    }
+    return (size_t)(base - boundaries) + (*base < value);
+}
+
+/* Boundaries must be finite and strictly increasing */
+static bool boundaries_valid(const double* boundaries, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (!isfinite(boundaries[i]) || (i > 0 && boundaries[i] <= boundaries[i - 1])) {
+            return false;
         }
     }
-    return NULL;
+    return true;
 }
 
-prts_result_t prts_metrics_register(
-    prts_metrics_collector_t* collector,
-    const prts_metric_config_t* config
-) {
-    if (!collector || !config || !config->name) {
-        return PRTS_ERROR_INVALID;
+static uint64_t double_to_bits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double bits_to_double(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void series_counter_add(metric_series_t* s, uint64_t delta) {
+    atomic_fetch_add_explicit(&current_shard(s)->count, delta, memory_order_relaxed);
+}
+
+static void series_gauge_store(metric_series_t* s, double value) {
+    atomic_store_explicit(&s->gauge_bits, double_to_bits(value), memory_order_relaxed);
+}
+
+static void series_histogram_add(metric_series_t* s, double value) {
+    const struct prts_metric* m = s->metric;
+    unsigned index = current_shard_index();
+    metric_shard_t* shard = &s->shards[index];
+    size_t bucket = find_bucket(m->boundaries, m->num_boundaries, value);
+    atomic_fetch_add_explicit(&s->buckets[index * m->bucket_stride + bucket], 1,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&shard->count, 1, memory_order_relaxed);
+
+    /* Shards are rarely shared, so the CAS almost always succeeds first time */
+    uint64_t old_bits = atomic_load_explicit(&shard->sum_bits, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&shard->sum_bits, &old_bits,
+               double_to_bits(bits_to_double(old_bits) + value),
+               memory_order_relaxed, memory_order_relaxed)) {
     }
+}
 
-    if (collector->num_metrics >= MAX_METRICS) {
-        return PRTS_ERROR_FULL;
+/* Sum the shards of a series */
+static void series_read(const metric_series_t* s, uint64_t* count_out, double* sum_out) {
+    uint64_t count = 0;
+    double sum = 0.0;
+    for (size_t i = 0; i < METRIC_SHARDS; i++) {
+        count += atomic_load_explicit(&s->shards[i].count, memory_order_relaxed);
+        sum += bits_to_double(atomic_load_explicit(&s->shards[i].sum_bits, memory_order_relaxed));
     }
+    *count_out = count;
+    if (sum_out) *sum_out = sum;
+}
 
-#ifdef _WIN32
-    EnterCriticalSection(&collector->lock);
-#else
-    pthread_mutex_lock(&collector->lock);
-#endif
+static double series_gauge_load(const metric_series_t* s) {
+    return bits_to_double(atomic_load_explicit(&s->gauge_bits, memory_order_relaxed));
+}
 
-    if (find_metric(collector, config->name)) {
-#ifdef _WIN32
-        LeaveCriticalSection(&collector->lock);
-#else
-        pthread_mutex_unlock(&collector->lock);
-#endif
-        return PRTS_ERROR_INVALID; /* Already exists */
+/*
+ * Sketch bins are not sharded; a short spinlock per series serializes
+ * inserts, which touch one bin and a few summary fields.
+ */
+static void sketch_lock(metric_series_t* s) {
+    while (atomic_flag_test_and_set_explicit(&s->sketch_lock, memory_order_acquire)) {
     }
+}
 
-    metric_entry_t* m = &collector->metrics[collector->num_metrics++];
-    strncpy(m->name, config->name, MAX_NAME_LEN - 1);
-    if (config->description) {
-        strncpy(m->description, config->description, sizeof(m->description) - 1);
+static void sketch_unlock(metric_series_t* s) {
+    atomic_flag_clear_explicit(&s->sketch_lock, memory_order_release);
+}
+
+/* Record an observation into a histogram or sketch series */
+static void series_observe(metric_series_t* s, double value) {
+    if (s->sketch) {
+        sketch_lock(s);
+        prts_sketch_add(s->sketch, value);
+        sketch_unlock(s);
+    } else {
+        series_histogram_add(s, value);
     }
-    m->type = config->type;
-    m->num_entries = 0;
+}
 
-    /* Copy labels */
-    if (config->labels && config->num_labels > 0) {
-        m->labels = calloc(config->num_labels, sizeof(char*));
-        m->num_labels = config->num_labels;
-        for (size_t i = 0; i < config->num_labels; i++) {
-            m->labels[i] = strdup(config->labels[i]);
+/* Read count, sum and the exported quantiles of a sketch */
+static void sketch_read(const prts_sketch_t* sketch, prts_metric_value_t* value_out) {
+    value_out->value.sketch.count = prts_sketch_count(sketch);
+    value_out->value.sketch.sum = prts_sketch_sum(sketch);
+    prts_sketch_quantile(sketch, 0.5, &value_out->value.sketch.p50);
+    prts_sketch_quantile(sketch, 0.9, &value_out->value.sketch.p90);
+    prts_sketch_quantile(sketch, 0.99, &value_out->value.sketch.p99);
+    prts_sketch_quantile(sketch, 0.999, &value_out->value.sketch.p999);
+}
+
+static void series_read_sketch(metric_series_t* s, prts_metric_value_t* value_out) {
+    sketch_lock(s);
+    sketch_read(s->sketch, value_out);
+    sketch_unlock(s);
+}
+
+/* Sum per-bucket (non-cumulative) counts across shards */
+static void series_read_buckets(const metric_series_t* s, uint64_t* counts, size_t num_counts) {
+    const struct prts_metric* m = s->metric;
+    size_t n = m->num_boundaries + 1;
+    if (num_counts < n) {
+        n = num_counts;
+    }
+
+    memset(counts, 0, n * sizeof(uint64_t));
+    for (size_t i = 0; i < METRIC_SHARDS; i++) {
+        const _Atomic uint64_t* shard_buckets = s->buckets + i * m->bucket_stride;
+        for (size_t b = 0; b < n; b++) {
+            counts[b] += atomic_load_explicit(&shard_buckets[b], memory_order_relaxed);
         }
     }
+}
 
-#ifdef _WIN32
-    LeaveCriticalSection(&collector->lock);
-#else
-    pthread_mutex_unlock(&collector->lock);
-#endif
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
 
-    return PRTS_OK;
+static uint64_t hash_string(uint64_t hash, const char* str) {
+    for (const unsigned char* p = (const unsigned char*)str; *p; p++) {
+        hash = (hash ^ *p) * FNV_PRIME;
+    }
+    return hash;
 }
 
-prts_result_t prts_metrics_counter_inc(
-    prts_metrics_collector_t* collector,
-    const char* name,
-    const char** label_values,
-    uint64_t delta
+/* FNV-1a over the label values, each terminated by a separator byte */
+static uint64_t hash_label_values(uint64_t hash, const char** label_values, size_t num_labels) {
+    for (size_t i = 0; i < num_labels; i++) {
+        hash = hash_string(hash, label_values[i]);
+        hash = (hash ^ 0xff) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static bool labels_valid(const metric_entry_t* m, const char** label_values) {
+    if (m->num_labels == 0) {
+        return true;
+    }
+    if (!label_values) {
+        return false;
+    }
+    for (size_t i = 0; i < m->num_labels; i++) {
+        if (!label_values[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool labels_equal(const metric_series_t* s, const char** label_values, size_t num_labels) {
+    for (size_t i = 0; i < num_labels; i++) {
+        if (strcmp(s->label_values[i], label_values[i]) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Write {label="value",...} with Prometheus escaping; returns bytes needed */
+static size_t format_labels(
+    const metric_entry_t* m,
+    const metric_series_t* s,
+    char* buffer,
+    size_t buffer_size
 ) {
-    if (!collector || !name) {
-        return PRTS_ERROR_INVALID;
+    if (m->num_labels == 0) {
+        if (buffer_size > 0) buffer[0] = '\0';
+        return 0;
     }
 
-#ifdef _WIN32
-    EnterCriticalSection(&collector->lock);
-#else
-    pthread_mutex_lock(&collector->lock);
-#endif
+    size_t offset = 0;
+#define PUT(c) do { if (offset + 1 < buffer_size) buffer[offset] = (c); offset++; } while (0)
+    PUT('{');
+    for (size_t i = 0; i < m->num_labels; i++) {
+        if (i > 0) PUT(',');
+        for (const char* p = m->labels[i]; *p; p++) PUT(*p);
+        PUT('=');
+        PUT('"');
+        for (const char* p = s->label_values[i]; *p; p++) {
+            if (*p == '\\' || *p == '"') {
+                PUT('\\');
+                PUT(*p);
+            } else if (*p == '\n') {
+                PUT('\\');
+                PUT('n');
+            } else {
+                PUT(*p);
+            }
+        }
+        PUT('"');
+    }
+    PUT('}');
+#undef PUT
 
-    metric_entry_t* m = find_metric(collector, name);
-    if (!m || m->type != PRTS_METRIC_COUNTER) {
-#ifdef _WIN32
-        LeaveCriticalSection(&collector->lock);
-#else
-        pthread_mutex_unlock(&collector->lock);
-#endif
-        return PRTS_ERROR_INVALID;
+    if (buffer_size > 0) {
+        buffer[offset < buffer_size ? offset : buffer_size - 1] = '\0';
     }
+    return offset;
+}
 
-    /* Find or create entry for label values */
-    size_t entry_idx = 0; /* Default entry for no labels */
-    if (m->num_entries == 0) {
-        m->num_entries = 1;
+static void series_free(metric_series_t* s, size_t num_labels) {
+    if (!s) return;
+    free(s->shards_alloc);
+    free(s->labels_text);
+    prts_sketch_destroy(s->sketch);
+    if (s->label_values) {
+        for (size_t i = 0; i < num_labels; i++) {
+            free(s->label_values[i]);
+        }
+        free(s->label_values);
     }
+    free(s);
+}
 
-    m->entries[entry_idx].value.counter += delta;
+static metric_series_t* find_series(
+    const metric_entry_t* m,
+    uint64_t hash,
+    const char** label_values
+) {
+    if (!m->series) {
+        return NULL;
+    }
 
-#ifdef _WIN32
-    LeaveCriticalSection(&collector->lock);
-#else
-    pthread_mutex_unlock(&collector->lock);
-#endif
+    size_t mask = m->series_capacity - 1;
+    for (size_t slot = hash & mask; m->series[slot]; slot = (slot + 1) & mask) {
+        metric_series_t* s = m->series[slot];
+        if (s->hash == hash && labels_equal(s, label_values, m->num_labels)) {
+            return s;
+        }
+    }
+    return NULL;
+}
+
+/* Reinsert the live series into a table of the given capacity */
+static prts_result_t rehash_series_table(metric_entry_t* m, size_t new_capacity) {
+    metric_series_t** table = calloc(new_capacity, sizeof(metric_series_t*));
+    if (!table) {
+        return PRTS_ERROR_NOMEM;
+    }
 
+    size_t mask = new_capacity - 1;
+    for (size_t i = 0; i < m->series_capacity; i++) {
+        metric_series_t* s = m->series[i];
+        if (!s) continue;
+        size_t slot = s->hash & mask;
+        while (table[slot]) {
+            slot = (slot + 1) & mask;
+        }
+        table[slot] = s;
+    }
+
+    free(m->series);
+    m->series = table;
+    m->series_capacity = new_capacity;
     return PRTS_OK;
 }
 
-prts_result_t prts_metrics_gauge_set(
-    prts_metrics_collector_t* collector,
-    const char* name,
+static prts_result_t grow_series_table(metric_entry_t* m) {
+    return rehash_series_table(m, m->series_capacity ? m->series_capacity * 2
+                                                     : INITIAL_SERIES_CAPACITY);
+}
+
+/*
+ * Find the series for a label set, creating it on first use unless a
+ * cardinality limit is reached. Caller holds the exclusive lock.
+ */
+static metric_series_t* get_series(
+    metric_entry_t* m,
     const char** label_values,
-    double value
+    prts_result_t* result_out
 ) {
-    if (!collector || !name) {
-        return PRTS_ERROR_INVALID;
+    uint64_t hash = hash_label_values(FNV_OFFSET_BASIS, label_values, m->num_labels);
+    metric_series_t* s = find_series(m, hash, label_values);
+    if (s) {
+        *result_out = PRTS_OK;
+        return s;
     }
 
-#ifdef _WIN32
-    EnterCriticalSection(&collector->lock);
-#else
-    pthread_mutex_lock(&collector->lock);
-#endif
+    prts_metrics_collector_t* collector = m->collector;
+    const prts_metrics_limits_t* limits = &collector->limits;
+    if ((limits->max_series_per_metric > 0 && m->num_series >= limits->max_series_per_metric) ||
+        (limits->max_series > 0 && collector->num_series >= limits->max_series)) {
+        m->series_dropped++;
+        collector->series_dropped++;
+        *result_out = PRTS_ERROR_FULL;
+        return NULL;
+    }
 
-    metric_entry_t* m = find_metric(collector, name);
-    if (!m || m->type != PRTS_METRIC_GAUGE) {
-#ifdef _WIN32
-        LeaveCriticalSection(&collector->lock);
-#else
-        pthread_mutex_unlock(&collector->lock);
-#endif
-        return PRTS_ERROR_INVALID;
+    *result_out = PRTS_ERROR_NOMEM;
+
+    /* Keep the load factor below 3/4 */
+    if ((m->num_series + 1) * 4 > m->series_capacity * 3 &&
+        grow_series_table(m) != PRTS_OK) {
+        return NULL;
     }
 
-    size_t entry_idx = 0;
-    if (m->num_entries == 0) {
-        m->num_entries = 1;
+    s = calloc(1, sizeof(metric_series_t));
+    if (!s) {
+        return NULL;
     }
+    s->metric = m;
+    atomic_init(&s->epoch, atomic_load_explicit(&collector->epoch, memory_order_relaxed));
+    s->hash = hash;
+    s->key = hash_label_values(m->name_hash, label_values, m->num_labels);
 
-    m->entries[entry_idx].value.gauge = value;
+    if (m->type == PRTS_METRIC_SKETCH) {
+        if (prts_sketch_create(m->sketch_accuracy, 0, &s->sketch) != PRTS_OK) {
+            free(s);
+            return NULL;
+        }
+        atomic_flag_clear(&s->sketch_lock);
+    }
 
-#ifdef _WIN32
-    LeaveCriticalSection(&collector->lock);
-#else
-    pthread_mutex_unlock(&collector->lock);
-#endif
+    if (m->type == PRTS_METRIC_COUNTER || m->type == PRTS_METRIC_HISTOGRAM) {
+        size_t bucket_bytes = METRIC_SHARDS * m->bucket_stride * sizeof(uint64_t);
+        s->shards_alloc = calloc(1, METRIC_SHARDS * sizeof(metric_shard_t) + bucket_bytes +
+                                    CACHE_LINE_SIZE);
+        if (!s->shards_alloc) {
+            free(s);
+            return NULL;
+        }
+        s->shards = (metric_shard_t*)(((uintptr_t)s->shards_alloc + CACHE_LINE_SIZE - 1) &
+                                      ~(uintptr_t)(CACHE_LINE_SIZE - 1));
+        s->buckets = (_Atomic uint64_t*)(s->shards + METRIC_SHARDS);
+    }
 
-    return PRTS_OK;
+    if (m->num_labels > 0) {
+        s->label_values = calloc(m->num_labels, sizeof(char*));
+        if (!s->label_values) {
+            series_free(s, 0);
+            return NULL;
+        }
+        for (size_t i = 0; i < m->num_labels; i++) {
+            s->label_values[i] = strdup(label_values[i]);
+            if (!s->label_values[i]) {
+                series_free(s, m->num_labels);
+                return NULL;
+            }
+        }
+
+        s->labels_len = format_labels(m, s, NULL, 0);
+        s->labels_text = malloc(s->labels_len + 1);
+        if (!s->labels_text) {
+            series_free(s, m->num_labels);
+            return NULL;
+        }
+        format_labels(m, s, s->labels_text, s->labels_len + 1);
+    }
+
+    size_t mask = m->series_capacity - 1;
+    size_t slot = hash & mask;
+    while (m->series[slot]) {
+        slot = (slot + 1) & mask;
+    }
+    m->series[slot] = s;
+    m->num_series++;
+    collector->num_series++;
+    *result_out = PRTS_OK;
+    return s;
 }
 
-prts_result_t prts_metrics_histogram_observe(
-    prts_metrics_collector_t* collector,
-    const char* name,
-    const char** label_values,
-    double value
-) {
-    if (!collector || !name) {
-        return PRTS_ERROR_INVALID;
+static void metric_free(metric_entry_t* m) {
+    for (size_t i = 0; i < m->series_capacity; i++) {
+        series_free(m->series[i], m->num_labels);
+    }
+    free(m->series);
+    free(m->boundaries);
+    if (m->labels) {
+        for (size_t i = 0; i < m->num_labels; i++) {
+            free(m->labels[i]);
+        }
+        free(m->labels);
     }
+    free(m);
+}
 
-#ifdef _WIN32
-    EnterCriticalSection(&collector->lock);
-#else
-    pthread_mutex_lock(&collector->lock);
-#endif
+/* Exports stream through a fixed chunk; larger writes bypass it */
+#define EXPORT_CHUNK_SIZE 16384
 
-    metric_entry_t* m = find_metric(collector, name);
-    if (!m || m->type != PRTS_METRIC_HISTOGRAM) {
-#ifdef _WIN32
-        LeaveCriticalSection(&collector->lock);
-#else
-        pthread_mutex_unlock(&collector->lock);
-#endif
+/*
+ * Per-metric snapshot taken under the read lock and formatted after it
+ * is released. Each series contributes its rendered labels to text and
+ * [labels_len, values...] to words.
+ */
+struct export_state {
+    char* text;
+    size_t text_len;
+    size_t text_cap;
+    uint64_t* words;
+    size_t num_words;
+    size_t words_cap;
+
+    prts_export_format_t format;
+    prts_export_write_fn write;
+    void* ctx;
+    prts_result_t result;
+    size_t out_len;
+    char out[EXPORT_CHUNK_SIZE];
+};
+
+static void export_state_free(struct export_state* state) {
+    if (!state) return;
+    free(state->text);
+    free(state->words);
+    free(state);
+}
+
+prts_result_t prts_metrics_create(prts_metrics_collector_t** collector_out) {
+    if (!collector_out) {
         return PRTS_ERROR_INVALID;
     }
 
-    size_t entry_idx = 0;
-    if (m->num_entries == 0) {
-        m->num_entries = 1;
+    prts_metrics_collector_t* collector = calloc(1, sizeof(prts_metrics_collector_t));
+    if (!collector) {
+        return PRTS_ERROR_NOMEM;
     }
 
-    m->entries[entry_idx].value.histogram.count++;
-    m->entries[entry_idx].value.histogram.sum += value;
-
 #ifdef _WIN32
-    LeaveCriticalSection(&collector->lock);
+    InitializeSRWLock(&collector->lock);
+    InitializeCriticalSection(&collector->export_lock);
 #else
-    pthread_mutex_unlock(&collector->lock);
+    pthread_rwlock_init(&collector->lock, NULL);
+    pthread_mutex_init(&collector->export_lock, NULL);
 #endif
 
+    *collector_out = collector;
     return PRTS_OK;
 }
 
-prts_result_t prts_metrics_export_prometheus(
-    prts_metrics_collector_t* collector,
-    char* buffer,
-    size_t buffer_size,
-    size_t* written_out
-) {
-    if (!collector || !buffer || !written_out) {
-        return PRTS_ERROR_INVALID;
-    }
+void prts_metrics_destroy(prts_metrics_collector_t* collector) {
+    if (!collector) return;
 
 #ifdef _WIN32
-    EnterCriticalSection(&collector->lock);
+    DeleteCriticalSection(&collector->export_lock);
 #else
-    pthread_mutex_lock(&collector->lock);
+    pthread_rwlock_destroy(&collector->lock);
+    pthread_mutex_destroy(&collector->export_lock);
 #endif
+    export_state_free(collector->export_state);
 
-    size_t offset = 0;
+    /* Free allocated memory */
+    for (size_t i = 0; i < collector->num_metrics; i++) {
+        metric_free(collector->metrics[i]);
+    }
+    free(collector->metrics);
+    free(collector->name_index);
 
-    for (size_t i = 0; i < collector->num_metrics && offset < buffer_size; i++) {
-        metric_entry_t* m = &collector->metrics[i];
+    free(collector);
+}
 
-        /* Write HELP */
-        offset += snprintf(buffer + offset, buffer_size - offset,
-            "# HELP %s %s\n", m->name, m->description);
+static metric_entry_t* find_metric(prts_metrics_collector_t* collector, const char* name) {
+    if (collector->num_metrics == 0) {
+        return NULL;
+    }
 
-        /* Write TYPE */
-        const char* type_str = "untyped";
-        switch (m->type) {
-            case PRTS_METRIC_COUNTER: type_str = "counter"; break;
-            case PRTS_METRIC_GAUGE: type_str = "gauge"; break;
-            case PRTS_METRIC_HISTOGRAM: type_str = "histogram"; break;
+    uint64_t hash = hash_string(FNV_OFFSET_BASIS, name);
+    size_t mask = collector->name_index_size - 1;
+    for (size_t slot = hash & mask; collector->name_index[slot]; slot = (slot + 1) & mask) {
+        metric_entry_t* m = collector->name_index[slot];
+        if (m->name_hash == hash && strcmp(m->name, name) == 0) {
+            return m;
         }
-        offset += snprintf(buffer + offset, buffer_size - offset,
-            "# TYPE %s %s\n", m->name, type_str);
+    }
+    return NULL;
+}
 
-        /* Write values */
-        for (size_t j = 0; j < m->num_entries && offset < buffer_size; j++) {
-            switch (m->type) {
-                case PRTS_METRIC_COUNTER:
-                    offset += snprintf(buffer + offset, buffer_size - offset,
-                        "%s %llu\n", m->name,
-                        (unsigned long long)m->entries[j].value.counter);
-                    break;
-                case PRTS_METRIC_GAUGE:
-                    offset += snprintf(buffer + offset, buffer_size - offset,
-                        "%s %g\n", m->name, m->entries[j].value.gauge);
-                    break;
+static void index_metric(metric_entry_t** index, size_t index_size, metric_entry_t* m) {
+    size_t mask = index_size - 1;
+    size_t slot = m->name_hash & mask;
+    while (index[slot]) {
+        slot = (slot + 1) & mask;
+    }
+    index[slot] = m;
+}
+
+/* Make room for one more metric in the metric array and name index */
+static prts_result_t reserve_metric(prts_metrics_collector_t* collector) {
+    if (collector->num_metrics == collector->metrics_capacity) {
+        size_t capacity = collector->metrics_capacity ? collector->metrics_capacity * 2
+                                                      : INITIAL_METRICS_CAPACITY;
+        metric_entry_t** metrics = realloc(collector->metrics, capacity * sizeof(metric_entry_t*));
+        if (!metrics) {
+            return PRTS_ERROR_NOMEM;
+        }
+        collector->metrics = metrics;
+        collector->metrics_capacity = capacity;
+    }
+
+    if ((collector->num_metrics + 1) * 2 > collector->name_index_size) {
+        size_t size = collector->metrics_capacity * 2;
+        metric_entry_t** index = calloc(size, sizeof(metric_entry_t*));
+        if (!index) {
+            return PRTS_ERROR_NOMEM;
+        }
+        for (size_t i = 0; i < collector->num_metrics; i++) {
+            index_metric(index, size, collector->metrics[i]);
+        }
+        free(collector->name_index);
+        collector->name_index = index;
+        collector->name_index_size = size;
+    }
+
+    return PRTS_OK;
+}
+
+/* Default histogram buckets, matching the Prometheus client defaults */
+static const double default_boundaries[] = {
+    0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+};
+
+static prts_result_t register_metric(
+    prts_metrics_collector_t* collector,
+    const prts_metric_config_t* config,
+    const prts_histogram_config_t* buckets,
+    double sketch_accuracy,
+    prts_metric_t** metric_out
+) {
+    if (!collector || !config || !config->name) {
+        return PRTS_ERROR_INVALID;
+    }
+    if (config->num_labels > 0 && !config->labels) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    const double* boundaries = NULL;
+    size_t num_boundaries = 0;
+    if (config->type == PRTS_METRIC_HISTOGRAM) {
+        boundaries = default_boundaries;
+        num_boundaries = sizeof(default_boundaries) / sizeof(default_boundaries[0]);
+        if (buckets) {
+            if (buckets->num_boundaries > 0 && !buckets->boundaries) {
+                return PRTS_ERROR_INVALID;
+            }
+            boundaries = buckets->boundaries;
+            num_boundaries = buckets->num_boundaries;
+        }
+
+        if (!boundaries_valid(boundaries, num_boundaries)) {
+            return PRTS_ERROR_INVALID;
+        }
+    } else if (buckets) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    collector_lock(collector);
+
+    if (find_metric(collector, config->name)) {
+        collector_unlock(collector);
+        return PRTS_ERROR_INVALID; /* Already exists */
+    }
+
+    metric_entry_t* m = calloc(1, sizeof(metric_entry_t));
+    if (!m || reserve_metric(collector) != PRTS_OK) {
+        free(m);
+        collector_unlock(collector);
+        return PRTS_ERROR_NOMEM;
+    }
+    m->collector = collector;
+    strncpy(m->name, config->name, MAX_NAME_LEN - 1);
+    m->name_hash = hash_string(FNV_OFFSET_BASIS, m->name);
+    if (config->description) {
+        strncpy(m->description, config->description, sizeof(m->description) - 1);
+    }
+    m->type = config->type;
+    m->sketch_accuracy = sketch_accuracy;
+
+    /* Copy bucket boundaries, padding per-shard bucket rows to cache lines */
+    if (config->type == PRTS_METRIC_HISTOGRAM) {
+        if (num_boundaries > 0) {
+            m->boundaries = malloc(num_boundaries * sizeof(double));
+            if (!m->boundaries) {
+                metric_free(m);
+                collector_unlock(collector);
+                return PRTS_ERROR_NOMEM;
+            }
+            memcpy(m->boundaries, boundaries, num_boundaries * sizeof(double));
+        }
+        m->num_boundaries = num_boundaries;
+
+        size_t per_line = CACHE_LINE_SIZE / sizeof(uint64_t);
+        m->bucket_stride = (num_boundaries + 1 + per_line - 1) / per_line * per_line;
+    }
+
+    /* Copy labels */
+    if (config->num_labels > 0) {
+        m->labels = calloc(config->num_labels, sizeof(char*));
+        if (!m->labels) {
+            metric_free(m);
+            collector_unlock(collector);
+            return PRTS_ERROR_NOMEM;
+        }
+        m->num_labels = config->num_labels;
+        for (size_t i = 0; i < config->num_labels; i++) {
+            m->labels[i] = strdup(config->labels[i]);
+            if (!m->labels[i]) {
+                metric_free(m);
+                collector_unlock(collector);
+                return PRTS_ERROR_NOMEM;
+            }
+        }
+    }
+
+    collector->metrics[collector->num_metrics++] = m;
+    index_metric(collector->name_index, collector->name_index_size, m);
+
+    collector_unlock(collector);
+
+    if (metric_out) {
+        *metric_out = m;
+    }
+    return PRTS_OK;
+}
+
+prts_result_t prts_metrics_register(
+    prts_metrics_collector_t* collector,
+    const prts_metric_config_t* config
+) {
+    return register_metric(collector, config, NULL, 0, NULL);
+}
+
+prts_result_t prts_metrics_register_handle(
+    prts_metrics_collector_t* collector,
+    const prts_metric_config_t* config,
+    prts_metric_t** metric_out
+) {
+    return register_metric(collector, config, NULL, 0, metric_out);
+}
+
+prts_result_t prts_metrics_register_histogram(
+    prts_metrics_collector_t* collector,
+    const prts_metric_config_t* config,
+    const prts_histogram_config_t* buckets,
+    prts_metric_t** metric_out
+) {
+    return register_metric(collector, config, buckets, 0, metric_out);
+}
+
+prts_result_t prts_metrics_register_sketch(
+    prts_metrics_collector_t* collector,
+    const prts_metric_config_t* config,
+    double relative_accuracy,
+    prts_metric_t** metric_out
+) {
+    if (!config || config->type != PRTS_METRIC_SKETCH ||
+        !(relative_accuracy >= 0 && relative_accuracy < 1)) {
+        return PRTS_ERROR_INVALID;
+    }
+    return register_metric(collector, config, NULL, relative_accuracy, metric_out);
+}
+
+prts_result_t prts_metrics_lookup(
+    prts_metrics_collector_t* collector,
+    const char* name,
+    prts_metric_t** metric_out
+) {
+    if (!collector || !name || !metric_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    collector_read_lock(collector);
+    metric_entry_t* m = find_metric(collector, name);
+    collector_read_unlock(collector);
+
+    if (!m) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    *metric_out = m;
+    return PRTS_OK;
+}
+
+prts_result_t prts_metrics_bind(
+    prts_metric_t* metric,
+    const char** label_values,
+    prts_metric_series_t** series_out
+) {
+    if (!metric || !series_out || !labels_valid(metric, label_values)) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    prts_result_t result;
+    collector_lock(metric->collector);
+    metric_series_t* s = get_series(metric, label_values, &result);
+    if (s) {
+        atomic_fetch_add_explicit(&s->pins, 1, memory_order_relaxed);
+    }
+    collector_unlock(metric->collector);
+
+    if (s) {
+        *series_out = s;
+    }
+    return result;
+}
+
+void prts_metrics_unbind(prts_metric_series_t* series) {
+    if (!series) return;
+    atomic_fetch_sub_explicit(&series->pins, 1, memory_order_relaxed);
+}
+
+/* Record an update in the current eviction epoch */
+static void series_touch(metric_series_t* s) {
+    /* Written at most once per epoch, so the line stays shared */
+    uint32_t epoch = atomic_load_explicit(&s->metric->collector->epoch, memory_order_relaxed);
+    if (atomic_load_explicit(&s->epoch, memory_order_relaxed) != epoch) {
+        atomic_store_explicit(&s->epoch, epoch, memory_order_relaxed);
+    }
+}
+
+prts_result_t prts_series_counter_inc(prts_metric_series_t* series, uint64_t delta) {
+    if (!series || series->metric->type != PRTS_METRIC_COUNTER) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    series_counter_add(series, delta);
+    series_touch(series);
+    return PRTS_OK;
+}
+
+prts_result_t prts_series_gauge_set(prts_metric_series_t* series, double value) {
+    if (!series || series->metric->type != PRTS_METRIC_GAUGE) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    series_gauge_store(series, value);
+    series_touch(series);
+    return PRTS_OK;
+}
+
+prts_result_t prts_series_histogram_observe(prts_metric_series_t* series, double value) {
+    if (!series || (series->metric->type != PRTS_METRIC_HISTOGRAM &&
+                    series->metric->type != PRTS_METRIC_SKETCH)) {
+        return PRTS_ERROR_INVALID;
+    }
+    if (series->metric->type == PRTS_METRIC_SKETCH && !isfinite(value)) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    series_observe(series, value);
+    series_touch(series);
+    return PRTS_OK;
+}
+
+/* A name-path update, applied to whichever series the labels resolve to */
+typedef struct {
+    prts_metric_type_t type;
+    uint64_t delta;
+    double value;
+} series_update_t;
+
+static void apply_update(metric_series_t* s, const series_update_t* update) {
+    switch (update->type) {
+        case PRTS_METRIC_COUNTER:
+            series_counter_add(s, update->delta);
+            break;
+        case PRTS_METRIC_GAUGE:
+            series_gauge_store(s, update->value);
+            break;
+        default:
+            series_observe(s, update->value);
+            break;
+    }
+
+    series_touch(s);
+}
+
+/*
+ * Look up a metric of the given type and the series for a label set,
+ * then apply the update. Existing series are updated under the shared
+ * lock; only creating a new series takes the lock exclusively.
+ * Sketches accept histogram observations.
+ */
+static prts_result_t update_series(
+    prts_metrics_collector_t* collector,
+    const char* name,
+    const char** label_values,
+    const series_update_t* update
+) {
+    if (!collector || !name) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    collector_read_lock(collector);
+
+    metric_entry_t* m = find_metric(collector, name);
+    bool type_ok = m && (m->type == update->type ||
+                         (update->type == PRTS_METRIC_HISTOGRAM &&
+                          m->type == PRTS_METRIC_SKETCH));
+    if (type_ok && m->type == PRTS_METRIC_SKETCH && !isfinite(update->value)) {
+        type_ok = false;    /* Sketches only hold finite values */
+    }
+    if (!type_ok || !labels_valid(m, label_values)) {
+        collector_read_unlock(collector);
+        return PRTS_ERROR_INVALID;
+    }
+
+    uint64_t hash = hash_label_values(FNV_OFFSET_BASIS, label_values, m->num_labels);
+    metric_series_t* s = find_series(m, hash, label_values);
+    if (s) {
+        apply_update(s, update);
+        collector_read_unlock(collector);
+        return PRTS_OK;
+    }
+    collector_read_unlock(collector);
+
+    prts_result_t result;
+    collector_lock(collector);
+    s = get_series(m, label_values, &result);
+    if (s) {
+        apply_update(s, update);
+    }
+    collector_unlock(collector);
+
+    return result;
+}
+
+prts_result_t prts_metrics_counter_inc(
+    prts_metrics_collector_t* collector,
+    const char* name,
+    const char** label_values,
+    uint64_t delta
+) {
+    series_update_t update = { PRTS_METRIC_COUNTER, delta, 0.0 };
+    return update_series(collector, name, label_values, &update);
+}
+
+prts_result_t prts_metrics_gauge_set(
+    prts_metrics_collector_t* collector,
+    const char* name,
+    const char** label_values,
+    double value
+) {
+    series_update_t update = { PRTS_METRIC_GAUGE, 0, value };
+    return update_series(collector, name, label_values, &update);
+}
+
+prts_result_t prts_metrics_histogram_observe(
+    prts_metrics_collector_t* collector,
+    const char* name,
+    const char** label_values,
+    double value
+) {
+    series_update_t update = { PRTS_METRIC_HISTOGRAM, 0, value };
+    return update_series(collector, name, label_values, &update);
+}
+
+prts_result_t prts_metrics_set_limits(
+    prts_metrics_collector_t* collector,
+    const prts_metrics_limits_t* limits
+) {
+    if (!collector || !limits) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    collector_lock(collector);
+    collector->limits = *limits;
+    collector_unlock(collector);
+
+    return PRTS_OK;
+}
+
+/* Unpinned and not updated for more than idle_epochs epochs */
+static bool series_stale(metric_series_t* s, uint32_t epoch, uint32_t idle_epochs) {
+    if (atomic_load_explicit(&s->pins, memory_order_relaxed) > 0) {
+        return false;
+    }
+    uint32_t last = atomic_load_explicit(&s->epoch, memory_order_relaxed);
+    return epoch - last > idle_epochs;
+}
+
+prts_result_t prts_metrics_evict_stale(
+    prts_metrics_collector_t* collector,
+    uint32_t idle_epochs,
+    size_t* evicted_out
+) {
+    if (!collector || idle_epochs == 0) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    collector_lock(collector);
+
+    uint32_t epoch = atomic_load_explicit(&collector->epoch, memory_order_relaxed) + 1;
+    atomic_store_explicit(&collector->epoch, epoch, memory_order_relaxed);
+
+    prts_result_t result = PRTS_OK;
+    size_t evicted = 0;
+    for (size_t i = 0; i < collector->num_metrics; i++) {
+        metric_entry_t* m = collector->metrics[i];
+
+        bool any_stale = false;
+        for (size_t j = 0; j < m->series_capacity && !any_stale; j++) {
+            any_stale = m->series[j] && series_stale(m->series[j], epoch, idle_epochs);
+        }
+        if (!any_stale) continue;
+
+        /*
+         * Live series move to a fresh table so probe chains stay unbroken.
+         * It is allocated before anything is freed: without it the metric
+         * keeps its stale series until the next sweep.
+         */
+        metric_series_t** table = calloc(m->series_capacity, sizeof(metric_series_t*));
+        if (!table) {
+            result = PRTS_ERROR_NOMEM;
+            break;
+        }
+
+        size_t mask = m->series_capacity - 1;
+        size_t removed = 0;
+        for (size_t j = 0; j < m->series_capacity; j++) {
+            metric_series_t* s = m->series[j];
+            if (!s) continue;
+
+            if (series_stale(s, epoch, idle_epochs)) {
+                series_free(s, m->num_labels);
+                removed++;
+                continue;
+            }
+            size_t slot = s->hash & mask;
+            while (table[slot]) {
+                slot = (slot + 1) & mask;
+            }
+            table[slot] = s;
+        }
+        free(m->series);
+        m->series = table;
+
+        m->num_series -= removed;
+        m->series_evicted += removed;
+        evicted += removed;
+    }
+
+    collector->num_series -= evicted;
+    collector->series_evicted += evicted;
+
+    collector_unlock(collector);
+
+    if (evicted_out) {
+        *evicted_out = evicted;
+    }
+    return result;
+}
+
+prts_result_t prts_metrics_stats(
+    prts_metrics_collector_t* collector,
+    prts_metrics_stats_t* stats_out
+) {
+    if (!collector || !stats_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    collector_read_lock(collector);
+    stats_out->num_metrics = collector->num_metrics;
+    stats_out->num_series = collector->num_series;
+    stats_out->series_dropped = collector->series_dropped;
+    stats_out->series_evicted = collector->series_evicted;
+    collector_read_unlock(collector);
+
+    return PRTS_OK;
+}
+
+prts_result_t prts_metrics_get(
+    prts_metrics_collector_t* collector,
+    const char* name,
+    const char** label_values,
+    prts_metric_value_t* value_out
+) {
+    if (!collector || !name || !value_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    collector_read_lock(collector);
+
+    metric_entry_t* m = find_metric(collector, name);
+    if (!m || !labels_valid(m, label_values)) {
+        collector_read_unlock(collector);
+        return PRTS_ERROR_INVALID;
+    }
+
+    memset(value_out, 0, sizeof(prts_metric_value_t));
+    value_out->type = m->type;
+    value_out->timestamp = prts_timestamp_now();
+
+    /* A label set that was never updated reads as zero */
+    uint64_t hash = hash_label_values(FNV_OFFSET_BASIS, label_values, m->num_labels);
+    metric_series_t* s = find_series(m, hash, label_values);
+    if (s) {
+        switch (m->type) {
+            case PRTS_METRIC_COUNTER:
+                series_read(s, &value_out->value.counter, NULL);
+                break;
+            case PRTS_METRIC_GAUGE:
+                value_out->value.gauge = series_gauge_load(s);
+                break;
+            case PRTS_METRIC_HISTOGRAM:
+                series_read(s, &value_out->value.histogram.count,
+                            &value_out->value.histogram.sum);
+                break;
+            case PRTS_METRIC_SKETCH:
+                series_read_sketch(s, value_out);
+                break;
+        }
+    }
+    if (m->type == PRTS_METRIC_HISTOGRAM) {
+        value_out->value.histogram.num_buckets = m->num_boundaries + 1;
+    }
+
+    collector_read_unlock(collector);
+
+    return PRTS_OK;
+}
+
+prts_result_t prts_metrics_get_buckets(
+    prts_metrics_collector_t* collector,
+    const char* name,
+    const char** label_values,
+    uint64_t* counts_out,
+    size_t capacity,
+    size_t* num_buckets_out
+) {
+    if (!collector || !name || (!counts_out && capacity > 0)) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    collector_read_lock(collector);
+
+    metric_entry_t* m = find_metric(collector, name);
+    if (!m || m->type != PRTS_METRIC_HISTOGRAM || !labels_valid(m, label_values)) {
+        collector_read_unlock(collector);
+        return PRTS_ERROR_INVALID;
+    }
+
+    size_t num_buckets = m->num_boundaries + 1;
+    uint64_t hash = hash_label_values(FNV_OFFSET_BASIS, label_values, m->num_labels);
+    metric_series_t* s = find_series(m, hash, label_values);
+    if (capacity > 0 && s) {
+        series_read_buckets(s, counts_out, capacity);
+    } else if (capacity > 0) {
+        memset(counts_out, 0, (capacity < num_buckets ? capacity : num_buckets) * sizeof(uint64_t));
+    }
+
+    collector_read_unlock(collector);
+
+    if (num_buckets_out) {
+        *num_buckets_out = num_buckets;
+    }
+    return PRTS_OK;
+}
+
+prts_result_t prts_metrics_series_key(
+    prts_metrics_collector_t* collector,
+    const char* name,
+    const char** label_values,
+    uint64_t* key_out
+) {
+    if (!collector || !name || !key_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    collector_read_lock(collector);
+
+    metric_entry_t* m = find_metric(collector, name);
+    if (!m || !labels_valid(m, label_values)) {
+        collector_read_unlock(collector);
+        return PRTS_ERROR_INVALID;
+    }
+    *key_out = hash_label_values(m->name_hash, label_values, m->num_labels);
+
+    collector_read_unlock(collector);
+
+    return PRTS_OK;
+}
+
+prts_result_t prts_metrics_visit(
+    prts_metrics_collector_t* collector,
+    prts_metrics_visit_fn visit,
+    void* ctx
+) {
+    if (!collector || !visit) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    collector_read_lock(collector);
+
+    prts_timestamp_t now = prts_timestamp_now();
+    uint64_t* bucket_counts = NULL;
+    prts_sketch_t* sketch = NULL;
+    prts_result_t result = PRTS_OK;
+
+    for (size_t i = 0; i < collector->num_metrics && result == PRTS_OK; i++) {
+        metric_entry_t* m = collector->metrics[i];
+
+        if (m->type == PRTS_METRIC_HISTOGRAM) {
+            uint64_t* counts = realloc(bucket_counts, (m->num_boundaries + 1) * sizeof(uint64_t));
+            if (!counts) {
+                free(bucket_counts);
+                collector_read_unlock(collector);
+                return PRTS_ERROR_NOMEM;
+            }
+            bucket_counts = counts;
+        }
+
+        /* Series sketches are copied out so visitors never see them change */
+        prts_sketch_destroy(sketch);
+        sketch = NULL;
+        if (m->type == PRTS_METRIC_SKETCH &&
+            prts_sketch_create(m->sketch_accuracy, 0, &sketch) != PRTS_OK) {
+            result = PRTS_ERROR_NOMEM;
+            break;
+        }
+
+        prts_metric_sample_t sample;
+        memset(&sample, 0, sizeof(sample));
+        sample.name = m->name;
+        sample.type = m->type;
+        sample.label_names = (const char* const*)m->labels;
+        sample.num_labels = m->num_labels;
+        sample.boundaries = m->boundaries;
+
+        for (size_t j = 0; j < m->series_capacity; j++) {
+            metric_series_t* s = m->series[j];
+            if (!s) continue;
+
+            sample.label_values = (const char* const*)s->label_values;
+            sample.series_key = s->key;
+            memset(&sample.value, 0, sizeof(sample.value));
+            sample.value.type = m->type;
+            sample.value.timestamp = now;
+
+            switch (m->type) {
+                case PRTS_METRIC_COUNTER:
+                    series_read(s, &sample.value.value.counter, NULL);
+                    break;
+                case PRTS_METRIC_GAUGE:
+                    sample.value.value.gauge = series_gauge_load(s);
+                    break;
                 case PRTS_METRIC_HISTOGRAM:
-                    offset += snprintf(buffer + offset, buffer_size - offset,
-                        "%s_count %llu\n%s_sum %g\n",
-                        m->name, (unsigned long long)m->entries[j].value.histogram.count,
-                        m->name, m->entries[j].value.histogram.sum);
+                    series_read(s, &sample.value.value.histogram.count,
+                                &sample.value.value.histogram.sum);
+                    series_read_buckets(s, bucket_counts, m->num_boundaries + 1);
+                    sample.value.value.histogram.bucket_counts = bucket_counts;
+                    sample.value.value.histogram.num_buckets = m->num_boundaries + 1;
+                    break;
+                case PRTS_METRIC_SKETCH:
+                    prts_sketch_clear(sketch);
+                    sketch_lock(s);
+                    result = prts_sketch_merge(sketch, s->sketch);
+                    sketch_unlock(s);
+                    sketch_read(sketch, &sample.value);
+                    sample.sketch = sketch;
                     break;
             }
+            if (result != PRTS_OK) {
+                break;
+            }
+
+            visit(&sample, ctx);
+        }
+    }
+
+    collector_read_unlock(collector);
+    free(bucket_counts);
+    prts_sketch_destroy(sketch);
+
+    return result;
+}
+
+static void export_flush(struct export_state* st) {
+    if (st->out_len > 0 && st->result == PRTS_OK) {
+        st->result = st->write(st->out, st->out_len, st->ctx);
+    }
+    st->out_len = 0;
+}
+
+/* Fill chunks to EXPORT_CHUNK_SIZE; long pieces span several chunks */
+static void emit(struct export_state* st, const char* data, size_t len) {
+    while (st->result == PRTS_OK && len > 0) {
+        if (st->out_len == EXPORT_CHUNK_SIZE) {
+            export_flush(st);
+            continue;
+        }
+
+        size_t n = EXPORT_CHUNK_SIZE - st->out_len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(st->out + st->out_len, data, n);
+        st->out_len += n;
+        data += n;
+        len -= n;
+    }
+}
+
+static void emit_str(struct export_state* st, const char* str) {
+    emit(st, str, strlen(str));
+}
+
+static void emit_char(struct export_state* st, char c) {
+    if (st->out_len < EXPORT_CHUNK_SIZE) {
+        st->out[st->out_len++] = c;
+    } else {
+        emit(st, &c, 1);
+    }
+}
+
+/* Digits of v, right-aligned in buf[0..20); returns the first index */
+static size_t format_u64(char* buf, uint64_t v) {
+    size_t i = 20;
+    do {
+        buf[--i] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    return i;
+}
+
+static void emit_u64(struct export_state* st, uint64_t v) {
+    char buf[20];
+    size_t i = format_u64(buf, v);
+    emit(st, buf + i, 20 - i);
+}
+
+/*
+ * Shortest common forms without printf: integers, and values that are
+ * exact at six decimals (the nearest double to the printed decimal is
+ * the value itself, so these round-trip). Anything else falls back to
+ * the shortest %g precision that round-trips.
+ */
+static size_t format_double(char* buf, double v) {
+    if (v != v) {
+        memcpy(buf, "NaN", 3);
+        return 3;
+    }
+    if (isinf(v)) {
+        memcpy(buf, v > 0 ? "+Inf" : "-Inf", 4);
+        return 4;
+    }
+
+    double scaled = v * 1e6;
+    double rounded = nearbyint(scaled);
+    if (fabs(v) < 1e15 && fabs(scaled) < 9e15 && rounded / 1e6 == v) {
+        size_t len = 0;
+        uint64_t units = (uint64_t)fabs(rounded);
+        if (rounded < 0) {
+            buf[len++] = '-';
+        }
+
+        char digits[20];
+        size_t i = format_u64(digits, units / 1000000);
+        memcpy(buf + len, digits + i, 20 - i);
+        len += 20 - i;
+
+        uint64_t frac = units % 1000000;
+        if (frac != 0) {
+            buf[len++] = '.';
+            for (uint64_t div = 100000; frac != 0; div /= 10) {
+                buf[len++] = (char)('0' + frac / div);
+                frac %= div;
+            }
+        }
+        return len;
+    }
+
+    int len = snprintf(buf, 32, "%.15g", v);
+    if (strtod(buf, NULL) != v) {
+        len = snprintf(buf, 32, "%.17g", v);
+    }
+    return (size_t)len;
+}
+
+static void emit_double(struct export_state* st, double v) {
+    char buf[32];
+    emit(st, buf, format_double(buf, v));
+}
+
+static prts_result_t reserve_words(struct export_state* st, size_t n) {
+    if (st->num_words + n <= st->words_cap) {
+        return PRTS_OK;
+    }
+    size_t cap = st->words_cap ? st->words_cap : 1024;
+    while (cap < st->num_words + n) cap *= 2;
+    uint64_t* words = realloc(st->words, cap * sizeof(uint64_t));
+    if (!words) {
+        return PRTS_ERROR_NOMEM;
+    }
+    st->words = words;
+    st->words_cap = cap;
+    return PRTS_OK;
+}
+
+static prts_result_t reserve_text(struct export_state* st, size_t n) {
+    if (st->text_len + n <= st->text_cap) {
+        return PRTS_OK;
+    }
+    size_t cap = st->text_cap ? st->text_cap : 4096;
+    while (cap < st->text_len + n) cap *= 2;
+    char* text = realloc(st->text, cap);
+    if (!text) {
+        return PRTS_ERROR_NOMEM;
+    }
+    st->text = text;
+    st->text_cap = cap;
+    return PRTS_OK;
+}
+
+/* Copy the values and rendered labels of every series; caller holds the read lock */
+static prts_result_t snapshot_metric(struct export_state* st, const metric_entry_t* m) {
+    st->text_len = 0;
+    st->num_words = 0;
+
+    size_t values = 1;
+    switch (m->type) {
+        case PRTS_METRIC_COUNTER:
+        case PRTS_METRIC_GAUGE:
+            values = 1;
+            break;
+        case PRTS_METRIC_HISTOGRAM:
+            values = 2 + m->num_boundaries + 1;
+            break;
+        case PRTS_METRIC_SKETCH:
+            values = 6;
+            break;
+    }
+
+    for (size_t i = 0; i < m->series_capacity; i++) {
+        metric_series_t* s = m->series[i];
+        if (!s) continue;
+
+        if (reserve_words(st, 1 + values) != PRTS_OK ||
+            reserve_text(st, s->labels_len) != PRTS_OK) {
+            return PRTS_ERROR_NOMEM;
+        }
+        if (s->labels_len > 0) {
+            memcpy(st->text + st->text_len, s->labels_text, s->labels_len);
+            st->text_len += s->labels_len;
+        }
+
+        uint64_t* w = st->words + st->num_words;
+        st->num_words += 1 + values;
+        w[0] = s->labels_len;
+
+        uint64_t count;
+        double sum;
+        switch (m->type) {
+            case PRTS_METRIC_COUNTER:
+                series_read(s, &w[1], NULL);
+                break;
+            case PRTS_METRIC_GAUGE:
+                w[1] = double_to_bits(series_gauge_load(s));
+                break;
+            case PRTS_METRIC_HISTOGRAM:
+                series_read(s, &count, &sum);
+                w[1] = count;
+                w[2] = double_to_bits(sum);
+                series_read_buckets(s, &w[3], m->num_boundaries + 1);
+                break;
+            case PRTS_METRIC_SKETCH: {
+                prts_metric_value_t v;
+                memset(&v, 0, sizeof(v));
+                series_read_sketch(s, &v);
+                w[1] = v.value.sketch.count;
+                w[2] = double_to_bits(v.value.sketch.sum);
+                w[3] = double_to_bits(v.value.sketch.p50);
+                w[4] = double_to_bits(v.value.sketch.p90);
+                w[5] = double_to_bits(v.value.sketch.p99);
+                w[6] = double_to_bits(v.value.sketch.p999);
+                break;
+            }
         }
     }
 
-    *written_out = offset;
+    return PRTS_OK;
+}
+
+/* name{labels,key="value"} for bucket and quantile lines */
+static void emit_series_with(
+    struct export_state* st,
+    const char* name,
+    const char* suffix,
+    const char* labels,
+    size_t labels_len,
+    const char* key,
+    const char* value,
+    size_t value_len
+) {
+    emit_str(st, name);
+    emit_str(st, suffix);
+    if (labels_len > 0) {
+        emit(st, labels, labels_len - 1);
+        emit_char(st, ',');
+    } else {
+        emit_char(st, '{');
+    }
+    emit_str(st, key);
+    emit(st, "=\"", 2);
+    emit(st, value, value_len);
+    emit(st, "\"} ", 3);
+}
+
+static void emit_series(
+    struct export_state* st,
+    const char* name,
+    const char* suffix,
+    const char* labels,
+    size_t labels_len
+) {
+    emit_str(st, name);
+    emit_str(st, suffix);
+    emit(st, labels, labels_len);
+    emit_char(st, ' ');
+}
+
+static void emit_header(
+    struct export_state* st,
+    const char* family,
+    const char* help,
+    const char* type_str
+) {
+    emit(st, "# HELP ", 7);
+    emit_str(st, family);
+    emit_char(st, ' ');
+    for (const char* p = help; *p; p++) {
+        if (*p == '\\') {
+            emit(st, "\\\\", 2);
+        } else if (*p == '\n') {
+            emit(st, "\\n", 2);
+        } else {
+            emit_char(st, *p);
+        }
+    }
+    emit(st, "\n# TYPE ", 8);
+    emit_str(st, family);
+    emit_char(st, ' ');
+    emit_str(st, type_str);
+    emit_char(st, '\n');
+}
+
+static void format_metric(struct export_state* st, const metric_entry_t* m) {
+    bool openmetrics = st->format == PRTS_EXPORT_OPENMETRICS;
+
+    /* OpenMetrics counters are named after the family plus _total */
+    char family[MAX_NAME_LEN];
+    const char* counter_suffix = "";
+    strcpy(family, m->name);
+    if (openmetrics && m->type == PRTS_METRIC_COUNTER) {
+        size_t len = strlen(family);
+        if (len > 6 && strcmp(family + len - 6, "_total") == 0) {
+            family[len - 6] = '\0';
+        }
+        counter_suffix = "_total";
+    }
+
+    const char* type_str = openmetrics ? "unknown" : "untyped";
+    switch (m->type) {
+        case PRTS_METRIC_COUNTER: type_str = "counter"; break;
+        case PRTS_METRIC_GAUGE: type_str = "gauge"; break;
+        case PRTS_METRIC_HISTOGRAM: type_str = "histogram"; break;
+        case PRTS_METRIC_SKETCH: type_str = "summary"; break;
+    }
+    emit_header(st, family, m->description, type_str);
+
+    static const char* quantile_names[] = {"0.5", "0.9", "0.99", "0.999"};
+    size_t text_offset = 0;
+    char num[32];
+
+    for (size_t w = 0; w < st->num_words && st->result == PRTS_OK; ) {
+        size_t labels_len = (size_t)st->words[w++];
+        const char* labels = labels_len > 0 ? st->text + text_offset : "";
+        const uint64_t* values = st->words + w;
+
+        switch (m->type) {
+            case PRTS_METRIC_COUNTER:
+                emit_series(st, family, counter_suffix, labels, labels_len);
+                emit_u64(st, values[0]);
+                w += 1;
+                break;
+            case PRTS_METRIC_GAUGE:
+                emit_series(st, m->name, "", labels, labels_len);
+                emit_double(st, bits_to_double(values[0]));
+                w += 1;
+                break;
+            case PRTS_METRIC_HISTOGRAM: {
+                /* Cumulative buckets; +Inf doubles as the count */
+                const uint64_t* buckets = values + 2;
+                uint64_t cumulative = 0;
+                for (size_t b = 0; b <= m->num_boundaries; b++) {
+                    cumulative += buckets[b];
+                    if (b < m->num_boundaries) {
+                        emit_series_with(st, m->name, "_bucket", labels, labels_len, "le",
+                                         num, format_double(num, m->boundaries[b]));
+                    } else {
+                        emit_series_with(st, m->name, "_bucket", labels, labels_len, "le",
+                                         "+Inf", 4);
+                    }
+                    emit_u64(st, cumulative);
+                    emit_char(st, '\n');
+                }
+                emit_series(st, m->name, "_count", labels, labels_len);
+                emit_u64(st, cumulative);
+                emit_char(st, '\n');
+                emit_series(st, m->name, "_sum", labels, labels_len);
+                emit_double(st, bits_to_double(values[1]));
+                w += 2 + m->num_boundaries + 1;
+                break;
+            }
+            case PRTS_METRIC_SKETCH:
+                /* Empty series carry no quantiles */
+                for (size_t q = 0; q < 4 && values[0] > 0; q++) {
+                    emit_series_with(st, m->name, "", labels, labels_len, "quantile",
+                                     quantile_names[q], strlen(quantile_names[q]));
+                    emit_double(st, bits_to_double(values[2 + q]));
+                    emit_char(st, '\n');
+                }
+                emit_series(st, m->name, "_count", labels, labels_len);
+                emit_u64(st, values[0]);
+                emit_char(st, '\n');
+                emit_series(st, m->name, "_sum", labels, labels_len);
+                emit_double(st, bits_to_double(values[1]));
+                w += 6;
+                break;
+        }
+        emit_char(st, '\n');
+        text_offset += labels_len;
+    }
+}
+
+/*
+ * Per-metric dropped and evicted series counts, as
+ * prts_metrics_series_{dropped,evicted}_total{metric="..."}. Only
+ * metrics that lost series appear.
+ */
+static void export_cardinality(struct export_state* st, prts_metrics_collector_t* collector) {
+    static const struct {
+        const char* family;
+        const char* help;
+    } families[2] = {
+        { "prts_metrics_series_dropped", "Series not created because a cardinality limit was reached" },
+        { "prts_metrics_series_evicted", "Series removed after going stale" },
+    };
+
+    /*
+     * Snapshot [metric entry, dropped, evicted] for metrics with losses.
+     * Entries outlive the lock; the metrics array may be reallocated by
+     * a concurrent register.
+     */
+    st->num_words = 0;
+    collector_read_lock(collector);
+    for (size_t i = 0; i < collector->num_metrics; i++) {
+        const metric_entry_t* m = collector->metrics[i];
+        if (m->series_dropped == 0 && m->series_evicted == 0) continue;
+        if (reserve_words(st, 3) != PRTS_OK) {
+            st->result = PRTS_ERROR_NOMEM;
+            break;
+        }
+        st->words[st->num_words++] = (uint64_t)(uintptr_t)m;
+        st->words[st->num_words++] = m->series_dropped;
+        st->words[st->num_words++] = m->series_evicted;
+    }
+    collector_read_unlock(collector);
+
+    if (st->num_words == 0 || st->result != PRTS_OK) {
+        return;
+    }
+
+    for (size_t f = 0; f < 2; f++) {
+        if (st->format == PRTS_EXPORT_OPENMETRICS) {
+            emit_header(st, families[f].family, families[f].help, "counter");
+        } else {
+            char family[64];
+            snprintf(family, sizeof(family), "%s_total", families[f].family);
+            emit_header(st, family, families[f].help, "counter");
+        }
+        for (size_t w = 0; w < st->num_words; w += 3) {
+            emit_str(st, families[f].family);
+            emit(st, "_total{metric=\"", 15);
+            const metric_entry_t* m = (const metric_entry_t*)(uintptr_t)st->words[w];
+            emit_str(st, m->name);
+            emit(st, "\"} ", 3);
+            emit_u64(st, st->words[w + 1 + f]);
+            emit_char(st, '\n');
+        }
+    }
+}
+
+prts_result_t prts_metrics_export(
+    prts_metrics_collector_t* collector,
+    prts_export_format_t format,
+    prts_export_write_fn write,
+    void* ctx
+) {
+    if (!collector || !write) {
+        return PRTS_ERROR_INVALID;
+    }
+
+#ifdef _WIN32
+    EnterCriticalSection(&collector->export_lock);
+#else
+    pthread_mutex_lock(&collector->export_lock);
+#endif
+
+    struct export_state* st = collector->export_state;
+    if (!st) {
+        st = calloc(1, sizeof(struct export_state));
+        collector->export_state = st;
+    }
+
+    prts_result_t result = PRTS_ERROR_NOMEM;
+    if (st) {
+        st->format = format;
+        st->write = write;
+        st->ctx = ctx;
+        st->result = PRTS_OK;
+        st->out_len = 0;
+
+        /*
+         * The read lock covers one metric's snapshot at a time; formatting
+         * runs unlocked. Metric entries are never removed, so their names
+         * and boundaries stay valid.
+         */
+        for (size_t i = 0; st->result == PRTS_OK; i++) {
+            collector_read_lock(collector);
+            if (i >= collector->num_metrics) {
+                collector_read_unlock(collector);
+                break;
+            }
+            const metric_entry_t* m = collector->metrics[i];
+            prts_result_t snap = snapshot_metric(st, m);
+            collector_read_unlock(collector);
+
+            if (snap != PRTS_OK) {
+                st->result = snap;
+                break;
+            }
+            format_metric(st, m);
+        }
+
+        if (st->result == PRTS_OK) {
+            export_cardinality(st, collector);
+        }
+        if (format == PRTS_EXPORT_OPENMETRICS) {
+            emit(st, "# EOF\n", 6);
+        }
+        export_flush(st);
+        result = st->result;
+    }
 
 #ifdef _WIN32
-    LeaveCriticalSection(&collector->lock);
+    LeaveCriticalSection(&collector->export_lock);
 #else
-    pthread_mutex_unlock(&collector->lock);
+    pthread_mutex_unlock(&collector->export_lock);
 #endif
 
+    return result;
+}
+
+/* Writes into a fixed buffer, keeping room for the terminating NUL */
+typedef struct {
+    char* buffer;
+    size_t size;
+    size_t offset;
+} buffer_sink_t;
+
+static prts_result_t buffer_write(const char* data, size_t len, void* ctx) {
+    buffer_sink_t* sink = ctx;
+    size_t room = sink->size - 1 - sink->offset;
+    if (len > room) {
+        memcpy(sink->buffer + sink->offset, data, room);
+        sink->offset += room;
+        return PRTS_ERROR_FULL;
+    }
+    memcpy(sink->buffer + sink->offset, data, len);
+    sink->offset += len;
     return PRTS_OK;
 }
+
+prts_result_t prts_metrics_export_prometheus(
+    prts_metrics_collector_t* collector,
+    char* buffer,
+    size_t buffer_size,
+    size_t* written_out
+) {
+    if (!collector || !buffer || buffer_size == 0 || !written_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    buffer_sink_t sink = { buffer, buffer_size, 0 };
+    prts_result_t result = prts_metrics_export(collector, PRTS_EXPORT_PROMETHEUS,
+                                               buffer_write, &sink);
+    buffer[sink.offset] = '\0';
+    *written_out = sink.offset;
+
+    return result;
+}
+
+prts_result_t prts_metrics_sketch_merge(
+    prts_metrics_collector_t* collector,
+    const char* name,
+    const char** label_values,
+    prts_sketch_t* sketch_out
+) {
+    if (!collector || !name || !sketch_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    collector_read_lock(collector);
+
+    metric_entry_t* m = find_metric(collector, name);
+    if (!m || m->type != PRTS_METRIC_SKETCH ||
+        (label_values && !labels_valid(m, label_values))) {
+        collector_read_unlock(collector);
+        return PRTS_ERROR_INVALID;
+    }
+
+    /* NULL label values select every series of the metric */
+    prts_result_t result = PRTS_OK;
+    for (size_t i = 0; i < m->series_capacity && result == PRTS_OK; i++) {
+        metric_series_t* s = m->series[i];
+        if (!s || (label_values && !labels_equal(s, label_values, m->num_labels))) {
+            continue;
+        }
+
+        sketch_lock(s);
+        result = prts_sketch_merge(sketch_out, s->sketch);
+        sketch_unlock(s);
+    }
+
+    collector_read_unlock(collector);
+
+    return result;
+}
+
+prts_result_t prts_histogram_linear_buckets(
+    double start,
+    double width,
+    size_t count,
+    double* boundaries_out
+) {
+    if (!boundaries_out || count == 0 || !(width > 0)) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        boundaries_out[i] = start + width * (double)i;
+    }
+    return boundaries_valid(boundaries_out, count) ? PRTS_OK : PRTS_ERROR_INVALID;
+}
+
+prts_result_t prts_histogram_exponential_buckets(
+    double start,
+    double factor,
+    size_t count,
+    double* boundaries_out
+) {
+    if (!boundaries_out || count == 0 || !(start > 0) || !(factor > 1)) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    double bound = start;
+    for (size_t i = 0; i < count; i++) {
+        boundaries_out[i] = bound;
+        bound *= factor;
+    }
+    return boundaries_valid(boundaries_out, count) ? PRTS_OK : PRTS_ERROR_INVALID;
+}
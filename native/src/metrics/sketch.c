@@ -0,0 +1,316 @@
+/**
+ * PRTS Native - Quantile Sketch
+ * Relative-error quantile sketch (DDSketch) with bounded memory.
+ */
+
+#include "prts/metrics.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#define DEFAULT_RELATIVE_ACCURACY 0.01
+#define DEFAULT_MAX_BINS 2048
+
+/* Values at or below this are counted in the zero bin */
+#define MIN_INDEXABLE_VALUE 1e-9
+
+/*
+ * Bins cover logarithmic ranges (gamma^(i-1), gamma^i]. When the index
+ * range would exceed max_bins, the lowest bins are collapsed into one,
+ * which keeps the error bound for the upper quantiles we care about.
+ */
+struct prts_sketch {
+    double relative_accuracy;
+    double gamma;
+    double log_gamma;
+    size_t max_bins;
+
+    uint64_t* bins;
+    int32_t offset;         /* Index of bins[0] */
+    size_t num_bins;
+
+    uint64_t zero_count;
+    uint64_t count;
+    double sum;
+    double min;
+    double max;
+};
+
+prts_result_t prts_sketch_create(
+    double relative_accuracy,
+    size_t max_bins,
+    prts_sketch_t** sketch_out
+) {
+    if (!sketch_out) {
+        return PRTS_ERROR_INVALID;
+    }
+    if (relative_accuracy == 0) {
+        relative_accuracy = DEFAULT_RELATIVE_ACCURACY;
+    }
+    if (!(relative_accuracy > 0 && relative_accuracy < 1)) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    prts_sketch_t* sketch = calloc(1, sizeof(prts_sketch_t));
+    if (!sketch) {
+        return PRTS_ERROR_NOMEM;
+    }
+
+    sketch->relative_accuracy = relative_accuracy;
+    sketch->gamma = (1 + relative_accuracy) / (1 - relative_accuracy);
+    sketch->log_gamma = log(sketch->gamma);
+    sketch->max_bins = max_bins > 0 ? max_bins : DEFAULT_MAX_BINS;
+
+    /* Every finite value must have an int32 bin index */
+    if (log(DBL_MAX) / sketch->log_gamma >= INT32_MAX) {
+        free(sketch);
+        return PRTS_ERROR_INVALID;
+    }
+
+    *sketch_out = sketch;
+    return PRTS_OK;
+}
+
+void prts_sketch_destroy(prts_sketch_t* sketch) {
+    if (!sketch) return;
+    free(sketch->bins);
+    free(sketch);
+}
+
+void prts_sketch_clear(prts_sketch_t* sketch) {
+    if (!sketch) return;
+    free(sketch->bins);
+    sketch->bins = NULL;
+    sketch->offset = 0;
+    sketch->num_bins = 0;
+    sketch->zero_count = 0;
+    sketch->count = 0;
+    sketch->sum = 0;
+    sketch->min = 0;
+    sketch->max = 0;
+}
+
+static int32_t sketch_index(const prts_sketch_t* sketch, double value) {
+    return (int32_t)ceil(log(value) / sketch->log_gamma);
+}
+
+static double sketch_value(const prts_sketch_t* sketch, int32_t index) {
+    return 2.0 * exp(index * sketch->log_gamma) / (sketch->gamma + 1);
+}
+
+/*
+ * Make the bin range cover [lo, hi], collapsing the lowest bins if the
+ * range would exceed max_bins.
+ */
+static prts_result_t sketch_extend(prts_sketch_t* sketch, int32_t lo, int32_t hi) {
+    if (sketch->num_bins > 0) {
+        int32_t cur_hi = sketch->offset + (int32_t)sketch->num_bins - 1;
+        if (lo >= sketch->offset && hi <= cur_hi) {
+            return PRTS_OK;
+        }
+        if (sketch->offset < lo) lo = sketch->offset;
+        if (cur_hi > hi) hi = cur_hi;
+    }
+
+    if ((size_t)((int64_t)hi - lo + 1) > sketch->max_bins) {
+        lo = hi - (int32_t)sketch->max_bins + 1;
+    }
+
+    /* A collapsed sketch already covers the clamped range; callers fold into bin 0 */
+    if (sketch->num_bins > 0 && lo == sketch->offset &&
+        hi == sketch->offset + (int32_t)sketch->num_bins - 1) {
+        return PRTS_OK;
+    }
+
+    size_t num_bins = (size_t)(hi - lo + 1);
+    uint64_t* bins = calloc(num_bins, sizeof(uint64_t));
+    if (!bins) {
+        return PRTS_ERROR_NOMEM;
+    }
+
+    for (size_t i = 0; i < sketch->num_bins; i++) {
+        int32_t index = sketch->offset + (int32_t)i;
+        bins[(index < lo ? lo : index) - lo] += sketch->bins[i];
+    }
+
+    free(sketch->bins);
+    sketch->bins = bins;
+    sketch->offset = lo;
+    sketch->num_bins = num_bins;
+    return PRTS_OK;
+}
+
+static void sketch_track(prts_sketch_t* sketch, uint64_t count, double sum, double min, double max) {
+    if (sketch->count == 0) {
+        sketch->min = min;
+        sketch->max = max;
+    } else {
+        if (min < sketch->min) sketch->min = min;
+        if (max > sketch->max) sketch->max = max;
+    }
+    sketch->count += count;
+    sketch->sum += sum;
+}
+
+prts_result_t prts_sketch_add(prts_sketch_t* sketch, double value) {
+    if (!sketch || !isfinite(value)) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    if (value <= MIN_INDEXABLE_VALUE) {
+        sketch->zero_count++;
+    } else {
+        int32_t index = sketch_index(sketch, value);
+        if (sketch_extend(sketch, index, index) != PRTS_OK) {
+            return PRTS_ERROR_NOMEM;
+        }
+        if (index < sketch->offset) {
+            index = sketch->offset;
+        }
+        sketch->bins[index - sketch->offset]++;
+    }
+
+    sketch_track(sketch, 1, value, value, value);
+    return PRTS_OK;
+}
+
+prts_result_t prts_sketch_merge(prts_sketch_t* sketch, const prts_sketch_t* other) {
+    if (!sketch || !other || sketch->gamma != other->gamma) {
+        return PRTS_ERROR_INVALID;
+    }
+    if (other->count == 0) {
+        return PRTS_OK;
+    }
+
+    if (other->num_bins > 0) {
+        int32_t lo = other->offset;
+        int32_t hi = other->offset + (int32_t)other->num_bins - 1;
+        if (sketch_extend(sketch, lo, hi) != PRTS_OK) {
+            return PRTS_ERROR_NOMEM;
+        }
+        for (size_t i = 0; i < other->num_bins; i++) {
+            int32_t index = other->offset + (int32_t)i;
+            if (index < sketch->offset) {
+                index = sketch->offset;
+            }
+            sketch->bins[index - sketch->offset] += other->bins[i];
+        }
+    }
+
+    sketch->zero_count += other->zero_count;
+    sketch_track(sketch, other->count, other->sum, other->min, other->max);
+    return PRTS_OK;
+}
+
+prts_result_t prts_sketch_subtract(prts_sketch_t* sketch, const prts_sketch_t* earlier) {
+    if (!sketch || !earlier || sketch->gamma != earlier->gamma ||
+        earlier->count > sketch->count || earlier->zero_count > sketch->zero_count) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    /* Check every bin first so a mismatch leaves the sketch untouched */
+    int32_t hi = sketch->offset + (int32_t)sketch->num_bins - 1;
+    uint64_t folded = 0;            /* Earlier counts collapsed into bins[0] since */
+    for (size_t i = 0; i < earlier->num_bins; i++) {
+        int32_t index = earlier->offset + (int32_t)i;
+        if (earlier->bins[i] == 0) {
+            continue;
+        }
+        if (sketch->num_bins == 0 || index > hi) {
+            return PRTS_ERROR_INVALID;
+        }
+        if (index <= sketch->offset) {
+            folded += earlier->bins[i];
+        } else if (sketch->bins[index - sketch->offset] < earlier->bins[i]) {
+            return PRTS_ERROR_INVALID;
+        }
+    }
+    if (folded > 0 && sketch->bins[0] < folded) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    for (size_t i = 0; i < earlier->num_bins; i++) {
+        int32_t index = earlier->offset + (int32_t)i;
+        if (earlier->bins[i] > 0 && index > sketch->offset) {
+            sketch->bins[index - sketch->offset] -= earlier->bins[i];
+        }
+    }
+    if (folded > 0) {
+        sketch->bins[0] -= folded;
+    }
+    sketch->zero_count -= earlier->zero_count;
+    sketch->count -= earlier->count;
+    sketch->sum -= earlier->sum;
+
+    if (sketch->count == 0) {
+        prts_sketch_clear(sketch);
+        return PRTS_OK;
+    }
+
+    /* Trim the emptied ends so the difference only holds its own range */
+    size_t lo = 0;
+    size_t n = sketch->num_bins;
+    while (lo < n && sketch->bins[lo] == 0) lo++;
+    while (n > lo && sketch->bins[n - 1] == 0) n--;
+    if (lo == n) {
+        free(sketch->bins);
+        sketch->bins = NULL;
+        sketch->offset = 0;
+        sketch->num_bins = 0;
+    } else if (lo > 0 || n < sketch->num_bins) {
+        memmove(sketch->bins, sketch->bins + lo, (n - lo) * sizeof(uint64_t));
+        uint64_t* bins = realloc(sketch->bins, (n - lo) * sizeof(uint64_t));
+        if (bins) {
+            sketch->bins = bins;
+        }
+        sketch->offset += (int32_t)lo;
+        sketch->num_bins = n - lo;
+    }
+
+    return PRTS_OK;
+}
+
+prts_result_t prts_sketch_quantile(const prts_sketch_t* sketch, double q, double* value_out) {
+    if (!sketch || !value_out || !(q >= 0 && q <= 1)) {
+        return PRTS_ERROR_INVALID;
+    }
+    if (sketch->count == 0) {
+        return PRTS_ERROR_EMPTY;
+    }
+
+    double rank = q * (double)(sketch->count - 1);
+    double value = sketch->max;
+
+    uint64_t cumulative = sketch->zero_count;
+    if ((double)cumulative > rank) {
+        value = 0;
+    } else {
+        for (size_t i = 0; i < sketch->num_bins; i++) {
+            cumulative += sketch->bins[i];
+            if ((double)cumulative > rank) {
+                value = sketch_value(sketch, sketch->offset + (int32_t)i);
+                break;
+            }
+        }
+    }
+
+    /* The extremes are tracked exactly, or bound a difference */
+    if (value < sketch->min) value = sketch->min;
+    if (value > sketch->max) value = sketch->max;
+
+    *value_out = value;
+    return PRTS_OK;
+}
+
+uint64_t prts_sketch_count(const prts_sketch_t* sketch) {
+    return sketch ? sketch->count : 0;
+}
+
+double prts_sketch_sum(const prts_sketch_t* sketch) {
+    return sketch ? sketch->sum : 0.0;
+}
+
+double prts_sketch_relative_accuracy(const prts_sketch_t* sketch) {
+    return sketch ? sketch->relative_accuracy : 0.0;
+}
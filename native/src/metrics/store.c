@@ -0,0 +1,1100 @@
+/**
+ * PRTS Native - Metrics Series Store
+ * Compressed in-memory metric history (Gorilla encoding).
+ */
+
+#include "prts/metrics.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define DEFAULT_INTERVAL (10ULL * 1000000000ULL)
+#define DEFAULT_RETENTION (24ULL * 3600ULL * 1000000000ULL)
+#define DEFAULT_CHUNK_BYTES 512
+
+/* Chunks must hold at least a first sample plus one worst-case sample */
+#define MIN_CHUNK_BYTES 64
+
+#define NS_PER_MS 1000000ULL
+
+/* Default rollup tiers, finest first */
+#define DEFAULT_NUM_TIERS 2
+static const prts_rollup_tier_t default_tiers[DEFAULT_NUM_TIERS] = {
+    { 60ULL * 1000000000ULL, 7ULL * 24 * 3600 * 1000000000ULL },
+    { 3600ULL * 1000000000ULL, 90ULL * 24 * 3600 * 1000000000ULL },
+};
+
+/* Rollup chunks hold a few hundred points each */
+#define ROLLUP_CHUNK_BYTES 1024
+
+/* Initial series table size (power of two) */
+#define INITIAL_TABLE_CAPACITY 64
+
+/*
+ * Worst-case encoded sample: a 5-bit timestamp prefix with a 64-bit
+ * delta-of-delta, and a 2-bit value prefix with 5 + 6 bits of header
+ * and 64 meaningful bits.
+ */
+#define MAX_SAMPLE_BITS (5 + 64 + 2 + 5 + 6 + 64)
+
+/* Worst-case encoded rollup point: timestamp and count deltas, three values */
+#define MAX_ROLLUP_BITS (2 * (5 + 64) + 3 * (2 + 5 + 6 + 64))
+
+/*
+ * Samples in a chunk are one bit stream. The first sample is stored
+ * raw; each later timestamp is the delta-of-delta of milliseconds in a
+ * variable-width bucket, and each value is XORed with the previous one
+ * so unchanged or slowly changing values take a handful of bits.
+ */
+typedef struct {
+    uint64_t first_ms;
+    uint64_t last_ms;
+    uint32_t count;
+    size_t bits;
+    size_t capacity_bits;
+    uint8_t data[];
+} store_chunk_t;
+
+/* Chunks oldest first; the last chunk is open while head is set */
+typedef struct {
+    store_chunk_t** chunks;
+    size_t num_chunks;
+    size_t chunks_capacity;
+    store_chunk_t* head;
+} chunk_list_t;
+
+/* XOR value coder state: the previous value and its meaningful-bit window */
+typedef struct {
+    uint64_t bits;
+    unsigned leading;
+    unsigned trailing;
+} xor_state_t;
+
+/*
+ * Completed buckets of one tier, compressed like samples: a rollup chunk
+ * stores each bucket start as a delta-of-delta, the count as a delta and
+ * min/max/sum as three XOR-coded value streams.
+ */
+typedef struct {
+    chunk_list_t points;
+    prts_rollup_point_t open;       /* Bucket being filled, count == 0 when empty */
+    uint64_t folded_ms;             /* Samples up to and including this are added */
+
+    /* Encoder state of the open rollup chunk */
+    uint64_t prev_ms;
+    int64_t prev_delta;
+    uint64_t prev_count;
+    xor_state_t prev_min;
+    xor_state_t prev_max;
+    xor_state_t prev_sum;
+} rollup_tier_t;
+
+typedef struct {
+    uint64_t key;
+
+    /* Sealed chunks are always folded into every tier */
+    rollup_tier_t tiers[PRTS_STORE_MAX_TIERS];
+
+    chunk_list_t raw;
+
+    /* Encoder state of the open chunk */
+    uint64_t prev_ms;
+    int64_t prev_delta;
+    xor_state_t prev_value;
+} store_series_t;
+
+struct prts_series_store {
+    prts_metrics_collector_t* collector;
+    prts_timestamp_t interval;
+    prts_timestamp_t retention;
+    size_t chunk_bytes;
+    prts_timestamp_t last_sample;
+
+    prts_rollup_tier_t tiers[PRTS_STORE_MAX_TIERS];
+    size_t num_tiers;
+
+    /* Open-addressed series table keyed by series key */
+    store_series_t** table;
+    size_t table_capacity;
+    size_t num_series;
+
+#ifdef _WIN32
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+};
+
+static void store_lock(prts_series_store_t* store) {
+#ifdef _WIN32
+    EnterCriticalSection(&store->lock);
+#else
+    pthread_mutex_lock(&store->lock);
+#endif
+}
+
+static void store_unlock(prts_series_store_t* store) {
+#ifdef _WIN32
+    LeaveCriticalSection(&store->lock);
+#else
+    pthread_mutex_unlock(&store->lock);
+#endif
+}
+
+static uint64_t double_to_bits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double bits_to_double(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static unsigned leading_zeros(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return x ? (unsigned)__builtin_clzll(x) : 64;
+#else
+    unsigned n = 0;
+    for (uint64_t bit = 1ULL << 63; bit && !(x & bit); bit >>= 1) n++;
+    return n;
+#endif
+}
+
+static unsigned trailing_zeros(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return x ? (unsigned)__builtin_ctzll(x) : 64;
+#else
+    unsigned n = 0;
+    for (uint64_t bit = 1; bit && !(x & bit); bit <<= 1) n++;
+    return n;
+#endif
+}
+
+/* Append the low n bits of value, most significant first; data is zeroed */
+static void put_bits(store_chunk_t* chunk, uint64_t value, unsigned n) {
+    while (n > 0) {
+        unsigned room = 8 - (unsigned)(chunk->bits & 7);
+        unsigned take = n < room ? n : room;
+        uint8_t part = (uint8_t)((value >> (n - take)) & ((1u << take) - 1));
+        chunk->data[chunk->bits >> 3] |= (uint8_t)(part << (room - take));
+        chunk->bits += take;
+        n -= take;
+    }
+}
+
+static uint64_t get_bits(const uint8_t* data, size_t* pos, unsigned n) {
+    uint64_t value = 0;
+    while (n > 0) {
+        unsigned room = 8 - (unsigned)(*pos & 7);
+        unsigned take = n < room ? n : room;
+        uint8_t byte = data[*pos >> 3];
+        value = (value << take) | ((byte >> (room - take)) & ((1u << take) - 1));
+        *pos += take;
+        n -= take;
+    }
+    return value;
+}
+
+/*
+ * Signed integers (timestamp delta-of-deltas, count deltas) in
+ * variable-width buckets: prefix, payload bits, bias.
+ */
+static void put_signed(store_chunk_t* chunk, int64_t dod) {
+    if (dod == 0) {
+        put_bits(chunk, 0x0, 1);
+    } else if (dod >= -63 && dod <= 64) {
+        put_bits(chunk, 0x2, 2);
+        put_bits(chunk, (uint64_t)(dod + 63), 7);
+    } else if (dod >= -255 && dod <= 256) {
+        put_bits(chunk, 0x6, 3);
+        put_bits(chunk, (uint64_t)(dod + 255), 9);
+    } else if (dod >= -2047 && dod <= 2048) {
+        put_bits(chunk, 0xE, 4);
+        put_bits(chunk, (uint64_t)(dod + 2047), 12);
+    } else if (dod >= INT32_MIN && dod <= INT32_MAX) {
+        put_bits(chunk, 0x1E, 5);
+        put_bits(chunk, (uint64_t)(uint32_t)(int32_t)dod, 32);
+    } else {
+        put_bits(chunk, 0x1F, 5);
+        put_bits(chunk, (uint64_t)dod, 64);
+    }
+}
+
+static int64_t get_signed(const uint8_t* data, size_t* pos) {
+    if (get_bits(data, pos, 1) == 0) return 0;
+    if (get_bits(data, pos, 1) == 0) return (int64_t)get_bits(data, pos, 7) - 63;
+    if (get_bits(data, pos, 1) == 0) return (int64_t)get_bits(data, pos, 9) - 255;
+    if (get_bits(data, pos, 1) == 0) return (int64_t)get_bits(data, pos, 12) - 2047;
+    if (get_bits(data, pos, 1) == 0) return (int32_t)(uint32_t)get_bits(data, pos, 32);
+    return (int64_t)get_bits(data, pos, 64);
+}
+
+/*
+ * Values: '0' repeats the previous value; '10' reuses the previous
+ * leading/trailing zero window; '11' sends a new window as 5 bits of
+ * leading zeros and 6 bits of length - 1.
+ */
+static void put_value(store_chunk_t* chunk, xor_state_t* prev, uint64_t bits) {
+    uint64_t x = bits ^ prev->bits;
+    prev->bits = bits;
+
+    if (x == 0) {
+        put_bits(chunk, 0x0, 1);
+        return;
+    }
+
+    unsigned leading = leading_zeros(x);
+    unsigned trailing = trailing_zeros(x);
+    if (leading > 31) {
+        leading = 31;
+    }
+
+    if (prev->leading + prev->trailing < 64 &&
+        leading >= prev->leading && trailing >= prev->trailing) {
+        put_bits(chunk, 0x2, 2);
+        put_bits(chunk, x >> prev->trailing, 64 - prev->leading - prev->trailing);
+    } else {
+        unsigned length = 64 - leading - trailing;
+        put_bits(chunk, 0x3, 2);
+        put_bits(chunk, leading, 5);
+        put_bits(chunk, length - 1, 6);
+        put_bits(chunk, x >> trailing, length);
+        prev->leading = leading;
+        prev->trailing = trailing;
+    }
+}
+
+/* Start a value stream whose first value is stored raw */
+static void put_first_value(store_chunk_t* chunk, xor_state_t* prev, uint64_t bits) {
+    put_bits(chunk, bits, 64);
+    prev->bits = bits;
+    prev->leading = 64;
+    prev->trailing = 0;
+}
+
+static uint64_t get_value(const uint8_t* data, size_t* pos, xor_state_t* prev) {
+    if (get_bits(data, pos, 1) != 0) {
+        if (get_bits(data, pos, 1) != 0) {
+            prev->leading = (unsigned)get_bits(data, pos, 5);
+            unsigned length = (unsigned)get_bits(data, pos, 6) + 1;
+            prev->trailing = 64 - prev->leading - length;
+        }
+        unsigned length = 64 - prev->leading - prev->trailing;
+        prev->bits ^= get_bits(data, pos, length) << prev->trailing;
+    }
+    return prev->bits;
+}
+
+static uint64_t get_first_value(const uint8_t* data, size_t* pos, xor_state_t* prev) {
+    prev->bits = get_bits(data, pos, 64);
+    prev->leading = 64;
+    prev->trailing = 0;
+    return prev->bits;
+}
+
+/* Decoder state for one chunk */
+typedef struct {
+    const store_chunk_t* chunk;
+    size_t pos;
+    uint32_t index;
+    uint64_t ms;
+    int64_t delta;
+    xor_state_t value;
+} chunk_reader_t;
+
+static void reader_init(chunk_reader_t* r, const store_chunk_t* chunk) {
+    memset(r, 0, sizeof(*r));
+    r->chunk = chunk;
+}
+
+static bool reader_next(chunk_reader_t* r, prts_sample_t* sample_out) {
+    const uint8_t* data = r->chunk->data;
+    if (r->index >= r->chunk->count) {
+        return false;
+    }
+
+    uint64_t bits;
+    if (r->index == 0) {
+        r->ms = get_bits(data, &r->pos, 64);
+        bits = get_first_value(data, &r->pos, &r->value);
+    } else {
+        r->delta += get_signed(data, &r->pos);
+        r->ms += (uint64_t)r->delta;
+        bits = get_value(data, &r->pos, &r->value);
+    }
+
+    r->index++;
+    sample_out->timestamp = r->ms * NS_PER_MS;
+    sample_out->value = bits_to_double(bits);
+    return true;
+}
+
+/* Decoder state for one rollup chunk */
+typedef struct {
+    const store_chunk_t* chunk;
+    size_t pos;
+    uint32_t index;
+    uint64_t ms;
+    int64_t delta;
+    uint64_t count;
+    xor_state_t min;
+    xor_state_t max;
+    xor_state_t sum;
+} rollup_reader_t;
+
+static void rollup_reader_init(rollup_reader_t* r, const store_chunk_t* chunk) {
+    memset(r, 0, sizeof(*r));
+    r->chunk = chunk;
+}
+
+static bool rollup_reader_next(rollup_reader_t* r, prts_rollup_point_t* point_out) {
+    const uint8_t* data = r->chunk->data;
+    if (r->index >= r->chunk->count) {
+        return false;
+    }
+
+    if (r->index == 0) {
+        r->ms = get_bits(data, &r->pos, 64);
+        r->count = get_bits(data, &r->pos, 64);
+        point_out->min = bits_to_double(get_first_value(data, &r->pos, &r->min));
+        point_out->max = bits_to_double(get_first_value(data, &r->pos, &r->max));
+        point_out->sum = bits_to_double(get_first_value(data, &r->pos, &r->sum));
+    } else {
+        r->delta += get_signed(data, &r->pos);
+        r->ms += (uint64_t)r->delta;
+        r->count += (uint64_t)get_signed(data, &r->pos);
+        point_out->min = bits_to_double(get_value(data, &r->pos, &r->min));
+        point_out->max = bits_to_double(get_value(data, &r->pos, &r->max));
+        point_out->sum = bits_to_double(get_value(data, &r->pos, &r->sum));
+    }
+
+    r->index++;
+    point_out->timestamp = r->ms * NS_PER_MS;
+    point_out->count = r->count;
+    return true;
+}
+
+static void chunk_list_free(chunk_list_t* list) {
+    for (size_t i = 0; i < list->num_chunks; i++) {
+        free(list->chunks[i]);
+    }
+    free(list->chunks);
+}
+
+/* Append a new empty chunk and make it the open head */
+static prts_result_t chunk_list_open(chunk_list_t* list, size_t bytes) {
+    if (list->num_chunks == list->chunks_capacity) {
+        size_t capacity = list->chunks_capacity ? list->chunks_capacity * 2 : 8;
+        store_chunk_t** chunks = realloc(list->chunks, capacity * sizeof(store_chunk_t*));
+        if (!chunks) {
+            return PRTS_ERROR_NOMEM;
+        }
+        list->chunks = chunks;
+        list->chunks_capacity = capacity;
+    }
+
+    store_chunk_t* chunk = calloc(1, sizeof(store_chunk_t) + bytes);
+    if (!chunk) {
+        return PRTS_ERROR_NOMEM;
+    }
+    chunk->capacity_bits = bytes * 8;
+    list->chunks[list->num_chunks++] = chunk;
+    list->head = chunk;
+    return PRTS_OK;
+}
+
+/* Shrink the open chunk to its used size and stop appending to it */
+static void chunk_list_seal(chunk_list_t* list) {
+    if (!list->head) return;
+
+    size_t used = (list->head->bits + 7) / 8;
+    store_chunk_t* sealed = realloc(list->head, sizeof(store_chunk_t) + used);
+    if (sealed) {
+        sealed->capacity_bits = used * 8;
+        list->chunks[list->num_chunks - 1] = sealed;
+    }
+    list->head = NULL;
+}
+
+/* Free the oldest n chunks */
+static void chunk_list_drop(chunk_list_t* list, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (list->chunks[i] == list->head) {
+            list->head = NULL;
+        }
+        free(list->chunks[i]);
+    }
+    list->num_chunks -= n;
+    memmove(list->chunks, list->chunks + n, list->num_chunks * sizeof(store_chunk_t*));
+}
+
+static void series_free(store_series_t* s) {
+    if (!s) return;
+    chunk_list_free(&s->raw);
+    for (size_t t = 0; t < PRTS_STORE_MAX_TIERS; t++) {
+        chunk_list_free(&s->tiers[t].points);
+    }
+    free(s);
+}
+
+static void point_add(prts_rollup_point_t* point, const prts_rollup_point_t* other) {
+    if (point->count == 0) {
+        *point = *other;
+        return;
+    }
+    if (other->min < point->min) point->min = other->min;
+    if (other->max > point->max) point->max = other->max;
+    point->sum += other->sum;
+    point->count += other->count;
+}
+
+/* Encode the open bucket as the tier's newest completed point */
+static prts_result_t tier_push(rollup_tier_t* tier) {
+    chunk_list_t* list = &tier->points;
+    const prts_rollup_point_t* point = &tier->open;
+    uint64_t ms = point->timestamp / NS_PER_MS;
+
+    if (list->head && list->head->capacity_bits - list->head->bits < MAX_ROLLUP_BITS) {
+        chunk_list_seal(list);
+    }
+
+    if (!list->head) {
+        prts_result_t result = chunk_list_open(list, ROLLUP_CHUNK_BYTES);
+        if (result != PRTS_OK) {
+            return result;
+        }
+
+        put_bits(list->head, ms, 64);
+        put_bits(list->head, point->count, 64);
+        put_first_value(list->head, &tier->prev_min, double_to_bits(point->min));
+        put_first_value(list->head, &tier->prev_max, double_to_bits(point->max));
+        put_first_value(list->head, &tier->prev_sum, double_to_bits(point->sum));
+        list->head->first_ms = ms;
+        tier->prev_delta = 0;
+    } else {
+        int64_t delta = (int64_t)(ms - tier->prev_ms);
+        put_signed(list->head, delta - tier->prev_delta);
+        put_signed(list->head, (int64_t)(point->count - tier->prev_count));
+        put_value(list->head, &tier->prev_min, double_to_bits(point->min));
+        put_value(list->head, &tier->prev_max, double_to_bits(point->max));
+        put_value(list->head, &tier->prev_sum, double_to_bits(point->sum));
+        tier->prev_delta = delta;
+    }
+
+    list->head->last_ms = ms;
+    list->head->count++;
+    tier->prev_ms = ms;
+    tier->prev_count = point->count;
+    tier->open.count = 0;
+    return PRTS_OK;
+}
+
+static prts_result_t tier_add(rollup_tier_t* tier, prts_timestamp_t width, const prts_sample_t* sample) {
+    prts_rollup_point_t point = {
+        sample->timestamp - sample->timestamp % width,
+        sample->value, sample->value, sample->value, 1
+    };
+
+    if (tier->open.count > 0 && tier->open.timestamp != point.timestamp) {
+        prts_result_t result = tier_push(tier);
+        if (result != PRTS_OK) {
+            return result;
+        }
+    }
+    point_add(&tier->open, &point);
+    return PRTS_OK;
+}
+
+/*
+ * Roll the samples of a chunk up into every tier. Each tier records how
+ * far it got, so a fold interrupted by NOMEM resumes without counting a
+ * sample twice.
+ */
+static prts_result_t fold_chunk(
+    const prts_series_store_t* store,
+    store_series_t* s,
+    const store_chunk_t* chunk
+) {
+    for (size_t t = 0; t < store->num_tiers; t++) {
+        rollup_tier_t* tier = &s->tiers[t];
+        if (chunk->last_ms <= tier->folded_ms) continue;
+
+        chunk_reader_t reader;
+        reader_init(&reader, chunk);
+        prts_sample_t sample;
+        while (reader_next(&reader, &sample)) {
+            uint64_t ms = sample.timestamp / NS_PER_MS;
+            if (ms <= tier->folded_ms) continue;
+            if (sample.value == sample.value) {         /* Skip NaN */
+                prts_result_t result = tier_add(tier, store->tiers[t].width, &sample);
+                if (result != PRTS_OK) {
+                    return result;
+                }
+            }
+            tier->folded_ms = ms;
+        }
+    }
+    return PRTS_OK;
+}
+
+/* Fold the open chunk into the tiers, then shrink it and stop appending */
+static prts_result_t seal_head(const prts_series_store_t* store, store_series_t* s) {
+    if (!s->raw.head) {
+        return PRTS_OK;
+    }
+
+    prts_result_t result = fold_chunk(store, s, s->raw.head);
+    if (result != PRTS_OK) {
+        return result;
+    }
+    chunk_list_seal(&s->raw);
+    return PRTS_OK;
+}
+
+static store_series_t** find_slot(const prts_series_store_t* store, uint64_t key) {
+    size_t mask = store->table_capacity - 1;
+    size_t slot = key & mask;
+    while (store->table[slot] && store->table[slot]->key != key) {
+        slot = (slot + 1) & mask;
+    }
+    return &store->table[slot];
+}
+
+/* Rehash the live series into a table of the given capacity */
+static prts_result_t rebuild_table(prts_series_store_t* store, size_t capacity) {
+    store_series_t** old_table = store->table;
+    size_t old_capacity = store->table_capacity;
+
+    store->table = calloc(capacity, sizeof(store_series_t*));
+    if (!store->table) {
+        store->table = old_table;
+        return PRTS_ERROR_NOMEM;
+    }
+    store->table_capacity = capacity;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_table[i]) {
+            *find_slot(store, old_table[i]->key) = old_table[i];
+        }
+    }
+    free(old_table);
+
+    return PRTS_OK;
+}
+
+static store_series_t* get_series(prts_series_store_t* store, uint64_t key) {
+    /* Keep the load factor below 3/4 */
+    if ((store->num_series + 1) * 4 > store->table_capacity * 3 &&
+        rebuild_table(store, store->table_capacity * 2) != PRTS_OK) {
+        return NULL;
+    }
+
+    store_series_t** slot = find_slot(store, key);
+    if (!*slot) {
+        *slot = calloc(1, sizeof(store_series_t));
+        if (!*slot) {
+            return NULL;
+        }
+        (*slot)->key = key;
+        store->num_series++;
+    }
+    return *slot;
+}
+
+static prts_result_t append_sample(
+    prts_series_store_t* store,
+    store_series_t* s,
+    prts_timestamp_t timestamp,
+    double value
+) {
+    uint64_t ms = timestamp / NS_PER_MS;
+    if (s->raw.num_chunks > 0 && ms <= s->prev_ms) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    store_chunk_t* head = s->raw.head;
+    if (head && head->capacity_bits - head->bits < MAX_SAMPLE_BITS) {
+        /* A full head that cannot be folded yet stays open for a retry */
+        prts_result_t result = seal_head(store, s);
+        if (result != PRTS_OK) {
+            return result;
+        }
+    }
+
+    uint64_t bits = double_to_bits(value);
+    if (!s->raw.head) {
+        prts_result_t result = chunk_list_open(&s->raw, store->chunk_bytes);
+        if (result != PRTS_OK) {
+            return result;
+        }
+
+        put_bits(s->raw.head, ms, 64);
+        put_first_value(s->raw.head, &s->prev_value, bits);
+        s->raw.head->first_ms = ms;
+        s->prev_delta = 0;
+    } else {
+        int64_t delta = (int64_t)(ms - s->prev_ms);
+        put_signed(s->raw.head, delta - s->prev_delta);
+        put_value(s->raw.head, &s->prev_value, bits);
+        s->prev_delta = delta;
+    }
+
+    s->raw.head->last_ms = ms;
+    s->raw.head->count++;
+    s->prev_ms = ms;
+    return PRTS_OK;
+}
+
+/* Enabled rollup tiers must be whole milliseconds wide and get wider */
+static prts_result_t configure_tiers(
+    prts_series_store_t* store,
+    const prts_rollup_tier_t* tiers,
+    size_t num_tiers
+) {
+    if (!tiers) {
+        if (num_tiers > 0) {
+            return PRTS_ERROR_INVALID;
+        }
+        tiers = default_tiers;
+        num_tiers = DEFAULT_NUM_TIERS;
+    }
+
+    store->num_tiers = 0;
+    for (size_t i = 0; i < num_tiers; i++) {
+        if (tiers[i].retention == 0) continue;
+        if (store->num_tiers == PRTS_STORE_MAX_TIERS ||
+            tiers[i].width < NS_PER_MS || tiers[i].width % NS_PER_MS != 0 ||
+            (store->num_tiers > 0 &&
+             tiers[i].width <= store->tiers[store->num_tiers - 1].width)) {
+            return PRTS_ERROR_INVALID;
+        }
+        store->tiers[store->num_tiers++] = tiers[i];
+    }
+    return PRTS_OK;
+}
+
+prts_result_t prts_series_store_create(
+    prts_metrics_collector_t* collector,
+    const prts_store_config_t* config,
+    prts_series_store_t** store_out
+) {
+    if (!collector || !store_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    prts_series_store_t* store = calloc(1, sizeof(prts_series_store_t));
+    if (!store) {
+        return PRTS_ERROR_NOMEM;
+    }
+
+    store->collector = collector;
+    store->interval = config && config->interval > 0 ? config->interval : DEFAULT_INTERVAL;
+    store->retention = config && config->retention > 0 ? config->retention : DEFAULT_RETENTION;
+    store->chunk_bytes = config && config->chunk_bytes > 0 ? config->chunk_bytes
+                                                           : DEFAULT_CHUNK_BYTES;
+    if (store->chunk_bytes < MIN_CHUNK_BYTES ||
+        configure_tiers(store, config ? config->rollup_tiers : NULL,
+                        config ? config->num_rollup_tiers : 0) != PRTS_OK) {
+        free(store);
+        return PRTS_ERROR_INVALID;
+    }
+
+    store->table_capacity = INITIAL_TABLE_CAPACITY;
+    store->table = calloc(store->table_capacity, sizeof(store_series_t*));
+    if (!store->table) {
+        free(store);
+        return PRTS_ERROR_NOMEM;
+    }
+
+#ifdef _WIN32
+    InitializeCriticalSection(&store->lock);
+#else
+    pthread_mutex_init(&store->lock, NULL);
+#endif
+
+    *store_out = store;
+    return PRTS_OK;
+}
+
+void prts_series_store_destroy(prts_series_store_t* store) {
+    if (!store) return;
+
+    for (size_t i = 0; i < store->table_capacity; i++) {
+        series_free(store->table[i]);
+    }
+    free(store->table);
+
+#ifdef _WIN32
+    DeleteCriticalSection(&store->lock);
+#else
+    pthread_mutex_destroy(&store->lock);
+#endif
+
+    free(store);
+}
+
+typedef struct {
+    prts_series_store_t* store;
+    prts_timestamp_t now;
+    prts_result_t result;
+} sample_context_t;
+
+static void store_sample(const prts_metric_sample_t* sample, void* ctx) {
+    sample_context_t* sc = ctx;
+
+    double value = 0.0;
+    switch (sample->type) {
+        case PRTS_METRIC_COUNTER:
+            value = (double)sample->value.value.counter;
+            break;
+        case PRTS_METRIC_GAUGE:
+            value = sample->value.value.gauge;
+            break;
+        case PRTS_METRIC_HISTOGRAM:
+            value = (double)sample->value.value.histogram.count;
+            break;
+        case PRTS_METRIC_SKETCH:
+            value = (double)sample->value.value.sketch.count;
+            break;
+    }
+
+    store_series_t* s = get_series(sc->store, sample->series_key);
+    prts_result_t result = s ? append_sample(sc->store, s, sc->now, value) : PRTS_ERROR_NOMEM;
+    if (result == PRTS_ERROR_NOMEM) {
+        sc->result = result;
+    }
+}
+
+/* Drop rollup chunks whose newest bucket ended before the tier's retention window */
+static void expire_points(
+    rollup_tier_t* tier,
+    const prts_rollup_tier_t* config,
+    prts_timestamp_t now
+) {
+    chunk_list_t* list = &tier->points;
+    size_t expired = 0;
+    while (expired < list->num_chunks &&
+           list->chunks[expired]->last_ms * NS_PER_MS + config->width + config->retention < now) {
+        expired++;
+    }
+    if (expired > 0) {
+        chunk_list_drop(list, expired);
+    }
+    if (list->num_chunks == 0 && tier->open.count > 0 &&
+        tier->open.timestamp + config->width + config->retention < now) {
+        tier->open.count = 0;
+    }
+}
+
+/*
+ * Drop chunks that ended before the retention window, and stale rollups.
+ * An open chunk is folded before it goes; if that runs out of memory the
+ * series keeps its chunks until a later sample.
+ */
+static prts_result_t expire_chunks(prts_series_store_t* store, prts_timestamp_t now) {
+    uint64_t cutoff_ms = now > store->retention ? (now - store->retention) / NS_PER_MS : 0;
+
+    prts_result_t result = PRTS_OK;
+    size_t emptied = 0;
+    for (size_t i = 0; i < store->table_capacity; i++) {
+        store_series_t* s = store->table[i];
+        if (!s) continue;
+
+        size_t expired = 0;
+        while (expired < s->raw.num_chunks && s->raw.chunks[expired]->last_ms < cutoff_ms) {
+            if (s->raw.chunks[expired] == s->raw.head) {
+                prts_result_t fold = fold_chunk(store, s, s->raw.head);
+                if (fold != PRTS_OK) {
+                    result = fold;
+                    break;
+                }
+            }
+            expired++;
+        }
+        if (expired > 0) {
+            chunk_list_drop(&s->raw, expired);
+        }
+
+        bool has_rollups = false;
+        for (size_t t = 0; t < store->num_tiers; t++) {
+            expire_points(&s->tiers[t], &store->tiers[t], now);
+            has_rollups |= s->tiers[t].points.num_chunks > 0 || s->tiers[t].open.count > 0;
+        }
+
+        if (s->raw.num_chunks == 0 && !has_rollups) {
+            series_free(s);
+            store->table[i] = NULL;
+            emptied++;
+        }
+    }
+
+    if (emptied > 0) {
+        store->num_series -= emptied;
+        prts_result_t rebuilt = rebuild_table(store, store->table_capacity);
+        if (rebuilt != PRTS_OK) {
+            return rebuilt;
+        }
+    }
+    return result;
+}
+
+prts_result_t prts_series_store_sample(
+    prts_series_store_t* store,
+    prts_timestamp_t now
+) {
+    if (!store) {
+        return PRTS_ERROR_INVALID;
+    }
+    if (now == 0) {
+        now = prts_timestamp_now();
+    }
+
+    store_lock(store);
+
+    if (store->last_sample != 0 && now < store->last_sample + store->interval / 2) {
+        store_unlock(store);
+        return PRTS_OK;
+    }
+    store->last_sample = now;
+
+    sample_context_t sc = { store, now, PRTS_OK };
+    prts_result_t result = prts_metrics_visit(store->collector, store_sample, &sc);
+    if (result == PRTS_OK) {
+        result = sc.result;
+    }
+    if (result == PRTS_OK) {
+        result = expire_chunks(store, now);
+    }
+
+    store_unlock(store);
+
+    return result;
+}
+
+prts_result_t prts_series_store_append(
+    prts_series_store_t* store,
+    uint64_t series_key,
+    prts_timestamp_t timestamp,
+    double value
+) {
+    if (!store) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    store_lock(store);
+
+    store_series_t* s = get_series(store, series_key);
+    prts_result_t result = s ? append_sample(store, s, timestamp, value) : PRTS_ERROR_NOMEM;
+
+    store_unlock(store);
+
+    return result;
+}
+
+prts_result_t prts_series_store_query(
+    prts_series_store_t* store,
+    uint64_t series_key,
+    prts_timestamp_t from,
+    prts_timestamp_t to,
+    prts_sample_t* samples_out,
+    size_t max_samples,
+    size_t* count_out
+) {
+    if (!store || !samples_out || !count_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    store_lock(store);
+
+    size_t count = 0;
+    store_series_t* s = *find_slot(store, series_key);
+    for (size_t i = 0; s && i < s->raw.num_chunks && count < max_samples; i++) {
+        const store_chunk_t* chunk = s->raw.chunks[i];
+        if (chunk->last_ms * NS_PER_MS < from) continue;
+        if (chunk->first_ms * NS_PER_MS > to) break;
+
+        chunk_reader_t reader;
+        reader_init(&reader, chunk);
+        prts_sample_t sample;
+        while (count < max_samples && reader_next(&reader, &sample)) {
+            if (sample.timestamp > to) break;
+            if (sample.timestamp >= from) {
+                samples_out[count++] = sample;
+            }
+        }
+    }
+
+    store_unlock(store);
+
+    *count_out = count;
+    return PRTS_OK;
+}
+
+/* Accumulates points into step-aligned output buckets */
+typedef struct {
+    prts_timestamp_t from;
+    prts_timestamp_t to;
+    prts_timestamp_t step;
+    prts_rollup_point_t* out;
+    size_t max;
+    size_t count;
+    prts_rollup_point_t current;
+} rollup_query_t;
+
+static bool query_full(const rollup_query_t* q) {
+    return q->count >= q->max;
+}
+
+static void query_flush(rollup_query_t* q) {
+    if (q->current.count > 0 && !query_full(q)) {
+        q->out[q->count++] = q->current;
+    }
+    q->current.count = 0;
+}
+
+static void query_add(rollup_query_t* q, const prts_rollup_point_t* point) {
+    prts_rollup_point_t p = *point;
+    p.timestamp -= p.timestamp % q->step;
+    if (q->current.count > 0 && q->current.timestamp != p.timestamp) {
+        query_flush(q);
+    }
+    point_add(&q->current, &p);
+}
+
+static void query_tier(rollup_query_t* q, const rollup_tier_t* tier, prts_timestamp_t width) {
+    /* Only chunks with a bucket ending after from are decoded */
+    const chunk_list_t* list = &tier->points;
+    for (size_t i = 0; i < list->num_chunks && !query_full(q); i++) {
+        const store_chunk_t* chunk = list->chunks[i];
+        if (chunk->last_ms * NS_PER_MS + width <= q->from) continue;
+
+        rollup_reader_t reader;
+        rollup_reader_init(&reader, chunk);
+        prts_rollup_point_t point;
+        while (!query_full(q) && rollup_reader_next(&reader, &point)) {
+            if (point.timestamp > q->to) return;
+            if (point.timestamp + width > q->from) {
+                query_add(q, &point);
+            }
+        }
+    }
+    if (tier->open.count > 0 && tier->open.timestamp <= q->to &&
+        tier->open.timestamp + width > q->from) {
+        query_add(q, &tier->open);
+    }
+}
+
+/* Raw samples in range newer than after_ms */
+static void query_raw(rollup_query_t* q, const store_series_t* s, uint64_t after_ms, bool all) {
+    for (size_t i = 0; i < s->raw.num_chunks && !query_full(q); i++) {
+        const store_chunk_t* chunk = s->raw.chunks[i];
+        if (chunk->last_ms * NS_PER_MS < q->from) continue;
+        if (!all && chunk->last_ms <= after_ms) continue;
+        if (chunk->first_ms * NS_PER_MS > q->to) break;
+
+        chunk_reader_t reader;
+        reader_init(&reader, chunk);
+        prts_sample_t sample;
+        while (!query_full(q) && reader_next(&reader, &sample)) {
+            if (sample.timestamp > q->to) break;
+            if (sample.timestamp < q->from || sample.value != sample.value) continue;
+            if (!all && sample.timestamp / NS_PER_MS <= after_ms) continue;
+
+            prts_rollup_point_t point = {
+                sample.timestamp, sample.value, sample.value, sample.value, 1
+            };
+            query_add(q, &point);
+        }
+    }
+}
+
+prts_result_t prts_series_store_query_rollup(
+    prts_series_store_t* store,
+    uint64_t series_key,
+    prts_timestamp_t from,
+    prts_timestamp_t to,
+    prts_timestamp_t step,
+    prts_rollup_point_t* points_out,
+    size_t max_points,
+    size_t* count_out
+) {
+    if (!store || !points_out || !count_out || step == 0) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    rollup_query_t q;
+    memset(&q, 0, sizeof(q));
+    q.from = from;
+    q.to = to;
+    q.step = step;
+    q.out = points_out;
+    q.max = max_points;
+
+    store_lock(store);
+
+    store_series_t* s = *find_slot(store, series_key);
+    if (s) {
+        /* Coarsest tier that still resolves the step */
+        int tier = -1;
+        for (size_t t = 0; t < store->num_tiers; t++) {
+            if (store->tiers[t].width <= step) {
+                tier = (int)t;
+            }
+        }
+
+        if (tier >= 0) {
+            query_tier(&q, &s->tiers[tier], store->tiers[tier].width);
+            query_raw(&q, s, s->tiers[tier].folded_ms, false);
+        } else {
+            query_raw(&q, s, 0, true);
+        }
+        query_flush(&q);
+    }
+
+    store_unlock(store);
+
+    *count_out = q.count;
+    return PRTS_OK;
+}
+
+prts_result_t prts_series_store_stats(
+    prts_series_store_t* store,
+    prts_store_stats_t* stats_out
+) {
+    if (!store || !stats_out) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    store_lock(store);
+
+    memset(stats_out, 0, sizeof(prts_store_stats_t));
+    stats_out->num_series = store->num_series;
+    for (size_t i = 0; i < store->table_capacity; i++) {
+        const store_series_t* s = store->table[i];
+        if (!s) continue;
+        stats_out->num_chunks += s->raw.num_chunks;
+        for (size_t c = 0; c < s->raw.num_chunks; c++) {
+            stats_out->num_samples += s->raw.chunks[c]->count;
+            stats_out->bytes += (s->raw.chunks[c]->bits + 7) / 8;
+        }
+        for (size_t t = 0; t < store->num_tiers; t++) {
+            const chunk_list_t* points = &s->tiers[t].points;
+            for (size_t c = 0; c < points->num_chunks; c++) {
+                stats_out->rollup_points += points->chunks[c]->count;
+                stats_out->rollup_bytes += (points->chunks[c]->bits + 7) / 8;
+            }
+        }
+    }
+
+    store_unlock(store);
+
+    return PRTS_OK;
+}
@@ -3,9 +3,12 @@
  */
 
 #include "prts/types.h"
+#include "prts/platform.h"
 #include <mach/mach_time.h>
 #include <stdio.h>
 #include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 static mach_timebase_info_data_t timebase_info;
 static bool timebase_initialized = false;
@@ -34,3 +37,58 @@ void prts_timestamp_to_str(prts_timestamp_t ts, char* buf, size_t buf_size) {
         snprintf(buf + offset, buf_size - offset, ".%09llu", (unsigned long long)nanos);
     }
 }
+
+/* ============================================================================
+ * Topology
+ * macOS exposes neither NUMA nodes nor hard CPU affinity: one node holds
+ * every CPU and pinning requests fail.
+ * ============================================================================ */
+
+size_t prts_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t)n : 1;
+}
+
+size_t prts_numa_node_count(void) {
+    return 1;
+}
+
+prts_result_t prts_numa_node_cpus(size_t node, prts_cpu_set_t* cpus) {
+    if (!cpus || node != 0) {
+        return PRTS_ERROR_INVALID;
+    }
+    prts_cpu_set_zero(cpus);
+    for (size_t i = 0; i < prts_cpu_count(); i++) {
+        prts_cpu_set_add(cpus, i);
+    }
+    return PRTS_OK;
+}
+
+size_t prts_numa_current_node(void) {
+    return 0;
+}
+
+prts_result_t prts_thread_set_affinity(const prts_cpu_set_t* cpus) {
+    if (!cpus || prts_cpu_set_empty(cpus)) {
+        return PRTS_ERROR_INVALID;
+    }
+    return PRTS_ERROR;
+}
+
+prts_result_t prts_thread_bind_memory(size_t node) {
+    return node == 0 ? PRTS_OK : PRTS_ERROR_INVALID;
+}
+
+void* prts_numa_alloc(size_t size, size_t node) {
+    if (size == 0 || node != 0) {
+        return NULL;
+    }
+    void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+void prts_numa_free(void* ptr, size_t size) {
+    if (ptr) {
+        munmap(ptr, size);
+    }
+}
@@ -2,9 +2,20 @@
  * PRTS Native - Linux Platform Implementation
  */
 
+#define _GNU_SOURCE
 #include "prts/types.h"
+#include "prts/platform.h"
 #include <time.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#define NODE_SYSFS "/sys/devices/system/node"
 
 prts_timestamp_t prts_timestamp_now(void) {
     struct timespec ts;
@@ -26,3 +37,147 @@ void prts_timestamp_to_str(prts_timestamp_t ts, char* buf, size_t buf_size) {
         snprintf(buf + offset, buf_size - offset, ".%09llu", (unsigned long long)nanos);
     }
 }
+
+/* ============================================================================
+ * Topology
+ * ============================================================================ */
+
+/* Parse a sysfs list such as "0-3,8-11" into a set; false if unreadable */
+static bool read_cpu_list(const char* path, prts_cpu_set_t* set) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+
+    char buf[4096];
+    bool ok = fgets(buf, sizeof(buf), f) != NULL;
+    fclose(f);
+    if (!ok) {
+        return false;
+    }
+
+    prts_cpu_set_zero(set);
+    char* p = buf;
+    while (*p && *p != '\n') {
+        char* end;
+        unsigned long first = strtoul(p, &end, 10);
+        if (end == p) {
+            return false;
+        }
+        unsigned long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtoul(p + 1, &end, 10);
+            p = end;
+        }
+        for (unsigned long i = first; i <= last && i < PRTS_MAX_CPUS; i++) {
+            prts_cpu_set_add(set, i);
+        }
+        if (*p == ',') {
+            p++;
+        }
+    }
+    return true;
+}
+
+size_t prts_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t)n : 1;
+}
+
+size_t prts_numa_node_count(void) {
+    prts_cpu_set_t nodes;
+    if (!read_cpu_list(NODE_SYSFS "/online", &nodes)) {
+        return 1;
+    }
+
+    size_t count = 1;
+    for (size_t node = 0; node < PRTS_MAX_NUMA_NODES; node++) {
+        if (prts_cpu_set_has(&nodes, node)) {
+            count = node + 1;
+        }
+    }
+    return count;
+}
+
+prts_result_t prts_numa_node_cpus(size_t node, prts_cpu_set_t* cpus) {
+    if (!cpus || node >= PRTS_MAX_NUMA_NODES) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    char path[128];
+    snprintf(path, sizeof(path), NODE_SYSFS "/node%zu/cpulist", node);
+    if (!read_cpu_list(path, cpus)) {
+        if (node != 0 || prts_numa_node_count() > 1) {
+            return PRTS_ERROR_INVALID;
+        }
+        /* No NUMA information: node 0 holds every CPU */
+        prts_cpu_set_zero(cpus);
+        for (size_t i = 0; i < prts_cpu_count(); i++) {
+            prts_cpu_set_add(cpus, i);
+        }
+    }
+    return prts_cpu_set_empty(cpus) ? PRTS_ERROR_INVALID : PRTS_OK;
+}
+
+size_t prts_numa_current_node(void) {
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0) {
+        return 0;
+    }
+    return node;
+}
+
+prts_result_t prts_thread_set_affinity(const prts_cpu_set_t* cpus) {
+    if (!cpus || prts_cpu_set_empty(cpus)) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (size_t i = 0; i < PRTS_MAX_CPUS && i < CPU_SETSIZE; i++) {
+        if (prts_cpu_set_has(cpus, i)) {
+            CPU_SET(i, &mask);
+        }
+    }
+    return sched_setaffinity(0, sizeof(mask), &mask) == 0 ? PRTS_OK : PRTS_ERROR;
+}
+
+/* ============================================================================
+ * NUMA memory
+ * ============================================================================ */
+
+prts_result_t prts_thread_bind_memory(size_t node) {
+    if (node >= PRTS_MAX_NUMA_NODES) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    unsigned long mask = 1UL << node;
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, sizeof(mask) * 8 + 1) != 0) {
+        return PRTS_ERROR;
+    }
+    return PRTS_OK;
+}
+
+void* prts_numa_alloc(size_t size, size_t node) {
+    if (size == 0 || node >= PRTS_MAX_NUMA_NODES) {
+        return NULL;
+    }
+
+    void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        return NULL;
+    }
+
+    /* Pages are placed on first touch; without NUMA support this is a no-op */
+    unsigned long mask = 1UL << node;
+    syscall(SYS_mbind, ptr, size, MPOL_PREFERRED, &mask, sizeof(mask) * 8 + 1, 0);
+    return ptr;
+}
+
+void prts_numa_free(void* ptr, size_t size) {
+    if (ptr) {
+        munmap(ptr, size);
+    }
+}
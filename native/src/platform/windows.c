@@ -3,8 +3,10 @@
  */
 
 #include "prts/types.h"
+#include "prts/platform.h"
 #include <windows.h>
 #include <stdio.h>
+#include <string.h>
 
 static LARGE_INTEGER frequency;
 static LARGE_INTEGER start_time;
@@ -43,3 +45,86 @@ void prts_timestamp_to_str(prts_timestamp_t ts, char* buf, size_t buf_size) {
         st.wHour, st.wMinute, st.wSecond,
         (unsigned long long)(ts % 1000000000));
 }
+
+/* ============================================================================
+ * Topology
+ * CPU index = processor group * 64 + processor number within the group.
+ * ============================================================================ */
+
+size_t prts_cpu_count(void) {
+    DWORD n = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+    return n > 0 ? (size_t)n : 1;
+}
+
+size_t prts_numa_node_count(void) {
+    ULONG highest = 0;
+    if (!GetNumaHighestNodeNumber(&highest)) {
+        return 1;
+    }
+    return highest + 1 < PRTS_MAX_NUMA_NODES ? (size_t)highest + 1 : PRTS_MAX_NUMA_NODES;
+}
+
+prts_result_t prts_numa_node_cpus(size_t node, prts_cpu_set_t* cpus) {
+    if (!cpus || node >= prts_numa_node_count()) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    GROUP_AFFINITY affinity;
+    if (!GetNumaNodeProcessorMaskEx((USHORT)node, &affinity)) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    prts_cpu_set_zero(cpus);
+    if (affinity.Group < PRTS_MAX_CPUS / 64) {
+        cpus->bits[affinity.Group] = (uint64_t)affinity.Mask;
+    }
+    return prts_cpu_set_empty(cpus) ? PRTS_ERROR_INVALID : PRTS_OK;
+}
+
+size_t prts_numa_current_node(void) {
+    PROCESSOR_NUMBER processor;
+    USHORT node = 0;
+    GetCurrentProcessorNumberEx(&processor);
+    if (!GetNumaProcessorNodeEx(&processor, &node) || node == 0xFFFF) {
+        return 0;
+    }
+    return node;
+}
+
+/* A thread runs in one processor group; CPUs beyond the first used group are ignored */
+prts_result_t prts_thread_set_affinity(const prts_cpu_set_t* cpus) {
+    if (!cpus || prts_cpu_set_empty(cpus)) {
+        return PRTS_ERROR_INVALID;
+    }
+
+    GROUP_AFFINITY affinity;
+    memset(&affinity, 0, sizeof(affinity));
+    for (size_t group = 0; group < PRTS_MAX_CPUS / 64; group++) {
+        if (cpus->bits[group]) {
+            affinity.Group = (WORD)group;
+            affinity.Mask = (KAFFINITY)cpus->bits[group];
+            break;
+        }
+    }
+    return SetThreadGroupAffinity(GetCurrentThread(), &affinity, NULL) ? PRTS_OK : PRTS_ERROR;
+}
+
+/* Windows already allocates from the node of the processor a thread runs on */
+prts_result_t prts_thread_bind_memory(size_t node) {
+    return node < prts_numa_node_count() ? PRTS_OK : PRTS_ERROR_INVALID;
+}
+
+void* prts_numa_alloc(size_t size, size_t node) {
+    if (size == 0 || node >= prts_numa_node_count()) {
+        return NULL;
+    }
+    return VirtualAllocExNuma(GetCurrentProcess(), NULL, size, MEM_RESERVE | MEM_COMMIT,
+                              PAGE_READWRITE, (DWORD)node);
+}
+
+void prts_numa_free(void* ptr, size_t size) {
+    (void)size;
+    if (ptr) {
+        VirtualFree(ptr, 0, MEM_RELEASE);
+    }
+}
@@ -0,0 +1,888 @@
+/**
+ * PRTS Native - Metrics Tests
+ */
+
+#include "prts/metrics.h"
+#include "prts/thread_pool.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+static const char* build_labels[] = { "pipeline", "agent" };
+
+/* A collector with a two-label counter, builds_total{pipeline, agent} */
+static prts_metrics_collector_t* create_collector(void) {
+    prts_metrics_collector_t* collector;
+    CHECK(prts_metrics_create(&collector) == PRTS_OK);
+
+    prts_metric_config_t config = {0};
+    config.name = "builds_total";
+    config.description = "Builds";
+    config.type = PRTS_METRIC_COUNTER;
+    config.labels = build_labels;
+    config.num_labels = 2;
+    CHECK(prts_metrics_register(collector, &config) == PRTS_OK);
+    return collector;
+}
+
+static uint64_t counter_value(
+    prts_metrics_collector_t* collector,
+    const char* name,
+    const char** label_values
+) {
+    prts_metric_value_t value;
+    CHECK(prts_metrics_get(collector, name, label_values, &value) == PRTS_OK);
+    return value.value.counter;
+}
+
+/* Each label set is its own series; unseen label sets read as zero */
+static void test_label_sets(void) {
+    prts_metrics_collector_t* collector = create_collector();
+
+    char pipeline[16];
+    char agent[16];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(pipeline, sizeof(pipeline), "p%d", i % 50);
+        snprintf(agent, sizeof(agent), "a%d", i % 7);
+        const char* values[] = { pipeline, agent };
+        CHECK(prts_metrics_counter_inc(collector, "builds_total", values, 1) == PRTS_OK);
+    }
+
+    /* i % 50 == 3 and i % 7 == 3 holds for i = 3 + 350k */
+    const char* hit[] = { "p3", "a3" };
+    CHECK(counter_value(collector, "builds_total", hit) == 3);
+
+    /* Values are not interchangeable between label positions */
+    const char* swapped[] = { "a3", "p3" };
+    CHECK(counter_value(collector, "builds_total", swapped) == 0);
+
+    /* Label values are delimited, so "p1","a23" and "p1a","23" differ */
+    const char* joined_a[] = { "p1", "a23" };
+    const char* joined_b[] = { "p1a", "23" };
+    CHECK(prts_metrics_counter_inc(collector, "builds_total", joined_a, 5) == PRTS_OK);
+    CHECK(counter_value(collector, "builds_total", joined_a) == 5);
+    CHECK(counter_value(collector, "builds_total", joined_b) == 0);
+
+    prts_metrics_stats_t stats;
+    CHECK(prts_metrics_stats(collector, &stats) == PRTS_OK);
+    CHECK(stats.num_metrics == 1 && stats.num_series == 351);
+
+    prts_metrics_destroy(collector);
+}
+
+/*
+ * The label hash terminates each value with a 0xff byte, so values that
+ * contain 0xff can produce the same byte stream, and the same key. Such
+ * series must still be told apart by their values.
+ */
+static void test_label_hash_collision(void) {
+    prts_metrics_collector_t* collector = create_collector();
+
+    const char* a[] = { "x\xff", "y" };
+    const char* b[] = { "x", "\xffy" };
+    uint64_t key_a, key_b;
+    CHECK(prts_metrics_series_key(collector, "builds_total", a, &key_a) == PRTS_OK);
+    CHECK(prts_metrics_series_key(collector, "builds_total", b, &key_b) == PRTS_OK);
+    CHECK(key_a == key_b);
+
+    CHECK(prts_metrics_counter_inc(collector, "builds_total", a, 2) == PRTS_OK);
+    CHECK(prts_metrics_counter_inc(collector, "builds_total", b, 7) == PRTS_OK);
+    CHECK(prts_metrics_counter_inc(collector, "builds_total", a, 1) == PRTS_OK);
+    CHECK(counter_value(collector, "builds_total", a) == 3);
+    CHECK(counter_value(collector, "builds_total", b) == 7);
+
+    prts_metrics_stats_t stats;
+    CHECK(prts_metrics_stats(collector, &stats) == PRTS_OK);
+    CHECK(stats.num_series == 2);
+
+    prts_metrics_destroy(collector);
+}
+
+/* Series stay reachable while the table grows many times over */
+static void test_table_growth(void) {
+    enum { SERIES = 20000 };
+    prts_metrics_collector_t* collector = create_collector();
+
+    char pipeline[16];
+    for (int round = 1; round <= 2; round++) {
+        for (int i = 0; i < SERIES; i++) {
+            snprintf(pipeline, sizeof(pipeline), "p%d", i);
+            const char* values[] = { pipeline, "agent" };
+            CHECK(prts_metrics_counter_inc(collector, "builds_total", values,
+                                           (uint64_t)i) == PRTS_OK);
+
+            /* Re-read an early series to catch entries lost by a resize */
+            const char* first[] = { "p1", "agent" };
+            CHECK(counter_value(collector, "builds_total", first) ==
+                  (uint64_t)(i >= 1 ? round : round - 1));
+        }
+    }
+
+    for (int i = 0; i < SERIES; i++) {
+        snprintf(pipeline, sizeof(pipeline), "p%d", i);
+        const char* values[] = { pipeline, "agent" };
+        CHECK(counter_value(collector, "builds_total", values) == 2 * (uint64_t)i);
+    }
+
+    prts_metrics_stats_t stats;
+    CHECK(prts_metrics_stats(collector, &stats) == PRTS_OK);
+    CHECK(stats.num_series == SERIES);
+
+    prts_metrics_destroy(collector);
+}
+
+/* A labelled metric needs a value for every label */
+static void test_label_count_mismatch(void) {
+    prts_metrics_collector_t* collector = create_collector();
+
+    const char* missing[] = { "p1", NULL };
+    const char* complete[] = { "p1", "a1" };
+    prts_metric_value_t value;
+    uint64_t key;
+
+    CHECK(prts_metrics_counter_inc(collector, "builds_total", NULL, 1) == PRTS_ERROR_INVALID);
+    CHECK(prts_metrics_counter_inc(collector, "builds_total", missing, 1) == PRTS_ERROR_INVALID);
+    CHECK(prts_metrics_get(collector, "builds_total", NULL, &value) == PRTS_ERROR_INVALID);
+    CHECK(prts_metrics_get(collector, "builds_total", missing, &value) == PRTS_ERROR_INVALID);
+    CHECK(prts_metrics_series_key(collector, "builds_total", missing, &key) ==
+          PRTS_ERROR_INVALID);
+
+    prts_metric_t* metric;
+    prts_metric_series_t* series;
+    CHECK(prts_metrics_lookup(collector, "builds_total", &metric) == PRTS_OK);
+    CHECK(prts_metrics_bind(metric, missing, &series) == PRTS_ERROR_INVALID);
+
+    /* Rejected updates create nothing */
+    prts_metrics_stats_t stats;
+    CHECK(prts_metrics_stats(collector, &stats) == PRTS_OK);
+    CHECK(stats.num_series == 0);
+
+    /* Unknown metrics and type mismatches are rejected too */
+    CHECK(prts_metrics_counter_inc(collector, "missing_total", NULL, 1) == PRTS_ERROR_INVALID);
+    CHECK(prts_metrics_gauge_set(collector, "builds_total", complete, 1.0) ==
+          PRTS_ERROR_INVALID);
+    CHECK(prts_metrics_counter_inc(collector, "builds_total", complete, 1) == PRTS_OK);
+    CHECK(counter_value(collector, "builds_total", complete) == 1);
+
+    prts_metrics_destroy(collector);
+}
+
+/* Handles taken early stay valid and agree with the name path as metrics grow */
+static void test_metric_handles(void) {
+    enum { METRICS = 600 };
+    prts_metrics_collector_t* collector = create_collector();
+
+    prts_metric_t* builds;
+    prts_metric_series_t* series;
+    const char* values[] = { "deploy", "a1" };
+    CHECK(prts_metrics_lookup(collector, "builds_total", &builds) == PRTS_OK);
+    CHECK(prts_metrics_bind(builds, values, &series) == PRTS_OK);
+
+    char name[32];
+    prts_metric_t* gauges[METRICS];
+    for (int i = 0; i < METRICS; i++) {
+        snprintf(name, sizeof(name), "gauge_%d", i);
+        prts_metric_config_t config = {0};
+        config.name = name;
+        config.type = PRTS_METRIC_GAUGE;
+        CHECK(prts_metrics_register_handle(collector, &config, &gauges[i]) == PRTS_OK);
+
+        /* Bound and name-path updates land on the same series */
+        CHECK(prts_series_counter_inc(series, 1) == PRTS_OK);
+        CHECK(prts_metrics_counter_inc(collector, "builds_total", values, 2) == PRTS_OK);
+    }
+    CHECK(counter_value(collector, "builds_total", values) == 3 * METRICS);
+
+    /* Names still resolve to the handles returned at registration */
+    for (int i = 0; i < METRICS; i++) {
+        snprintf(name, sizeof(name), "gauge_%d", i);
+        prts_metric_t* found;
+        CHECK(prts_metrics_lookup(collector, name, &found) == PRTS_OK);
+        CHECK(found == gauges[i]);
+
+        prts_metric_series_t* gauge;
+        CHECK(prts_metrics_bind(gauges[i], NULL, &gauge) == PRTS_OK);
+        CHECK(prts_series_gauge_set(gauge, (double)i) == PRTS_OK);
+        prts_metrics_unbind(gauge);
+
+        prts_metric_value_t value;
+        CHECK(prts_metrics_get(collector, name, NULL, &value) == PRTS_OK);
+        CHECK(value.value.gauge == (double)i);
+    }
+
+    /* Duplicate names are refused without replacing the original */
+    prts_metric_config_t dup = {0};
+    dup.name = "gauge_7";
+    dup.type = PRTS_METRIC_COUNTER;
+    prts_metric_t* dup_handle;
+    CHECK(prts_metrics_register_handle(collector, &dup, &dup_handle) != PRTS_OK);
+    CHECK(prts_metrics_lookup(collector, "gauge_7", &dup_handle) == PRTS_OK);
+    CHECK(dup_handle == gauges[7]);
+
+    prts_metrics_stats_t stats;
+    CHECK(prts_metrics_stats(collector, &stats) == PRTS_OK);
+    CHECK(stats.num_metrics == METRICS + 1 && stats.num_series == METRICS + 1);
+
+    prts_metrics_unbind(series);
+    prts_metrics_destroy(collector);
+}
+
+/* Series beyond a cardinality limit are refused and counted as dropped */
+static void test_series_limits(void) {
+    prts_metrics_collector_t* collector = create_collector();
+    prts_metrics_limits_t limits = { 3, 5 };
+    CHECK(prts_metrics_set_limits(collector, &limits) == PRTS_OK);
+
+    const char* values[][2] = { { "p0", "a" }, { "p1", "a" }, { "p2", "a" }, { "p3", "a" } };
+    for (int i = 0; i < 3; i++) {
+        CHECK(prts_metrics_counter_inc(collector, "builds_total", values[i], 1) == PRTS_OK);
+    }
+    CHECK(prts_metrics_counter_inc(collector, "builds_total", values[3], 1) == PRTS_ERROR_FULL);
+    CHECK(counter_value(collector, "builds_total", values[3]) == 0);
+
+    /* Existing series keep updating; every refused update is counted */
+    CHECK(prts_metrics_counter_inc(collector, "builds_total", values[0], 1) == PRTS_OK);
+    CHECK(counter_value(collector, "builds_total", values[0]) == 2);
+    prts_metric_t* builds;
+    prts_metric_series_t* series;
+    CHECK(prts_metrics_lookup(collector, "builds_total", &builds) == PRTS_OK);
+    CHECK(prts_metrics_bind(builds, values[3], &series) == PRTS_ERROR_FULL);
+
+    prts_metrics_stats_t stats;
+    CHECK(prts_metrics_stats(collector, &stats) == PRTS_OK);
+    CHECK(stats.num_series == 3 && stats.series_dropped == 2);
+
+    /* The collector-wide limit spans metrics */
+    char name[16];
+    for (int i = 0; i < 3; i++) {
+        snprintf(name, sizeof(name), "gauge_%d", i);
+        prts_metric_config_t config = {0};
+        config.name = name;
+        config.type = PRTS_METRIC_GAUGE;
+        CHECK(prts_metrics_register(collector, &config) == PRTS_OK);
+        CHECK(prts_metrics_gauge_set(collector, name, NULL, 1) ==
+              (i < 2 ? PRTS_OK : PRTS_ERROR_FULL));
+    }
+    CHECK(prts_metrics_stats(collector, &stats) == PRTS_OK);
+    CHECK(stats.num_series == 5 && stats.series_dropped == 3);
+
+    /* Lifting the limits lets new series through again */
+    prts_metrics_limits_t unlimited = { 0, 0 };
+    CHECK(prts_metrics_set_limits(collector, &unlimited) == PRTS_OK);
+    CHECK(prts_metrics_counter_inc(collector, "builds_total", values[3], 4) == PRTS_OK);
+    CHECK(counter_value(collector, "builds_total", values[3]) == 4);
+
+    prts_metrics_destroy(collector);
+}
+
+/* Idle series go after idle_epochs sweeps; bound and updated ones stay */
+static void test_evict_stale(void) {
+    enum { SERIES = 200 };
+    prts_metrics_collector_t* collector = create_collector();
+    size_t evicted;
+    CHECK(prts_metrics_evict_stale(collector, 0, &evicted) == PRTS_ERROR_INVALID);
+
+    char pipeline[16];
+    for (int i = 0; i < SERIES; i++) {
+        snprintf(pipeline, sizeof(pipeline), "p%d", i);
+        const char* values[] = { pipeline, "a" };
+        CHECK(prts_metrics_counter_inc(collector, "builds_total", values, (uint64_t)i + 1) ==
+              PRTS_OK);
+    }
+    prts_metric_t* builds;
+    prts_metric_series_t* bound;
+    const char* bound_values[] = { "bound", "a" };
+    CHECK(prts_metrics_lookup(collector, "builds_total", &builds) == PRTS_OK);
+    CHECK(prts_metrics_bind(builds, bound_values, &bound) == PRTS_OK);
+
+    /* Within idle_epochs nothing is stale */
+    CHECK(prts_metrics_evict_stale(collector, 2, &evicted) == PRTS_OK && evicted == 0);
+    CHECK(prts_metrics_evict_stale(collector, 2, &evicted) == PRTS_OK && evicted == 0);
+
+    /* Even series are touched; the odd ones are evicted on the next sweep */
+    for (int i = 0; i < SERIES; i += 2) {
+        snprintf(pipeline, sizeof(pipeline), "p%d", i);
+        const char* values[] = { pipeline, "a" };
+        CHECK(prts_metrics_counter_inc(collector, "builds_total", values, 1) == PRTS_OK);
+    }
+    CHECK(prts_metrics_evict_stale(collector, 2, &evicted) == PRTS_OK);
+    CHECK(evicted == SERIES / 2);
+
+    /* Survivors keep their values after the table rebuild; evicted ones read zero */
+    for (int i = 0; i < SERIES; i++) {
+        snprintf(pipeline, sizeof(pipeline), "p%d", i);
+        const char* values[] = { pipeline, "a" };
+        CHECK(counter_value(collector, "builds_total", values) ==
+              (i % 2 ? 0 : (uint64_t)i + 2));
+    }
+
+    /* The bound handle outlived the sweep and still updates its series */
+    CHECK(prts_series_counter_inc(bound, 7) == PRTS_OK);
+    CHECK(counter_value(collector, "builds_total", bound_values) == 7);
+
+    prts_metrics_stats_t stats;
+    CHECK(prts_metrics_stats(collector, &stats) == PRTS_OK);
+    CHECK(stats.num_series == SERIES / 2 + 1 && stats.series_evicted == SERIES / 2);
+
+    /* An evicted label set starts over from zero */
+    const char* revived[] = { "p1", "a" };
+    CHECK(prts_metrics_counter_inc(collector, "builds_total", revived, 5) == PRTS_OK);
+    CHECK(counter_value(collector, "builds_total", revived) == 5);
+
+    /* Once unbound, an idle series is evicted like any other */
+    prts_metrics_unbind(bound);
+    for (int i = 0; i < 3; i++) {
+        CHECK(prts_metrics_evict_stale(collector, 2, NULL) == PRTS_OK);
+    }
+    CHECK(counter_value(collector, "builds_total", bound_values) == 0);
+    CHECK(prts_metrics_stats(collector, &stats) == PRTS_OK);
+    CHECK(stats.num_series == 0 && stats.series_evicted == SERIES + 2);
+
+    prts_metrics_destroy(collector);
+}
+
+enum { UPDATE_TASKS = 16, UPDATE_ITERATIONS = 24000 };
+
+typedef struct {
+    prts_metrics_collector_t* collector;
+    prts_metric_series_t* bound;
+    int index;
+} update_task_t;
+
+static void update_task(void* arg) {
+    update_task_t* task = arg;
+    const char* shared[] = { "shared", "a" };
+    char pipeline[16];
+    snprintf(pipeline, sizeof(pipeline), "task%d", task->index);
+    const char* own[] = { pipeline, "a" };
+
+    for (int i = 0; i < UPDATE_ITERATIONS; i++) {
+        CHECK(prts_metrics_counter_inc(task->collector, "builds_total", shared, 1) == PRTS_OK);
+        CHECK(prts_metrics_counter_inc(task->collector, "builds_total", own, 1) == PRTS_OK);
+        CHECK(prts_series_counter_inc(task->bound, 2) == PRTS_OK);
+        CHECK(prts_metrics_histogram_observe(task->collector, "latency", NULL,
+                                             (double)(i % 12)) == PRTS_OK);
+    }
+}
+
+/* Concurrent updates, including series created on the fly, lose nothing */
+static void test_concurrent_updates(void) {
+    prts_metrics_collector_t* collector = create_collector();
+
+    double bounds[] = { 1, 2, 5, 10 };
+    prts_histogram_config_t buckets = { bounds, 4 };
+    prts_metric_config_t config = {0};
+    config.name = "latency";
+    config.type = PRTS_METRIC_HISTOGRAM;
+    CHECK(prts_metrics_register_histogram(collector, &config, &buckets, NULL) == PRTS_OK);
+
+    prts_metric_t* builds;
+    prts_metric_series_t* bound;
+    const char* bound_values[] = { "bound", "a" };
+    CHECK(prts_metrics_lookup(collector, "builds_total", &builds) == PRTS_OK);
+    CHECK(prts_metrics_bind(builds, bound_values, &bound) == PRTS_OK);
+
+    prts_threadpool_config_t pool_config = {0};
+    pool_config.num_threads = 8;
+    pool_config.queue_size = 64;
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&pool_config, &pool) == PRTS_OK);
+
+    update_task_t tasks[UPDATE_TASKS];
+    for (int i = 0; i < UPDATE_TASKS; i++) {
+        tasks[i].collector = collector;
+        tasks[i].bound = bound;
+        tasks[i].index = i;
+        CHECK(prts_threadpool_submit(pool, update_task, &tasks[i]) == PRTS_OK);
+    }
+    prts_threadpool_wait_all(pool);
+    prts_threadpool_destroy(pool);
+
+    const uint64_t total = (uint64_t)UPDATE_TASKS * UPDATE_ITERATIONS;
+    const char* shared[] = { "shared", "a" };
+    CHECK(counter_value(collector, "builds_total", shared) == total);
+    CHECK(counter_value(collector, "builds_total", bound_values) == 2 * total);
+    for (int i = 0; i < UPDATE_TASKS; i++) {
+        char pipeline[16];
+        snprintf(pipeline, sizeof(pipeline), "task%d", i);
+        const char* own[] = { pipeline, "a" };
+        CHECK(counter_value(collector, "builds_total", own) == UPDATE_ITERATIONS);
+    }
+
+    /* Each run of 12 observes 0..11: 66 in sum, split 2/1/3/5/1 over the buckets */
+    prts_metric_value_t value;
+    CHECK(prts_metrics_get(collector, "latency", NULL, &value) == PRTS_OK);
+    CHECK(value.value.histogram.count == total);
+    CHECK(value.value.histogram.sum == 66.0 * (double)(total / 12));
+
+    uint64_t counts[5];
+    size_t num_buckets;
+    CHECK(prts_metrics_get_buckets(collector, "latency", NULL, counts, 5,
+                                   &num_buckets) == PRTS_OK);
+    CHECK(num_buckets == 5);
+    CHECK(counts[0] == total / 12 * 2 && counts[1] == total / 12);
+    CHECK(counts[2] == total / 12 * 3 && counts[3] == total / 12 * 5);
+    CHECK(counts[4] == total / 12);
+
+    prts_metrics_unbind(bound);
+    prts_metrics_destroy(collector);
+}
+
+/* Buckets are upper-inclusive, with values above the last bound in +Inf */
+static void test_histogram_buckets(void) {
+    prts_metrics_collector_t* collector = create_collector();
+
+    double bounds[3];
+    CHECK(prts_histogram_linear_buckets(1, 1, 3, bounds) == PRTS_OK);
+    CHECK(bounds[0] == 1 && bounds[1] == 2 && bounds[2] == 3);
+
+    prts_histogram_config_t buckets = { bounds, 3 };
+    prts_metric_config_t config = {0};
+    config.name = "duration";
+    config.type = PRTS_METRIC_HISTOGRAM;
+    CHECK(prts_metrics_register_histogram(collector, &config, &buckets, NULL) == PRTS_OK);
+
+    static const struct {
+        double value;
+        size_t bucket;
+    } observations[] = {
+        { -5, 0 }, { 0, 0 }, { 1, 0 },
+        { 1.0000001, 1 }, { 2, 1 },
+        { 3, 2 },
+        { 3.5, 3 }, { 1e308, 3 },
+    };
+    uint64_t expected[4] = {0};
+    for (size_t i = 0; i < sizeof(observations) / sizeof(observations[0]); i++) {
+        CHECK(prts_metrics_histogram_observe(collector, "duration", NULL,
+                                             observations[i].value) == PRTS_OK);
+        expected[observations[i].bucket]++;
+    }
+
+    uint64_t counts[4];
+    size_t num_buckets = 0;
+    CHECK(prts_metrics_get_buckets(collector, "duration", NULL, counts, 4,
+                                   &num_buckets) == PRTS_OK);
+    CHECK(num_buckets == 4);
+    CHECK(memcmp(counts, expected, sizeof(expected)) == 0);
+
+    /* A short buffer receives the leading buckets and the full count */
+    uint64_t head[2] = {0};
+    CHECK(prts_metrics_get_buckets(collector, "duration", NULL, head, 2,
+                                   &num_buckets) == PRTS_OK);
+    CHECK(num_buckets == 4 && head[0] == expected[0] && head[1] == expected[1]);
+
+    CHECK(prts_metrics_get_buckets(collector, "builds_total", NULL, counts, 4,
+                                   NULL) == PRTS_ERROR_INVALID);
+
+    /* Registration refuses boundaries that are not finite and increasing */
+    double unsorted[] = { 1, 3, 2 };
+    double repeated[] = { 1, 1 };
+    double infinite[] = { 1, INFINITY };
+    prts_histogram_config_t bad[] = { { unsorted, 3 }, { repeated, 2 }, { infinite, 2 } };
+    config.name = "bad_duration";
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        CHECK(prts_metrics_register_histogram(collector, &config, &bad[i], NULL) ==
+              PRTS_ERROR_INVALID);
+    }
+
+    prts_metrics_destroy(collector);
+}
+
+/* Generators reject arguments that cannot give finite, increasing bounds */
+static void test_bucket_generators(void) {
+    double bounds[10];
+
+    CHECK(prts_histogram_exponential_buckets(1, 2, 4, bounds) == PRTS_OK);
+    CHECK(bounds[0] == 1 && bounds[1] == 2 && bounds[2] == 4 && bounds[3] == 8);
+    CHECK(prts_histogram_linear_buckets(-1, 0.5, 3, bounds) == PRTS_OK);
+    CHECK(bounds[0] == -1 && bounds[1] == -0.5 && bounds[2] == 0);
+
+    CHECK(prts_histogram_linear_buckets(0, 1, 0, bounds) == PRTS_ERROR_INVALID);
+    CHECK(prts_histogram_linear_buckets(0, 1, 3, NULL) == PRTS_ERROR_INVALID);
+    CHECK(prts_histogram_linear_buckets(0, 0, 3, bounds) == PRTS_ERROR_INVALID);
+    CHECK(prts_histogram_linear_buckets(0, -1, 3, bounds) == PRTS_ERROR_INVALID);
+    CHECK(prts_histogram_linear_buckets(0, NAN, 3, bounds) == PRTS_ERROR_INVALID);
+    CHECK(prts_histogram_linear_buckets(NAN, 1, 3, bounds) == PRTS_ERROR_INVALID);
+    CHECK(prts_histogram_linear_buckets(0, INFINITY, 3, bounds) == PRTS_ERROR_INVALID);
+    /* A width lost to rounding repeats the start */
+    CHECK(prts_histogram_linear_buckets(1e20, 1, 3, bounds) == PRTS_ERROR_INVALID);
+
+    CHECK(prts_histogram_exponential_buckets(1, 2, 0, bounds) == PRTS_ERROR_INVALID);
+    CHECK(prts_histogram_exponential_buckets(1, 2, 3, NULL) == PRTS_ERROR_INVALID);
+    CHECK(prts_histogram_exponential_buckets(0, 2, 3, bounds) == PRTS_ERROR_INVALID);
+    CHECK(prts_histogram_exponential_buckets(-1, 2, 3, bounds) == PRTS_ERROR_INVALID);
+    CHECK(prts_histogram_exponential_buckets(1, 1, 3, bounds) == PRTS_ERROR_INVALID);
+    CHECK(prts_histogram_exponential_buckets(1, 0.5, 3, bounds) == PRTS_ERROR_INVALID);
+    CHECK(prts_histogram_exponential_buckets(1, NAN, 3, bounds) == PRTS_ERROR_INVALID);
+    CHECK(prts_histogram_exponential_buckets(INFINITY, 2, 3, bounds) == PRTS_ERROR_INVALID);
+    /* Overflows to +Inf before the last bound */
+    CHECK(prts_histogram_exponential_buckets(1e300, 10, 10, bounds) == PRTS_ERROR_INVALID);
+}
+
+#define SECOND 1000000000ULL
+
+static prts_metrics_aggregator_t* create_aggregator(prts_metrics_collector_t* collector) {
+    prts_aggregator_config_t config = { 1 * SECOND, 10 * SECOND };
+    prts_metrics_aggregator_t* aggregator;
+    CHECK(prts_metrics_aggregator_create(collector, &config, &aggregator) == PRTS_OK);
+    return aggregator;
+}
+
+/* rate and irate count a counter that restarted as increasing from zero */
+static void test_aggregator_counter_reset(void) {
+    prts_metrics_collector_t* collector = create_collector();
+    prts_metrics_aggregator_t* aggregator = create_aggregator(collector);
+    const char* values[] = { "deploy", "a1" };
+
+    /* 10 per second up to 50 */
+    prts_timestamp_t now = 1000 * SECOND;
+    for (int i = 0; i < 5; i++) {
+        CHECK(prts_metrics_counter_inc(collector, "builds_total", values, 10) == PRTS_OK);
+        CHECK(prts_metrics_aggregator_tick(aggregator, now) == PRTS_OK);
+        now += SECOND;
+    }
+
+    /* Evicting the idle series restarts it from zero */
+    size_t evicted = 0;
+    for (int i = 0; i < 3 && evicted == 0; i++) {
+        CHECK(prts_metrics_evict_stale(collector, 1, &evicted) == PRTS_OK);
+    }
+    CHECK(evicted == 1);
+    CHECK(prts_metrics_counter_inc(collector, "builds_total", values, 5) == PRTS_OK);
+    CHECK(prts_metrics_aggregator_tick(aggregator, now) == PRTS_OK);
+
+    prts_window_stats_t stats;
+    CHECK(prts_metrics_aggregator_query(aggregator, "builds_total", values, 2 * SECOND,
+                                        &stats) == PRTS_OK);
+    CHECK(stats.last == 5 && stats.min == 5 && stats.max == 50);
+    CHECK(stats.irate == 5);
+    CHECK(stats.rate == 7.5);       /* 40 -> 50 -> (reset) 5 over 2s */
+
+    now += SECOND;
+    CHECK(prts_metrics_counter_inc(collector, "builds_total", values, 10) == PRTS_OK);
+    CHECK(prts_metrics_aggregator_tick(aggregator, now) == PRTS_OK);
+    CHECK(prts_metrics_aggregator_query(aggregator, "builds_total", values, 3 * SECOND,
+                                        &stats) == PRTS_OK);
+    CHECK(stats.irate == 10);
+    CHECK(fabs(stats.rate - 25.0 / 3.0) < 1e-12);
+    CHECK(stats.samples == 3);
+
+    prts_metrics_aggregator_destroy(aggregator);
+    prts_metrics_destroy(collector);
+}
+
+/* A window of the whole retention stays exact once the ring has wrapped */
+static void test_aggregator_retention_window(void) {
+    prts_metrics_collector_t* collector = create_collector();
+    prts_metrics_aggregator_t* aggregator = create_aggregator(collector);
+    const char* values[] = { "deploy", "a1" };
+
+    prts_timestamp_t now = 1000 * SECOND;
+    for (int i = 0; i < 40; i++) {
+        CHECK(prts_metrics_counter_inc(collector, "builds_total", values, 3) == PRTS_OK);
+        CHECK(prts_metrics_aggregator_tick(aggregator, now) == PRTS_OK);
+        now += SECOND;
+    }
+
+    prts_window_stats_t stats;
+    CHECK(prts_metrics_aggregator_query(aggregator, "builds_total", values, 10 * SECOND,
+                                        &stats) == PRTS_OK);
+    CHECK(stats.rate == 3 && stats.irate == 3);
+    CHECK(stats.samples == 10);
+    CHECK(stats.last == 120 && stats.min == 93 && stats.max == 120);
+
+    CHECK(prts_metrics_aggregator_query(aggregator, "builds_total", values, SECOND,
+                                        &stats) == PRTS_OK);
+    CHECK(stats.samples == 1 && stats.rate == 3);
+
+    CHECK(prts_metrics_aggregator_query(aggregator, "builds_total", values, 10 * SECOND + 1,
+                                        &stats) == PRTS_ERROR_INVALID);
+    CHECK(prts_metrics_aggregator_query(aggregator, "builds_total", values, 0,
+                                        &stats) == PRTS_ERROR_INVALID);
+
+    const char* unseen[] = { "never", "a1" };
+    CHECK(prts_metrics_aggregator_query(aggregator, "builds_total", unseen, SECOND,
+                                        &stats) == PRTS_ERROR_EMPTY);
+
+    prts_metrics_aggregator_destroy(aggregator);
+    prts_metrics_destroy(collector);
+}
+
+/* Quantiles cover only the observations made inside the window */
+static void test_aggregator_window_quantile(void) {
+    prts_metrics_collector_t* collector = create_collector();
+
+    double bounds[] = { 1, 2, 5, 10 };
+    prts_histogram_config_t buckets = { bounds, 4 };
+    prts_metric_config_t config = {0};
+    config.name = "latency";
+    config.type = PRTS_METRIC_HISTOGRAM;
+    CHECK(prts_metrics_register_histogram(collector, &config, &buckets, NULL) == PRTS_OK);
+    config.name = "latency_sketch";
+    config.type = PRTS_METRIC_SKETCH;
+    CHECK(prts_metrics_register_sketch(collector, &config, 0.01, NULL) == PRTS_OK);
+
+    prts_metrics_aggregator_t* aggregator = create_aggregator(collector);
+
+    /* Five intervals of fast requests, then three of slow ones */
+    prts_timestamp_t now = 1000 * SECOND;
+    for (int i = 0; i < 8; i++) {
+        double value = i < 5 ? 0.5 : 8.0;
+        for (int j = 0; j < 100; j++) {
+            CHECK(prts_metrics_histogram_observe(collector, "latency", NULL, value) == PRTS_OK);
+            CHECK(prts_metrics_histogram_observe(collector, "latency_sketch", NULL,
+                                                 value + j / 100.0) == PRTS_OK);
+        }
+        now += SECOND;
+        CHECK(prts_metrics_aggregator_tick(aggregator, now) == PRTS_OK);
+    }
+
+    /* Linear within (5, 10] for the slow intervals only */
+    double q;
+    CHECK(prts_metrics_aggregator_quantile(aggregator, "latency", NULL, 3 * SECOND, 0.5,
+                                           &q) == PRTS_OK);
+    CHECK(q == 7.5);
+    CHECK(prts_metrics_aggregator_quantile(aggregator, "latency", NULL, 8 * SECOND, 0.25,
+                                           &q) == PRTS_OK);
+    CHECK(q == 0.4375);             /* From the first snapshot: rank 175 of 400 in [0, 1] */
+
+    /* Sketches merge their per-interval bins and keep relative accuracy */
+    CHECK(prts_metrics_aggregator_quantile(aggregator, "latency_sketch", NULL, 3 * SECOND, 0,
+                                           &q) == PRTS_OK);
+    CHECK(fabs(q - 8.0) <= 8.0 * 0.01);
+    CHECK(prts_metrics_aggregator_quantile(aggregator, "latency_sketch", NULL, 8 * SECOND, 0.5,
+                                           &q) == PRTS_OK);
+    CHECK(q < 1.5);
+    CHECK(prts_metrics_aggregator_quantile(aggregator, "latency_sketch", NULL, 8 * SECOND, 1,
+                                           &q) == PRTS_OK);
+    CHECK(fabs(q - 8.99) <= 8.99 * 0.01);
+
+    /* A window with no new observations is empty */
+    now += SECOND;
+    CHECK(prts_metrics_aggregator_tick(aggregator, now) == PRTS_OK);
+    CHECK(prts_metrics_aggregator_quantile(aggregator, "latency", NULL, SECOND, 0.5,
+                                           &q) == PRTS_ERROR_EMPTY);
+    CHECK(prts_metrics_aggregator_quantile(aggregator, "latency_sketch", NULL, SECOND, 0.5,
+                                           &q) == PRTS_ERROR_EMPTY);
+    const char* values[] = { "deploy", "a1" };
+    CHECK(prts_metrics_counter_inc(collector, "builds_total", values, 1) == PRTS_OK);
+    CHECK(prts_metrics_aggregator_tick(aggregator, now + SECOND) == PRTS_OK);
+    CHECK(prts_metrics_aggregator_quantile(aggregator, "builds_total", values, SECOND, 0.5,
+                                           &q) == PRTS_ERROR_INVALID);
+
+    prts_metrics_aggregator_destroy(aggregator);
+    prts_metrics_destroy(collector);
+}
+
+/* Growable export sink recording each chunk size */
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+    size_t chunks[64];
+    size_t num_chunks;
+    size_t fail_at;                 /* Chunk to refuse with PRTS_ERROR_FULL (0 for none) */
+} export_sink_t;
+
+static prts_result_t sink_write(const char* data, size_t len, void* ctx) {
+    export_sink_t* sink = ctx;
+    CHECK(sink->num_chunks < 64);
+    sink->chunks[sink->num_chunks++] = len;
+    if (sink->num_chunks == sink->fail_at) {
+        return PRTS_ERROR_FULL;
+    }
+
+    if (sink->len + len + 1 > sink->cap) {
+        sink->cap = (sink->len + len + 1) * 2;
+        sink->data = realloc(sink->data, sink->cap);
+        CHECK(sink->data != NULL);
+    }
+    memcpy(sink->data + sink->len, data, len);
+    sink->len += len;
+    sink->data[sink->len] = '\0';
+    return PRTS_OK;
+}
+
+static const char* const golden_prometheus =
+    "# HELP http_requests_total HTTP requests\\nserved \\\\ total\n"
+    "# TYPE http_requests_total counter\n"
+    "http_requests_total{path=\"/a\\\"b\\\\c\\nd\"} 3\n"
+    "# HELP temperature Temp\n"
+    "# TYPE temperature gauge\n"
+    "temperature -1.5\n"
+    "# HELP latency_seconds Latency\n"
+    "# TYPE latency_seconds histogram\n"
+    "latency_seconds_bucket{le=\"0.5\"} 1\n"
+    "latency_seconds_bucket{le=\"1\"} 1\n"
+    "latency_seconds_bucket{le=\"+Inf\"} 2\n"
+    "latency_seconds_count 2\n"
+    "latency_seconds_sum 2.5\n"
+    "# HELP size_bytes Size\n"
+    "# TYPE size_bytes summary\n"
+    "size_bytes{quantile=\"0.5\"} 100\n"
+    "size_bytes{quantile=\"0.9\"} 100\n"
+    "size_bytes{quantile=\"0.99\"} 100\n"
+    "size_bytes{quantile=\"0.999\"} 100\n"
+    "size_bytes_count 1\n"
+    "size_bytes_sum 100\n";
+
+/* Exposition text of each type, with escaped help text and label values */
+static void test_export_golden(void) {
+    prts_metrics_collector_t* collector;
+    CHECK(prts_metrics_create(&collector) == PRTS_OK);
+
+    const char* labels[] = { "path" };
+    prts_metric_config_t config = { "http_requests_total", "HTTP requests\nserved \\ total",
+                                    PRTS_METRIC_COUNTER, labels, 1 };
+    CHECK(prts_metrics_register(collector, &config) == PRTS_OK);
+    prts_metric_config_t gauge = { "temperature", "Temp", PRTS_METRIC_GAUGE, NULL, 0 };
+    CHECK(prts_metrics_register(collector, &gauge) == PRTS_OK);
+    double bounds[] = { 0.5, 1 };
+    prts_histogram_config_t buckets = { bounds, 2 };
+    prts_metric_config_t histogram = { "latency_seconds", "Latency", PRTS_METRIC_HISTOGRAM,
+                                       NULL, 0 };
+    CHECK(prts_metrics_register_histogram(collector, &histogram, &buckets, NULL) == PRTS_OK);
+    prts_metric_config_t sketch = { "size_bytes", "Size", PRTS_METRIC_SKETCH, NULL, 0 };
+    CHECK(prts_metrics_register_sketch(collector, &sketch, 0.01, NULL) == PRTS_OK);
+
+    const char* path[] = { "/a\"b\\c\nd" };
+    CHECK(prts_metrics_counter_inc(collector, "http_requests_total", path, 3) == PRTS_OK);
+    CHECK(prts_metrics_gauge_set(collector, "temperature", NULL, -1.5) == PRTS_OK);
+    CHECK(prts_metrics_histogram_observe(collector, "latency_seconds", NULL, 0.5) == PRTS_OK);
+    CHECK(prts_metrics_histogram_observe(collector, "latency_seconds", NULL, 2) == PRTS_OK);
+    CHECK(prts_metrics_histogram_observe(collector, "size_bytes", NULL, 100) == PRTS_OK);
+
+    export_sink_t sink = {0};
+    CHECK(prts_metrics_export(collector, PRTS_EXPORT_PROMETHEUS, sink_write, &sink) == PRTS_OK);
+    CHECK(strcmp(sink.data, golden_prometheus) == 0);
+
+    /* OpenMetrics names counter families without _total and ends with # EOF */
+    sink.len = 0;
+    CHECK(prts_metrics_export(collector, PRTS_EXPORT_OPENMETRICS, sink_write, &sink) == PRTS_OK);
+    const char* family = "# HELP http_requests HTTP requests\\nserved \\\\ total\n"
+                         "# TYPE http_requests counter\n";
+    CHECK(strncmp(sink.data, family, strlen(family)) == 0);
+    const char* rest = strstr(golden_prometheus, "http_requests_total{");
+    CHECK(strncmp(sink.data + strlen(family), rest, strlen(rest)) == 0);
+    CHECK(strcmp(sink.data + strlen(family) + strlen(rest), "# EOF\n") == 0);
+
+    free(sink.data);
+    prts_metrics_destroy(collector);
+}
+
+/* A large export fills whole 16KB chunks, even across one huge label value */
+static void test_export_chunks(void) {
+    enum { CHUNK = 16384 };
+    prts_metrics_collector_t* collector = create_collector();
+
+    char pipeline[32];
+    for (int i = 0; i < 2000; i++) {
+        snprintf(pipeline, sizeof(pipeline), "pipeline-%d", i * 7919);
+        const char* values[] = { pipeline, i % 2 ? "linux" : "windows-x64" };
+        CHECK(prts_metrics_counter_inc(collector, "builds_total", values, (uint64_t)i) ==
+              PRTS_OK);
+    }
+    char* huge = malloc(40000);
+    CHECK(huge != NULL);
+    memset(huge, 'h', 39999);
+    huge[39999] = '\0';
+    const char* huge_values[] = { huge, "a" };
+    CHECK(prts_metrics_counter_inc(collector, "builds_total", huge_values, 1) == PRTS_OK);
+
+    export_sink_t sink = {0};
+    CHECK(prts_metrics_export(collector, PRTS_EXPORT_PROMETHEUS, sink_write, &sink) == PRTS_OK);
+    CHECK(sink.num_chunks > 4);
+    for (size_t i = 0; i + 1 < sink.num_chunks; i++) {
+        CHECK(sink.chunks[i] == CHUNK);
+    }
+    CHECK(sink.chunks[sink.num_chunks - 1] > 0 && sink.chunks[sink.num_chunks - 1] <= CHUNK);
+
+    /* The buffer export produces the same bytes */
+    char* buffer = malloc(sink.len + 1);
+    CHECK(buffer != NULL);
+    size_t written;
+    CHECK(prts_metrics_export_prometheus(collector, buffer, sink.len + 1, &written) == PRTS_OK);
+    CHECK(written == sink.len && memcmp(buffer, sink.data, written) == 0);
+
+    /* A failing writer stops the export at that chunk */
+    export_sink_t failing = {0};
+    failing.fail_at = 2;
+    CHECK(prts_metrics_export(collector, PRTS_EXPORT_PROMETHEUS, sink_write, &failing) ==
+          PRTS_ERROR_FULL);
+    CHECK(failing.num_chunks == 2 && failing.len == CHUNK);
+
+    free(failing.data);
+    free(buffer);
+    free(sink.data);
+    free(huge);
+    prts_metrics_destroy(collector);
+}
+
+/* A short buffer keeps the longest prefix that fits, NUL-terminated */
+static void test_export_prometheus_full(void) {
+    prts_metrics_collector_t* collector = create_collector();
+    char pipeline[32];
+    for (int i = 0; i < 500; i++) {
+        snprintf(pipeline, sizeof(pipeline), "p%d", i);
+        const char* values[] = { pipeline, "a" };
+        CHECK(prts_metrics_counter_inc(collector, "builds_total", values, 1) == PRTS_OK);
+    }
+
+    static char full[65536];
+    size_t full_len;
+    CHECK(prts_metrics_export_prometheus(collector, full, sizeof(full), &full_len) == PRTS_OK);
+    CHECK(full_len > 16384 && full[full_len] == '\0');
+
+    /* Exactly enough room for the text and its NUL */
+    static char exact[65536];
+    size_t written;
+    CHECK(prts_metrics_export_prometheus(collector, exact, full_len + 1, &written) == PRTS_OK);
+    CHECK(written == full_len && strcmp(exact, full) == 0);
+
+    static const size_t sizes[] = { 1, 100, 16384, 16385, 20000 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        char* buffer = malloc(sizes[i]);
+        CHECK(buffer != NULL);
+        CHECK(prts_metrics_export_prometheus(collector, buffer, sizes[i], &written) ==
+              PRTS_ERROR_FULL);
+        CHECK(written == sizes[i] - 1 && buffer[written] == '\0');
+        CHECK(memcmp(buffer, full, written) == 0);
+        free(buffer);
+    }
+
+    CHECK(prts_metrics_export_prometheus(collector, exact, full_len, &written) ==
+          PRTS_ERROR_FULL);
+    CHECK(written == full_len - 1);
+    CHECK(prts_metrics_export_prometheus(collector, exact, 0, &written) == PRTS_ERROR_INVALID);
+
+    prts_metrics_destroy(collector);
+}
+
+int main(void) {
+    test_label_sets();
+    test_label_hash_collision();
+    test_table_growth();
+    test_label_count_mismatch();
+    test_metric_handles();
+    test_series_limits();
+    test_evict_stale();
+    test_concurrent_updates();
+    test_histogram_buckets();
+    test_bucket_generators();
+    test_aggregator_counter_reset();
+    test_aggregator_retention_window();
+    test_aggregator_window_quantile();
+    test_export_golden();
+    test_export_chunks();
+    test_export_prometheus_full();
+    printf("test_metrics: ok\n");
+    return 0;
+}
@@ -0,0 +1,554 @@
+/**
+ * PRTS Native - Log Parser Tests
+ */
+
+#include "prts/log.h"
+#include "prts/thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+#ifdef PRTS_TEST_WRAP_REALLOC
+/* Linked with --wrap=realloc: fail the next fail_reallocs calls */
+void* __real_realloc(void* ptr, size_t size);
+
+static int fail_reallocs;
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    if (fail_reallocs > 0) {
+        fail_reallocs--;
+        return NULL;
+    }
+    return __real_realloc(ptr, size);
+}
+#endif
+
+static prts_log_parser_t* text_parser(void) {
+    prts_parser_config_t config = {0};
+    config.format = PRTS_LOG_FORMAT_TEXT;
+
+    prts_log_parser_t* parser;
+    CHECK(prts_parser_create(&config, &parser) == PRTS_OK);
+    return parser;
+}
+
+/* Append the messages of every pending entry to out, separated by '|' */
+static void drain(prts_log_parser_t* parser, char* out, size_t out_size) {
+    prts_log_entry_t entries[2];
+    size_t count;
+    do {
+        CHECK(prts_parser_poll(parser, entries, 2, &count) == PRTS_OK);
+        for (size_t i = 0; i < count; i++) {
+            size_t len = strlen(out);
+            CHECK(len + entries[i].message_len + 2 <= out_size);
+            memcpy(out + len, entries[i].message, entries[i].message_len);
+            out[len + entries[i].message_len] = '|';
+            out[len + entries[i].message_len + 1] = '\0';
+        }
+    } while (count > 0);
+}
+
+/* Every chunk size splits lines differently; the entries must not change */
+static void test_feed_split_lines(void) {
+    const char* input =
+        "[INFO] hello world\n"
+        "[WARN] second line here\n"
+        "ERROR third\n"
+        "\n"
+        "[DEBUG] tail without newline";
+    const char* expected = "hello world|second line here|third|tail without newline|";
+    size_t input_len = strlen(input);
+
+    prts_log_parser_t* parser = text_parser();
+    for (size_t chunk_size = 1; chunk_size <= input_len; chunk_size++) {
+        prts_parser_reset(parser);
+
+        char got[256] = "";
+        for (size_t offset = 0; offset < input_len; offset += chunk_size) {
+            /* Feed from a scratch buffer so carried fragments cannot alias the input */
+            char chunk[128];
+            size_t len = input_len - offset < chunk_size ? input_len - offset : chunk_size;
+            memcpy(chunk, input + offset, len);
+            CHECK(prts_parser_feed(parser, chunk, len) == PRTS_OK);
+            drain(parser, got, sizeof(got));
+            memset(chunk, 'X', sizeof(chunk));
+        }
+        CHECK(prts_parser_finish(parser) == PRTS_OK);
+        drain(parser, got, sizeof(got));
+
+        CHECK(strcmp(got, expected) == 0);
+    }
+    prts_parser_destroy(parser);
+}
+
+/* finish returns the trailing fragment once; feeding waits for the poll */
+static void test_finish_flushes_fragment(void) {
+    prts_log_parser_t* parser = text_parser();
+
+    CHECK(prts_parser_feed(parser, "[INFO] first\n[INFO] sec", 23) == PRTS_OK);
+    CHECK(prts_parser_feed(parser, "ond", 3) == PRTS_ERROR_FULL);
+
+    char got[64] = "";
+    drain(parser, got, sizeof(got));
+    CHECK(strcmp(got, "first|") == 0);
+
+    CHECK(prts_parser_feed(parser, "ond", 3) == PRTS_OK);
+    CHECK(prts_parser_finish(parser) == PRTS_OK);
+    CHECK(prts_parser_finish(parser) == PRTS_ERROR_FULL);
+    drain(parser, got, sizeof(got));
+    CHECK(strcmp(got, "first|second|") == 0);
+
+    /* Nothing is left to flush */
+    CHECK(prts_parser_finish(parser) == PRTS_OK);
+    drain(parser, got, sizeof(got));
+    CHECK(strcmp(got, "first|second|") == 0);
+
+    prts_parser_destroy(parser);
+}
+
+static void write_file(const char* path, const char* contents) {
+    FILE* f = fopen(path, "wb");
+    CHECK(f != NULL);
+    CHECK(fwrite(contents, 1, strlen(contents), f) == strlen(contents));
+    CHECK(fclose(f) == 0);
+}
+
+/* Parse up to max_lines entries from the mapping cursor, one call per entry */
+static void parse_mapped(
+    prts_log_parser_t* parser,
+    prts_log_mapping_t* mapping,
+    size_t max_lines,
+    char* out,
+    size_t out_size
+) {
+    out[0] = '\0';
+    for (size_t i = 0; i < max_lines; i++) {
+        prts_log_entry_t entry;
+        size_t count;
+        CHECK(prts_parser_parse_mapping(parser, mapping, &entry, 1, &count) == PRTS_OK);
+        if (count == 0) {
+            break;
+        }
+        size_t len = strlen(out);
+        CHECK(len + entry.message_len + 2 <= out_size);
+        memcpy(out + len, entry.message, entry.message_len);
+        out[len + entry.message_len] = '|';
+        out[len + entry.message_len + 1] = '\0';
+    }
+}
+
+static const char* const mapping_paths[] = {
+    "test_parser_a.log",
+    "test_parser_empty.log",
+    "test_parser_c.log",
+};
+
+static prts_log_mapping_t* open_test_mapping(void) {
+    write_file(mapping_paths[0], "[INFO] a1\n\n[WARN] a2");
+    write_file(mapping_paths[1], "");
+    write_file(mapping_paths[2], "[ERROR] c1\n");
+
+    prts_log_mapping_t* mapping;
+    CHECK(prts_log_mapping_open(mapping_paths, 3, &mapping) == PRTS_OK);
+    return mapping;
+}
+
+static void close_test_mapping(prts_log_mapping_t* mapping) {
+    prts_log_mapping_close(mapping);
+    for (size_t i = 0; i < 3; i++) {
+        remove(mapping_paths[i]);
+    }
+}
+
+/* Empty files map to nothing; a last line without a newline still parses */
+static void test_mapping_files(void) {
+    prts_log_mapping_t* mapping = open_test_mapping();
+    prts_log_parser_t* parser = text_parser();
+
+    const char* data;
+    size_t len;
+    CHECK(prts_log_mapping_count(mapping) == 3);
+    CHECK(prts_log_mapping_data(mapping, 1, &data, &len) == PRTS_OK);
+    CHECK(data == NULL && len == 0);
+    CHECK(prts_log_mapping_data(mapping, 0, &data, &len) == PRTS_OK);
+    CHECK(len == 20 && memcmp(data, "[INFO] a1", 9) == 0);
+
+    char got[64];
+    parse_mapped(parser, mapping, 16, got, sizeof(got));
+    CHECK(strcmp(got, "a1|a2|c1|") == 0);
+
+    size_t file, offset;
+    prts_log_mapping_tell(mapping, &file, &offset);
+    CHECK(file == 3 && offset == 0);
+    parse_mapped(parser, mapping, 16, got, sizeof(got));
+    CHECK(got[0] == '\0');
+
+    prts_parser_destroy(parser);
+    close_test_mapping(mapping);
+}
+
+/* tell checkpoints the cursor; seek and rewind resume from it exactly */
+static void test_mapping_seek_tell(void) {
+    prts_log_mapping_t* mapping = open_test_mapping();
+    prts_log_parser_t* parser = text_parser();
+
+    char got[64];
+    parse_mapped(parser, mapping, 1, got, sizeof(got));
+    CHECK(strcmp(got, "a1|") == 0);
+
+    size_t file, offset;
+    prts_log_mapping_tell(mapping, &file, &offset);
+    CHECK(file == 0 && offset == 10);
+
+    parse_mapped(parser, mapping, 16, got, sizeof(got));
+    CHECK(strcmp(got, "a2|c1|") == 0);
+
+    CHECK(prts_log_mapping_seek(mapping, file, offset) == PRTS_OK);
+    parse_mapped(parser, mapping, 1, got, sizeof(got));
+    CHECK(strcmp(got, "a2|") == 0);
+
+    /* The end of a file moves on to the next non-empty one */
+    CHECK(prts_log_mapping_seek(mapping, 0, 20) == PRTS_OK);
+    parse_mapped(parser, mapping, 16, got, sizeof(got));
+    CHECK(strcmp(got, "c1|") == 0);
+
+    prts_log_mapping_rewind(mapping);
+    prts_log_mapping_tell(mapping, &file, &offset);
+    CHECK(file == 0 && offset == 0);
+    parse_mapped(parser, mapping, 16, got, sizeof(got));
+    CHECK(strcmp(got, "a1|a2|c1|") == 0);
+
+    CHECK(prts_log_mapping_seek(mapping, 3, 0) == PRTS_OK);
+    parse_mapped(parser, mapping, 16, got, sizeof(got));
+    CHECK(got[0] == '\0');
+
+    /* Out-of-range positions leave the cursor alone */
+    CHECK(prts_log_mapping_seek(mapping, 0, 21) == PRTS_ERROR_INVALID);
+    CHECK(prts_log_mapping_seek(mapping, 4, 0) == PRTS_ERROR_INVALID);
+    prts_log_mapping_tell(mapping, &file, &offset);
+    CHECK(file == 3 && offset == 0);
+
+    prts_parser_destroy(parser);
+    close_test_mapping(mapping);
+}
+
+/*
+ * Parallel parsing splits near equal offsets, so with uneven line lengths
+ * most chunk boundaries fall inside a line. The entries must match a
+ * sequential batch parse exactly, in order.
+ */
+static void test_parallel_matches_batch(void) {
+    enum { LINES = 100000 };
+    static const char* const levels[] = { "INFO", "WARN", "ERROR", "DEBUG" };
+
+    char* data = malloc((size_t)LINES * 128);
+    CHECK(data != NULL);
+    size_t len = 0;
+    for (size_t i = 0; i < LINES; i++) {
+        if (i % 1000 == 999) {
+            data[len++] = '\n';
+            continue;
+        }
+        len += (size_t)sprintf(data + len, "[%s] line %zu %.*s\n", levels[i % 4], i,
+                               (int)(i * 7919 % 80), "................................"
+                               "................................................");
+    }
+    len--;                          /* The last line has no newline */
+    CHECK(len > 4 * 1024 * 1024);
+
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 4;
+    config.queue_size = 64;
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+
+    prts_log_parser_t* batch_parser = text_parser();
+    prts_log_parser_t* parallel_parser = text_parser();
+    prts_log_entry_t* batch = malloc(LINES * sizeof(prts_log_entry_t));
+    prts_log_entry_t* parallel = malloc(LINES * sizeof(prts_log_entry_t));
+    CHECK(batch != NULL && parallel != NULL);
+
+    size_t batch_count, parallel_count;
+    CHECK(prts_parser_parse_batch(batch_parser, data, len, batch, LINES,
+                                  &batch_count) == PRTS_OK);
+    CHECK(batch_count == LINES - LINES / 1000);
+    CHECK(prts_parser_parse_parallel(parallel_parser, pool, data, len, parallel, LINES,
+                                     &parallel_count) == PRTS_OK);
+    CHECK(parallel_count == batch_count);
+
+    for (size_t i = 0; i < batch_count; i++) {
+        CHECK(parallel[i].raw == batch[i].raw && parallel[i].raw_len == batch[i].raw_len);
+        CHECK(parallel[i].level == batch[i].level);
+        CHECK(parallel[i].timestamp == batch[i].timestamp);
+        CHECK(parallel[i].message_len == batch[i].message_len);
+        CHECK(memcmp(parallel[i].message, batch[i].message, batch[i].message_len) == 0);
+    }
+
+    /* max_entries truncates to the same prefix */
+    CHECK(prts_parser_parse_parallel(parallel_parser, pool, data, len, parallel, 1000,
+                                     &parallel_count) == PRTS_OK);
+    CHECK(parallel_count == 1000);
+    CHECK(parallel[999].raw == batch[999].raw);
+
+    CHECK(prts_parser_parse_parallel(parallel_parser, pool, data, len, parallel, 0,
+                                     &parallel_count) == PRTS_OK);
+    CHECK(parallel_count == 0);
+
+    free(parallel);
+    free(batch);
+    prts_parser_destroy(parallel_parser);
+    prts_parser_destroy(batch_parser);
+    prts_threadpool_destroy(pool);
+    free(data);
+}
+
+/* Patterns with no delimiter between captures or an unclosed capture are rejected */
+static void test_template_compile(void) {
+    prts_log_parser_t* parser = text_parser();
+
+    CHECK(prts_parser_set_template(parser, "%{host} %{message}") == PRTS_OK);
+    CHECK(prts_parser_set_template(parser, "%{a}%{b}") == PRTS_ERROR_INVALID);
+    CHECK(prts_parser_set_template(parser, "[%{level}]%{}%{message}") == PRTS_ERROR_INVALID);
+    CHECK(prts_parser_set_template(parser, "%{level} %{message") == PRTS_ERROR_INVALID);
+    CHECK(prts_parser_set_template(parser, "trailing %{") == PRTS_ERROR_INVALID);
+    CHECK(prts_parser_set_template(parser, "") == PRTS_ERROR_INVALID);
+
+    /* A rejected pattern keeps the previous template */
+    prts_log_entry_t entry;
+    CHECK(prts_parser_parse(parser, "web1 [INFO] up", 14, &entry) == PRTS_OK);
+    CHECK(entry.num_fields == 1 && strcmp(entry.field_names[0], "host") == 0);
+    CHECK(strcmp(entry.field_values[0], "web1") == 0);
+
+    /* "%%" is a literal percent, not the start of a capture */
+    CHECK(prts_parser_set_template(parser, "100%%{x} %{message}") == PRTS_OK);
+    CHECK(prts_parser_parse(parser, "100%{x} done", 12, &entry) == PRTS_OK);
+    CHECK(entry.num_fields == 0 && entry.message_len == 4);
+    CHECK(memcmp(entry.message, "done", 4) == 0);
+
+    prts_parser_destroy(parser);
+}
+
+/* A trailing literal must end the line; otherwise the generic parser takes over */
+static void test_template_trailing_literal(void) {
+    prts_log_parser_t* parser = text_parser();
+    CHECK(prts_parser_set_template(parser, "%{host} %{level}: %{message};") == PRTS_OK);
+
+    prts_log_entry_t entry;
+    const char* line = "db2 WARN: disk at 91%;";
+    CHECK(prts_parser_parse(parser, line, strlen(line), &entry) == PRTS_OK);
+    CHECK(entry.level == PRTS_LOG_WARN);
+    CHECK(entry.message_len == 11 && memcmp(entry.message, "disk at 91%", 11) == 0);
+    CHECK(entry.num_fields == 1 && strcmp(entry.field_values[0], "db2") == 0);
+
+    /* The message stops at the first ';', which then is not at the end */
+    line = "db2 ERROR: a; b;";
+    CHECK(prts_parser_parse(parser, line, strlen(line), &entry) == PRTS_OK);
+    CHECK(entry.num_fields == 0 && entry.raw_len == strlen(line));
+
+    line = "db2 ERROR: no terminator";
+    CHECK(prts_parser_parse(parser, line, strlen(line), &entry) == PRTS_OK);
+    CHECK(entry.num_fields == 0);
+
+    prts_parser_destroy(parser);
+}
+
+/* Field names of a parallel parse outlive the per-chunk parsers */
+static void test_template_parallel_fields(void) {
+    enum { LINES = 100000 };
+
+    char* data = malloc((size_t)LINES * 64);
+    CHECK(data != NULL);
+    size_t len = 0;
+    for (size_t i = 0; i < LINES; i++) {
+        len += (size_t)sprintf(data + len, "T%zu [INFO] (tool%zu) f%zu.c:%zu: msg %zu\n",
+                               i, i % 7, i, i % 977, i);
+    }
+    CHECK(len > 2 * 1024 * 1024);
+
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 4;
+    config.queue_size = 64;
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+
+    prts_log_parser_t* parser = text_parser();
+    CHECK(prts_parser_set_template(parser,
+        "%{timestamp} [%{level}] (%{source}) %{file}:%{line}: %{message}") == PRTS_OK);
+
+    prts_log_entry_t* entries = malloc(LINES * sizeof(prts_log_entry_t));
+    CHECK(entries != NULL);
+    size_t count;
+    CHECK(prts_parser_parse_parallel(parser, pool, data, len, entries, LINES,
+                                     &count) == PRTS_OK);
+    CHECK(count == LINES);
+
+    for (size_t i = 0; i < count; i++) {
+        char expected[32];
+        CHECK(entries[i].num_fields == 3);
+        CHECK(entries[i].field_names == entries[0].field_names);
+        CHECK(strcmp(entries[i].field_names[0], "timestamp") == 0);
+        CHECK(strcmp(entries[i].field_names[1], "file") == 0);
+        CHECK(strcmp(entries[i].field_names[2], "line") == 0);
+        sprintf(expected, "f%zu.c", i);
+        CHECK(strcmp(entries[i].field_values[1], expected) == 0);
+        sprintf(expected, "%zu", i % 977);
+        CHECK(strcmp(entries[i].field_values[2], expected) == 0);
+    }
+
+    free(entries);
+    prts_parser_destroy(parser);
+    prts_threadpool_destroy(pool);
+    free(data);
+}
+
+/* Level keywords in any case, as prefixes and in lines shorter than a word */
+static void test_level_keywords(void) {
+    static const struct {
+        const char* line;
+        prts_log_level_t level;
+        const char* message;
+    } cases[] = {
+        { "[TRACE] t", PRTS_LOG_TRACE, "t" },
+        { "debug", PRTS_LOG_DEBUG, "" },
+        { "Info hello", PRTS_LOG_INFO, "hello" },
+        { "warn w", PRTS_LOG_WARN, "w" },
+        { "ERROR x", PRTS_LOG_ERROR, "x" },
+        { "fAtAl!", PRTS_LOG_FATAL, "!" },
+        { "WARNING disk", PRTS_LOG_WARN, "ING disk" },
+        { "tracer", PRTS_LOG_TRACE, "r" },
+        { "[warn] w", PRTS_LOG_WARN, "w" },
+        { "2026-01-01 12:00:00 ERROR boom", PRTS_LOG_ERROR, "boom" },
+        /* Not keywords: too short, a near miss, or only equal after folding bit 5 */
+        { "inf", PRTS_LOG_INFO, "inf" },
+        { "Err", PRTS_LOG_INFO, "Err" },
+        { "DEBU", PRTS_LOG_INFO, "DEBU" },
+        { "errr x", PRTS_LOG_INFO, "errr x" },
+        { "\x14RACE", PRTS_LOG_INFO, "\x14RACE" },
+        { "[Err] q", PRTS_LOG_INFO, "q" },
+    };
+
+    prts_log_parser_t* parser = text_parser();
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        /* An exact-size copy lets sanitizers catch reads past the line */
+        size_t len = strlen(cases[i].line);
+        char* line = malloc(len > 0 ? len : 1);
+        CHECK(line != NULL);
+        memcpy(line, cases[i].line, len);
+
+        prts_log_entry_t entry;
+        CHECK(prts_parser_parse(parser, line, len, &entry) == PRTS_OK);
+        CHECK(entry.level == cases[i].level);
+        CHECK(entry.message_len == strlen(cases[i].message));
+        CHECK(memcmp(entry.message, cases[i].message, entry.message_len) == 0);
+        free(line);
+    }
+    prts_parser_destroy(parser);
+}
+
+/* AUTO detects per line in batches, but once per stream or mapped file */
+static void test_auto_format(void) {
+    const char* data = "[WARN] text first\n{\"level\":\"error\",\"msg\":\"json\"}\n";
+    size_t len = strlen(data);
+
+    prts_parser_config_t config = {0};
+    config.format = PRTS_LOG_FORMAT_AUTO;
+    prts_log_parser_t* parser;
+    CHECK(prts_parser_create(&config, &parser) == PRTS_OK);
+
+    prts_log_entry_t entries[4];
+    size_t count;
+    CHECK(prts_parser_parse_batch(parser, data, len, entries, 4, &count) == PRTS_OK);
+    CHECK(count == 2);
+    CHECK(entries[0].level == PRTS_LOG_WARN);
+    CHECK(entries[1].level == PRTS_LOG_ERROR);
+    CHECK(entries[1].message_len == 4 && memcmp(entries[1].message, "json", 4) == 0);
+
+    /* The stream locks in TEXT, so the JSON line is text with no level keyword */
+    CHECK(prts_parser_feed(parser, data, len) == PRTS_OK);
+    CHECK(prts_parser_poll(parser, entries, 4, &count) == PRTS_OK);
+    CHECK(count == 2);
+    CHECK(entries[0].level == PRTS_LOG_WARN);
+    CHECK(entries[1].level == PRTS_LOG_INFO);
+    CHECK(entries[1].message == entries[1].raw);
+
+    /* reset starts a new stream, detected from its first line */
+    prts_parser_reset(parser);
+    const char* json_first = strchr(data, '\n') + 1;
+    CHECK(prts_parser_feed(parser, json_first, strlen(json_first)) == PRTS_OK);
+    CHECK(prts_parser_poll(parser, entries, 4, &count) == PRTS_OK);
+    CHECK(count == 1 && entries[0].level == PRTS_LOG_ERROR);
+
+    /* Each mapped file is its own source */
+    const char* paths[] = { "test_parser_text.log", "test_parser_json.log" };
+    write_file(paths[0], "[WARN] text\n[INFO] more text\n");
+    write_file(paths[1], json_first);
+    prts_log_mapping_t* mapping;
+    CHECK(prts_log_mapping_open(paths, 2, &mapping) == PRTS_OK);
+    CHECK(prts_parser_parse_mapping(parser, mapping, entries, 4, &count) == PRTS_OK);
+    CHECK(count == 3);
+    CHECK(entries[2].level == PRTS_LOG_ERROR);
+    CHECK(entries[2].message_len == 4 && memcmp(entries[2].message, "json", 4) == 0);
+    prts_log_mapping_close(mapping);
+    remove(paths[0]);
+    remove(paths[1]);
+
+    prts_parser_destroy(parser);
+}
+
+#ifdef PRTS_TEST_WRAP_REALLOC
+/* A feed that cannot grow its buffers fails whole and can be retried */
+static void test_feed_nomem_keeps_carry(void) {
+    prts_log_parser_t* parser = text_parser();
+
+    CHECK(prts_parser_feed(parser, "[INFO] carr", 11) == PRTS_OK);
+
+    /* Completing the fragment needs the join buffer; the long tail needs more carry */
+    char chunk[600];
+    memcpy(chunk, "ied\n[WARN] ", 11);
+    memset(chunk + 11, 'x', sizeof(chunk) - 11);
+
+    fail_reallocs = 1;
+    CHECK(prts_parser_feed(parser, chunk, sizeof(chunk)) == PRTS_ERROR_NOMEM);
+    fail_reallocs = 0;
+
+    char got[1024] = "";
+    drain(parser, got, sizeof(got));
+    CHECK(got[0] == '\0');
+
+    CHECK(prts_parser_feed(parser, chunk, sizeof(chunk)) == PRTS_OK);
+    CHECK(prts_parser_finish(parser) == PRTS_ERROR_FULL);
+    drain(parser, got, sizeof(got));
+    CHECK(strcmp(got, "carried|") == 0);
+
+    CHECK(prts_parser_finish(parser) == PRTS_OK);
+    drain(parser, got, sizeof(got));
+    CHECK(strlen(got) == strlen("carried|") + sizeof(chunk) - 11 + 1);
+
+    prts_parser_destroy(parser);
+}
+#endif
+
+int main(void) {
+    test_feed_split_lines();
+    test_finish_flushes_fragment();
+    test_mapping_files();
+    test_mapping_seek_tell();
+    test_parallel_matches_batch();
+    test_template_compile();
+    test_template_trailing_literal();
+    test_template_parallel_fields();
+    test_level_keywords();
+    test_auto_format();
+#ifdef PRTS_TEST_WRAP_REALLOC
+    test_feed_nomem_keeps_carry();
+#endif
+    printf("test_parser: ok\n");
+    return 0;
+}
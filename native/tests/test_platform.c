@@ -0,0 +1,210 @@
+/**
+ * PRTS Native - Platform Tests
+ */
+
+#ifndef _WIN32
+#define _GNU_SOURCE
+#endif
+
+#include "prts/platform.h"
+#include "prts/thread_pool.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+#ifdef PRTS_TEST_WRAP_FOPEN
+/* Linked with --wrap=fopen: while sysfs_root is set, node sysfs paths open under it */
+#define NODE_SYSFS "/sys/devices/system/node"
+
+FILE* __real_fopen(const char* path, const char* mode);
+
+static char sysfs_root[256];
+
+FILE* __wrap_fopen(const char* path, const char* mode) {
+    size_t prefix = strlen(NODE_SYSFS);
+    if (sysfs_root[0] && strncmp(path, NODE_SYSFS, prefix) == 0) {
+        char redirected[512];
+        snprintf(redirected, sizeof(redirected), "%s%s", sysfs_root, path + prefix);
+        return __real_fopen(redirected, mode);
+    }
+    return __real_fopen(path, mode);
+}
+
+static void write_file(const char* name, const char* contents) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", sysfs_root, name);
+    FILE* f = __real_fopen(path, "w");
+    CHECK(f != NULL);
+    fputs(contents, f);
+    fclose(f);
+}
+
+static void remove_file(const char* name) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", sysfs_root, name);
+    remove(path);
+}
+
+static size_t cpu_set_count(const prts_cpu_set_t* set) {
+    size_t count = 0;
+    for (size_t i = 0; i < PRTS_MAX_CPUS; i++) {
+        count += prts_cpu_set_has(set, i);
+    }
+    return count;
+}
+
+/* Lists are parsed from the node files: ranges, single CPUs, empty and bad files */
+static void test_cpu_list_parsing(void) {
+    char dir[] = "/tmp/prts_sysfs_XXXXXX";
+    CHECK(mkdtemp(dir) != NULL);
+    snprintf(sysfs_root, sizeof(sysfs_root), "%s", dir);
+
+    char node_dir[512];
+    for (int node = 0; node < 3; node++) {
+        snprintf(node_dir, sizeof(node_dir), "%s/node%d", dir, node);
+        CHECK(mkdir(node_dir, 0700) == 0);
+    }
+    write_file("online", "0-2\n");
+    CHECK(prts_numa_node_count() == 3);
+
+    prts_cpu_set_t cpus;
+    write_file("node0/cpulist", "0-3,8-11\n");
+    CHECK(prts_numa_node_cpus(0, &cpus) == PRTS_OK);
+    CHECK(cpu_set_count(&cpus) == 8);
+    for (size_t i = 0; i < 12; i++) {
+        CHECK(prts_cpu_set_has(&cpus, i) == (i < 4 || i >= 8));
+    }
+
+    /* A single CPU, without a trailing newline */
+    write_file("node1/cpulist", "5");
+    CHECK(prts_numa_node_cpus(1, &cpus) == PRTS_OK);
+    CHECK(cpu_set_count(&cpus) == 1);
+    CHECK(prts_cpu_set_has(&cpus, 5));
+
+    /* CPUs past PRTS_MAX_CPUS are dropped */
+    write_file("node1/cpulist", "1,1022-4000\n");
+    CHECK(prts_numa_node_cpus(1, &cpus) == PRTS_OK);
+    CHECK(cpu_set_count(&cpus) == 3);
+    CHECK(prts_cpu_set_has(&cpus, 1));
+    CHECK(prts_cpu_set_has(&cpus, PRTS_MAX_CPUS - 1));
+
+    /* A memory-only node lists no CPUs, as do empty and missing files */
+    write_file("node2/cpulist", "\n");
+    CHECK(prts_numa_node_cpus(2, &cpus) == PRTS_ERROR_INVALID);
+    write_file("node2/cpulist", "");
+    CHECK(prts_numa_node_cpus(2, &cpus) == PRTS_ERROR_INVALID);
+    remove_file("node2/cpulist");
+    CHECK(prts_numa_node_cpus(2, &cpus) == PRTS_ERROR_INVALID);
+
+    write_file("node2/cpulist", "4-x\n");
+    CHECK(prts_numa_node_cpus(2, &cpus) == PRTS_ERROR_INVALID);
+    write_file("node2/cpulist", "x\n");
+    CHECK(prts_numa_node_cpus(2, &cpus) == PRTS_ERROR_INVALID);
+
+    CHECK(prts_numa_node_cpus(PRTS_MAX_NUMA_NODES, &cpus) == PRTS_ERROR_INVALID);
+    CHECK(prts_numa_node_cpus(0, NULL) == PRTS_ERROR_INVALID);
+
+    /* Gaps in the online list still count up to the highest node */
+    write_file("online", "0,2\n");
+    CHECK(prts_numa_node_count() == 3);
+    write_file("online", "");
+    CHECK(prts_numa_node_count() == 1);
+
+    remove_file("online");
+    for (int node = 0; node < 3; node++) {
+        char name[32];
+        snprintf(name, sizeof(name), "node%d/cpulist", node);
+        remove_file(name);
+        snprintf(node_dir, sizeof(node_dir), "%s/node%d", dir, node);
+        rmdir(node_dir);
+    }
+    rmdir(dir);
+    sysfs_root[0] = '\0';
+}
+#endif
+
+static _Atomic int ran;
+
+static void count_task(void* arg) {
+    (void)arg;
+    atomic_fetch_add(&ran, 1);
+}
+
+/* A NUMA pool has a working pool for node 0 and none past the last node */
+static void check_numa_pool(void) {
+    size_t nodes = prts_numa_node_count();
+    CHECK(nodes >= 1);
+
+    prts_cpu_set_t cpus;
+    CHECK(prts_numa_node_cpus(0, &cpus) == PRTS_OK);
+    CHECK(!prts_cpu_set_empty(&cpus));
+
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 2;
+    config.queue_size = 64;
+
+    prts_numa_pool_t* numa;
+    CHECK(prts_numa_pool_create(&config, &numa) == PRTS_OK);
+    prts_thread_pool_t* node0 = prts_numa_pool_node(numa, 0);
+    CHECK(node0 != NULL);
+    CHECK(prts_numa_pool_node(numa, nodes) == NULL);
+    CHECK(prts_numa_pool_node(numa, PRTS_MAX_NUMA_NODES) == NULL);
+
+    prts_thread_pool_t* local = prts_numa_pool_local(numa);
+    CHECK(local != NULL);
+
+    atomic_store(&ran, 0);
+    for (int i = 0; i < 100; i++) {
+        CHECK(prts_threadpool_submit(node0, count_task, NULL) == PRTS_OK);
+        CHECK(prts_threadpool_submit(local, count_task, NULL) == PRTS_OK);
+    }
+    prts_threadpool_wait_all(node0);
+    prts_threadpool_wait_all(local);
+    CHECK(atomic_load(&ran) == 200);
+
+    prts_numa_pool_destroy(numa);
+}
+
+/* NUMA pools on this machine's own topology */
+static void test_numa_pool(void) {
+    check_numa_pool();
+}
+
+#ifdef PRTS_TEST_WRAP_FOPEN
+/* Without node sysfs, node 0 holds every CPU and NUMA pools still work */
+static void test_numa_fallback(void) {
+    snprintf(sysfs_root, sizeof(sysfs_root), "/nonexistent/prts_sysfs");
+    CHECK(prts_numa_node_count() == 1);
+
+    prts_cpu_set_t cpus;
+    CHECK(prts_numa_node_cpus(0, &cpus) == PRTS_OK);
+    CHECK(cpu_set_count(&cpus) == (prts_cpu_count() < PRTS_MAX_CPUS ? prts_cpu_count() : PRTS_MAX_CPUS));
+    CHECK(prts_numa_node_cpus(1, &cpus) == PRTS_ERROR_INVALID);
+
+    check_numa_pool();
+    sysfs_root[0] = '\0';
+}
+#endif
+
+int main(void) {
+#ifdef PRTS_TEST_WRAP_FOPEN
+    test_cpu_list_parsing();
+    test_numa_fallback();
+#endif
+    test_numa_pool();
+    printf("test_platform: ok\n");
+    return 0;
+}
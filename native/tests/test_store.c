@@ -0,0 +1,519 @@
+/**
+ * PRTS Native - Series Store Tests
+ */
+
+#include "prts/metrics.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+#define MS 1000000ULL
+#define SECOND (1000 * MS)
+
+#ifdef PRTS_TEST_WRAP_CALLOC
+/* Linked with --wrap=calloc: while fail_calloc_every is set, fail every Nth call */
+void* __real_calloc(size_t count, size_t size);
+
+static int fail_calloc_every;
+static int calloc_calls;
+
+void* __wrap_calloc(size_t count, size_t size) {
+    if (fail_calloc_every > 0 && ++calloc_calls % fail_calloc_every == 0) {
+        return NULL;
+    }
+    return __real_calloc(count, size);
+}
+#endif
+
+/* Any key works for direct appends */
+#define KEY 0x5eedULL
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static double from_bits(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/* Rollups are left out so only the raw codec is exercised */
+static prts_series_store_t* create_store(prts_metrics_collector_t** collector_out,
+                                         size_t chunk_bytes) {
+    static const prts_rollup_tier_t no_tiers[1];
+    CHECK(prts_metrics_create(collector_out) == PRTS_OK);
+
+    prts_store_config_t config = {0};
+    config.retention = 1000ULL * 24 * 3600 * SECOND;
+    config.chunk_bytes = chunk_bytes;
+    config.rollup_tiers = no_tiers;
+    config.num_rollup_tiers = 0;
+
+    prts_series_store_t* store;
+    CHECK(prts_series_store_create(*collector_out, &config, &store) == PRTS_OK);
+    return store;
+}
+
+/* Read back the whole series and compare timestamps and value bits exactly */
+static void check_roundtrip(
+    prts_series_store_t* store,
+    const prts_sample_t* expected,
+    size_t count
+) {
+    prts_sample_t* samples = malloc((count + 1) * sizeof(prts_sample_t));
+    CHECK(samples != NULL);
+    size_t found;
+    CHECK(prts_series_store_query(store, KEY, 0, UINT64_MAX, samples, count + 1, &found) ==
+          PRTS_OK);
+    CHECK(found == count);
+    for (size_t i = 0; i < count; i++) {
+        CHECK(samples[i].timestamp == expected[i].timestamp);
+        CHECK(memcmp(&samples[i].value, &expected[i].value, sizeof(double)) == 0);
+    }
+    free(samples);
+}
+
+/* NaN payloads, signed zeros, infinities and subnormals survive XOR coding */
+static void test_special_values(void) {
+    prts_metrics_collector_t* collector;
+    prts_series_store_t* store = create_store(&collector, 0);
+
+    const double values[] = {
+        0.0, -0.0, 0.0, NAN, -NAN, from_bits(0x7ff0000000000001ULL),
+        from_bits(0x7ff8dead0000beefULL), INFINITY, -INFINITY, INFINITY,
+        DBL_MIN, DBL_TRUE_MIN, -DBL_TRUE_MIN, DBL_MAX, -DBL_MAX, 1.0, 1.0, 1.0,
+        -0.0, -0.0, NAN, NAN, 0.1, 0.2, 0.30000000000000004,
+    };
+    enum { COUNT = sizeof(values) / sizeof(values[0]) };
+
+    prts_sample_t expected[COUNT];
+    for (size_t i = 0; i < COUNT; i++) {
+        expected[i].timestamp = (1700000000000ULL + i * 10000) * MS;
+        expected[i].value = values[i];
+        CHECK(prts_series_store_append(store, KEY, expected[i].timestamp, values[i]) == PRTS_OK);
+    }
+    check_roundtrip(store, expected, COUNT);
+
+    prts_series_store_destroy(store);
+    prts_metrics_destroy(collector);
+}
+
+/*
+ * XORs with 31 or more leading zeros are clamped to the 5-bit header;
+ * mix them with windows that grow, shrink and get reused.
+ */
+static void test_leading_zeros(void) {
+    enum { COUNT = 400 };
+    prts_metrics_collector_t* collector;
+    prts_series_store_t* store = create_store(&collector, 0);
+
+    prts_sample_t expected[COUNT];
+    uint64_t bits = 0x3ff0000000000000ULL;
+    for (size_t i = 0; i < COUNT; i++) {
+        unsigned shift = (unsigned)(next_random() % 64);
+        switch (i % 5) {
+            case 0: bits ^= 1ULL << (shift % 33); break;                 /* >= 31 leading */
+            case 1: bits ^= 1ULL; break;                                 /* 63 leading */
+            case 2: bits ^= 1ULL << 32 | 1ULL; break;                    /* Exactly 31 */
+            case 3: bits ^= next_random() >> shift; break;
+            case 4: bits ^= 1ULL << 63 | 1ULL; break;                    /* Full width */
+        }
+        expected[i].timestamp = (1000 + i) * SECOND;
+        expected[i].value = from_bits(bits);
+        CHECK(prts_series_store_append(store, KEY, expected[i].timestamp, expected[i].value) ==
+              PRTS_OK);
+    }
+    check_roundtrip(store, expected, COUNT);
+
+    prts_series_store_destroy(store);
+    prts_metrics_destroy(collector);
+}
+
+/* Delta-of-deltas at each bucket edge, and appends that do not move forward */
+static void test_timestamps(void) {
+    prts_metrics_collector_t* collector;
+    prts_series_store_t* store = create_store(&collector, 0);
+
+    static const int64_t dods[] = {
+        0, 1, -1, 64, -63, 65, -64, 256, -255, 257, -256, 2048, -2047, 2049, -2048,
+        INT32_MAX, -(int64_t)INT32_MAX, (int64_t)INT32_MAX + 1, 0, 0,
+        -(int64_t)INT32_MAX - 1, 5000000000LL, -4999999000LL,
+    };
+    enum { COUNT = sizeof(dods) / sizeof(dods[0]) + 2 };
+
+    prts_sample_t expected[COUNT];
+    uint64_t ms = 1700000000000ULL;
+    int64_t delta = 10000000000LL;
+    expected[0].timestamp = ms * MS;
+    expected[1].timestamp = (ms += (uint64_t)delta) * MS;
+    for (size_t i = 0; i + 2 < COUNT; i++) {
+        delta += dods[i];
+        CHECK(delta > 0);
+        expected[i + 2].timestamp = (ms += (uint64_t)delta) * MS;
+    }
+
+    for (size_t i = 0; i < COUNT; i++) {
+        expected[i].value = (double)i;
+        CHECK(prts_series_store_append(store, KEY, expected[i].timestamp, expected[i].value) ==
+              PRTS_OK);
+
+        /* Earlier and same-millisecond timestamps are refused without side effects */
+        prts_timestamp_t t = expected[i].timestamp;
+        CHECK(prts_series_store_append(store, KEY, t, -1.0) == PRTS_ERROR_INVALID);
+        CHECK(prts_series_store_append(store, KEY, t + MS - 1, -1.0) == PRTS_ERROR_INVALID);
+        CHECK(prts_series_store_append(store, KEY, t - MS, -1.0) == PRTS_ERROR_INVALID);
+    }
+    check_roundtrip(store, expected, COUNT);
+
+    /* Sub-millisecond parts are truncated */
+    prts_sample_t truncated = { expected[COUNT - 1].timestamp + 2 * MS, 7.0 };
+    CHECK(prts_series_store_append(store, KEY, truncated.timestamp + 999999, 7.0) == PRTS_OK);
+    prts_sample_t last;
+    size_t found;
+    CHECK(prts_series_store_query(store, KEY, truncated.timestamp, UINT64_MAX, &last, 1,
+                                  &found) == PRTS_OK);
+    CHECK(found == 1 && last.timestamp == truncated.timestamp && last.value == 7.0);
+
+    prts_series_store_destroy(store);
+    prts_metrics_destroy(collector);
+}
+
+/* Small chunks: ranges starting and ending anywhere decode the same samples */
+static void test_chunk_boundaries(void) {
+    enum { COUNT = 3000 };
+    prts_metrics_collector_t* collector;
+    prts_series_store_t* store = create_store(&collector, 64);
+
+    prts_sample_t* expected = malloc(COUNT * sizeof(prts_sample_t));
+    prts_sample_t* samples = malloc(COUNT * sizeof(prts_sample_t));
+    CHECK(expected != NULL && samples != NULL);
+
+    prts_timestamp_t t = 1700000000000ULL * MS;
+    for (size_t i = 0; i < COUNT; i++) {
+        t += (i % 7 == 0 ? next_random() % 100000 + 1 : 10000) * MS;
+        uint64_t r = next_random();
+        expected[i].timestamp = t;
+        expected[i].value = i % 3 == 0 ? from_bits(r) : (double)(r % 1000);
+        CHECK(prts_series_store_append(store, KEY, t, expected[i].value) == PRTS_OK);
+    }
+
+    prts_store_stats_t stats;
+    CHECK(prts_series_store_stats(store, &stats) == PRTS_OK);
+    CHECK(stats.num_series == 1 && stats.num_samples == COUNT && stats.num_chunks > 100);
+    check_roundtrip(store, expected, COUNT);
+
+    for (int round = 0; round < 500; round++) {
+        size_t a = next_random() % COUNT;
+        size_t b = a + next_random() % (COUNT - a);
+        size_t found;
+        CHECK(prts_series_store_query(store, KEY, expected[a].timestamp, expected[b].timestamp,
+                                      samples, COUNT, &found) == PRTS_OK);
+        CHECK(found == b - a + 1);
+        CHECK(memcmp(samples, expected + a, found * sizeof(prts_sample_t)) == 0);
+
+        /* Bounds between samples exclude both neighbours */
+        if (b > a + 1) {
+            CHECK(prts_series_store_query(store, KEY, expected[a].timestamp + 1,
+                                          expected[b].timestamp - 1, samples, COUNT,
+                                          &found) == PRTS_OK);
+            CHECK(found == b - a - 1);
+            CHECK(memcmp(samples, expected + a + 1, found * sizeof(prts_sample_t)) == 0);
+        }
+
+        /* max_samples truncates to the oldest samples */
+        size_t limit = next_random() % 50;
+        CHECK(prts_series_store_query(store, KEY, expected[a].timestamp, UINT64_MAX, samples,
+                                      limit, &found) == PRTS_OK);
+        CHECK(found == (limit < COUNT - a ? limit : COUNT - a));
+        CHECK(memcmp(samples, expected + a, found * sizeof(prts_sample_t)) == 0);
+    }
+
+    free(samples);
+    free(expected);
+    prts_series_store_destroy(store);
+    prts_metrics_destroy(collector);
+}
+
+/* Rollup tiers of 1s and 10s; retentions of 0 give a day */
+static prts_series_store_t* create_rollup_store(
+    prts_metrics_collector_t** collector_out,
+    prts_timestamp_t retention,
+    prts_timestamp_t fine_retention,
+    prts_timestamp_t coarse_retention
+) {
+    const prts_timestamp_t day = 24ULL * 3600 * SECOND;
+    const prts_rollup_tier_t tiers[] = {
+        { SECOND, fine_retention ? fine_retention : day },
+        { 10 * SECOND, coarse_retention ? coarse_retention : day },
+    };
+    CHECK(prts_metrics_create(collector_out) == PRTS_OK);
+
+    prts_store_config_t config = {0};
+    config.retention = retention ? retention : day;
+    config.chunk_bytes = 64;
+    config.rollup_tiers = tiers;
+    config.num_rollup_tiers = 2;
+
+    prts_series_store_t* store;
+    CHECK(prts_series_store_create(*collector_out, &config, &store) == PRTS_OK);
+    return store;
+}
+
+/* Aggregate samples into step buckets directly, skipping NaN */
+static size_t expected_rollup(
+    const prts_sample_t* samples,
+    size_t count,
+    prts_timestamp_t step,
+    prts_rollup_point_t* points_out
+) {
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        double v = samples[i].value;
+        if (v != v) continue;
+
+        prts_timestamp_t bucket = samples[i].timestamp - samples[i].timestamp % step;
+        if (n == 0 || points_out[n - 1].timestamp != bucket) {
+            prts_rollup_point_t point = { bucket, v, v, 0.0, 0 };
+            points_out[n++] = point;
+        }
+        prts_rollup_point_t* p = &points_out[n - 1];
+        if (v < p->min) p->min = v;
+        if (v > p->max) p->max = v;
+        p->sum += v;
+        p->count++;
+    }
+    return n;
+}
+
+static void check_rollup(
+    prts_series_store_t* store,
+    const prts_sample_t* samples,
+    size_t count,
+    prts_timestamp_t step
+) {
+    prts_rollup_point_t* expected = malloc(count * sizeof(prts_rollup_point_t));
+    prts_rollup_point_t* points = malloc(count * sizeof(prts_rollup_point_t));
+    CHECK(expected != NULL && points != NULL);
+
+    size_t n = expected_rollup(samples, count, step, expected);
+    size_t found;
+    CHECK(prts_series_store_query_rollup(store, KEY, 0, samples[count - 1].timestamp, step,
+                                         points, count, &found) == PRTS_OK);
+    CHECK(found == n);
+    CHECK(memcmp(points, expected, n * sizeof(prts_rollup_point_t)) == 0);
+
+    free(points);
+    free(expected);
+}
+
+/*
+ * Each step reads the coarsest tier no wider than it, stitched to the raw
+ * samples not folded yet; steps below 1s read raw samples. A wrong tier
+ * shows up as misaligned buckets.
+ */
+static void test_rollup_tiers(void) {
+    enum { COUNT = 6000, EXTRA = 60 };
+    prts_metrics_collector_t* collector;
+    prts_series_store_t* store = create_rollup_store(&collector, 0, 0, 0);
+
+    prts_sample_t* samples = malloc((COUNT + EXTRA) * sizeof(prts_sample_t));
+    CHECK(samples != NULL);
+    for (size_t i = 0; i < COUNT; i++) {
+        samples[i].timestamp = (i + 1) * 250 * MS;
+        samples[i].value = i % 97 == 0 ? NAN : (double)(next_random() % 1000);
+        CHECK(prts_series_store_append(store, KEY, samples[i].timestamp, samples[i].value) ==
+              PRTS_OK);
+    }
+
+    /* The newest samples are still in the open raw chunk, not in any tier */
+    prts_store_stats_t stats;
+    CHECK(prts_series_store_stats(store, &stats) == PRTS_OK);
+    CHECK(stats.num_chunks > 10 && stats.rollup_points > 0);
+
+    static const prts_timestamp_t steps[] = {
+        250 * MS, 500 * MS, SECOND, 2 * SECOND, 5 * SECOND, 10 * SECOND, 60 * SECOND,
+        3600 * SECOND,
+    };
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        check_rollup(store, samples, COUNT, steps[i]);
+    }
+
+    /* Stitching holds wherever the unfolded span starts */
+    for (size_t i = COUNT; i < COUNT + EXTRA; i++) {
+        samples[i].timestamp = (i + 1) * 250 * MS;
+        samples[i].value = (double)(i % 13);
+        CHECK(prts_series_store_append(store, KEY, samples[i].timestamp, samples[i].value) ==
+              PRTS_OK);
+        check_rollup(store, samples, i + 1, SECOND);
+        check_rollup(store, samples, i + 1, 10 * SECOND);
+    }
+
+    free(samples);
+    prts_series_store_destroy(store);
+    prts_metrics_destroy(collector);
+}
+
+/* Start of the contiguous run of points ending at the newest one */
+static prts_timestamp_t suffix_start(
+    const prts_rollup_point_t* points,
+    size_t count,
+    prts_timestamp_t step,
+    prts_timestamp_t last
+) {
+    CHECK(count > 0 && points[count - 1].timestamp == last);
+    for (size_t i = 1; i < count; i++) {
+        CHECK(points[i].timestamp == points[i - 1].timestamp + step);
+    }
+    return points[0].timestamp;
+}
+
+/* Raw samples and each tier expire on their own retention */
+static void test_rollup_expiry(void) {
+    enum { COUNT = 1000 };
+    prts_metrics_collector_t* collector;
+    prts_series_store_t* store = create_rollup_store(&collector, 100 * SECOND, 300 * SECOND,
+                                                     3000 * SECOND);
+    for (size_t i = 1; i <= COUNT; i++) {
+        CHECK(prts_series_store_append(store, KEY, i * SECOND, (double)i) == PRTS_OK);
+    }
+
+    /* Raw keeps chunks ending within 100s, the 1s tier those within 300s */
+    CHECK(prts_series_store_sample(store, (COUNT + 1) * SECOND) == PRTS_OK);
+
+    static prts_sample_t samples[COUNT];
+    size_t found;
+    CHECK(prts_series_store_query(store, KEY, 0, UINT64_MAX, samples, COUNT, &found) ==
+          PRTS_OK);
+    CHECK(found > 0 && found < COUNT);
+    CHECK(samples[0].timestamp <= (COUNT - 100) * SECOND);
+    CHECK(samples[found - 1].timestamp == COUNT * SECOND);
+
+    static prts_rollup_point_t points[COUNT];
+    CHECK(prts_series_store_query_rollup(store, KEY, 0, UINT64_MAX, SECOND, points, COUNT,
+                                         &found) == PRTS_OK);
+    prts_timestamp_t start = suffix_start(points, found, SECOND, COUNT * SECOND);
+    CHECK(start > SECOND && start <= (COUNT - 300) * SECOND);
+
+    CHECK(prts_series_store_query_rollup(store, KEY, 0, UINT64_MAX, 10 * SECOND, points, COUNT,
+                                         &found) == PRTS_OK);
+    CHECK(found == COUNT / 10 + 1);
+    CHECK(suffix_start(points, found, 10 * SECOND, COUNT * SECOND) == 0);
+    CHECK(points[0].count == 9 && points[1].count == 10 && points[found - 1].count == 1);
+
+    /* Past the 1s tier's retention only the 10s tier answers */
+    CHECK(prts_series_store_sample(store, (COUNT + 401) * SECOND) == PRTS_OK);
+    CHECK(prts_series_store_query(store, KEY, 0, UINT64_MAX, samples, COUNT, &found) ==
+          PRTS_OK);
+    CHECK(found == 0);
+    CHECK(prts_series_store_query_rollup(store, KEY, 0, UINT64_MAX, SECOND, points, COUNT,
+                                         &found) == PRTS_OK);
+    CHECK(found == 0);
+    CHECK(prts_series_store_query_rollup(store, KEY, 0, UINT64_MAX, 10 * SECOND, points, COUNT,
+                                         &found) == PRTS_OK);
+    CHECK(found == COUNT / 10 + 1);
+
+    /* Once the 10s tier expires too the series is gone */
+    prts_store_stats_t stats;
+    CHECK(prts_series_store_sample(store, (COUNT + 3011) * SECOND) == PRTS_OK);
+    CHECK(prts_series_store_stats(store, &stats) == PRTS_OK);
+    CHECK(stats.num_series == 0 && stats.num_chunks == 0 && stats.rollup_points == 0);
+
+    prts_series_store_destroy(store);
+    prts_metrics_destroy(collector);
+}
+
+#ifdef PRTS_TEST_WRAP_CALLOC
+/*
+ * Appends that fail to open a chunk, raw or rollup, mid-fold return NOMEM
+ * and succeed on retry; each tier resumes after folded_ms, so the result
+ * matches a store that never failed.
+ */
+static void test_fold_nomem_resumes(void) {
+    enum { COUNT = 20000 };
+    prts_metrics_collector_t* collector;
+    prts_metrics_collector_t* reference_collector;
+    prts_series_store_t* store = create_rollup_store(&collector, 0, 0, 0);
+    prts_series_store_t* reference = create_rollup_store(&reference_collector, 0, 0, 0);
+
+    prts_sample_t* samples = malloc(COUNT * sizeof(prts_sample_t));
+    CHECK(samples != NULL);
+    int failures = 0;
+    for (size_t i = 0; i < COUNT; i++) {
+        samples[i].timestamp = (i + 1) * 100 * MS;
+        samples[i].value = (double)(next_random() % 100000) / 8;
+        CHECK(prts_series_store_append(reference, KEY, samples[i].timestamp, samples[i].value) ==
+              PRTS_OK);
+
+        fail_calloc_every = 3;
+        prts_result_t result;
+        int attempts = 0;
+        while ((result = prts_series_store_append(store, KEY, samples[i].timestamp,
+                                                  samples[i].value)) == PRTS_ERROR_NOMEM) {
+            failures++;
+            CHECK(++attempts < 8);
+        }
+        fail_calloc_every = 0;
+        CHECK(result == PRTS_OK);
+    }
+    CHECK(failures > 10);
+
+    prts_store_stats_t stats;
+    prts_store_stats_t reference_stats;
+    CHECK(prts_series_store_stats(store, &stats) == PRTS_OK);
+    CHECK(prts_series_store_stats(reference, &reference_stats) == PRTS_OK);
+    CHECK(stats.num_samples == COUNT && stats.rollup_points == reference_stats.rollup_points);
+
+    static const prts_timestamp_t steps[] = { SECOND, 10 * SECOND, 60 * SECOND };
+    prts_rollup_point_t* points = malloc(COUNT * sizeof(prts_rollup_point_t));
+    prts_rollup_point_t* expected = malloc(COUNT * sizeof(prts_rollup_point_t));
+    CHECK(points != NULL && expected != NULL);
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        size_t found;
+        size_t expected_found;
+        CHECK(prts_series_store_query_rollup(store, KEY, 0, UINT64_MAX, steps[i], points, COUNT,
+                                             &found) == PRTS_OK);
+        CHECK(prts_series_store_query_rollup(reference, KEY, 0, UINT64_MAX, steps[i], expected,
+                                             COUNT, &expected_found) == PRTS_OK);
+        CHECK(found == expected_found);
+        CHECK(memcmp(points, expected, found * sizeof(prts_rollup_point_t)) == 0);
+        check_rollup(store, samples, COUNT, steps[i]);
+    }
+
+    free(expected);
+    free(points);
+    free(samples);
+    prts_series_store_destroy(reference);
+    prts_series_store_destroy(store);
+    prts_metrics_destroy(reference_collector);
+    prts_metrics_destroy(collector);
+}
+#endif
+
+int main(void) {
+    test_special_values();
+    test_leading_zeros();
+    test_timestamps();
+    test_chunk_boundaries();
+    test_rollup_tiers();
+    test_rollup_expiry();
+#ifdef PRTS_TEST_WRAP_CALLOC
+    test_fold_nomem_resumes();
+#endif
+    printf("test_store: ok\n");
+    return 0;
+}
@@ -0,0 +1,1296 @@
+/**
+ * PRTS Native - Thread Pool Tests
+ */
+
+#include "prts/thread_pool.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#define THREAD_LOCAL __declspec(thread)
+#else
+#include <time.h>
+#define THREAD_LOCAL _Thread_local
+#endif
+
+#define MS 1000000ULL
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+static void sleep_ms(unsigned ms) {
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+#endif
+}
+
+/* Holds a worker until the gate opens */
+static _Atomic bool gate_open;
+
+static void gate_task(void* arg) {
+    (void)arg;
+    while (!atomic_load(&gate_open)) {
+        sleep_ms(1);
+    }
+}
+
+static prts_result_t future_ok(void* arg, void** value_out) {
+    *value_out = arg;
+    return PRTS_OK;
+}
+
+static prts_result_t future_fail(void* arg, void** value_out) {
+    (void)arg;
+    (void)value_out;
+    return PRTS_ERROR_FULL;
+}
+
+/*
+ * when_all / when_any over many inputs completing at once on different
+ * workers, with the combined handles sometimes released before the
+ * inputs complete.
+ */
+static void test_future_join_stress(void) {
+    enum { ROUNDS = 300, INPUTS = 64 };
+
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 8;
+    config.queue_size = 4096;
+    config.work_stealing = true;
+
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+
+    for (int round = 0; round < ROUNDS; round++) {
+        bool failing = round % 3 == 0;
+        bool release_early = round % 2 == 1;
+
+        prts_future_t* inputs[INPUTS];
+        for (size_t i = 0; i < INPUTS; i++) {
+            prts_future_fn fn = failing && i == INPUTS / 2 ? future_fail : future_ok;
+            CHECK(prts_threadpool_async(pool, fn, (void*)(i + 1), &inputs[i]) == PRTS_OK);
+        }
+
+        prts_future_t* all;
+        prts_future_t* any;
+        CHECK(prts_future_when_all(pool, inputs, INPUTS, &all) == PRTS_OK);
+        CHECK(prts_future_when_any(pool, inputs, INPUTS, &any) == PRTS_OK);
+
+        if (release_early) {
+            prts_future_release(all);
+            prts_future_release(any);
+        }
+        for (size_t i = 0; i < INPUTS; i++) {
+            prts_future_release(inputs[i]);
+        }
+        if (!release_early) {
+            void* value = NULL;
+            CHECK(prts_future_get(all, NULL) == (failing ? PRTS_ERROR_FULL : PRTS_OK));
+            CHECK(prts_future_get(any, &value) == PRTS_OK && value != NULL);
+            prts_future_release(all);
+            prts_future_release(any);
+        }
+    }
+
+    prts_threadpool_wait_all(pool);
+    prts_threadpool_destroy(pool);
+}
+
+/* Distinguishes the thread that pushed a task from the one that ran it */
+static THREAD_LOCAL int thread_tag;
+
+enum { STEAL_LEAVES = 20000 };
+
+typedef struct {
+    prts_thread_pool_t* pool;
+    _Atomic uint32_t hits[STEAL_LEAVES];
+    _Atomic size_t stolen;
+    int owner;
+} steal_state_t;
+
+typedef struct {
+    steal_state_t* state;
+    size_t index;
+} steal_leaf_t;
+
+static steal_leaf_t steal_leaves[STEAL_LEAVES];
+
+static void steal_leaf(void* arg) {
+    steal_leaf_t* leaf = arg;
+    atomic_fetch_add_explicit(&leaf->state->hits[leaf->index], 1, memory_order_relaxed);
+    if (thread_tag != leaf->state->owner) {
+        atomic_fetch_add_explicit(&leaf->state->stolen, 1, memory_order_relaxed);
+    }
+
+    /* Enough work per task that thieves keep the owner's top under contention */
+    volatile unsigned spin = 0;
+    for (int i = 0; i < 200; i++) spin += (unsigned)i;
+}
+
+/* Pushes every leaf onto its own deque, growing it while the others steal */
+static void steal_root(void* arg) {
+    steal_state_t* state = arg;
+    thread_tag = state->owner;
+    for (size_t i = 0; i < STEAL_LEAVES; i++) {
+        steal_leaves[i].state = state;
+        steal_leaves[i].index = i;
+        CHECK(prts_threadpool_submit(state->pool, steal_leaf, &steal_leaves[i]) == PRTS_OK);
+    }
+}
+
+/* Stealing while the owner's deque grows runs every task exactly once */
+static void test_steal_during_growth(void) {
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 8;
+    config.queue_size = 64;
+    config.work_stealing = true;
+
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+
+    static steal_state_t state;
+    size_t stolen = 0;
+    for (int round = 0; round < 10; round++) {
+        state.pool = pool;
+        state.owner = round + 1;
+        atomic_store(&state.stolen, 0);
+        for (size_t i = 0; i < STEAL_LEAVES; i++) {
+            atomic_store(&state.hits[i], 0);
+        }
+
+        CHECK(prts_threadpool_submit(pool, steal_root, &state) == PRTS_OK);
+        prts_threadpool_wait_all(pool);
+
+        for (size_t i = 0; i < STEAL_LEAVES; i++) {
+            CHECK(atomic_load(&state.hits[i]) == 1);
+        }
+        stolen += atomic_load(&state.stolen);
+    }
+    CHECK(stolen > 0);
+
+    prts_threadpool_destroy(pool);
+}
+
+enum { SPAWN_DEPTH = 7, SPAWN_TASKS = ((1 << (2 * (SPAWN_DEPTH + 1))) - 1) / 3 };
+
+typedef struct spawn_arg spawn_arg_t;
+
+typedef struct {
+    prts_thread_pool_t* pool;
+    spawn_arg_t* args;              /* SPAWN_TASKS slots, claimed four at a time */
+    _Atomic size_t next;
+    _Atomic size_t count;
+} spawn_state_t;
+
+struct spawn_arg {
+    spawn_state_t* state;
+    int depth;
+};
+
+static void spawn_task(void* arg);
+
+/* Each level fans out through submit and submit_batch from the worker */
+static void spawn_children(spawn_state_t* state, int depth) {
+    size_t first = atomic_fetch_add_explicit(&state->next, 4, memory_order_relaxed);
+    CHECK(first + 4 <= SPAWN_TASKS);
+    spawn_arg_t* children = &state->args[first];
+    void* args[3];
+    for (int i = 0; i < 4; i++) {
+        children[i].state = state;
+        children[i].depth = depth - 1;
+        if (i < 3) args[i] = &children[i];
+    }
+    CHECK(prts_threadpool_submit_batch(state->pool, spawn_task, args, 3, NULL) == PRTS_OK);
+    CHECK(prts_threadpool_submit(state->pool, spawn_task, &children[3]) == PRTS_OK);
+}
+
+static void spawn_task(void* arg) {
+    spawn_arg_t* spawn = arg;
+    atomic_fetch_add_explicit(&spawn->state->count, 1, memory_order_relaxed);
+    if (spawn->depth > 0) {
+        spawn_children(spawn->state, spawn->depth);
+    }
+}
+
+/*
+ * Tasks submitted from tasks go to the worker's deque and are never held
+ * back by queue_size, even at 1.
+ */
+static void test_nested_local_push(void) {
+    static spawn_arg_t args[SPAWN_TASKS];
+
+    for (int stealing = 0; stealing < 2; stealing++) {
+        prts_threadpool_config_t config = {0};
+        config.num_threads = 4;
+        config.queue_size = 1;
+        config.work_stealing = stealing == 1;
+
+        prts_thread_pool_t* pool;
+        CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+
+        spawn_state_t state;
+        state.pool = pool;
+        state.args = args;
+        atomic_init(&state.next, 1);
+        atomic_init(&state.count, 0);
+        args[0].state = &state;
+        args[0].depth = SPAWN_DEPTH;
+        CHECK(prts_threadpool_submit(pool, spawn_task, &args[0]) == PRTS_OK);
+        prts_threadpool_wait_all(pool);
+
+        CHECK(atomic_load(&state.count) == SPAWN_TASKS);
+        CHECK(atomic_load(&state.next) == SPAWN_TASKS);
+        prts_threadpool_destroy(pool);
+    }
+}
+
+static _Atomic size_t runs;
+
+static void count_task(void* arg) {
+    (void)arg;
+    atomic_fetch_add_explicit(&runs, 1, memory_order_relaxed);
+}
+
+static void sleep_task(void* arg) {
+    sleep_ms((unsigned)(size_t)arg);
+}
+
+/* Waits time out while the task is queued and succeed once it has run */
+static void test_task_wait_timeout(void) {
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 1;
+    config.queue_size = 16;
+
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+
+    atomic_store(&gate_open, false);
+    CHECK(prts_threadpool_submit(pool, gate_task, NULL) == PRTS_OK);
+    prts_task_t* task;
+    CHECK(prts_threadpool_submit_wait(pool, count_task, NULL, &task) == PRTS_OK);
+
+    CHECK(prts_task_wait(task, 0) == PRTS_ERROR_TIMEOUT);
+    prts_timestamp_t start = prts_timestamp_now();
+    CHECK(prts_task_wait(task, 30) == PRTS_ERROR_TIMEOUT);
+    CHECK(prts_timestamp_now() - start >= 30 * MS);
+
+    /* A second timed wait after the first one flagged the word */
+    CHECK(prts_task_wait(task, 1) == PRTS_ERROR_TIMEOUT);
+
+    atomic_store(&gate_open, true);
+    CHECK(prts_task_wait(task, 10000) == PRTS_OK);
+    CHECK(prts_task_wait(task, 0) == PRTS_OK);
+    CHECK(prts_task_wait(task, -1) == PRTS_OK);
+    prts_task_free(task);
+
+    /* A timed wait is woken by completion, not by its timeout */
+    CHECK(prts_threadpool_submit_wait(pool, sleep_task, (void*)(size_t)20, &task) == PRTS_OK);
+    start = prts_timestamp_now();
+    CHECK(prts_task_wait(task, 10000) == PRTS_OK);
+    CHECK(prts_timestamp_now() - start < 5000 * MS);
+    prts_task_free(task);
+
+    CHECK(prts_task_wait(NULL, 0) == PRTS_ERROR_INVALID);
+    prts_threadpool_destroy(pool);
+}
+
+/* Frees handles from inside a task, often before the task they name has run */
+static void free_handles_task(void* arg) {
+    prts_thread_pool_t* pool = arg;
+    for (int i = 0; i < 8; i++) {
+        prts_task_t* task;
+        CHECK(prts_threadpool_submit_wait(pool, count_task, NULL, &task) == PRTS_OK);
+        prts_task_free(task);
+    }
+}
+
+/*
+ * Handles freed before, during and after completion are recycled; a
+ * recycled node starts pending again.
+ */
+static void test_task_free_reuse(void) {
+    enum { ROUNDS = 300, TASKS = 64 };
+
+    for (int stealing = 0; stealing < 2; stealing++) {
+        prts_threadpool_config_t config = {0};
+        config.num_threads = 4;
+        config.queue_size = 1024;
+        config.work_stealing = stealing == 1;
+
+        prts_thread_pool_t* pool;
+        CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+        atomic_store(&runs, 0);
+
+        prts_task_t* first[TASKS];
+        bool reused = false;
+        for (int round = 0; round < ROUNDS; round++) {
+            prts_task_t* tasks[TASKS];
+            for (size_t i = 0; i < TASKS; i++) {
+                CHECK(prts_threadpool_submit_wait(pool, count_task, NULL, &tasks[i]) == PRTS_OK);
+                if (round == 0) {
+                    first[i] = tasks[i];
+                } else {
+                    for (size_t j = 0; j < TASKS && !reused; j++) {
+                        reused = tasks[i] == first[j];
+                    }
+                }
+
+                /* Free every other handle at once, racing the worker */
+                if (i % 2 == 0) {
+                    prts_task_free(tasks[i]);
+                }
+            }
+            CHECK(prts_threadpool_submit(pool, free_handles_task, pool) == PRTS_OK);
+            for (size_t i = 1; i < TASKS; i += 2) {
+                CHECK(prts_task_wait(tasks[i], -1) == PRTS_OK);
+                prts_task_free(tasks[i]);
+            }
+        }
+        prts_threadpool_wait_all(pool);
+        CHECK(reused);
+        CHECK(atomic_load(&runs) == (size_t)ROUNDS * (TASKS + 8));
+
+        /* Behind a blocked worker, recycled handles are pending until they run */
+        atomic_store(&gate_open, false);
+        for (size_t i = 0; i < config.num_threads; i++) {
+            CHECK(prts_threadpool_submit(pool, gate_task, NULL) == PRTS_OK);
+        }
+        prts_task_t* pending[TASKS];
+        for (size_t i = 0; i < TASKS; i++) {
+            CHECK(prts_threadpool_submit_wait(pool, count_task, NULL, &pending[i]) == PRTS_OK);
+            CHECK(prts_task_wait(pending[i], 0) == PRTS_ERROR_TIMEOUT);
+        }
+        atomic_store(&gate_open, true);
+        for (size_t i = 0; i < TASKS; i++) {
+            CHECK(prts_task_wait(pending[i], -1) == PRTS_OK);
+            prts_task_free(pending[i]);
+        }
+
+        prts_threadpool_destroy(pool);
+    }
+}
+
+enum { RANGE_SIZE = 5000 };
+
+typedef struct {
+    _Atomic uint32_t hits[RANGE_SIZE];
+    size_t begin;
+    size_t end;
+    size_t grain;
+    _Atomic size_t chunks;
+} range_state_t;
+
+static void mark_range(size_t begin, size_t end, void* arg) {
+    range_state_t* state = arg;
+    CHECK(state->begin <= begin && begin < end && end <= state->end);
+    CHECK(state->grain == 0 || end - begin <= state->grain);
+    atomic_fetch_add_explicit(&state->chunks, 1, memory_order_relaxed);
+    for (size_t i = begin; i < end; i++) {
+        atomic_fetch_add_explicit(&state->hits[i], 1, memory_order_relaxed);
+    }
+}
+
+typedef struct {
+    uint64_t sum;
+    uint64_t count;
+    size_t min;
+    size_t max;
+} range_acc_t;
+
+/* Integer work, so any split combines to the sequential answer exactly */
+static void reduce_range(size_t begin, size_t end, void* acc, void* arg) {
+    range_acc_t* a = acc;
+    (void)arg;
+    for (size_t i = begin; i < end; i++) {
+        a->sum += (uint64_t)i * i;
+        a->count++;
+        if (i < a->min) a->min = i;
+        if (i > a->max) a->max = i;
+    }
+}
+
+static void combine_range(void* acc, const void* other, void* arg) {
+    range_acc_t* a = acc;
+    const range_acc_t* b = other;
+    (void)arg;
+    a->sum += b->sum;
+    a->count += b->count;
+    if (b->min < a->min) a->min = b->min;
+    if (b->max > a->max) a->max = b->max;
+}
+
+/* Odd ranges and grains: every index once, chunks no larger than the grain */
+static void test_parallel_for_coverage(void) {
+    static const size_t ranges[][2] = {
+        { 0, 0 }, { 7, 7 }, { 0, 1 }, { 3, 4 }, { 0, 7 }, { 1, 1000 }, { 0, 1001 },
+        { 13, 4110 }, { 0, RANGE_SIZE }, { RANGE_SIZE - 3, RANGE_SIZE },
+    };
+    static const size_t grains[] = { 0, 1, 2, 3, 7, 64, 999, 4096, 100000 };
+
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 4;
+    config.queue_size = 64;
+
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+
+    static range_state_t state;
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+        for (size_t g = 0; g < sizeof(grains) / sizeof(grains[0]); g++) {
+            size_t begin = ranges[r][0];
+            size_t end = ranges[r][1];
+            size_t grain = grains[g];
+            for (size_t i = 0; i < RANGE_SIZE; i++) {
+                atomic_store(&state.hits[i], 0);
+            }
+            state.begin = begin;
+            state.end = end;
+            state.grain = grain;
+            atomic_store(&state.chunks, 0);
+
+            CHECK(prts_threadpool_parallel_for(pool, begin, end, grain, mark_range, &state) ==
+                  PRTS_OK);
+            for (size_t i = 0; i < RANGE_SIZE; i++) {
+                CHECK(atomic_load(&state.hits[i]) == (i >= begin && i < end ? 1u : 0u));
+            }
+            if (grain > 0) {
+                CHECK(atomic_load(&state.chunks) == (end - begin + grain - 1) / grain);
+            }
+
+            /* The same split reduces to the sequential result */
+            range_acc_t identity = { 0, 0, SIZE_MAX, 0 };
+            range_acc_t expected = identity;
+            reduce_range(begin, end, &expected, NULL);
+            range_acc_t result;
+            CHECK(prts_threadpool_parallel_reduce(pool, begin, end, grain, sizeof(range_acc_t),
+                                                  &identity, reduce_range, combine_range, NULL,
+                                                  &result) == PRTS_OK);
+            CHECK(memcmp(&result, &expected, sizeof(result)) == 0);
+        }
+    }
+
+    CHECK(prts_threadpool_parallel_for(pool, 5, 4, 1, mark_range, &state) == PRTS_ERROR_INVALID);
+    prts_threadpool_destroy(pool);
+}
+
+typedef struct {
+    prts_thread_pool_t* pool;
+    _Atomic size_t items;
+} nested_state_t;
+
+static void count_items(size_t begin, size_t end, void* arg) {
+    nested_state_t* state = arg;
+    atomic_fetch_add_explicit(&state->items, end - begin, memory_order_relaxed);
+}
+
+static void inner_loop(size_t begin, size_t end, void* arg) {
+    nested_state_t* state = arg;
+    for (size_t i = begin; i < end; i++) {
+        CHECK(prts_threadpool_parallel_for(state->pool, 0, 100, 3, count_items, state) ==
+              PRTS_OK);
+    }
+}
+
+static void outer_task(void* arg) {
+    nested_state_t* state = arg;
+    CHECK(prts_threadpool_parallel_for(state->pool, 0, 20, 1, inner_loop, state) == PRTS_OK);
+}
+
+/*
+ * Loops started from tasks, and loops inside loop bodies, with queue_size 1:
+ * workers fan out past the bound and help while they wait.
+ */
+static void test_nested_parallel_for(void) {
+    enum { TASKS = 32 };
+
+    for (size_t threads = 1; threads <= 4; threads += 3) {
+        prts_threadpool_config_t config = {0};
+        config.num_threads = threads;
+        config.queue_size = 1;
+
+        prts_thread_pool_t* pool;
+        CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+
+        nested_state_t state;
+        state.pool = pool;
+        atomic_init(&state.items, 0);
+        for (int i = 0; i < TASKS; i++) {
+            CHECK(prts_threadpool_submit(pool, outer_task, &state) == PRTS_OK);
+        }
+        prts_threadpool_wait_all(pool);
+        CHECK(atomic_load(&state.items) == (size_t)TASKS * 20 * 100);
+
+        prts_threadpool_destroy(pool);
+    }
+}
+
+enum { BATCH_SIZE = 100 };
+
+static _Atomic uint32_t batch_hits[BATCH_SIZE];
+
+static void batch_task(void* arg) {
+    atomic_fetch_add_explicit(&batch_hits[*(size_t*)arg], 1, memory_order_relaxed);
+}
+
+/* A batch larger than queue_size is admitted whole; each argument runs once */
+static void test_submit_batch(void) {
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 2;
+    config.queue_size = 8;
+
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+
+    static size_t indices[BATCH_SIZE];
+    void* args[BATCH_SIZE];
+    prts_task_t* tasks[BATCH_SIZE];
+    for (size_t i = 0; i < BATCH_SIZE; i++) {
+        indices[i] = i;
+        args[i] = &indices[i];
+        atomic_store(&batch_hits[i], 0);
+    }
+    CHECK(prts_threadpool_submit_batch(pool, batch_task, args, BATCH_SIZE, tasks) == PRTS_OK);
+    for (size_t i = 0; i < BATCH_SIZE; i++) {
+        CHECK(prts_task_wait(tasks[i], -1) == PRTS_OK);
+        prts_task_free(tasks[i]);
+        CHECK(atomic_load(&batch_hits[i]) == 1);
+    }
+
+    CHECK(prts_threadpool_submit_batch(pool, batch_task, args, 0, NULL) == PRTS_OK);
+    CHECK(prts_threadpool_submit_batch(pool, batch_task, NULL, 1, NULL) == PRTS_ERROR_INVALID);
+    prts_threadpool_destroy(pool);
+}
+
+enum { GRAPH_NODES = 200 };
+
+typedef struct graph_test graph_test_t;
+
+typedef struct {
+    graph_test_t* test;
+    size_t index;
+} graph_arg_t;
+
+struct graph_test {
+    graph_arg_t args[GRAPH_NODES];
+    _Atomic size_t runs[GRAPH_NODES];
+    _Atomic size_t stamp[GRAPH_NODES];  /* Order in which nodes ran */
+    _Atomic size_t clock;
+    size_t failing;                     /* Node that fails (GRAPH_NODES for none) */
+    size_t gated;                       /* Node that waits for gate_open */
+};
+
+static prts_result_t graph_task(void* arg) {
+    graph_arg_t* node = arg;
+    graph_test_t* test = node->test;
+    if (node->index == test->gated) {
+        while (!atomic_load(&gate_open)) {
+            sleep_ms(1);
+        }
+    }
+    atomic_fetch_add(&test->runs[node->index], 1);
+    atomic_store(&test->stamp[node->index], atomic_fetch_add(&test->clock, 1) + 1);
+    return node->index == test->failing ? PRTS_ERROR_FULL : PRTS_OK;
+}
+
+static prts_task_graph_t* create_graph(prts_thread_pool_t* pool, graph_test_t* test, size_t n) {
+    prts_task_graph_t* graph;
+    CHECK(prts_task_graph_create(pool, &graph) == PRTS_OK);
+    memset(test, 0, sizeof(*test));
+    test->failing = GRAPH_NODES;
+    test->gated = GRAPH_NODES;
+    for (size_t i = 0; i < n; i++) {
+        test->args[i].test = test;
+        test->args[i].index = i;
+        size_t id;
+        CHECK(prts_task_graph_add(graph, graph_task, &test->args[i], &id) == PRTS_OK);
+        CHECK(id == i);
+    }
+    return graph;
+}
+
+/* Cycles anywhere in the graph are refused before anything runs */
+static void test_graph_cycles(void) {
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 2;
+    config.queue_size = 64;
+
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+
+    static graph_test_t test;
+    prts_task_graph_t* graph = create_graph(pool, &test, 4);
+    CHECK(prts_task_graph_add_edge(graph, 1, 1) == PRTS_ERROR_INVALID);
+    CHECK(prts_task_graph_add_edge(graph, 0, 4) == PRTS_ERROR_INVALID);
+
+    /* 0 is a root, but 1 -> 2 -> 3 -> 1 never becomes ready */
+    CHECK(prts_task_graph_add_edge(graph, 0, 1) == PRTS_OK);
+    CHECK(prts_task_graph_add_edge(graph, 1, 2) == PRTS_OK);
+    CHECK(prts_task_graph_add_edge(graph, 2, 3) == PRTS_OK);
+    CHECK(prts_task_graph_add_edge(graph, 3, 1) == PRTS_OK);
+    CHECK(prts_task_graph_submit(graph) == PRTS_ERROR_INVALID);
+    CHECK(prts_task_graph_wait(graph, -1) == PRTS_OK);
+    prts_threadpool_wait_all(pool);
+    for (size_t i = 0; i < 4; i++) {
+        CHECK(atomic_load(&test.runs[i]) == 0);
+    }
+    prts_task_graph_destroy(graph);
+
+    /* Every node on a cycle: no roots at all */
+    graph = create_graph(pool, &test, 2);
+    CHECK(prts_task_graph_add_edge(graph, 0, 1) == PRTS_OK);
+    CHECK(prts_task_graph_add_edge(graph, 1, 0) == PRTS_OK);
+    CHECK(prts_task_graph_submit(graph) == PRTS_ERROR_INVALID);
+    prts_task_graph_destroy(graph);
+
+    prts_threadpool_destroy(pool);
+}
+
+/*
+ * Nodes run after all their predecessors; a failure skips exactly the
+ * nodes downstream of it, and a resubmitted graph runs afresh.
+ */
+static void test_graph_failure_and_resubmit(void) {
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 4;
+    config.queue_size = 64;
+    config.work_stealing = true;
+
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+
+    static graph_test_t test;
+    prts_task_graph_t* graph = create_graph(pool, &test, GRAPH_NODES);
+
+    /* Random DAG: edges only from lower to higher ids; reach[i][j] if j is downstream of i */
+    static bool edge[GRAPH_NODES][GRAPH_NODES];
+    static bool reach[GRAPH_NODES][GRAPH_NODES];
+    uint64_t rng = 12345;
+    for (size_t j = 0; j < GRAPH_NODES; j++) {
+        for (size_t i = 0; i < j; i++) {
+            rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+            edge[i][j] = (rng >> 33) % 100 < 2;
+            if (edge[i][j]) {
+                CHECK(prts_task_graph_add_edge(graph, i, j) == PRTS_OK);
+            }
+        }
+    }
+    for (size_t i = GRAPH_NODES; i-- > 0;) {
+        for (size_t j = i + 1; j < GRAPH_NODES; j++) {
+            if (!edge[i][j]) continue;
+            reach[i][j] = true;
+            for (size_t k = j + 1; k < GRAPH_NODES; k++) {
+                reach[i][k] |= reach[j][k];
+            }
+        }
+    }
+
+    for (int round = 0; round < 6; round++) {
+        /* Alternate clean runs with a failure a few nodes in */
+        test.failing = round % 2 ? (size_t)round * 7 : GRAPH_NODES;
+        atomic_store(&test.clock, 0);
+        for (size_t i = 0; i < GRAPH_NODES; i++) {
+            atomic_store(&test.stamp[i], 0);
+        }
+
+        CHECK(prts_task_graph_submit(graph) == PRTS_OK);
+        CHECK(prts_task_graph_submit(graph) == PRTS_ERROR_INVALID);
+        CHECK(prts_task_graph_add(graph, graph_task, &test.args[0], NULL) == PRTS_ERROR_INVALID);
+        CHECK(prts_task_graph_wait(graph, -1) ==
+              (test.failing < GRAPH_NODES ? PRTS_ERROR_FULL : PRTS_OK));
+
+        for (size_t j = 0; j < GRAPH_NODES; j++) {
+            bool skipped = test.failing < GRAPH_NODES && reach[test.failing][j];
+            prts_result_t result;
+            CHECK(prts_task_graph_node_result(graph, j, &result) == PRTS_OK);
+            CHECK(result == (skipped ? PRTS_ERROR_CANCELLED
+                                     : j == test.failing ? PRTS_ERROR_FULL : PRTS_OK));
+
+            size_t stamp = atomic_load(&test.stamp[j]);
+            CHECK(skipped ? stamp == 0 : stamp > 0);
+            for (size_t i = 0; i < j && !skipped; i++) {
+                CHECK(!edge[i][j] || atomic_load(&test.stamp[i]) < stamp);
+            }
+        }
+    }
+
+    /* Each node ran once per round that did not skip it */
+    for (size_t j = 0; j < GRAPH_NODES; j++) {
+        size_t expected = 0;
+        for (int round = 0; round < 6; round++) {
+            size_t failing = round % 2 ? (size_t)round * 7 : GRAPH_NODES;
+            expected += !(failing < GRAPH_NODES && reach[failing][j]);
+        }
+        CHECK(atomic_load(&test.runs[j]) == expected);
+    }
+
+    prts_task_graph_destroy(graph);
+    prts_threadpool_destroy(pool);
+}
+
+/* Cancelling skips the nodes that have not started; the running one finishes */
+static void test_graph_cancel(void) {
+    enum { CHAIN = 20 };
+
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 2;
+    config.queue_size = 64;
+
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+
+    static graph_test_t test;
+    prts_task_graph_t* graph = create_graph(pool, &test, CHAIN);
+    for (size_t i = 0; i + 1 < CHAIN; i++) {
+        CHECK(prts_task_graph_add_edge(graph, i, i + 1) == PRTS_OK);
+    }
+
+    test.gated = 3;
+    atomic_store(&gate_open, false);
+    CHECK(prts_task_graph_submit(graph) == PRTS_OK);
+    while (atomic_load(&test.runs[2]) == 0) {
+        sleep_ms(1);
+    }
+    CHECK(prts_task_graph_wait(graph, 0) == PRTS_ERROR_TIMEOUT);
+    CHECK(prts_task_graph_wait(graph, 10) == PRTS_ERROR_TIMEOUT);
+
+    prts_task_graph_cancel(graph);
+    atomic_store(&gate_open, true);
+    CHECK(prts_task_graph_wait(graph, -1) == PRTS_ERROR_CANCELLED);
+    for (size_t i = 0; i < CHAIN; i++) {
+        prts_result_t result;
+        CHECK(prts_task_graph_node_result(graph, i, &result) == PRTS_OK);
+        CHECK(result == (i <= 3 ? PRTS_OK : PRTS_ERROR_CANCELLED));
+        CHECK(atomic_load(&test.runs[i]) == (i <= 3 ? 1u : 0u));
+    }
+
+    /* A cancelled graph runs in full when submitted again */
+    CHECK(prts_task_graph_submit(graph) == PRTS_OK);
+    CHECK(prts_task_graph_wait(graph, -1) == PRTS_OK);
+    for (size_t i = 0; i < CHAIN; i++) {
+        CHECK(atomic_load(&test.runs[i]) == (i <= 3 ? 2u : 1u));
+    }
+
+    /* Destroying a running graph waits for it */
+    CHECK(prts_task_graph_submit(graph) == PRTS_OK);
+    prts_task_graph_destroy(graph);
+    CHECK(atomic_load(&test.runs[CHAIN - 1]) == 2);
+
+    prts_threadpool_destroy(pool);
+}
+
+/* Records the order tasks run in */
+enum { ORDER_MAX = 512 };
+static int run_order[ORDER_MAX];
+static _Atomic size_t num_run;
+
+static void order_task(void* arg) {
+    size_t slot = atomic_fetch_add(&num_run, 1);
+    CHECK(slot < ORDER_MAX);
+    run_order[slot] = (int)(size_t)arg;
+}
+
+static void order_sleep_task(void* arg) {
+    order_task(arg);
+    sleep_ms(2);
+}
+
+/* A one-worker pool with injection lanes only, held by a gate task */
+static prts_thread_pool_t* create_gated_pool(uint32_t aging_ms) {
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 1;
+    config.queue_size = 1024;
+    config.aging_ms = aging_ms;
+
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+    atomic_store(&num_run, 0);
+    atomic_store(&gate_open, false);
+    CHECK(prts_threadpool_submit(pool, gate_task, NULL) == PRTS_OK);
+    return pool;
+}
+
+static void submit_priority(prts_thread_pool_t* pool, prts_task_fn fn, int id,
+                            prts_task_priority_t priority, uint32_t deadline_ms) {
+    prts_task_options_t options = { priority, deadline_ms };
+    CHECK(prts_threadpool_submit_ex(pool, fn, (void*)(size_t)id, &options, NULL) == PRTS_OK);
+}
+
+/* Lanes are served highest first until a queued head has aged past the others */
+static void test_priority_aging(void) {
+    /* Fresh work runs strictly by priority */
+    prts_thread_pool_t* pool = create_gated_pool(10000);
+    submit_priority(pool, order_task, 3, PRTS_PRIORITY_LOW, 0);
+    submit_priority(pool, order_task, 2, PRTS_PRIORITY_NORMAL, 0);
+    submit_priority(pool, order_task, 1, PRTS_PRIORITY_HIGH, 0);
+    atomic_store(&gate_open, true);
+    prts_threadpool_wait_all(pool);
+    CHECK(atomic_load(&num_run) == 3);
+    CHECK(run_order[0] == 1 && run_order[1] == 2 && run_order[2] == 3);
+    prts_threadpool_destroy(pool);
+
+    /* Low-priority work queued three intervals earlier outranks fresh high */
+    pool = create_gated_pool(10);
+    submit_priority(pool, order_task, 3, PRTS_PRIORITY_LOW, 0);
+    sleep_ms(40);
+    submit_priority(pool, order_task, 2, PRTS_PRIORITY_NORMAL, 0);
+    submit_priority(pool, order_task, 1, PRTS_PRIORITY_HIGH, 0);
+    atomic_store(&gate_open, true);
+    prts_threadpool_wait_all(pool);
+    CHECK(run_order[0] == 3 && run_order[1] == 1 && run_order[2] == 2);
+    prts_threadpool_destroy(pool);
+
+    /* A deadline within one interval ranks as high priority */
+    pool = create_gated_pool(10000);
+    submit_priority(pool, order_task, 2, PRTS_PRIORITY_NORMAL, 0);
+    submit_priority(pool, order_task, 1, PRTS_PRIORITY_LOW, 5000);
+    atomic_store(&gate_open, true);
+    prts_threadpool_wait_all(pool);
+    CHECK(run_order[0] == 1 && run_order[1] == 2);
+    prts_threadpool_destroy(pool);
+
+    /* High-priority work arriving faster than it runs does not starve a low task */
+    enum { FLOOD = 200 };
+    pool = create_gated_pool(5);
+    submit_priority(pool, order_task, 0, PRTS_PRIORITY_LOW, 0);
+    atomic_store(&gate_open, true);
+    for (int i = 1; i <= FLOOD; i++) {
+        submit_priority(pool, order_sleep_task, i, PRTS_PRIORITY_HIGH, 0);
+        sleep_ms(1);
+    }
+    prts_threadpool_wait_all(pool);
+    CHECK(atomic_load(&num_run) == FLOOD + 1);
+    size_t position = 0;
+    while (run_order[position] != 0) {
+        position++;
+    }
+    CHECK(position < FLOOD / 2);
+    prts_threadpool_destroy(pool);
+}
+
+/* A task still queued at its deadline is dropped and its wait is cancelled */
+static void test_task_deadline(void) {
+    prts_thread_pool_t* pool = create_gated_pool(10000);
+
+    prts_task_options_t late = { PRTS_PRIORITY_NORMAL, 10 };
+    prts_task_options_t ample = { PRTS_PRIORITY_NORMAL, 60000 };
+    prts_task_t* expired;
+    prts_task_t* on_time;
+    CHECK(prts_threadpool_submit_ex(pool, order_task, (void*)(size_t)1, &late, &expired) ==
+          PRTS_OK);
+    CHECK(prts_threadpool_submit_ex(pool, order_task, (void*)(size_t)2, &ample, &on_time) ==
+          PRTS_OK);
+    CHECK(prts_threadpool_submit_ex(pool, order_task, (void*)(size_t)3, &late, NULL) ==
+          PRTS_OK);
+    prts_task_options_t bad = { (prts_task_priority_t)7, 0 };
+    CHECK(prts_threadpool_submit_ex(pool, order_task, NULL, &bad, NULL) == PRTS_ERROR_INVALID);
+
+    sleep_ms(30);
+    atomic_store(&gate_open, true);
+    CHECK(prts_task_wait(expired, -1) == PRTS_ERROR_CANCELLED);
+    CHECK(prts_task_wait(expired, 0) == PRTS_ERROR_CANCELLED);
+    CHECK(prts_task_wait(on_time, -1) == PRTS_OK);
+    prts_task_free(expired);
+    prts_task_free(on_time);
+    prts_threadpool_wait_all(pool);
+
+    CHECK(atomic_load(&num_run) == 1 && run_order[0] == 2);
+    prts_threadpool_stats_t stats;
+    CHECK(prts_threadpool_stats(pool, &stats) == PRTS_OK);
+    CHECK(stats.expired_tasks == 2);
+
+    /* A recycled handle no longer reports the earlier expiry */
+    prts_task_t* task;
+    CHECK(prts_threadpool_submit_ex(pool, order_task, (void*)(size_t)4, &ample, &task) ==
+          PRTS_OK);
+    CHECK(prts_task_wait(task, -1) == PRTS_OK);
+    prts_task_free(task);
+
+    prts_threadpool_destroy(pool);
+}
+
+/* A quantile estimate within 25% below the known duration, with room above for oversleeping */
+static bool near_ms(uint64_t ns, uint64_t ms) {
+    return ns >= ms * MS * 3 / 4 && ns <= ms * MS * 3;
+}
+
+/* Run times and quantiles reflect tasks of known length */
+static void test_stats_exec_times(void) {
+    enum { FAST = 97, SLOW = 3, FAST_MS = 5, SLOW_MS = 50 };
+
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 1;
+    config.queue_size = 256;
+
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+
+    prts_threadpool_stats_t stats;
+    CHECK(prts_threadpool_stats(pool, &stats) == PRTS_OK);
+    CHECK(stats.completed_tasks == 0 && stats.total_exec_ns == 0 && stats.exec_p99_ns == 0);
+
+    for (int i = 0; i < FAST + SLOW; i++) {
+        size_t ms = i < FAST ? FAST_MS : SLOW_MS;
+        CHECK(prts_threadpool_submit(pool, sleep_task, (void*)ms) == PRTS_OK);
+    }
+    prts_threadpool_wait_all(pool);
+
+    CHECK(prts_threadpool_stats(pool, &stats) == PRTS_OK);
+    CHECK(stats.completed_tasks == FAST + SLOW && stats.pending_tasks == 0);
+    uint64_t slept = (uint64_t)(FAST * FAST_MS + SLOW * SLOW_MS) * MS;
+    CHECK(stats.total_exec_ns >= slept && stats.total_exec_ns <= 3 * slept);
+    CHECK(near_ms(stats.exec_p50_ns, FAST_MS));
+    CHECK(near_ms(stats.exec_p99_ns, SLOW_MS));
+
+    /* Each task queued behind the ones before it on the single worker */
+    CHECK(stats.total_wait_ns >= (uint64_t)FAST * (FAST - 1) / 2 * FAST_MS * MS);
+
+    prts_threadpool_destroy(pool);
+}
+
+/* Queue waits reflect how long tasks sat behind a blocked worker */
+static void test_stats_wait_times(void) {
+    enum { TASKS = 20, BLOCKED_MS = 50 };
+
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 1;
+    config.queue_size = 256;
+
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+
+    atomic_store(&gate_open, false);
+    CHECK(prts_threadpool_submit(pool, gate_task, NULL) == PRTS_OK);
+    for (int i = 0; i < TASKS; i++) {
+        CHECK(prts_threadpool_submit(pool, count_task, NULL) == PRTS_OK);
+    }
+    sleep_ms(BLOCKED_MS);
+
+    prts_threadpool_stats_t stats;
+    CHECK(prts_threadpool_stats(pool, &stats) == PRTS_OK);
+    CHECK(stats.active_threads == 1 && stats.idle_threads == 0);
+    CHECK(stats.pending_tasks == TASKS && stats.completed_tasks == 0);
+
+    atomic_store(&gate_open, true);
+    prts_threadpool_wait_all(pool);
+
+    CHECK(prts_threadpool_stats(pool, &stats) == PRTS_OK);
+    CHECK(stats.completed_tasks == TASKS + 1 && stats.pending_tasks == 0);
+    CHECK(stats.total_wait_ns >= (uint64_t)TASKS * BLOCKED_MS * MS);
+    CHECK(near_ms(stats.wait_p50_ns, BLOCKED_MS));
+    CHECK(near_ms(stats.wait_p99_ns, BLOCKED_MS));
+
+    /* Only the gate task ran for long */
+    CHECK(stats.total_exec_ns >= (uint64_t)BLOCKED_MS * MS);
+    CHECK(stats.exec_p50_ns < MS);
+
+    prts_threadpool_destroy(pool);
+}
+
+/* Delayed tasks record when they ran */
+typedef struct {
+    prts_timestamp_t submitted;
+    _Atomic prts_timestamp_t fired;
+} delayed_t;
+
+static void delayed_task(void* arg) {
+    delayed_t* delayed = (delayed_t*)arg;
+    atomic_store(&delayed->fired, prts_timestamp_now());
+}
+
+/* Delayed tasks never run before their delay, and not long after it */
+static void test_timer_delay(void) {
+    enum { TIMERS = 200 };
+    static const uint32_t delays[] = { 0, 1, 2, 5, 20, 63, 64, 65, 150 };
+    enum { NUM_DELAYS = sizeof(delays) / sizeof(delays[0]) };
+
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 2;
+    config.queue_size = 1024;
+
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+
+    static delayed_t timers[TIMERS];
+    for (size_t i = 0; i < TIMERS; i++) {
+        timers[i].submitted = prts_timestamp_now();
+        atomic_store(&timers[i].fired, 0);
+        CHECK(prts_threadpool_submit_after(pool, delays[i % NUM_DELAYS], delayed_task,
+                                           &timers[i], NULL) == PRTS_OK);
+    }
+
+    for (size_t i = 0; i < TIMERS; i++) {
+        for (int waited = 0; !atomic_load(&timers[i].fired); waited++) {
+            CHECK(waited < 5000);
+            sleep_ms(1);
+        }
+        uint64_t delay = (uint64_t)delays[i % NUM_DELAYS] * MS;
+        prts_timestamp_t elapsed = atomic_load(&timers[i].fired) - timers[i].submitted;
+        CHECK(elapsed >= delay);
+        CHECK(elapsed < delay + 1000 * MS);
+    }
+
+    CHECK(prts_threadpool_submit_after(NULL, 1, delayed_task, &timers[0], NULL) == PRTS_ERROR_INVALID);
+    CHECK(prts_threadpool_submit_after(pool, 1, NULL, NULL, NULL) == PRTS_ERROR_INVALID);
+    prts_threadpool_destroy(pool);
+}
+
+/* Periodic runs record their times */
+#define PERIODIC_MAX 256
+
+typedef struct {
+    prts_timestamp_t times[PERIODIC_MAX];
+    _Atomic size_t runs;
+} periodic_t;
+
+static void periodic_task(void* arg) {
+    periodic_t* periodic = (periodic_t*)arg;
+    size_t run = atomic_load(&periodic->runs);
+    if (run < PERIODIC_MAX) {
+        periodic->times[run] = prts_timestamp_now();
+    }
+    atomic_store(&periodic->runs, run + 1);
+}
+
+static void slow_periodic_task(void* arg) {
+    periodic_task(arg);
+    sleep_ms(30);
+}
+
+/*
+ * Periodic timers keep their cadence: the k-th run is never early,
+ * runs never burst to catch up, overlapping runs are skipped, and
+ * nothing runs after the cancel beyond a run already handed out.
+ */
+static void test_timer_periodic(void) {
+    enum { PERIOD_MS = 10, WINDOW_MS = 200 };
+
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 2;
+    config.queue_size = 64;
+
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+    CHECK(prts_threadpool_submit_every(pool, 0, periodic_task, NULL, NULL) == PRTS_ERROR_INVALID);
+
+    static periodic_t periodic;
+    atomic_store(&periodic.runs, 0);
+    prts_timer_t* timer;
+    prts_timestamp_t start = prts_timestamp_now();
+    CHECK(prts_threadpool_submit_every(pool, PERIOD_MS, periodic_task, &periodic, &timer) == PRTS_OK);
+    sleep_ms(WINDOW_MS);
+
+    size_t runs = atomic_load(&periodic.runs);
+    prts_timestamp_t elapsed = prts_timestamp_now() - start;
+    CHECK(runs >= 3);
+    CHECK(runs <= elapsed / (PERIOD_MS * MS));
+    for (size_t k = 0; k < runs; k++) {
+        CHECK(periodic.times[k] - start >= (k + 1) * PERIOD_MS * MS);
+    }
+
+    CHECK(prts_timer_cancel(timer) == PRTS_OK);
+    size_t cancelled_at = atomic_load(&periodic.runs);
+    sleep_ms(5 * PERIOD_MS);
+    CHECK(atomic_load(&periodic.runs) <= cancelled_at + 1);
+
+    /* A 30ms body on a 5ms period runs at most once per 30ms */
+    atomic_store(&periodic.runs, 0);
+    start = prts_timestamp_now();
+    CHECK(prts_threadpool_submit_every(pool, 5, slow_periodic_task, &periodic, &timer) == PRTS_OK);
+    sleep_ms(WINDOW_MS);
+    CHECK(prts_timer_cancel(timer) == PRTS_OK);
+    elapsed = prts_timestamp_now() - start;
+    runs = atomic_load(&periodic.runs);
+    CHECK(runs >= 1);
+    CHECK(runs <= elapsed / (30 * MS) + 1);
+    for (size_t k = 1; k < runs && k < PERIODIC_MAX; k++) {
+        CHECK(periodic.times[k] - periodic.times[k - 1] >= 30 * MS);
+    }
+
+    prts_threadpool_wait_all(pool);
+    prts_threadpool_destroy(pool);
+}
+
+/* Cancel stops armed timers and reports one-shots that already fired */
+static void test_timer_cancel(void) {
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 2;
+    config.queue_size = 64;
+
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+    CHECK(prts_timer_cancel(NULL) == PRTS_ERROR_INVALID);
+
+    /* Before firing: stopped, and never runs */
+    static delayed_t early;
+    atomic_store(&early.fired, 0);
+    prts_timer_t* timer;
+    CHECK(prts_threadpool_submit_after(pool, 20, delayed_task, &early, &timer) == PRTS_OK);
+    CHECK(prts_timer_cancel(timer) == PRTS_OK);
+
+    /* After firing */
+    static delayed_t late;
+    atomic_store(&late.fired, 0);
+    CHECK(prts_threadpool_submit_after(pool, 1, delayed_task, &late, &timer) == PRTS_OK);
+    for (int waited = 0; !atomic_load(&late.fired); waited++) {
+        CHECK(waited < 5000);
+        sleep_ms(1);
+    }
+    CHECK(prts_timer_cancel(timer) == PRTS_ERROR_EMPTY);
+
+    /* A periodic timer stays armed between runs */
+    static periodic_t periodic;
+    atomic_store(&periodic.runs, 0);
+    CHECK(prts_threadpool_submit_every(pool, 1, periodic_task, &periodic, &timer) == PRTS_OK);
+    for (int waited = 0; atomic_load(&periodic.runs) < 3; waited++) {
+        CHECK(waited < 5000);
+        sleep_ms(1);
+    }
+    CHECK(prts_timer_cancel(timer) == PRTS_OK);
+
+    /* Many armed timers, every other one cancelled */
+    enum { MANY = 256 };
+    static delayed_t many[MANY];
+    prts_timer_t* handles[MANY];
+    for (size_t i = 0; i < MANY; i++) {
+        atomic_store(&many[i].fired, 0);
+        CHECK(prts_threadpool_submit_after(pool, (uint32_t)(10 + i % 70), delayed_task,
+                                           &many[i], &handles[i]) == PRTS_OK);
+    }
+    for (size_t i = 0; i < MANY; i += 2) {
+        CHECK(prts_timer_cancel(handles[i]) == PRTS_OK);
+    }
+    sleep_ms(150);
+    for (size_t i = 1; i < MANY; i += 2) {
+        for (int waited = 0; !atomic_load(&many[i].fired); waited++) {
+            CHECK(waited < 5000);
+            sleep_ms(1);
+        }
+        CHECK(prts_timer_cancel(handles[i]) == PRTS_ERROR_EMPTY);
+    }
+    for (size_t i = 0; i < MANY; i += 2) {
+        CHECK(!atomic_load(&many[i].fired));
+    }
+    CHECK(!atomic_load(&early.fired));
+
+    prts_threadpool_destroy(pool);
+}
+
+#ifdef PRTS_TEST_WRAP_CLOCK
+/* Linked with --wrap=prts_timestamp_now: the library's clock runs clock_skew_ns ahead */
+prts_timestamp_t __real_prts_timestamp_now(void);
+
+static _Atomic uint64_t clock_skew_ns;
+
+prts_timestamp_t __wrap_prts_timestamp_now(void) {
+    return __real_prts_timestamp_now() + atomic_load(&clock_skew_ns);
+}
+
+static void noop_task(void* arg) {
+    (void)arg;
+}
+
+/* Jump the clock and wake a worker to advance the wheel */
+static void skip_clock(prts_thread_pool_t* pool, uint64_t ms) {
+    atomic_fetch_add(&clock_skew_ns, ms * MS);
+    CHECK(prts_threadpool_submit(pool, noop_task, NULL) == PRTS_OK);
+    prts_threadpool_wait_all(pool);
+    sleep_ms(5);
+}
+
+/*
+ * Timers past the wheel's span (64^4 ticks, about 4.7 hours) park in the
+ * last level and re-cascade until due. The clock is skipped forward, so
+ * this runs last.
+ */
+static void test_timer_beyond_span(void) {
+    enum { HOUR_MS = 3600 * 1000 };
+    const uint64_t span_ms = 1ULL << 24;
+    const uint32_t delay_ms = (uint32_t)(3 * span_ms + 12345);
+    const uint32_t period_ms = (uint32_t)(span_ms + 777);
+
+    prts_threadpool_config_t config = {0};
+    config.num_threads = 1;
+    config.queue_size = 64;
+
+    prts_thread_pool_t* pool;
+    CHECK(prts_threadpool_create(&config, &pool) == PRTS_OK);
+
+    static delayed_t far;
+    atomic_store(&far.fired, 0);
+    static periodic_t periodic;
+    atomic_store(&periodic.runs, 0);
+    prts_timer_t* far_timer;
+    prts_timer_t* periodic_timer;
+    prts_timer_t* cancelled_timer;
+    far.submitted = prts_timestamp_now();
+    CHECK(prts_threadpool_submit_after(pool, delay_ms, delayed_task, &far, &far_timer) == PRTS_OK);
+    CHECK(prts_threadpool_submit_every(pool, period_ms, periodic_task, &periodic, &periodic_timer) == PRTS_OK);
+    CHECK(prts_threadpool_submit_after(pool, delay_ms, delayed_task, &far, &cancelled_timer) == PRTS_OK);
+
+    /* Hour by hour up to a second before the one-shot is due */
+    uint64_t skipped = 0;
+    while (skipped + HOUR_MS < delay_ms - 1000) {
+        skip_clock(pool, HOUR_MS);
+        skipped += HOUR_MS;
+        CHECK(!atomic_load(&far.fired));
+        CHECK(atomic_load(&periodic.runs) == skipped / period_ms);
+    }
+    skip_clock(pool, delay_ms - 1000 - skipped);
+    CHECK(!atomic_load(&far.fired));
+    CHECK(prts_timer_cancel(cancelled_timer) == PRTS_OK);
+
+    skip_clock(pool, 2000);
+    for (int waited = 0; !atomic_load(&far.fired); waited++) {
+        CHECK(waited < 5000);
+        sleep_ms(1);
+    }
+    CHECK(atomic_load(&far.fired) - far.submitted >= (uint64_t)delay_ms * MS);
+    CHECK(prts_timer_cancel(far_timer) == PRTS_ERROR_EMPTY);
+
+    /* No periodic run came before its period */
+    size_t runs = atomic_load(&periodic.runs);
+    CHECK(runs == 3);
+    for (size_t k = 0; k < runs; k++) {
+        CHECK(periodic.times[k] - far.submitted >= (k + 1) * (uint64_t)period_ms * MS);
+    }
+    CHECK(prts_timer_cancel(periodic_timer) == PRTS_OK);
+
+    prts_threadpool_destroy(pool);
+}
+#endif
+
+int main(void) {
+    test_future_join_stress();
+    test_steal_during_growth();
+    test_nested_local_push();
+    test_task_wait_timeout();
+    test_task_free_reuse();
+    test_parallel_for_coverage();
+    test_nested_parallel_for();
+    test_submit_batch();
+    test_graph_cycles();
+    test_graph_failure_and_resubmit();
+    test_graph_cancel();
+    test_priority_aging();
+    test_task_deadline();
+    test_stats_exec_times();
+    test_stats_wait_times();
+    test_timer_delay();
+    test_timer_periodic();
+    test_timer_cancel();
+#ifdef PRTS_TEST_WRAP_CLOCK
+    test_timer_beyond_span();
+#endif
+    printf("test_thread_pool: ok\n");
+    return 0;
+}